@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/digest.h"
+#include "../include/utils.h"
+
+// بنچمارک پیاده‌سازی‌های SHA-256
+// استفاده: digest_bench
+
+#define STREAM_SIZE (256 * 1024 * 1024)
+#define SMALL_BUFFERS 65536
+#define SMALL_BUFFER_SIZE 4096
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main() {
+    log_set_level(LOG_LEVEL_ERROR);
+
+    uint8_t *data = malloc(STREAM_SIZE);
+    const uint8_t **buffers = malloc(SMALL_BUFFERS * sizeof(*buffers));
+    size_t *sizes = malloc(SMALL_BUFFERS * sizeof(*sizes));
+    uint8_t (*digests)[SHA256_DIGEST_SIZE] = malloc(SMALL_BUFFERS * SHA256_DIGEST_SIZE);
+    if (!data || !buffers || !sizes || !digests) {
+        fprintf(stderr, "خطا در تخصیص حافظه\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < STREAM_SIZE; i++) {
+        data[i] = (uint8_t)(i * 2654435761u >> 24);
+    }
+    for (int i = 0; i < SMALL_BUFFERS; i++) {
+        buffers[i] = data + (size_t)i * SMALL_BUFFER_SIZE;
+        sizes[i] = SMALL_BUFFER_SIZE;
+    }
+
+    printf("پیاده‌سازی پیش‌فرض: %s\n", digest_implementation());
+    printf("%-10s %-18s %-18s\n", "روش", "جریان (GB/s)", "بافر 4KB (GB/s)");
+
+    const char *implementations[] = { "scalar", "avx2", "shani" };
+    for (int i = 0; i < 3; i++) {
+        if (digest_set_implementation(implementations[i]) != 0) {
+            printf("%-10s پشتیبانی نمی‌شود\n", implementations[i]);
+            continue;
+        }
+
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        double start = now_seconds();
+        sha256(data, STREAM_SIZE, digest);
+        double stream_seconds = now_seconds() - start;
+
+        start = now_seconds();
+        sha256_many(buffers, sizes, SMALL_BUFFERS, digests);
+        double many_seconds = now_seconds() - start;
+
+        double many_bytes = (double)SMALL_BUFFERS * SMALL_BUFFER_SIZE;
+        printf("%-10s %-18.2f %-18.2f\n", implementations[i],
+               STREAM_SIZE / stream_seconds / 1e9, many_bytes / many_seconds / 1e9);
+    }
+
+    free(digests);
+    free(sizes);
+    free(buffers);
+    free(data);
+    return 0;
+}
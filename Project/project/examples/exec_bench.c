@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "../include/namespace.h"
+#include "../include/utils.h"
+
+// بنچمارک exec در کانتینر: ورود به namespace ها یکی‌یکی با مسیرهای /proc/<pid>/ns و نوشتن در
+// cgroup.procs، در مقایسه با یک setns روی pidfd و CLONE_INTO_CGROUP؛ هر دو /bin/true را اجرا می‌کنند
+// و زمان از شروع تا پایان فرمان اندازه‌گیری می‌شود
+// استفاده: exec_bench [تکرار]
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int hold_pipe[2];
+
+// فرآیند مقصد با همان namespace های کانتینر تا بسته شدن pipe
+static int target_main(void *arg) {
+    (void)arg;
+    close(hold_pipe[1]);
+    char byte;
+    while (read(hold_pipe[0], &byte, 1) > 0) {
+    }
+    return 0;
+}
+
+static void write_file(const char *path, const char *text) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1 || write(fd, text, strlen(text)) != (ssize_t)strlen(text)) {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+}
+
+static char *true_argv[] = { "/bin/true", NULL };
+
+// روش مسیرمحور: فرآیند واسط به cgroup منتقل می‌شود، به هر namespace جدا وارد می‌شود و فرمان را در
+// فرزندی اجرا می‌کند که عضو PID namespace است
+static int exec_by_path(pid_t target, const char *procs_path) {
+    static const int types[] = { CLONE_NEWUSER, CLONE_NEWNS, CLONE_NEWPID, CLONE_NEWUTS, CLONE_NEWIPC, CLONE_NEWNET };
+    pid_t helper = fork();
+    if (helper == 0) {
+        char pid_str[16];
+        snprintf(pid_str, sizeof(pid_str), "%d", getpid());
+        int fd = open(procs_path, O_WRONLY | O_CLOEXEC);
+        if (fd == -1 || write(fd, pid_str, strlen(pid_str)) <= 0) _exit(1);
+        close(fd);
+        for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+            if (!namespace_exists(target, types[i]) || join_namespace(target, types[i]) != 0) _exit(1);
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            execv(true_argv[0], true_argv);
+            _exit(127);
+        }
+        int status;
+        _exit(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+    }
+    int status;
+    return helper > 0 && waitpid(helper, &status, 0) == helper && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int exec_by_pidfd(int pidfd, const char *cgroup_path) {
+    int cgroup_fd = open(cgroup_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    pid_t pid = namespace_exec(pidfd, NAMESPACE_EXEC_TYPES, cgroup_fd, NULL, true_argv);
+    close(cgroup_fd);
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 500;
+
+    const char *cgroup_root = access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0 ? "/sys/fs/cgroup"
+                                                                                    : "/sys/fs/cgroup/unified";
+    char cgroup_path[256], procs_path[300];
+    snprintf(cgroup_path, sizeof(cgroup_path), "%s/exec_bench", cgroup_root);
+    snprintf(procs_path, sizeof(procs_path), "%s/cgroup.procs", cgroup_path);
+    if (create_directory(cgroup_path, 0755) != 0) {
+        return 1;
+    }
+
+    if (pipe(hold_pipe) != 0) {
+        return 1;
+    }
+    const int stack_size = 256 * 1024;
+    char *stack = malloc(stack_size);
+    int pidfd = -1;
+    pid_t target = clone(target_main, stack + stack_size, NAMESPACE_EXEC_TYPES | CLONE_PIDFD | SIGCHLD, NULL, &pidfd);
+    if (target == -1) {
+        perror("clone");
+        return 1;
+    }
+    close(hold_pipe[0]);
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/uid_map", target);
+    write_file(path, "0 0 1");
+    snprintf(path, sizeof(path), "/proc/%d/setgroups", target);
+    write_file(path, "deny");
+    snprintf(path, sizeof(path), "/proc/%d/gid_map", target);
+    write_file(path, "0 0 1");
+
+    printf("%d بار اجرای /bin/true در namespace ها و cgroup فرآیند مقصد\n", iterations);
+
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        if (exec_by_path(target, procs_path) != 0) {
+            fprintf(stderr, "خطا در اجرای مسیرمحور\n");
+            return 1;
+        }
+    }
+    printf("%-16s %8.0f µs/exec\n", "/proc و setns", (now_seconds() - start) / iterations * 1e6);
+
+    start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        if (exec_by_pidfd(pidfd, cgroup_path) != 0) {
+            fprintf(stderr, "خطا در اجرای pidfd\n");
+            return 1;
+        }
+    }
+    printf("%-16s %8.0f µs/exec\n", "pidfd", (now_seconds() - start) / iterations * 1e6);
+
+    close(hold_pipe[1]);
+    waitpid(target, NULL, 0);
+    close(pidfd);
+    free(stack);
+    rmdir(cgroup_path);
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "../include/forkserver.h"
+#include "../include/utils.h"
+
+// بنچمارک fork-server: برنامه‌ای با مقداردهی سنگین (ساخت جدول چند ده مگابایتی) برای هر نمونه یک بار
+// با exec و مقداردهی کامل اجرا می‌شود، در مقایسه با یک بار مقداردهی و fork هر نمونه در cgroup خود
+// استفاده: forkserver_bench [تعداد نمونه] [مگابایت جدول]
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// برنامه کانتینر: مقداردهی، سپس کار کوچک هر نمونه
+static int app_main(size_t table_mb) {
+    size_t count = table_mb * 1024 * 1024 / sizeof(uint64_t);
+    uint64_t *table = malloc(count * sizeof(uint64_t));
+    if (!table) {
+        return 1;
+    }
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        table[i] = state;
+    }
+
+    int channel = forkserver_run();
+    if (channel == -1) {
+        return 0;
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i += count / 64) {
+        sum += table[i];
+    }
+    return sum == 0;
+}
+
+static const char *self_path;
+
+static int run_exec(size_t table_mb) {
+    char mb[16];
+    snprintf(mb, sizeof(mb), "%zu", table_mb);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl(self_path, self_path, "--app", mb, NULL);
+        _exit(127);
+    }
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--app") == 0) {
+        return app_main(atoi(argv[2]));
+    }
+    int instances = argc > 1 ? atoi(argv[1]) : 50;
+    size_t table_mb = argc > 2 ? atoi(argv[2]) : 64;
+
+    char self[512];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        return 1;
+    }
+    self[length] = '\0';
+    self_path = self;
+
+    const char *cgroup_root = access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0 ? "/sys/fs/cgroup"
+                                                                                    : "/sys/fs/cgroup/unified";
+    char base[256], cgroup_path[300];
+    snprintf(base, sizeof(base), "%s/forkserver_bench", cgroup_root);
+    if (create_directory(base, 0755) != 0) {
+        return 1;
+    }
+
+    printf("%d نمونه، جدول %zu MB\n", instances, table_mb);
+
+    double start = now_seconds();
+    for (int i = 0; i < instances; i++) {
+        if (run_exec(table_mb) != 0) {
+            fprintf(stderr, "خطا در اجرای نمونه با exec\n");
+            return 1;
+        }
+    }
+    printf("%-22s %8.2f ms/نمونه\n", "exec و مقداردهی", (now_seconds() - start) / instances * 1e3);
+
+    // سرور یک بار مقداردهی می‌شود
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) {
+        return 1;
+    }
+    start = now_seconds();
+    pid_t server = fork();
+    if (server == 0) {
+        close(sv[0]);
+        char fd_text[16], mb[16];
+        snprintf(fd_text, sizeof(fd_text), "%d", sv[1]);
+        snprintf(mb, sizeof(mb), "%zu", table_mb);
+        setenv(FORKSERVER_ENV, fd_text, 1);
+        execl(self_path, self_path, "--app", mb, NULL);
+        _exit(127);
+    }
+    close(sv[1]);
+    if (forkserver_wait_ready(sv[0], -1) != 0) {
+        return 1;
+    }
+    printf("%-22s %8.2f ms\n", "مقداردهی سرور", (now_seconds() - start) * 1e3);
+
+    start = now_seconds();
+    for (int i = 0; i < instances; i++) {
+        forkserver_instance_t instance;
+        snprintf(cgroup_path, sizeof(cgroup_path), "%s/instance-%d", base, i);
+        if (forkserver_fork(sv[0], i, cgroup_path, 0, &instance) != 0) {
+            fprintf(stderr, "خطا در ساخت نمونه با fork-server\n");
+            return 1;
+        }
+        forkserver_instance_wait(&instance, -1);
+        forkserver_instance_destroy(&instance);
+    }
+    printf("%-22s %8.2f ms/نمونه\n", "fork-server و cgroup", (now_seconds() - start) / instances * 1e3);
+
+    close(sv[0]);
+    waitpid(server, NULL, 0);
+    rmdir(base);
+    return 0;
+}
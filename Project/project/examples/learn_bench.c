@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/seccomp.h>
+#include <linux/filter.h>
+#include "../include/syslearn.h"
+#include "../include/utils.h"
+
+// بنچمارک سربار یادگیری syscall: حلقه getpid بدون ضبط، با برنامه eBPF روی sys_enter برای فرآیندی بیرون
+// و درون cgroup ضبط، و با seccomp RET_USER_NOTIF که هر syscall را به یک thread ناظر می‌فرستد و با
+// SECCOMP_USER_NOTIF_FLAG_CONTINUE ادامه می‌دهد
+// استفاده: learn_bench [تکرار]
+
+#define PROFILE_PATH "/tmp/learn_bench.profile"
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double getpid_loop(int iterations) {
+    double start = now_seconds();
+    for (int i = 0; i < iterations; i++) {
+        syscall(SYS_getpid);
+    }
+    return (now_seconds() - start) / iterations * 1e9;
+}
+
+// اجرای حلقه در فرزند؛ با procs_path فرزند پیش از اجرای دوباره همین باینری به cgroup می‌رود تا
+// execve شمارش را آغاز کند
+static double run_child(const char *self, int iterations, const char *procs_path) {
+    int result[2];
+    if (pipe(result) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(result[0]);
+        if (!procs_path) {
+            double ns = getpid_loop(iterations);
+            _exit(write(result[1], &ns, sizeof(ns)) == sizeof(ns) ? 0 : 1);
+        }
+        char pid_str[16], count[16], fd_str[16];
+        snprintf(pid_str, sizeof(pid_str), "%d", getpid());
+        int fd = open(procs_path, O_WRONLY | O_CLOEXEC);
+        if (fd == -1 || write(fd, pid_str, strlen(pid_str)) <= 0) _exit(1);
+        close(fd);
+        snprintf(count, sizeof(count), "%d", iterations);
+        snprintf(fd_str, sizeof(fd_str), "%d", result[1]);
+        execl(self, self, "--loop", count, fd_str, NULL);
+        _exit(1);
+    }
+    close(result[1]);
+    double ns = -1;
+    if (pid == -1 || read(result[0], &ns, sizeof(ns)) != sizeof(ns)) {
+        ns = -1;
+    }
+    close(result[0]);
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+    return ns;
+}
+
+static volatile int listener_fd = -1;
+static uint64_t notif_counts[1024];
+
+// ناظر پیش از نصب فیلتر ساخته می‌شود تا فیلتر را به ارث نبرد؛ تا آماده شدن توصیف‌گر بدون syscall
+// فیلترشده منتظر می‌ماند چون نوشتن در pipe از thread اصلی خود به ناظر ارسال می‌شود
+static void *supervisor_main(void *arg) {
+    (void)arg;
+    while (listener_fd == -1) {
+        sched_yield();
+    }
+    struct seccomp_notif req;
+    struct seccomp_notif_resp resp;
+    for (;;) {
+        memset(&req, 0, sizeof(req));
+        if (ioctl(listener_fd, SECCOMP_IOCTL_NOTIF_RECV, &req) != 0) {
+            return NULL;
+        }
+        notif_counts[req.data.nr & 1023]++;
+        memset(&resp, 0, sizeof(resp));
+        resp.id = req.id;
+        resp.flags = SECCOMP_USER_NOTIF_FLAG_CONTINUE;
+        ioctl(listener_fd, SECCOMP_IOCTL_NOTIF_SEND, &resp);
+    }
+}
+
+static double run_user_notif(int iterations) {
+    int result[2];
+    if (pipe(result) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(result[0]);
+        pthread_t supervisor;
+        if (pthread_create(&supervisor, NULL, supervisor_main, NULL) != 0) _exit(1);
+        struct sock_filter filter[] = { BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_USER_NOTIF) };
+        struct sock_fprog prog = { 1, filter };
+        int fd = syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, SECCOMP_FILTER_FLAG_NEW_LISTENER, &prog);
+        if (fd < 0) _exit(1);
+        listener_fd = fd;
+        double ns = getpid_loop(iterations);
+        _exit(write(result[1], &ns, sizeof(ns)) == sizeof(ns) ? 0 : 1);
+    }
+    close(result[1]);
+    double ns = -1;
+    if (pid == -1 || read(result[0], &ns, sizeof(ns)) != sizeof(ns)) {
+        ns = -1;
+    }
+    close(result[0]);
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+    return ns;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "--loop") == 0) {
+        double ns = getpid_loop(atoi(argv[2]));
+        return write(atoi(argv[3]), &ns, sizeof(ns)) == sizeof(ns) ? 0 : 1;
+    }
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    char self[512];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        return 1;
+    }
+    self[length] = '\0';
+
+    const char *cgroup_root = access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0 ? "/sys/fs/cgroup"
+                                                                                    : "/sys/fs/cgroup/unified";
+    char cgroup_path[256], procs_path[300];
+    snprintf(cgroup_path, sizeof(cgroup_path), "%s/learn_bench", cgroup_root);
+    snprintf(procs_path, sizeof(procs_path), "%s/cgroup.procs", cgroup_path);
+    if (create_directory(cgroup_path, 0755) != 0) {
+        return 1;
+    }
+
+    printf("%d بار getpid\n", iterations);
+    printf("%-28s %8.1f ns/syscall\n", "بدون ضبط", run_child(self, iterations, NULL));
+
+    if (syslearn_start("learn_bench", cgroup_path, PROFILE_PATH) != 0) {
+        rmdir(cgroup_path);
+        return 1;
+    }
+    printf("%-28s %8.1f ns/syscall\n", "eBPF، فرآیند بیرون cgroup", run_child(self, iterations, NULL));
+    printf("%-28s %8.1f ns/syscall\n", "eBPF، فرآیند درون cgroup", run_child(self, iterations, procs_path));
+    syslearn_finish("learn_bench");
+    unlink(PROFILE_PATH);
+    rmdir(cgroup_path);
+
+    printf("%-28s %8.1f ns/syscall\n", "seccomp RET_USER_NOTIF", run_user_notif(iterations / 20));
+    return 0;
+}
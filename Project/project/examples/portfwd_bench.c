@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "../include/portfwd.h"
+#include "../include/utils.h"
+
+// بنچمارک انتقال پورت روی loopback: اتصال مستقیم، پراکسی splice (portfwd) و پراکسی read/write با
+// یک thread برای هر جهت؛ پهنای باند یک اتصال حجیم (Gbps)، زمان CPU کل فرآیند برای هر GB (اختلاف با
+// اتصال مستقیم هزینه پراکسی است) و اتصال کوتاه در ثانیه
+// استفاده: portfwd_bench [MB] [اتصال]
+
+#define CHUNK_SIZE (64 * 1024)
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static int listen_loopback(uint16_t *port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof(address);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (fd == -1 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        getsockname(fd, (struct sockaddr *)&address, &length) != 0) {
+        perror("listen");
+        exit(1);
+    }
+    *port = ntohs(address.sin_port);
+    return fd;
+}
+
+static int connect_port(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port),
+                                   .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// سرویس مقصد: خواندن تا EOF و پاسخ یک بایتی؛ اتصال‌ها پشت سر هم پذیرفته می‌شوند
+static void* backend_main(void *arg) {
+    int listener = (int)(intptr_t)arg;
+    static char buffer[CHUNK_SIZE];
+    int fd;
+    while ((fd = accept(listener, NULL, NULL)) != -1) {
+        while (read(fd, buffer, sizeof(buffer)) > 0) {
+        }
+        if (write(fd, "k", 1) != 1) {
+            perror("write");
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+// پراکسی پایه: کپی با read/write در فضای کاربر
+static void* copy_direction(void *arg) {
+    int *fds = arg;
+    char buffer[CHUNK_SIZE];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+        ssize_t done = 0;
+        while (done < n) {
+            ssize_t written = write(fds[1], buffer + done, n - done);
+            if (written <= 0) goto out;
+            done += written;
+        }
+    }
+out:
+    shutdown(fds[1], SHUT_WR);
+    return NULL;
+}
+
+static uint16_t copy_target;
+
+static void* copy_connection(void *arg) {
+    int client = (int)(intptr_t)arg;
+    int upstream = connect_port(copy_target);
+    if (upstream != -1) {
+        int one = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(upstream, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        int forward[2] = { client, upstream }, backward[2] = { upstream, client };
+        pthread_t thread;
+        pthread_create(&thread, NULL, copy_direction, backward);
+        copy_direction(forward);
+        pthread_join(thread, NULL);
+        close(upstream);
+    }
+    close(client);
+    return NULL;
+}
+
+static void* copy_proxy_main(void *arg) {
+    int listener = (int)(intptr_t)arg;
+    int fd;
+    while ((fd = accept(listener, NULL, NULL)) != -1) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, copy_connection, (void *)(intptr_t)fd);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+// ارسال megabytes و انتظار برای پاسخ مقصد پس از دریافت کامل
+static double throughput(uint16_t port, size_t megabytes) {
+    static char buffer[CHUNK_SIZE];
+    double start = now_seconds();
+    int fd = connect_port(port);
+    if (fd == -1) return -1;
+    for (size_t sent = 0; sent < megabytes * 1024 * 1024; sent += CHUNK_SIZE) {
+        size_t done = 0;
+        while (done < CHUNK_SIZE) {
+            ssize_t n = write(fd, buffer + done, CHUNK_SIZE - done);
+            if (n <= 0) return -1;
+            done += n;
+        }
+    }
+    shutdown(fd, SHUT_WR);
+    char ack;
+    int ok = read(fd, &ack, 1) == 1;
+    close(fd);
+    double elapsed = now_seconds() - start;
+    return ok ? megabytes * 1024.0 * 1024 * 8 / elapsed / 1e9 : -1;
+}
+
+// اتصال کوتاه: یک بایت، نیمه‌بستن و پاسخ
+static double connection_rate(uint16_t port, int connections) {
+    double start = now_seconds();
+    for (int i = 0; i < connections; i++) {
+        int fd = connect_port(port);
+        char ack;
+        if (fd == -1 || write(fd, "x", 1) != 1 || shutdown(fd, SHUT_WR) != 0 || read(fd, &ack, 1) != 1) {
+            return -1;
+        }
+        close(fd);
+    }
+    return connections / (now_seconds() - start);
+}
+
+static void run(const char *name, uint16_t port, size_t megabytes, int connections) {
+    double cpu = cpu_seconds();
+    double gbps = throughput(port, megabytes);
+    cpu = (cpu_seconds() - cpu) / (megabytes / 1024.0);
+    printf("%-12s %8.2f Gbps %8.0f ms CPU/GB %10.0f اتصال/ثانیه\n", name, gbps, cpu * 1000,
+           connection_rate(port, connections));
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? (size_t)atoi(argv[1]) : 4096;
+    int connections = argc > 2 ? atoi(argv[2]) : 5000;
+    signal(SIGPIPE, SIG_IGN);
+
+    uint16_t backend_port, copy_port;
+    int backend = listen_loopback(&backend_port);
+    int copy = listen_loopback(&copy_port);
+    copy_target = backend_port;
+    pthread_t thread;
+    pthread_create(&thread, NULL, backend_main, (void *)(intptr_t)backend);
+    pthread_create(&thread, NULL, copy_proxy_main, (void *)(intptr_t)copy);
+
+    int id = portfwd_add(0, -1, htonl(INADDR_LOOPBACK), backend_port);
+    if (id < 0) {
+        return 1;
+    }
+
+    printf("loopback، %zu MB و %d اتصال کوتاه\n", megabytes, connections);
+    run("مستقیم", backend_port, megabytes, connections);
+    run("splice", portfwd_port(id), megabytes, connections);
+    run("read/write", copy_port, megabytes, connections);
+
+    portfwd_stop();
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "../include/container.h"
+#include "../include/ipc.h"
+#include "../include/rpc.h"
+#include "../include/utils.h"
+
+// بنچمارک زمان رفت و برگشت RPC بین دو فرآیند روی یک میزبان
+
+#define CALLS 200000
+#define BATCH 32
+
+// پردازش‌گر echo
+static int echo_handler(uint32_t method, const void *request, size_t request_size,
+                        void *response, size_t response_capacity, void *user_data) {
+    (void)method;
+    (void)user_data;
+    if (request_size > response_capacity) {
+        return -1;
+    }
+    memcpy(response, request, request_size);
+    return (int)request_size;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// اجرای یک سناریو با مدت busy-polling مشخص برای سرور
+static void run_scenario(container_config_t *config, unsigned server_spin_us, const char *label) {
+    rpc_server_t *server = rpc_server_create(config, "bench_rpc", echo_handler, NULL);
+    rpc_client_t *client = rpc_client_create(server, config, "client", 64, 256);
+    rpc_server_set_spin(server, server_spin_us);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        rpc_server_run(server);
+        _exit(0);
+    }
+
+    char request[64] = "ping", response[256];
+    uint64_t *latencies = malloc(sizeof(uint64_t) * CALLS);
+
+    // گرم‌کردن
+    for (int i = 0; i < 10000; i++) {
+        rpc_call(client, 1, request, sizeof(request), response, sizeof(response), 1000);
+    }
+
+    // فراخوانی‌های تکی
+    for (int i = 0; i < CALLS; i++) {
+        uint64_t start = monotonic_time_ns();
+        rpc_call(client, 1, request, sizeof(request), response, sizeof(response), 1000);
+        latencies[i] = monotonic_time_ns() - start;
+    }
+    qsort(latencies, CALLS, sizeof(uint64_t), compare_u64);
+    uint64_t total = 0;
+    for (int i = 0; i < CALLS; i++) {
+        total += latencies[i];
+    }
+
+    // فراخوانی‌های دسته‌ای: BATCH درخواست با یک doorbell
+    uint64_t batch_start = monotonic_time_ns();
+    for (int i = 0; i < CALLS / BATCH; i++) {
+        for (int j = 0; j < BATCH; j++) {
+            rpc_submit(client, 1, request, sizeof(request), NULL);
+        }
+        rpc_flush(client);
+        for (int j = 0; j < BATCH; j++) {
+            rpc_wait_completion(client, NULL, NULL, response, sizeof(response), 1000);
+        }
+    }
+    double batch_seconds = (monotonic_time_ns() - batch_start) / 1e9;
+
+    printf("%-22s avg %6.2f us  p50 %6.2f us  p99 %7.2f us  batch(%d) %6.2f M req/s\n", label,
+           total / (double)CALLS / 1000.0, latencies[CALLS / 2] / 1000.0,
+           latencies[(CALLS * 99) / 100] / 1000.0, BATCH, (CALLS / BATCH) * BATCH / batch_seconds / 1e6);
+
+    rpc_server_stop(server);
+    waitpid(pid, NULL, 0);
+    free(latencies);
+    rpc_server_destroy(server);
+}
+
+int main() {
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "bench");
+
+    // سرور با busy-polling: بدون فراخوانی سیستمی در مسیر داغ
+    run_scenario(&config, 1000000, "server busy-polling");
+    // سرور بدون busy-polling: هر فراخوانی سرور را با futex بیدار می‌کند
+    run_scenario(&config, 0, "server futex wakeup");
+
+    ipc_cleanup();
+    return 0;
+}
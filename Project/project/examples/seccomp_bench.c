@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/seccomp.h>
+#include <linux/audit.h>
+#include "../include/seccomp.h"
+#include "../include/utils.h"
+
+// بنچمارک فیلتر seccomp: حلقه getpid/read زیر فهرست خطی allow (به ترتیب الفبایی، مانند پروفایل‌های رایج)
+// در مقایسه با درخت ترجمه‌شده، بدون و با شمارش فراخوانی‌ها. هسته از 5.11 تصمیم ALLOW ثابت هر syscall را
+// cache می‌کند و فیلتر را اجرا نمی‌کند؛ در دور "بدون cache" یک بارگذاری args[0] در ابتدای فیلتر این
+// cache را غیرفعال می‌کند تا هزینه اجرای فیلتر (مانند هسته‌های قدیمی‌تر یا پروفایل‌های با شرط آرگومان) دیده شود
+// استفاده: seccomp_bench [تکرار]
+
+// syscall هایی که در پروفایل آزمایشی رد می‌شوند
+static const char *denied[] = { "ptrace", "kexec_load", "init_module", "finit_module", "delete_module", "reboot",
+                                "swapon", "swapoff", "mount", "umount2", "pivot_root", "bpf", "perf_event_open" };
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(seccomp_syscall_name(*(const int *)a), seccomp_syscall_name(*(const int *)b));
+}
+
+static void build_profile(seccomp_profile_t *profile, int *allowed, int *allowed_count) {
+    profile->default_action = SECCOMP_ACTION_ERRNO;
+    profile->rule_count = 0;
+    *allowed_count = 0;
+    for (int nr = 0; nr < SECCOMP_MAX_SYSCALL; nr++) {
+        const char *name = seccomp_syscall_name(nr);
+        if (!name) {
+            continue;
+        }
+        bool deny = false;
+        for (size_t i = 0; i < sizeof(denied) / sizeof(denied[0]); i++) {
+            deny = deny || strcmp(name, denied[i]) == 0;
+        }
+        if (!deny) {
+            seccomp_profile_add(profile, nr, SECCOMP_ACTION_ALLOW, 0);
+            allowed[(*allowed_count)++] = nr;
+        }
+    }
+    qsort(allowed, *allowed_count, sizeof(int), compare_names);
+}
+
+// فهرست خطی: یک JEQ برای هر syscall مجاز تا RET ALLOW مشترک در انتها
+static int compile_linear(const int *allowed, int count, struct sock_filter *prog) {
+    int len = 0;
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch));
+    prog[len++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0);
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS);
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr));
+    for (int i = 0; i < count; i++) {
+        int to_allow = count - i;
+        if (to_allow <= 255) {
+            prog[len++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, allowed[i], to_allow, 0);
+        } else {
+            prog[len++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, allowed[i], 0, 1);
+            prog[len++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JA | BPF_K, 0, 0, 0);
+        }
+    }
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | 1);
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+    // مقصد پرش‌های بلند پس از مشخص شدن طول برنامه
+    for (int i = 4; i < len - 2; i++) {
+        if (prog[i].code == (BPF_JMP | BPF_JA | BPF_K)) {
+            prog[i].k = len - 1 - (i + 1);
+        }
+    }
+    return len;
+}
+
+// بارگذاری آرگومان در ابتدای فیلتر که شبیه‌سازی هسته برای cache تصمیم‌ها را متوقف می‌کند
+static int disable_cache(struct sock_filter *prog, int len) {
+    memmove(&prog[1], &prog[0], len * sizeof(prog[0]));
+    prog[0] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, args[0]));
+    return len + 1;
+}
+
+// اجرای حلقه در فرزندی که فیلتر را نصب می‌کند؛ نانوثانیه به ازای هر syscall
+static double run(const struct sock_filter *prog, int len, int iterations) {
+    int result[2];
+    if (pipe(result) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(result[0]);
+        int fd = open("/dev/zero", O_RDONLY | O_CLOEXEC);
+        if (fd == -1 || (len > 0 && seccomp_install(prog, len) != 0)) {
+            _exit(1);
+        }
+        char byte;
+        double start = now_seconds();
+        for (int i = 0; i < iterations; i++) {
+            syscall(SYS_getpid);
+            if (read(fd, &byte, 1) != 1) {
+                _exit(1);
+            }
+        }
+        double ns = (now_seconds() - start) / (2.0 * iterations) * 1e9;
+        if (write(result[1], &ns, sizeof(ns)) != sizeof(ns)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(result[1]);
+    double ns = -1;
+    if (pid == -1 || read(result[0], &ns, sizeof(ns)) != sizeof(ns)) {
+        ns = -1;
+    }
+    close(result[0]);
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+    return ns;
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000000;
+
+    static seccomp_profile_t profile, counted;
+    static int allowed[SECCOMP_MAX_SYSCALL];
+    static struct sock_filter linear[SECCOMP_MAX_INSNS], tree[SECCOMP_MAX_INSNS], hot[SECCOMP_MAX_INSNS];
+    int allowed_count;
+    build_profile(&profile, allowed, &allowed_count);
+
+    // پروفایل ضبط‌شده: همان قاعده‌ها با شمارش فراخوانی‌های حلقه و چند syscall کم‌تکرار
+    counted = profile;
+    seccomp_profile_add(&counted, SYS_getpid, SECCOMP_ACTION_ALLOW, iterations);
+    seccomp_profile_add(&counted, SYS_read, SECCOMP_ACTION_ALLOW, iterations);
+    seccomp_profile_add(&counted, SYS_write, SECCOMP_ACTION_ALLOW, 10);
+    seccomp_profile_add(&counted, SYS_clock_gettime, SECCOMP_ACTION_ALLOW, 2);
+
+    int linear_len = compile_linear(allowed, allowed_count, linear);
+    int tree_len = seccomp_compile(&profile, tree, SECCOMP_MAX_INSNS - 1);
+    int hot_len = seccomp_compile(&counted, hot, SECCOMP_MAX_INSNS - 1);
+    if (tree_len == -1 || hot_len == -1) {
+        return 1;
+    }
+
+    printf("%d syscall مجاز، %d رد؛ %d بار getpid و read\n", allowed_count,
+           (int)(sizeof(denied) / sizeof(denied[0])), iterations);
+    printf("%-14s %6s %14s %14s\n", "فیلتر", "دستور", "ns (cache)", "ns (بدون cache)");
+    printf("%-14s %6d %14.1f %14s\n", "بدون فیلتر", 0, run(NULL, 0, iterations), "-");
+
+    const char *names[] = { "فهرست خطی", "درخت", "درخت + شمارش" };
+    struct sock_filter *progs[] = { linear, tree, hot };
+    int lengths[] = { linear_len, tree_len, hot_len };
+    for (int i = 0; i < 3; i++) {
+        double cached = run(progs[i], lengths[i], iterations);
+        int uncached_len = disable_cache(progs[i], lengths[i]);
+        printf("%-14s %6d %14.1f %14.1f\n", names[i], lengths[i], cached, run(progs[i], uncached_len, iterations));
+    }
+    return 0;
+}
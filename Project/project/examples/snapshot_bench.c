@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "../include/snapshot.h"
+#include "../include/filesystem.h"
+#include "../include/layerstore.h"
+#include "../include/reaper.h"
+#include "../include/utils.h"
+
+// بنچمارک snapshotter ها: زمان آماده‌سازی rootfs، بار کاری پر از copy-up و پاک‌سازی
+// استفاده: snapshot_bench (نیاز به root)
+
+#define BENCH_DIR "/tmp/snapshot_bench"
+#define BENCH_LAYER "sha256:5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5eb5"
+#define SMALL_FILES 2000
+#define SMALL_FILE_SIZE 4096
+#define LARGE_FILES 64
+#define LARGE_FILE_SIZE (1024 * 1024)
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int write_file(const char *path, const char *data, size_t size) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1 || write(fd, data, size) != (ssize_t)size) {
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+// لایه نمونه با نقاط نصب ضروری، فایل‌های کوچک زیاد و چند فایل بزرگ
+static int build_layer(const char *root) {
+    char path[512];
+    char *data = malloc(LARGE_FILE_SIZE);
+    if (!data) return -1;
+    for (size_t i = 0; i < LARGE_FILE_SIZE; i++) {
+        data[i] = (char)rand();
+    }
+
+    const char *dirs[] = { "", "/proc", "/sys", "/dev", "/tmp", "/small", "/large" };
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", root, dirs[i]);
+        mkdir(path, 0755);
+    }
+
+    int result = 0;
+    for (int i = 0; i < SMALL_FILES && result == 0; i++) {
+        snprintf(path, sizeof(path), "%s/small/file%d", root, i);
+        data[0] = (char)i;
+        data[1] = (char)(i >> 8);
+        result = write_file(path, data, SMALL_FILE_SIZE);
+    }
+    for (int i = 0; i < LARGE_FILES && result == 0; i++) {
+        snprintf(path, sizeof(path), "%s/large/file%d", root, i);
+        data[0] = (char)i;
+        result = write_file(path, data, LARGE_FILE_SIZE);
+    }
+
+    free(data);
+    return result;
+}
+
+// افزودن یک بایت به همه فایل‌ها؛ در overlay هر نوشتن copy-up کامل فایل را در پی دارد
+static int copy_up_workload(const char *rootfs) {
+    char path[1024];
+    for (int i = 0; i < SMALL_FILES + LARGE_FILES; i++) {
+        if (i < SMALL_FILES) {
+            snprintf(path, sizeof(path), "%s/small/file%d", rootfs, i);
+        } else {
+            snprintf(path, sizeof(path), "%s/large/file%d", rootfs, i - SMALL_FILES);
+        }
+        int fd = open(path, O_WRONLY | O_APPEND);
+        if (fd == -1) return -1;
+        if (write(fd, "x", 1) != 1) {
+            close(fd);
+            return -1;
+        }
+        close(fd);
+    }
+    return 0;
+}
+
+static void run_snapshotter(snapshot_type_t type) {
+    const snapshotter_t *snapshotter = snapshotter_get(type);
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.id, sizeof(config.id), "bench-%s", snapshotter->name);
+    snprintf(config.rootfs, sizeof(config.rootfs), "/var/lib/simplecontainer/rootfs/%s", config.id);
+    snprintf(config.overlay_workdir, sizeof(config.overlay_workdir), "/var/lib/simplecontainer/overlays/%s", config.id);
+    strncpy(config.image_layers[0], BENCH_LAYER, sizeof(config.image_layers[0]) - 1);
+    config.image_layer_count = 1;
+    config.snapshotter = type;
+
+    if (system("sync; echo 3 > /proc/sys/vm/drop_caches") != 0) {
+        // بدون دسترسی به drop_caches نتایج با حافظه نهان گرم است
+    }
+
+    double start = now_seconds();
+    if (prepare_container_directories(&config) != 0 || snapshotter->prepare(&config) != 0) {
+        printf("%-10s خطا در آماده‌سازی\n", snapshotter->name);
+        return;
+    }
+    double prepared = now_seconds();
+
+    // bind فقط‌خواندنی است و نوشتن در آن انتظار نمی‌رود
+    int workload = type == SNAPSHOT_BIND ? -1 : copy_up_workload(config.rootfs);
+    double written = now_seconds();
+
+    if (snapshotter->cleanup(&config) != 0) {
+        printf("%-10s خطا در پاک‌سازی\n", snapshotter->name);
+        return;
+    }
+    double cleaned = now_seconds();
+
+    char workload_time[32] = "-";
+    if (workload == 0) {
+        snprintf(workload_time, sizeof(workload_time), "%.1f", (written - prepared) * 1000);
+    }
+    printf("%-10s %12.1f %12s %12.1f\n", snapshotter->name,
+           (prepared - start) * 1000, workload_time, (cleaned - written) * 1000);
+}
+
+int main() {
+    if (getuid() != 0) {
+        fprintf(stderr, "این بنچمارک نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+
+    if (system("rm -rf " BENCH_DIR " && mkdir -p " BENCH_DIR) != 0 ||
+        build_layer(BENCH_DIR "/layer") != 0) {
+        fprintf(stderr, "خطا در ساخت لایه نمونه\n");
+        return 1;
+    }
+    if (layer_store_init() != 0 || reaper_init() != 0 ||
+        layer_store_import_dir(BENCH_LAYER, BENCH_DIR "/layer") != 0) {
+        fprintf(stderr, "خطا در وارد کردن لایه نمونه\n");
+        return 1;
+    }
+
+    printf("لایه: %d فایل %d KB و %d فایل %d MB\n", SMALL_FILES, SMALL_FILE_SIZE / 1024,
+           LARGE_FILES, LARGE_FILE_SIZE / (1024 * 1024));
+    printf("%-10s %12s %12s %12s\n", "snapshot", "prepare ms", "copy-up ms", "cleanup ms");
+
+    // reaper پس‌زمینه اجرا نمی‌شود تا هزینه حذف در ستون پاک‌سازی دیده شود
+    run_snapshotter(SNAPSHOT_OVERLAY);
+    run_snapshotter(SNAPSHOT_TMPFS);
+    run_snapshotter(SNAPSHOT_REFLINK);
+    run_snapshotter(SNAPSHOT_BIND);
+
+    layer_store_gc();
+    if (system("rm -rf " BENCH_DIR) != 0) {
+        return 1;
+    }
+    return 0;
+}
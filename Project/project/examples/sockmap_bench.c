@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "../include/sockmap.h"
+#include "../include/bpfprog.h"
+#include "../include/utils.h"
+
+// بنچمارک TCP روی 127.0.0.1 با و بدون شتاب sockmap: پهنای باند با نوشتن‌های 64KB و
+// تأخیر رفت و برگشت پیام 64 بایتی با TCP_NODELAY؛ استفاده: sockmap_bench [MB] [رفت و برگشت]؛ نیاز به root
+
+#define CHUNK_SIZE (64 * 1024)
+#define MESSAGE_SIZE 64
+
+static char cgroup_root[256];
+static char bench_cgroup[512];
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int move_self(const char *cgroup) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", cgroup);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+    int result = write(fd, "0", 1) == 1 ? 0 : -1;
+    close(fd);
+    return result;
+}
+
+static int connected_pair(int *client, int *server) {
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof(address);
+    if (listener == -1 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, 1) != 0 || getsockname(listener, (struct sockaddr *)&address, &length) != 0) {
+        perror("listen");
+        return -1;
+    }
+    *client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect(*client, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        perror("connect");
+        return -1;
+    }
+    *server = accept(listener, NULL, NULL);
+    close(listener);
+    int one = 1;
+    setsockopt(*client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(*server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return *server == -1 ? -1 : 0;
+}
+
+static int read_full(int fd, char *buffer, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, buffer + done, size - done);
+        if (n <= 0) return -1;
+        done += n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const char *buffer, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, buffer + done, size - done);
+        if (n <= 0) return -1;
+        done += n;
+    }
+    return 0;
+}
+
+static double throughput(size_t megabytes) {
+    int client, server;
+    if (connected_pair(&client, &server) != 0) return -1;
+    static char buffer[CHUNK_SIZE];
+    size_t total = megabytes * 1024 * 1024;
+    double start = now_seconds();
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (size_t sent = 0; sent < total; sent += CHUNK_SIZE) {
+            if (write_full(client, buffer, CHUNK_SIZE) != 0) _exit(1);
+        }
+        _exit(0);
+    }
+    size_t received = 0;
+    while (received < total) {
+        ssize_t n = read(server, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        received += n;
+    }
+    double elapsed = now_seconds() - start;
+    waitpid(pid, NULL, 0);
+    close(client);
+    close(server);
+    return received == total ? total / elapsed / (1024 * 1024) : -1;
+}
+
+static double round_trip(int iterations) {
+    int client, server;
+    if (connected_pair(&client, &server) != 0) return -1;
+    char message[MESSAGE_SIZE];
+    memset(message, 'x', sizeof(message));
+    pid_t pid = fork();
+    if (pid == 0) {
+        char reply[MESSAGE_SIZE];
+        for (int i = 0; i < iterations; i++) {
+            if (read_full(server, reply, sizeof(reply)) != 0 || write_full(server, reply, sizeof(reply)) != 0) {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    double start = now_seconds();
+    int completed = 0;
+    for (; completed < iterations; completed++) {
+        if (write_full(client, message, sizeof(message)) != 0 || read_full(client, message, sizeof(message)) != 0) {
+            break;
+        }
+    }
+    double elapsed = now_seconds() - start;
+    waitpid(pid, NULL, 0);
+    close(client);
+    close(server);
+    return completed == iterations ? elapsed / iterations * 1e6 : -1;
+}
+
+static void run(const char *name, size_t megabytes, int iterations) {
+    printf("%-12s %10.0f MB/s %10.1f µs/رفت و برگشت\n", name, throughput(megabytes), round_trip(iterations));
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? (size_t)atoi(argv[1]) : 1024;
+    int iterations = argc > 2 ? atoi(argv[2]) : 50000;
+    if (getuid() != 0) {
+        fprintf(stderr, "این بنچمارک نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+
+    // bpffs خصوصی تا نسخه pin‌شده میزبان دست نخورد؛ cgroup جدا برای اتصال sockops
+    if (unshare(CLONE_NEWNS) != 0 || mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) != 0 ||
+        mount("bpf", BPF_FS_PATH, "bpf", 0, "mode=0700") != 0) {
+        perror("mount");
+        return 1;
+    }
+    strcpy(cgroup_root, access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0 ? "/sys/fs/cgroup"
+                                                                                : "/sys/fs/cgroup/unified");
+    snprintf(bench_cgroup, sizeof(bench_cgroup), "%s/sockmap_bench", cgroup_root);
+    if (create_directory(bench_cgroup, 0755) != 0 || move_self(bench_cgroup) != 0) {
+        fprintf(stderr, "خطا در ایجاد cgroup %s\n", bench_cgroup);
+        return 1;
+    }
+
+    printf("TCP روی loopback، %zu MB و %d رفت و برگشت %d بایتی\n", megabytes, iterations, MESSAGE_SIZE);
+    run("TCP", megabytes, iterations);
+    int result = 0;
+    if (sockmap_attach_cgroup(bench_cgroup) == 0) {
+        run("sockmap", megabytes, iterations);
+        sockmap_detach_cgroup(bench_cgroup);
+    } else {
+        result = 1;
+    }
+    sockmap_cleanup();
+
+    move_self(cgroup_root);
+    rmdir(bench_cgroup);
+    return result;
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "../include/unpack.h"
+#include "../include/utils.h"
+
+// بنچمارک باز کردن آرشیو tar در مقایسه با tar -x
+// استفاده: unpack_bench [آرشیو...]؛ بدون آرگومان یک لایه مصنوعی ساخته می‌شود
+
+#define BENCH_DIR "/tmp/unpack_bench"
+#define SMALL_FILES 20000
+#define SMALL_FILE_SIZE 4096
+#define LARGE_FILES 8
+#define LARGE_FILE_SIZE (16 * 1024 * 1024)
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ساخت درخت نمونه شبیه یک لایه واقعی: تعداد زیادی فایل کوچک و چند فایل بزرگ
+static int build_sample_tree(const char *root) {
+    char path[512];
+    char *data = malloc(LARGE_FILE_SIZE);
+    if (!data) return -1;
+    for (size_t i = 0; i < LARGE_FILE_SIZE; i++) {
+        data[i] = (char)(rand() & 0x3f);  // کمی قابل فشرده‌سازی
+    }
+
+    for (int i = 0; i < SMALL_FILES; i++) {
+        if (i % 500 == 0) {
+            snprintf(path, sizeof(path), "%s/dir%d", root, i / 500);
+            mkdir(path, 0755);
+        }
+        snprintf(path, sizeof(path), "%s/dir%d/file%d", root, i / 500, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1 || write(fd, data + i, SMALL_FILE_SIZE) != SMALL_FILE_SIZE) {
+            free(data);
+            return -1;
+        }
+        close(fd);
+    }
+
+    for (int i = 0; i < LARGE_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/large%d", root, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        data[0] = (char)i;
+        if (fd == -1 || write(fd, data, LARGE_FILE_SIZE) != LARGE_FILE_SIZE) {
+            free(data);
+            return -1;
+        }
+        close(fd);
+    }
+
+    free(data);
+    return 0;
+}
+
+// اجرای یک دور و بازگرداندن زمان؛ مقصد پیش از هر دور پاک می‌شود
+static double run_case(const char *archive, bool use_tar, int threads, unpack_stats_t *stats) {
+    char command[1024];
+    snprintf(command, sizeof(command), "rm -rf %s/out && mkdir -p %s/out && sync", BENCH_DIR, BENCH_DIR);
+    if (system(command) != 0) return -1;
+
+    double start = now_seconds();
+    if (use_tar) {
+        snprintf(command, sizeof(command), "tar -xf %s -C %s/out", archive, BENCH_DIR);
+        if (system(command) != 0) return -1;
+    } else {
+        unpack_options_t options;
+        unpack_default_options(&options);
+        options.threads = threads;
+        if (unpack_tar(archive, BENCH_DIR "/out", &options, stats) != 0) return -1;
+    }
+    // writeback دیسک خارج از اندازه‌گیری انجام می‌شود تا دور بعد را تحت تأثیر قرار ندهد
+    double elapsed = now_seconds() - start;
+    sync();
+    return elapsed;
+}
+
+static void bench_archive(const char *archive) {
+    unpack_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    double tar_seconds = run_case(archive, true, 0, NULL);
+
+    printf("\nآرشیو: %s\n", archive);
+    printf("%-16s %-10s %-12s %-12s\n", "روش", "ثانیه", "MB/s", "فایل/s");
+
+    int thread_counts[] = { 1, 4, 0 };
+    for (int i = 0; i < 3; i++) {
+        double seconds = run_case(archive, false, thread_counts[i], &stats);
+        char label[32];
+        if (thread_counts[i] == 0) {
+            snprintf(label, sizeof(label), "unpack (همه CPU)");
+        } else {
+            snprintf(label, sizeof(label), "unpack (%d)", thread_counts[i]);
+        }
+        if (seconds < 0) {
+            printf("%-16s خطا\n", label);
+            continue;
+        }
+        printf("%-16s %-10.2f %-12.1f %-12.0f\n", label, seconds,
+               stats.bytes / seconds / (1024 * 1024), stats.files / seconds);
+    }
+
+    if (tar_seconds > 0) {
+        printf("%-16s %-10.2f %-12.1f %-12.0f\n", "tar -x", tar_seconds,
+               stats.bytes / tar_seconds / (1024 * 1024), stats.files / tar_seconds);
+    }
+}
+
+int main(int argc, char **argv) {
+    log_set_level(LOG_LEVEL_ERROR);
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            bench_archive(argv[i]);
+        }
+        return 0;
+    }
+
+    printf("ساخت لایه نمونه (%d فایل کوچک، %d فایل %d MB)...\n",
+           SMALL_FILES, LARGE_FILES, LARGE_FILE_SIZE >> 20);
+    if (system("rm -rf " BENCH_DIR " && mkdir -p " BENCH_DIR "/tree") != 0 ||
+        build_sample_tree(BENCH_DIR "/tree") != 0 ||
+        system("tar -cf " BENCH_DIR "/layer.tar -C " BENCH_DIR "/tree . && "
+               "gzip -1 -c " BENCH_DIR "/layer.tar > " BENCH_DIR "/layer.tar.gz") != 0) {
+        fprintf(stderr, "خطا در ساخت آرشیو نمونه\n");
+        return 1;
+    }
+
+    bench_archive(BENCH_DIR "/layer.tar");
+    bench_archive(BENCH_DIR "/layer.tar.gz");
+
+    if (system("rm -rf " BENCH_DIR) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef BPFPROG_H
+#define BPFPROG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <linux/bpf.h>
+
+// بارگذاری برنامه‌های eBPF بدون libbpf: برنامه‌ها کوچک‌اند و مستقیماً به bytecode نوشته می‌شوند
+
+// محل pin شدن map ها و برنامه‌ها تا اجراهای بعدی از همان اشیا استفاده کنند
+#define BPF_FS_PATH "/sys/fs/bpf"
+#define BPF_PIN_DIR BPF_FS_PATH "/simplecontainer"
+
+// ساخت دستورها
+#define BPF_INSN(code, dst, src, off, imm) ((struct bpf_insn){ (code), (dst), (src), (off), (imm) })
+#define MOV64_REG(dst, src) BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0)
+#define MOV64_IMM(dst, imm) BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm)
+#define ALU64_REG(op, dst, src) BPF_INSN(BPF_ALU64 | (op) | BPF_X, dst, src, 0, 0)
+#define ALU64_IMM(op, dst, imm) BPF_INSN(BPF_ALU64 | (op) | BPF_K, dst, 0, 0, imm)
+#define ADD64_IMM(dst, imm) ALU64_IMM(BPF_ADD, dst, imm)
+#define RSH32_IMM(dst, imm) BPF_INSN(BPF_ALU | BPF_RSH | BPF_K, dst, 0, 0, imm)
+#define TO_BE(dst, bits) BPF_INSN(BPF_ALU | BPF_END | BPF_TO_BE, dst, 0, 0, bits)
+#define LDX_W(dst, src, off) BPF_INSN(BPF_LDX | BPF_W | BPF_MEM, dst, src, off, 0)
+#define LDX_DW(dst, src, off) BPF_INSN(BPF_LDX | BPF_DW | BPF_MEM, dst, src, off, 0)
+#define STX_W(dst, src, off) BPF_INSN(BPF_STX | BPF_W | BPF_MEM, dst, src, off, 0)
+#define STX_DW(dst, src, off) BPF_INSN(BPF_STX | BPF_DW | BPF_MEM, dst, src, off, 0)
+#define ATOMIC_ADD_DW(dst, src, off) BPF_INSN(BPF_STX | BPF_DW | BPF_ATOMIC, dst, src, off, BPF_ADD)
+#define JEQ_IMM(dst, imm, off) BPF_INSN(BPF_JMP | BPF_JEQ | BPF_K, dst, 0, off, imm)
+#define JNE_IMM(dst, imm, off) BPF_INSN(BPF_JMP | BPF_JNE | BPF_K, dst, 0, off, imm)
+#define JLE_IMM(dst, imm, off) BPF_INSN(BPF_JMP | BPF_JLE | BPF_K, dst, 0, off, imm)
+#define JLE_REG(dst, src, off) BPF_INSN(BPF_JMP | BPF_JLE | BPF_X, dst, src, off, 0)
+#define JLT_REG(dst, src, off) BPF_INSN(BPF_JMP | BPF_JLT | BPF_X, dst, src, off, 0)
+#define JA(off) BPF_INSN(BPF_JMP | BPF_JA, 0, 0, off, 0)
+#define CALL(func) BPF_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, func)
+#define EXIT() BPF_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+#define LD_MAP_FD(dst, fd) BPF_INSN(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, fd), BPF_INSN(0, 0, 0, 0, 0)
+
+// فراخوان bpf()
+long bpf_call(int cmd, union bpf_attr *attr);
+
+// بارگذاری برنامه با مجوز GPL؛ در صورت خطا گزارش verifier ثبت می‌شود
+int bpf_prog_load_insns(enum bpf_prog_type type, enum bpf_attach_type expected_attach_type,
+                        const struct bpf_insn *insns, size_t count);
+
+// نصب bpffs در صورت نبود و ایجاد BPF_PIN_DIR
+bool bpf_pin_ready();
+
+// شیء pin‌شده با نام name زیر BPF_PIN_DIR
+int bpf_object_get(const char *name);
+int bpf_object_pin(int fd, const char *name);
+
+// اتصال یا جدا کردن برنامه از cgroup v2 (اتصال با BPF_F_ALLOW_MULTI)
+int bpf_cgroup_attach(const char *cgroup_path, int prog_fd, enum bpf_attach_type type);
+int bpf_cgroup_detach(const char *cgroup_path, int prog_fd, enum bpf_attach_type type);
+
+#endif /* BPFPROG_H */
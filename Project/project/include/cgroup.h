@@ -28,6 +28,9 @@ int cgroup_set_io_weight(container_config_t *config, uint64_t weight);
 // اضافه کردن فرآیند به cgroup
 int cgroup_add_process(container_config_t *config, pid_t pid);
 
+// توقف یا ادامه همه فرآیندهای cgroup (cgroup.freeze)؛ تا اعمال کامل منتظر می‌ماند
+int cgroup_freeze(container_config_t *config, bool frozen);
+
 // دریافت مصرف منابع
 int cgroup_get_memory_usage(container_config_t *config, uint64_t *usage);
 int cgroup_get_cpu_usage(container_config_t *config, uint64_t *usage);
@@ -9,6 +9,8 @@
 #define CMD_STOP    "stop"
 #define CMD_START   "start"
 #define CMD_STATUS  "status"
+#define CMD_COMMIT  "commit"
+#define CMD_EXEC    "exec"
 #define CMD_HELP    "help"
 
 // پردازش دستورات ورودی
@@ -20,6 +22,8 @@ int cli_list(container_manager_t *manager);
 int cli_stop(container_manager_t *manager, const char *container_id);
 int cli_start(container_manager_t *manager, const char *container_id);
 int cli_status(container_manager_t *manager, const char *container_id);
+int cli_commit(container_manager_t *manager, const char *container_id, const char *image_dir);
+int cli_exec(container_manager_t *manager, const char *container_id, char **argv);
 void cli_help();
 
 // پارس کردن آرگومان‌های دستور
@@ -0,0 +1,35 @@
+#ifndef COMMIT_H
+#define COMMIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "container.h"
+
+// فایل cache کنار upperdir: وضعیت ورودی‌ها و زنجیره لایه‌های commit قبلی
+#define COMMIT_CACHE_NAME "commit.cache"
+
+// آمار یک commit
+typedef struct {
+    uint64_t files;
+    uint64_t directories;
+    uint64_t symlinks;
+    uint64_t hardlinks;
+    uint64_t specials;          // دستگاه‌ها و FIFO ها
+    uint64_t whiteouts;         // حذف‌ها، شامل فایل‌های upper که پس از commit قبلی پاک شده‌اند
+    uint64_t opaque;            // دایرکتوری‌های opaque تازه
+    uint64_t unchanged;         // فایل‌هایی که به کمک cache کنار گذاشته شدند
+    uint64_t hashed;            // فایل‌هایی که محتوایشان هش شد
+    uint64_t bytes;             // حجم آرشیو
+} commit_stats_t;
+
+// نوشتن تغییرات upperdir از commit قبلی (ثبت‌شده در cache_path) به صورت آرشیو tar لایه
+// آرشیو در archive_dir/<hex>.tar قرار می‌گیرد و digest آن sha256 خود آرشیو است
+// خروجی: 0 = لایه ساخته شد، 1 = تغییری نبود، -1 = خطا؛ cache فقط پس از موفقیت به‌روز می‌شود
+int commit_layer(const char *upperdir, const char *cache_path, const char *archive_dir, int threads,
+                 char *digest, size_t digest_size, commit_stats_t *stats);
+
+// ساخت تصویر در image_dir از لایه‌های تصویر کانتینر، commit های قبلی و لایه تازه upperdir
+// کانتینر در حال اجرا در طول پیمایش با cgroup.freeze متوقف می‌شود
+int commit_container(container_config_t *config, const char *image_dir, int threads, commit_stats_t *stats);
+
+#endif /* COMMIT_H */
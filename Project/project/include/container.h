@@ -3,6 +3,40 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "forkserver.h"
+
+// حداکثر تعداد لایه‌های تصویر کانتینر
+#define MAX_IMAGE_LAYERS 32
+
+// حداکثر پورت‌های منتشرشده هر کانتینر
+#define MAX_PORT_MAPPINGS 8
+
+// نوع snapshotter فایل‌سیستم ریشه
+typedef enum {
+    SNAPSHOT_OVERLAY = 0,       // overlayfs با upper روی دیسک (پیش‌فرض)
+    SNAPSHOT_TMPFS,             // overlayfs با upper روی tmpfs با سقف حجم
+    SNAPSHOT_REFLINK,           // کپی کامل لایه‌ها با reflink در صورت پشتیبانی فایل‌سیستم
+    SNAPSHOT_BIND               // نصب فقط‌خواندنی لایه‌ها بدون لایه قابل نوشتن
+} snapshot_type_t;
+
+// شبکه کانتینر
+typedef enum {
+    NETWORK_NONE = 0,           // فقط loopback (پیش‌فرض)
+    NETWORK_BRIDGE              // veth متصل به bridge میزبان با نشانی IPv4
+} network_mode_t;
+
+// انتشار پورت کانتینر روی میزبان
+typedef struct {
+    uint16_t host_port;
+    uint16_t container_port;
+} port_mapping_t;
+
+// نگاشت شناسه‌های 0 تا count-1 کانتینر به محدوده‌ای از شناسه‌های فرعی میزبان
+typedef struct {
+    uint32_t uid_base;
+    uint32_t gid_base;
+    uint32_t count;             // 0 یعنی فقط root کانتینر به کاربر فراخواننده
+} id_mapping_t;
 
 // ساختار مشخصات کانتینر
 typedef struct {
@@ -21,10 +55,57 @@ typedef struct {
     uint64_t io_weight;         // وزن I/O
     
     pid_t container_pid;        // PID فرآیند اصلی کانتینر
+    int pidfd;                  // pidfd فرآیند اصلی برای exec (-1 وقتی اجرا نمی‌شود)
     bool running;               // وضعیت اجرا
     char cgroup_path[512];      // مسیر cgroup
+
+    // لایه‌های تصویر از پایین به بالا (digest در انبار لایه)
+    char image_layers[MAX_IMAGE_LAYERS][80];
+    int image_layer_count;
+
+    snapshot_type_t snapshotter;    // روش ساخت فایل‌سیستم ریشه
+    uint64_t snapshot_size;         // سقف حجم upper برای tmpfs (0 یعنی پیش‌فرض هسته)
+    uint64_t disk_limit_bytes;      // سقف لایه قابل نوشتن با project quota (0 یعنی بدون سقف)
+
+    char image_path[512];           // دایرکتوری تصویر (خالی بدون تصویر)؛ trace پیش‌خوانی کنار آن است
+    unsigned record_trace_seconds;  // ضبط trace پیش‌خوانی در ثانیه‌های نخست اجرا (0 یعنی پیش‌خوانی)
+
+    network_mode_t network;         // شبکه کانتینر
+    uint32_t ipv4_address;          // نشانی eth0 در حالت bridge (به ترتیب شبکه)
+    int address_lease;              // شاخص اجاره نشانی زیر NETWORK_LEASE_DIR (-1 یعنی بدون اجاره)
+    char netns_name[32];            // ورودی استخر network namespace در حال استفاده (خالی یعنی netns تازه)
+    bool sockmap;                   // شتاب TCP محلی با sockmap برای سوکت‌های cgroup کانتینر
+    uint64_t net_rate_bytes;        // سقف ترافیک شبکه هر جهت به بایت بر ثانیه (0 یعنی بدون سقف)
+    port_mapping_t ports[MAX_PORT_MAPPINGS];    // پورت‌های منتشرشده با portfwd
+    int port_count;
+    int port_forwards[MAX_PORT_MAPPINGS];       // شناسه forward هر پورت در حال اجرا (-1 یعنی غیرفعال)
+    id_mapping_t idmap;             // نگاشت user namespace؛ با محدوده، لایه‌ها با idmapped mount نصب می‌شوند
+    char seccomp_profile[512];      // پروفایل seccomp که پیش از execv نصب می‌شود (خالی یعنی بدون فیلتر)
+    char seccomp_learn[512];        // مسیر پروفایل ضبط‌شده از syscall های این اجرا (خالی یعنی بدون ضبط)
+    bool fork_server;               // برنامه پس از مقداردهی برای هر نمونه fork می‌کند
+    int forkserver_fd;              // سوکت مدیر با fork-server (-1 وقتی اجرا نمی‌شود)
+    bool forkserver_ready;
+    uint32_t instance_count;        // نمونه‌های ساخته‌شده؛ نام cgroup نمونه بعدی
 } container_config_t;
 
+// گزینه‌های ایجاد کانتینر
+typedef struct {
+    const char *image_path;         // تصویر لایه‌ای (NULL یعنی rootfs پایه)
+    snapshot_type_t snapshotter;
+    uint64_t snapshot_size;
+    unsigned record_trace_seconds;
+    uint64_t disk_limit_bytes;
+    network_mode_t network;
+    bool sockmap;
+    uint64_t net_rate_bytes;
+    port_mapping_t ports[MAX_PORT_MAPPINGS];
+    int port_count;
+    id_mapping_t idmap;
+    const char *seccomp_profile;
+    const char *seccomp_learn;
+    bool fork_server;
+} container_options_t;
+
 // ساختار‌ مدیریت کانتینر
 typedef struct {
     container_config_t *containers;
@@ -38,16 +119,32 @@ void container_manager_destroy(container_manager_t *manager);
 
 // توابع عملیاتی کانتینر
 int container_create(container_manager_t *manager, const char *name, const char *binary_path, char **args, int argc);
+int container_create_with_image(container_manager_t *manager, const char *name, const char *image_path,
+                                const char *binary_path, char **args, int argc);
+int container_create_with_options(container_manager_t *manager, const char *name, const container_options_t *options,
+                                  const char *binary_path, char **args, int argc);
 int container_start(container_manager_t *manager, const char *container_id);
 int container_stop(container_manager_t *manager, const char *container_id);
 int container_status(container_manager_t *manager, const char *container_id);
 int container_list(container_manager_t *manager);
 
+// اجرای argv در namespace ها، cgroup و rootfs کانتینر در حال اجرا؛ PID فرمان (فرزند فراخواننده) یا -1
+pid_t container_exec(container_manager_t *manager, const char *container_id, char *const argv[]);
+
+// نمونه تازه از برنامه کانتینر در حالت fork-server با fork از وضعیت مقداردهی‌شده، در cgroup فرزند
+// <cgroup_path>/instance-<n> و با namespace های تازه unshare_flags (زیرمجموعه FORKSERVER_UNSHARE_TYPES)
+int container_fork_instance(container_manager_t *manager, const char *container_id, int unshare_flags,
+                            forkserver_instance_t *instance);
+
+// ذخیره تغییرات لایه قابل نوشتن کانتینر به صورت تصویر جدید در image_dir
+int container_commit(container_manager_t *manager, const char *container_id, const char *image_dir);
+
 // تنظیم محدودیت‌های منابع
 int container_set_memory_limit(container_manager_t *manager, const char *container_id, uint64_t mem_limit_bytes);
 int container_set_cpu_shares(container_manager_t *manager, const char *container_id, uint64_t cpu_shares);
 int container_set_cpu_affinity(container_manager_t *manager, const char *container_id, int cpu_id);
 int container_set_io_weight(container_manager_t *manager, const char *container_id, uint64_t io_weight);
+int container_set_network_rate(container_manager_t *manager, const char *container_id, uint64_t rate_bytes);
 
 // مدیریت داخلی
 container_config_t* container_find_by_id(container_manager_t *manager, const char *container_id);
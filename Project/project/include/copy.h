@@ -0,0 +1,26 @@
+#ifndef COPY_H
+#define COPY_H
+
+#include <stdint.h>
+
+// آمار کپی درخت
+typedef struct {
+    uint64_t files;
+    uint64_t directories;
+    uint64_t symlinks;
+    uint64_t hardlinks;
+    uint64_t specials;          // دستگاه‌ها، FIFO ها و سوکت‌ها
+    uint64_t whiteouts;         // whiteout های اعمال‌شده در ادغام لایه overlay
+    uint64_t bytes;             // حجم داده فایل‌های معمولی
+} copy_stats_t;
+
+// کپی بازگشتی source در destination با حفظ مجوزها، مالکیت، زمان‌ها، hardlink ها و حفره‌ها
+// داده فایل‌ها به صورت موازی با copy_file_fd کپی می‌شود (threads = 0 یعنی تعداد CPU ها)
+// destination در صورت نبودن ساخته می‌شود؛ stats می‌تواند NULL باشد
+int copy_tree(const char *source, const char *destination, int threads, copy_stats_t *stats);
+
+// ادغام لایه overlay روی محتوای موجود destination: ورودی‌های هم‌نام جایگزین می‌شوند،
+// whiteout ها (دستگاه کاراکتری 0/0) ورودی پایینی را حذف و دایرکتوری‌های opaque آن را خالی می‌کنند
+int copy_tree_overlay(const char *layer, const char *destination, int threads, copy_stats_t *stats);
+
+#endif /* COPY_H */
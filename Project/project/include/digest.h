@@ -0,0 +1,51 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// اندازه خروجی SHA-256
+#define SHA256_DIGEST_SIZE 32
+
+// طول رشته "sha256:<hex>" به همراه NUL
+#define DIGEST_STRING_MAX 72
+
+// وضعیت SHA-256 افزایشی
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t buffer[64];
+    size_t buffered;
+} sha256_ctx_t;
+
+// SHA-256 افزایشی
+void sha256_init(sha256_ctx_t *ctx);
+void sha256_update(sha256_ctx_t *ctx, const void *data, size_t size);
+void sha256_final(sha256_ctx_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+// هش یک بافر
+void sha256(const void *data, size_t size, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+// هش چند بافر مستقل؛ با AVX2 هشت بافر همزمان در یک هسته پردازش می‌شوند
+void sha256_many(const uint8_t *const data[], const size_t sizes[], int count,
+                 uint8_t (*digests)[SHA256_DIGEST_SIZE]);
+
+// هش محتوای یک فایل
+int digest_file(const char *path, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+// هش موازی چند فایل (threads = 0 یعنی تعداد CPU ها)
+int digest_files(const char *const paths[], int count, uint8_t (*digests)[SHA256_DIGEST_SIZE], int threads);
+
+// قالب‌بندی به صورت "sha256:<hex>"
+void digest_format(const uint8_t digest[SHA256_DIGEST_SIZE], char *buffer, size_t buffer_size);
+
+// تبدیل رشته "sha256:<hex>" به بایت‌ها؛ الگوریتم‌های دیگر پشتیبانی نمی‌شوند
+int digest_parse(const char *digest_string, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+// پیاده‌سازی انتخاب‌شده در زمان اجرا ("shani"، "avx2" یا "scalar")
+const char* digest_implementation();
+
+// انتخاب دستی پیاده‌سازی برای آزمون و بنچمارک؛ در صورت پشتیبانی نشدن -1
+int digest_set_implementation(const char *name);
+
+#endif /* DIGEST_H */
@@ -0,0 +1,39 @@
+#ifndef DISKUSAGE_H
+#define DISKUSAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// شروع بازه شناسه‌های project quota کانتینرها (شناسه‌های کوچک معمولاً دستی تعریف می‌شوند)
+#define DISK_PROJECT_BASE 0x10000000u
+
+// پس از این مدت نتیجه ذخیره‌شده یک دایرکتوری حتی با mtime ثابت دوباره پیمایش می‌شود
+// (بزرگ شدن فایل موجود mtime دایرکتوری را تغییر نمی‌دهد)
+#define DISK_SCAN_MAX_AGE_SECONDS 300
+
+// نتایج پیمایش هر مسیر در این دایرکتوری ذخیره می‌شوند تا اجراهای بعدی CLI از آن‌ها استفاده کنند
+#define DISK_SCAN_CACHE_DIR "/var/lib/simplecontainer/diskusage"
+#define DISK_SCAN_CACHE_MAGIC 0x44555331u
+
+// مصرف دیسک یک دایرکتوری
+typedef struct {
+    uint64_t bytes;             // بلوک‌های تخصیص‌یافته (بایت)
+    uint64_t inodes;
+    bool from_quota;            // از project quota خوانده شد، نه پیمایش
+} disk_usage_t;
+
+// اختصاص project quota یکتا به دایرکتوری خالی path و ارث‌بری آن در زیردرخت
+// limit ها صفر یعنی بدون سقف؛ اگر فایل‌سیستم project quota فعال نداشته باشد -1
+int disk_quota_setup(const char *path, const char *id, uint64_t limit_bytes, uint64_t limit_inodes);
+
+// مصرف path: در صورت داشتن project quota با یک quotactl، وگرنه با پیمایش افزایشی
+int disk_usage_get(const char *path, disk_usage_t *usage);
+
+// پیمایش افزایشی: دایرکتوری‌هایی که inode و mtime آن‌ها تغییر نکرده از حافظه (یا فایل ذخیره‌شده
+// اجرای قبلی) خوانده می‌شوند
+int disk_usage_scan(const char *path, disk_usage_t *usage);
+
+// حذف نتایج ذخیره‌شده زیر path در حافظه و روی دیسک (پس از حذف کانتینر)
+void disk_usage_forget(const char *path);
+
+#endif /* DISKUSAGE_H */
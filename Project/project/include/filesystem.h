@@ -18,10 +18,14 @@ int do_chroot(const char *path);
 // ایجاد مسیرهای مورد نیاز در کانتینر
 int prepare_container_directories(container_config_t *config);
 
-// نصب فایل‌سیستم‌های ضروری
+// نصب فایل‌سیستم‌های ضروری زیر rootfs (پیش از chroot)
 int mount_essential_filesystems(container_config_t *config);
 
 // بارگذاری تصویر کانتینر (اختیاری)
+// تصویر دایرکتوری‌ای با فایل manifest است: هر خط "<digest> <آرشیو یا دایرکتوری لایه>"، از لایه پایین به بالا
 int load_container_image(container_config_t *config, const char *image_path);
 
+// رها کردن ارجاع لایه‌های تصویر کانتینر
+void release_container_image(container_config_t *config);
+
 #endif /* FILESYSTEM_H */
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef FORKSERVER_H
+#define FORKSERVER_H
+
+#include <stdint.h>
+#include <sched.h>
+#include <sys/types.h>
+
+// حالت fork-server: باینری کانتینر یک بار اجرا و مقداردهی می‌شود، سپس روی سوکت SEQPACKET به ارث رسیده
+// آمادگی اعلام می‌کند و برای هر درخواست نمونه fork می‌کند. هر درخواست یک کانال تازه برای نمونه همراه
+// دارد؛ فرزند از آن کانال خود را معرفی می‌کند (SCM_CREDENTIALS شماره فرآیند را به namespace مدیر
+// ترجمه می‌کند)، مدیر آن را به cgroup نمونه منتقل و سپس آزاد می‌کند
+
+// متغیر محیطی شماره توصیف‌گر سوکت در برنامه کانتینر
+#define FORKSERVER_ENV "SIMPLECONTAINER_FORKSERVER_FD"
+
+// سقف انتظار مدیر برای مقداردهی برنامه پیش از نخستین نمونه
+#define FORKSERVER_READY_TIMEOUT_MS 30000
+
+// بازگشت forkserver_run وقتی برنامه بیرون از حالت fork-server اجرا شده است
+#define FORKSERVER_STANDALONE (-2)
+
+// namespace هایی که نمونه می‌تواند پیش از ادامه تازه بسازد (CLONE_NEWPID فقط فرزندان نمونه را جدا می‌کند)
+#define FORKSERVER_UNSHARE_TYPES (CLONE_NEWNS | CLONE_NEWUTS | CLONE_NEWIPC | CLONE_NEWNET | CLONE_NEWPID)
+
+// پیام‌های پروتکل
+typedef enum {
+    FORKSERVER_MSG_READY = 1,   // سرور -> مدیر: مقداردهی تمام شد
+    FORKSERVER_MSG_FORK,        // مدیر -> سرور: value پرچم‌های unshare و کانال نمونه با SCM_RIGHTS
+    FORKSERVER_MSG_FORKED,      // نمونه -> مدیر روی کانال: value صفر یا -errno
+    FORKSERVER_MSG_GO           // مدیر -> نمونه: در cgroup خود است و ادامه می‌دهد
+} forkserver_msg_type_t;
+
+typedef struct {
+    uint32_t type;
+    uint32_t instance;
+    int32_t value;
+} forkserver_msg_t;
+
+// نمونه در حال اجرا از دید مدیر
+typedef struct {
+    uint32_t id;
+    pid_t pid;                  // شماره در PID namespace مدیر
+    int pidfd;                  // با پایان نمونه خواندنی می‌شود
+    int channel_fd;             // کانال اختصاصی با نمونه
+    char cgroup_path[512];
+} forkserver_instance_t;
+
+// ---------- سمت برنامه کانتینر ----------
+
+// پس از مقداردهی فراخوانی می‌شود: آمادگی را اعلام و درخواست‌ها را تا بسته شدن سوکت پاسخ می‌دهد.
+// در هر نمونه توصیف‌گر کانال آن را برمی‌گرداند؛ در سرور با بسته شدن سوکت توسط مدیر -1 و بدون متغیر
+// محیطی FORKSERVER_STANDALONE. نمونه‌های پایان‌یافته خودکار جمع‌آوری می‌شوند
+int forkserver_run(void);
+
+// ---------- سمت مدیر ----------
+
+// انتظار برای اعلام آمادگی سرور؛ timeout_ms منفی یعنی بدون سقف
+int forkserver_wait_ready(int server_fd, int timeout_ms);
+
+// درخواست نمونه id در cgroup_path (ایجاد می‌شود) با namespace های تازه unshare_flags
+int forkserver_fork(int server_fd, uint32_t id, const char *cgroup_path, int unshare_flags,
+                    forkserver_instance_t *instance);
+
+// انتظار برای پایان نمونه؛ timeout_ms منفی یعنی بدون سقف. 0 پس از پایان و 1 با پایان مهلت
+int forkserver_instance_wait(forkserver_instance_t *instance, int timeout_ms);
+
+// پایان اجباری نمونه با cgroup.kill، حذف cgroup و بستن توصیف‌گرها
+int forkserver_instance_destroy(forkserver_instance_t *instance);
+
+#endif /* FORKSERVER_H */
@@ -0,0 +1,28 @@
+#ifndef IDMAP_H
+#define IDMAP_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "container.h"
+
+// محدوده پیش‌فرض وقتی فقط پایه شناسه‌های میزبان داده شده است
+#define IDMAP_DEFAULT_COUNT 65536
+
+// فایل‌های شناسه‌های فرعی با خطوط "نام:شروع:تعداد"
+#define IDMAP_SUBUID_PATH "/etc/subuid"
+#define IDMAP_SUBGID_PATH "/etc/subgid"
+
+// پارس "base[:count]" یا "subuid" (نخستین محدوده کاربر جاری در /etc/subuid و /etc/subgid)
+int idmap_parse(const char *text, id_mapping_t *map);
+
+// نخستین محدوده user (نام یا uid عددی) در فایل subuid/subgid
+int idmap_read_subid(const char *path, const char *user, uint32_t *base, uint32_t *count);
+
+// نوشتن uid_map و gid_map فرآیند pid از namespace والد؛ برخلاف نوشتن از درون namespace محدوده
+// کامل و نگاشت root را هم می‌پذیرد. inverse شناسه‌های میزبان را به 0 تا count-1 برمی‌گرداند
+int idmap_write(pid_t pid, const id_mapping_t *map, bool inverse);
+
+// user namespace بدون فرآیند با نگاشت map برای MOUNT_ATTR_IDMAP؛ توصیف‌گر یا -1
+int idmap_userns_fd(const id_mapping_t *map, bool inverse);
+
+#endif /* IDMAP_H */
@@ -1,8 +1,30 @@
 #ifndef IPC_H
 #define IPC_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/uio.h>
 #include "container.h"
 
+// handle کانال IPC؛ یک بار با نام resolve می‌شود و برای هر پیام دوباره جستجو نمی‌شود
+typedef struct ipc_channel ipc_channel_t;
+
+// آمار هر کانال
+typedef struct {
+    uint64_t messages_sent;
+    uint64_t messages_received;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t errors;
+} ipc_channel_stats_t;
+
+// گزینه‌های ایجاد کانال
+typedef struct {
+    size_t size;        // حداکثر اندازه پیام (0 = پیش‌فرض)
+    bool huge_pages;    // سگمنت با صفحات 2MB، با بازگشت به صفحات معمولی در صورت نبود رزرو
+} ipc_channel_options_t;
+
 // راه‌اندازی IPC بین کانتینرها
 int ipc_setup();
 
@@ -12,13 +34,74 @@ int ipc_cleanup();
 // ایجاد کانال IPC برای کانتینر
 int ipc_create_channel(container_config_t *config, const char *channel_name);
 
+// ایجاد کانال IPC با اندازه و نوع صفحه دلخواه؛ حافظه به cgroup کانتینر نسبت داده می‌شود
+int ipc_create_channel_ex(container_config_t *config, const char *channel_name, const ipc_channel_options_t *options);
+
+// ایجاد کانال broadcast با یک نویسنده و خواننده‌های بدون قفل (seqlock)؛ حافظه به cgroup کانتینر نسبت داده می‌شود
+int ipc_create_broadcast_channel(container_config_t *config, const char *channel_name, size_t max_payload);
+
+// حذف یک کانال؛ handle های باز تا آخرین ipc_channel_close معتبر می‌مانند
+int ipc_destroy_channel(const char *channel_name);
+
+// تعداد کانال‌های ثبت‌شده
+size_t ipc_channel_count();
+
 // اتصال دو کانتینر از طریق IPC
 int ipc_connect_containers(const char *container_id1, const char *container_id2, const char *channel_name);
 
+// گرفتن handle یک کانال (افزایش شمارنده ارجاع)
+ipc_channel_t* ipc_channel_open(const char *channel_name);
+
+// اتصال به کانال حافظه مشترک یا broadcast که فرآیند دیگری ساخته است؛ handle با ipc_channel_close رها می‌شود
+// نوع صفحه سگمنت از این طرف قابل تشخیص نیست و ipc_channel_uses_huge_pages برای آن false است
+ipc_channel_t* ipc_channel_attach(const char *channel_name);
+
+// رها کردن handle (کاهش شمارنده ارجاع)
+void ipc_channel_close(ipc_channel_t *channel);
+
+// نام کانال
+const char* ipc_channel_name(const ipc_channel_t *channel);
+
+// حداکثر اندازه پیام کانال
+size_t ipc_channel_capacity(const ipc_channel_t *channel);
+
+// آیا سگمنت کانال با صفحات بزرگ پشتیبانی می‌شود
+bool ipc_channel_uses_huge_pages(const ipc_channel_t *channel);
+
+// نگاشت خام سگمنت کانال حافظه مشترک یا broadcast برای لایه‌هایی که ساختار خود را روی آن می‌سازند (مانند RPC)
+void* ipc_channel_map(ipc_channel_t *channel, size_t *size);
+
+// ارسال و دریافت پیام از طریق handle؛ کانال یک صف رکورد با یک فرستنده و یک گیرنده است
+// ipc_channel_receive در صف خالی 0 برمی‌گرداند
+int ipc_channel_send(ipc_channel_t *channel, const void *data, size_t data_size);
+int ipc_channel_receive(ipc_channel_t *channel, void *buffer, size_t buffer_size);
+
+// ارسال چند رکورد با یک انتشار اندیس و حداکثر یک بیدارباش
+// تعداد رکوردهای جاشده را برمی‌گرداند (کمتر از count اگر صف پر شود)
+int ipc_send_batch(ipc_channel_t *channel, const struct iovec *records, int count);
+
+// دریافت تا count رکورد؛ طول هر رکورد دریافتی در iov_len قرار می‌گیرد
+// timeout_ms: 0 = بدون انتظار، منفی = انتظار نامحدود؛ تعداد رکوردهای دریافتی را برمی‌گرداند
+int ipc_recv_batch(ipc_channel_t *channel, struct iovec *records, int count, int timeout_ms);
+
+// انتشار snapshot جدید در کانال broadcast؛ انتشار نیمه‌کاره نویسنده مرده کنار گذاشته می‌شود
+int ipc_broadcast_publish(ipc_channel_t *channel, const void *data, size_t data_size);
+
+// خواندن آخرین snapshot؛ اندازه داده را برمی‌گرداند و نسخه را در version قرار می‌دهد
+// اگر نویسنده وسط انتشار مرده باشد به جای انتظار بی‌پایان -1 برمی‌گرداند؛ انتشار طولانی نویسنده زنده منتظر می‌ماند
+int ipc_broadcast_read(ipc_channel_t *channel, void *buffer, size_t buffer_size, uint64_t *version);
+
+// انتظار futex تا انتشار نسخه‌ای غیر از last_version (timeout_ms < 0 یعنی بدون مهلت)
+// خروجی: 0 = نسخه جدید، 1 = پایان مهلت، -1 = خطا
+int ipc_broadcast_wait(ipc_channel_t *channel, uint64_t last_version, int timeout_ms);
+
+// دریافت آمار کانال
+int ipc_channel_get_stats(const ipc_channel_t *channel, ipc_channel_stats_t *stats);
+
 // ارسال پیام بین کانتینرها
 int ipc_send_message(const char *channel_name, const void *data, size_t data_size);
 
 // دریافت پیام از کانتینر دیگر
 int ipc_receive_message(const char *channel_name, void *buffer, size_t buffer_size);
 
-#endif /* IPC_H */
\ No newline at end of file
+#endif /* IPC_H */
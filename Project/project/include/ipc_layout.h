@@ -0,0 +1,55 @@
+#ifndef IPC_LAYOUT_H
+#define IPC_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// چیدمان حافظه مشترک کانال‌های IPC؛ طرف مقابل (و آزمون‌ها) همین ساختارها را می‌بیند
+
+// نشانه سرآیند سگمنت‌های این ماژول
+#define IPC_SEGMENT_MAGIC 0x49504353u
+
+// سرآیند هر سگمنت: نام کانال مالک تا برخورد کلید یا سگمنت مانده از اجرای قبلی تشخیص داده شود
+// اندازه آن مضرب 64 است تا ساختار کانال پس از آن هم‌تراز بماند
+typedef struct {
+    uint32_t magic;
+    uint32_t type;              // نوع کانال تا فرآیند دیگر بتواند بدون جدول کانال‌ها به آن وصل شود
+    char name[64];
+} __attribute__((aligned(64))) ipc_segment_header_t;
+
+// سرآیند صف رکوردهای کانال حافظه مشترک: حلقه بایتی با یک فرستنده و یک گیرنده
+// head و tail آفست‌هایی در [0, capacity) هستند؛ 8 بایت همیشه خالی می‌ماند تا صف پر از خالی متمایز باشد
+typedef struct {
+    uint32_t capacity;                                  // اندازه ناحیه داده (مضرب 8)
+    uint32_t reserved;
+    uint32_t head __attribute__((aligned(64)));         // نوشته‌شده توسط گیرنده
+    uint32_t tail __attribute__((aligned(64)));         // نوشته‌شده توسط فرستنده؛ کلمه futex گیرنده
+    uint32_t receiver_waiting __attribute__((aligned(64)));  // گیرنده روی futex خوابیده است
+} __attribute__((aligned(64))) ipc_ring_header_t;
+
+// هر رکورد: 4 بایت طول، 4 بایت خالی، داده و پرکننده تا مضرب 8
+#define IPC_RECORD_HEADER 8
+#define IPC_RECORD_ALIGN(size) (((size) + 7) & ~(size_t)7)
+#define IPC_RECORD_SPACE(size) (IPC_RECORD_HEADER + IPC_RECORD_ALIGN(size))
+
+// نشانه معتبر بودن سرآیند کانال broadcast
+#define IPC_BROADCAST_MAGIC 0x42524443u
+
+// سرآیند سگمنت broadcast: یک نویسنده و تعداد دلخواه خواننده بدون قفل
+// seq شمارنده seqlock است (فرد = در حال نوشتن) و همزمان کلمه futex برای اطلاع‌رسانی. نویسنده در طول
+// انتشار writer_lock (mutex robust و مشترک بین فرآیندها) را نگه می‌دارد؛ هسته قفل نویسنده مرده را
+// علامت می‌زند، پس مرگ نویسنده برخلاف PID در namespace های PID مختلف هم تشخیص داده می‌شود
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;          // حداکثر اندازه داده
+    uint32_t seq;               // seqlock
+    uint32_t waiters;           // تعداد خواننده‌های منتظر futex
+    uint64_t version;           // نسخه snapshot فعلی
+    uint32_t size;              // اندازه داده snapshot
+    uint32_t reserved;
+    pthread_mutex_t writer_lock;
+    char data[];
+} ipc_broadcast_header_t;
+
+#endif /* IPC_LAYOUT_H */
@@ -0,0 +1,53 @@
+#ifndef LAYERSTORE_H
+#define LAYERSTORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// مسیر پایه انبار لایه‌ها
+#define LAYER_STORE_PATH "/var/lib/simplecontainer/layers"
+
+// مدت نگهداری لایه بدون ارجاع پیش از حذف توسط GC (ثانیه)
+#define LAYER_GC_GRACE_SECONDS 3600
+
+// فاصله اجرای GC پس‌زمینه (ثانیه)
+#define LAYER_GC_INTERVAL_SECONDS 300
+
+// راه‌اندازی دایرکتوری‌های انبار لایه
+int layer_store_init();
+
+// بررسی قالب digest (مانند sha256:<hex>)
+bool layer_digest_valid(const char *digest);
+
+// بررسی وجود لایه در انبار
+bool layer_store_has(const char *digest);
+
+// مسیر فایل‌سیستم باز شده یک لایه
+int layer_store_path(const char *digest, char *buffer, size_t buffer_size);
+
+// وارد کردن یک دایرکتوری باز شده به عنوان لایه؛ فایل‌های یکسان به هم hardlink می‌شوند
+int layer_store_import_dir(const char *digest, const char *source_dir);
+
+// وارد کردن آرشیو tar لایه (فشرده یا بدون فشرده‌سازی)؛ digest باید sha256 خود آرشیو باشد
+int layer_store_import_tar(const char *digest, const char *archive_path);
+
+// بررسی محتوای لایه با digest درخت ثبت‌شده در زمان واردسازی
+int layer_store_verify(const char *digest);
+
+// بررسی لایه‌ها پیش از استفاده در کانتینر (پیش‌فرض غیرفعال)
+void layer_store_set_verify(bool enabled);
+bool layer_store_verify_enabled();
+
+// مدیریت شمارنده ارجاع لایه
+int layer_store_ref(const char *digest);
+int layer_store_unref(const char *digest);
+int layer_store_refcount(const char *digest);
+
+// یک دور جمع‌آوری زباله: حذف لایه‌های بدون ارجاع و اشیای بی‌استفاده
+int layer_store_gc();
+
+// اجرای دوره‌ای GC در یک thread پس‌زمینه با اولویت پایین
+int layer_store_gc_start(unsigned interval_seconds);
+void layer_store_gc_stop();
+
+#endif /* LAYERSTORE_H */
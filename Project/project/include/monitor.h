@@ -2,6 +2,8 @@
 #define MONITOR_H
 
 #include "container.h"
+#include "diskusage.h"
+#include "netacct.h"
 #include <stdint.h>
 
 // راه‌اندازی مانیتورینگ eBPF
@@ -19,6 +21,12 @@ int monitor_stop_container(container_config_t *config);
 // گزارش‌گیری از وضعیت منابع
 int monitor_get_resource_usage(container_config_t *config, uint64_t *cpu_usage, uint64_t *mem_usage, uint64_t *io_read, uint64_t *io_write);
 
+// مصرف دیسک لایه قابل نوشتن (project quota یا پیمایش افزایشی)
+int monitor_get_disk_usage(container_config_t *config, disk_usage_t *usage);
+
+// ترافیک شبکه شمرده‌شده با برنامه‌های cgroup_skb
+int monitor_get_network_usage(container_config_t *config, netacct_stats_t *stats);
+
 // ثبت رویدادهای namespace
 int monitor_namespace_events();
 
@@ -0,0 +1,27 @@
+#ifndef MOUNTTREE_H
+#define MOUNTTREE_H
+
+// دایرکتوری درخت‌های قالب که یک بار ساخته و برای هر کانتینر clone می‌شوند
+#define MOUNT_TEMPLATE_DIR "/var/lib/simplecontainer/templates"
+
+// قالب /dev حداقلی: tmpfs فقط‌خواندنی با گره‌های ضروری (بدون دستگاه‌های میزبان)
+#define MOUNT_TEMPLATE_DEV MOUNT_TEMPLATE_DIR "/dev"
+
+// ساخت قالب‌ها در mount namespace میزبان؛ قالب موجود از اجرای قبلی دوباره استفاده می‌شود
+int mount_template_init();
+
+// نصب فایل‌سیستم تازه روی target با fsopen/fsconfig/fsmount/move_mount
+// options به شکل "key=value,flag,..." و attrs از MOUNT_ATTR_* است؛ روی هسته‌های قدیمی از mount() استفاده می‌شود
+int mount_new_fs(const char *fstype, const char *options, unsigned int attrs, const char *target);
+
+// clone درخت نصب source با open_tree(OPEN_TREE_CLONE) و اتصال آن روی target با یک move_mount
+int mount_clone_tree(const char *source, const char *target);
+
+// clone غیربازگشتی source و اتصال آن روی target با نگاشت شناسه user namespace توصیف‌گر userns_fd
+// (MOUNT_ATTR_IDMAP) و attrs اضافه؛ مالکیت روی دیسک دست نمی‌خورد
+int mount_idmapped(const char *source, const char *target, int userns_fd, unsigned int attrs);
+
+// خصوصی کردن بازگشتی انتشار نصب‌های زیر path
+int mount_make_private(const char *path);
+
+#endif /* MOUNTTREE_H */
@@ -1,10 +1,14 @@
 #ifndef NAMESPACE_H
 #define NAMESPACE_H
 
+#include <sched.h>
 #include <sys/types.h>
 #include <stdbool.h>
 #include "container.h"
 
+// namespace هایی که exec در کانتینر به آن‌ها وارد می‌شود (همان پرچم‌های clone کانتینر)
+#define NAMESPACE_EXEC_TYPES (CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWPID | CLONE_NEWUTS | CLONE_NEWIPC | CLONE_NEWNET)
+
 // تنظیم همه namespace ها
 int setup_namespaces(container_config_t *config);
 
@@ -13,7 +17,7 @@ int setup_user_namespace();
 int setup_pid_namespace();
 int setup_mount_namespace();
 int setup_uts_namespace(const char *hostname);
-int setup_network_namespace();
+int setup_network_namespace(container_config_t *config);
 int setup_ipc_namespace();
 
 // اتصال به namespace موجود
@@ -25,4 +29,9 @@ const char* get_namespace_path(int nstype);
 // بررسی وجود namespace
 bool namespace_exists(pid_t pid, int nstype);
 
-#endif // NAMESPACE_H
\ No newline at end of file
+// اجرای argv در namespace های nstypes فرآیند pidfd با یک setns و در cgroup توصیف‌گر cgroup_fd با
+// CLONE_INTO_CGROUP (-1 یعنی cgroup فراخواننده)؛ root ریشه فایل‌سیستم فرمان است (NULL یعنی ریشه
+// mount namespace). فرمان فرزند فراخواننده است؛ PID آن در namespace میزبان پس از exec موفق یا -1
+pid_t namespace_exec(int pidfd, int nstypes, int cgroup_fd, const char *root, char *const argv[]);
+
+#endif // NAMESPACE_H
@@ -0,0 +1,39 @@
+#ifndef NETACCT_H
+#define NETACCT_H
+
+#include <stdint.h>
+
+// شمارش ترافیک شبکه هر کانتینر با برنامه‌های cgroup_skb ورودی و خروجی روی cgroup آن
+// شمارنده‌ها در cgroup storage هستند (یک ورودی برای هر cgroup و جهت) و همان برنامه در صورت تعیین سقف،
+// سطل توکن را اجرا می‌کند: بسته‌های مازاد دور ریخته می‌شوند و در خروجی ازدحام به TCP اعلام می‌شود
+
+// کمترین اندازه سطل؛ باید از بزرگ‌ترین بسته GSO بزرگ‌تر باشد تا هیچ بسته‌ای همیشه رد نشود
+#define NETACCT_MIN_BURST (256 * 1024)
+
+// مقادیر تجمعی از زمان اتصال
+typedef struct {
+    uint64_t rx_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_dropped;
+    uint64_t tx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_dropped;
+} netacct_stats_t;
+
+// بارگذاری map و برنامه‌ها یا استفاده از نسخه pin‌شده
+int netacct_init();
+
+// اتصال برنامه‌ها به cgroup v2؛ rate_bytes سقف بایت بر ثانیه در هر جهت (0 یعنی بدون سقف)
+int netacct_attach_cgroup(const char *cgroup_path, uint64_t rate_bytes);
+int netacct_detach_cgroup(const char *cgroup_path);
+
+// تغییر سقف cgroup متصل؛ شمارش‌های همزمان با به‌روزرسانی ممکن است از دست بروند
+int netacct_set_rate(const char *cgroup_path, uint64_t rate_bytes);
+
+// خواندن شمارنده‌ها
+int netacct_read(const char *cgroup_path, netacct_stats_t *stats);
+
+// بستن توصیف‌گرها؛ برنامه‌های متصل و نسخه pin‌شده باقی می‌مانند
+void netacct_cleanup();
+
+#endif /* NETACCT_H */
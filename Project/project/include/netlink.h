@@ -0,0 +1,51 @@
+#ifndef NETLINK_H
+#define NETLINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// حداکثر درخواست‌های یک دسته
+#define NETLINK_BATCH_MAX 32
+
+// سوکت rtnetlink با دسته درخواست‌های در انتظار؛ همه درخواست‌ها با یک sendmsg فرستاده
+// و پاسخ‌ها (ACK) در یک دور خوانده می‌شوند
+typedef struct {
+    int fd;
+    uint32_t seq;               // شماره ترتیب نخستین درخواست دسته
+    char *buffer;
+    size_t used;
+    size_t capacity;
+    size_t message;             // آغاز پیام در حال ساخت
+    int count;
+    const char *operations[NETLINK_BATCH_MAX];  // نام عملیات برای گزارش خطا
+    int error;                  // خطای ساخت پیام (حافظه یا سرریز دسته)
+} netlink_t;
+
+// باز کردن سوکت rtnetlink در network namespace فعلی
+int netlink_open(netlink_t *nl);
+void netlink_close(netlink_t *nl);
+
+// روشن کردن رابط با نام
+int netlink_link_up(netlink_t *nl, const char *ifname);
+
+// ایجاد جفت veth؛ peer مستقیماً در network namespace فرآیند peer_pid ساخته می‌شود (0 یعنی همین namespace)
+// master شاخص bridge برای اتصال سر میزبان (0 یعنی بدون bridge)
+int netlink_veth_create(netlink_t *nl, const char *ifname, const char *peer, pid_t peer_pid, int master);
+
+// مانند netlink_veth_create با peer در network namespace توصیف‌گر netns_fd
+int netlink_veth_create_in(netlink_t *nl, const char *ifname, const char *peer, int netns_fd, int master);
+
+// ایجاد bridge روشن (اگر وجود داشته باشد فقط روشن می‌شود)
+int netlink_bridge_create(netlink_t *nl, const char *ifname);
+
+// افزودن نشانی IPv4 به رابط (address به ترتیب شبکه)
+int netlink_addr_add(netlink_t *nl, int ifindex, uint32_t address, int prefix);
+
+// افزودن مسیر IPv4 از طریق gateway (prefix 0 یعنی مسیر پیش‌فرض)
+int netlink_route_add(netlink_t *nl, uint32_t destination, int prefix, uint32_t gateway, int ifindex);
+
+// ارسال دسته و انتظار برای همه ACK ها؛ در صورت خطای هر درخواست -1
+int netlink_commit(netlink_t *nl);
+
+#endif /* NETLINK_H */
@@ -0,0 +1,51 @@
+#ifndef NETPOOL_H
+#define NETPOOL_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "container.h"
+#include "network.h"
+
+// دایرکتوری network namespace های آماده؛ هر ورودی فایل <mode>-<n> با bind نصب nsfs است،
+// <mode>-<n>.sys قالب sysfs همان namespace و <mode>-<n>.busy شامل PID فرآیند یا کانتینری که ورودی را
+// برداشته، می‌سازد یا پاک می‌کند؛ این فایل فقط زیر قفل flock روی NETPOOL_DIR/.lock ادعا می‌شود
+#define NETPOOL_DIR "/run/simplecontainer/netns"
+#define NETPOOL_SYSFS_SUFFIX ".sys"
+#define NETPOOL_BUSY_SUFFIX ".busy"
+
+// تعداد پیش‌فرض namespace های آماده برای هر حالت شبکه
+#define NETPOOL_DEFAULT_SIZE 4
+
+// حداکثر ورودی‌های استخر (آماده، در حال استفاده و در انتظار پاک‌سازی)
+#define NETPOOL_MAX 64
+
+// نشانی ورودی‌های bridge از این شاخص به بعد تخصیص می‌یابد تا با نشانی‌های تخصیص مستقیم برخورد نکند
+#define NETPOOL_ADDRESS_BASE NETWORK_LEASE_MAX
+
+// پذیرش ورودی‌های اجرای قبلی و اجرای thread پر کردن استخر (size = 0 یعنی فقط پذیرش)
+// ورودی‌ها پس از خروج فرآیند زیر /run می‌مانند و اجرای بعدی از آن‌ها استفاده می‌کند
+int netpool_start(int size);
+void netpool_stop();
+
+// یک دور همزمان: پاک‌سازی ورودی‌های بازگشتی و ساخت ورودی تا رسیدن به اندازه استخر
+int netpool_fill();
+
+// برداشتن namespace آماده برای حالت شبکه کانتینر؛ netns_name و ipv4_address را پر می‌کند
+// 0 = برداشته شد، -1 = استخر خالی است (کانتینر باید با CLONE_NEWNET ساخته شود)
+int netpool_acquire(container_config_t *config);
+
+// ثبت PID کانتینر به عنوان مالک ورودی تا اجراهای دیگر آن را برندارند
+int netpool_set_owner(const container_config_t *config, pid_t pid);
+
+// بازگرداندن namespace کانتینر متوقف‌شده برای پاک‌سازی و استفاده دوباره
+void netpool_release(container_config_t *config);
+
+// انتقال thread فراخواننده به namespace کانتینر؛ saved_fd برای netpool_leave
+// clone بدون CLONE_NEWNET در این فاصله فرزند را در namespace آماده می‌سازد
+int netpool_enter(const container_config_t *config, int *saved_fd);
+int netpool_leave(int saved_fd);
+
+// حذف همه ورودی‌هایی که کانتینر زنده‌ای از آن‌ها استفاده نمی‌کند
+int netpool_purge();
+
+#endif /* NETPOOL_H */
@@ -0,0 +1,56 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "container.h"
+
+// bridge میزبان و زیرشبکه کانتینرها (10.88.0.0/16 با gateway 10.88.0.1)
+#define NETWORK_BRIDGE_NAME "sc0"
+#define NETWORK_SUBNET 0x0a580000u
+#define NETWORK_PREFIX 16
+#define NETWORK_GATEWAY (NETWORK_SUBNET | 1)
+
+// نام رابط کانتینر (سر دیگر veth)
+#define NETWORK_CONTAINER_IFNAME "eth0"
+
+// اجاره نشانی‌های تخصیص مستقیم بین همه فرآیندها: فایل <شاخص> شامل PID مالک، با قفل flock روی .lock
+#define NETWORK_LEASE_DIR "/run/simplecontainer/leases"
+
+// شاخص‌های تخصیص مستقیم؛ از این شاخص به بعد به ورودی‌های استخر network namespace تعلق دارد
+#define NETWORK_LEASE_MAX 0x8000
+
+// تبدیل نام ("none", "bridge") به حالت شبکه
+int network_mode_parse(const char *name, network_mode_t *mode);
+const char* network_mode_name(network_mode_t mode);
+
+// نشانی IPv4 کانتینر شماره index در زیرشبکه bridge (به ترتیب شبکه)
+uint32_t network_container_address(int index);
+
+// اجاره نشانی آزاد برای کانتینر با مالکیت فرآیند فعلی؛ ipv4_address و address_lease را پر می‌کند
+// اجاره‌ای که مالک آن دیگر زنده نیست آزاد به حساب می‌آید
+int network_address_acquire(container_config_t *config);
+
+// ثبت PID کانتینر به عنوان مالک اجاره تا پس از خروج فرآیند فعلی (--detach) آزاد نشود
+int network_address_set_owner(const container_config_t *config, pid_t pid);
+
+// آزاد کردن اجاره کانتینر (بدون اجاره کاری انجام نمی‌شود)
+void network_address_release(container_config_t *config);
+
+// نام سر میزبان veth کانتینر
+void network_host_ifname(const container_config_t *config, char *buffer, size_t size);
+
+// سمت میزبان پس از clone: ایجاد bridge در صورت نیاز و veth با سر eth0 در netns فرآیند pid
+int network_attach_container(container_config_t *config, pid_t pid);
+
+// مانند network_attach_container برای netns با توصیف‌گر netns_fd و نام سر میزبان دلخواه
+int network_attach_netns(const char *host_ifname, int netns_fd);
+
+// پیکربندی netns فعلی thread: loopback و در حالت bridge نشانی و مسیر پیش‌فرض eth0 در یک دسته
+int network_configure(network_mode_t mode, uint32_t address);
+
+// سمت کانتینر داخل netns تازه
+int network_configure_container(const container_config_t *config);
+
+#endif /* NETWORK_H */
@@ -0,0 +1,35 @@
+#ifndef PORTFWD_H
+#define PORTFWD_H
+
+#include <stdint.h>
+
+// انتقال پورت میزبان به کانتینر: یک thread با epoll همه forward ها و اتصال‌ها را اداره می‌کند و داده
+// هر جهت با splice از سوکت به pipe و از pipe به سوکت مقابل می‌رود (بدون کپی در فضای کاربر)
+
+// حداکثر forward های همزمان
+#define PORTFWD_MAX 256
+
+// ظرفیت pipe هر جهت اتصال
+#define PORTFWD_PIPE_SIZE (256 * 1024)
+
+// pipe های خالی نگه‌داشته‌شده برای اتصال‌های بعدی
+#define PORTFWD_PIPE_CACHE 64
+
+// شروع گوش دادن روی host_port همه نشانی‌های میزبان (0 یعنی پورت آزاد دلخواه) و انتقال هر اتصال به
+// target_address:target_port (به ترتیب شبکه و میزبان)؛ سوکت مقصد در netns_fd ساخته می‌شود (-1 یعنی
+// namespace میزبان) و توصیف‌گر کپی می‌شود. شناسه forward یا -1
+int portfwd_add(uint16_t host_port, int netns_fd, uint32_t target_address, uint16_t target_port);
+
+// بستن forward و همه اتصال‌های آن؛ پس از بازگشت پورت آزاد است
+int portfwd_remove(int id);
+
+// پورت میزبان forward یا -1
+int portfwd_port(int id);
+
+// تعداد اتصال‌های باز همه forward ها
+int portfwd_connection_count();
+
+// بستن همه forward ها و خروج thread؛ thread با اولین portfwd_add دوباره ساخته می‌شود
+void portfwd_stop();
+
+#endif /* PORTFWD_H */
@@ -0,0 +1,35 @@
+#ifndef PREWARM_H
+#define PREWARM_H
+
+#include <stdint.h>
+
+// نام فایل trace در دایرکتوری تصویر
+#define PREWARM_TRACE_NAME "prewarm.trace"
+
+// تعداد thread های پیش‌خوانی
+#define PREWARM_THREADS 4
+
+// محدوده‌های مقیم با فاصله کمتر از این تعداد صفحه یکی می‌شوند
+#define PREWARM_MERGE_PAGES 16
+
+// آمار ضبط یا پیش‌خوانی
+typedef struct {
+    uint64_t files;
+    uint64_t ranges;
+    uint64_t bytes;
+} prewarm_stats_t;
+
+// شروع ضبط فایل‌هایی که زیر root باز می‌شوند (fanotify روی کل فایل‌سیستم root)
+// ضبط پس از seconds ثانیه یا با prewarm_record_finish تمام و trace در trace_path نوشته می‌شود
+int prewarm_record_start(const char *id, const char *root, const char *trace_path, unsigned seconds);
+
+// انتظار برای پایان ضبط id و نوشتن trace؛ اگر ضبطی نباشد 0
+int prewarm_record_finish(const char *id);
+
+// پیش‌خوانی همزمان trace روی فایل‌های زیر root به ترتیب trace؛ stats می‌تواند NULL باشد
+int prewarm_replay(const char *root, const char *trace_path, int threads, prewarm_stats_t *stats);
+
+// اجرای prewarm_replay در یک thread جدا و بازگشت فوری
+int prewarm_start(const char *root, const char *trace_path);
+
+#endif /* PREWARM_H */
@@ -0,0 +1,33 @@
+#ifndef REAPER_H
+#define REAPER_H
+
+// دایرکتوری موارد در انتظار حذف؛ باید روی همان فایل‌سیستم rootfs و overlay ها باشد
+#define REAPER_TRASH_PATH "/var/lib/simplecontainer/trash"
+
+// سقف پیش‌فرض حذف ورودی‌ها در ثانیه تا I/O کارهای اصلی گرسنه نماند
+#define REAPER_DEFAULT_RATE 20000
+
+// فاصله بررسی دوره‌ای trash (ثانیه)
+#define REAPER_INTERVAL_SECONDS 60
+
+// حداکثر زمانی که reaper_stop برای حذف موارد باقیمانده trash صبر می‌کند (ثانیه)
+// آنچه در این مدت حذف نشود در اولین دور reaper_start بعدی حذف می‌شود
+#define REAPER_DRAIN_SECONDS 10
+
+// راه‌اندازی دایرکتوری trash
+int reaper_init();
+
+// انتقال اتمیک path به trash و بازگشت فوری؛ حذف واقعی در پس‌زمینه انجام می‌شود
+// اگر reaper اجرا نشود یا rename ممکن نباشد، حذف همزمان انجام می‌شود
+int reaper_discard(const char *path);
+
+// یک دور حذف همه موارد trash روی thread فراخواننده؛ تعداد موارد حذف‌شده
+int reaper_collect();
+
+// اجرای reaper پس‌زمینه با thread pool (threads = 0 یعنی تعداد CPU ها، rate = 0 یعنی بدون محدودیت)
+int reaper_start(int threads, unsigned rate);
+
+// توقف reaper: موارد باقیمانده تا REAPER_DRAIN_SECONDS حذف و سپس thread join می‌شود
+void reaper_stop();
+
+#endif /* REAPER_H */
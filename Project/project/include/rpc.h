@@ -0,0 +1,73 @@
+#ifndef RPC_H
+#define RPC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "container.h"
+
+// خروجی توابع انتظار در صورت پایان مهلت
+#define RPC_TIMEOUT -2
+
+// سرور RPC: یک doorbell مشترک و یک جفت حلقه به ازای هر کلاینت
+typedef struct rpc_server rpc_server_t;
+
+// کلاینت RPC: حلقه ارسال (submission) و حلقه پاسخ (completion) در یک سگمنت مشترک
+typedef struct rpc_client rpc_client_t;
+
+// پردازش‌گر درخواست؛ پاسخ مستقیماً در حلقه پاسخ نوشته می‌شود
+// با قفل فهرست کلاینت‌ها فراخوانی می‌شود و نباید کلاینتی از همان سرور بسازد یا آزاد کند
+// خروجی: اندازه پاسخ، یا مقدار منفی به عنوان وضعیت خطا
+typedef int (*rpc_handler_t)(uint32_t method, const void *request, size_t request_size,
+                             void *response, size_t response_capacity, void *user_data);
+
+// ایجاد سرور RPC
+rpc_server_t* rpc_server_create(container_config_t *config, const char *name, rpc_handler_t handler, void *user_data);
+
+// آزادسازی سرور و همه کلاینت‌های آن
+void rpc_server_destroy(rpc_server_t *server);
+
+// مدت busy-polling پیش از خوابیدن روی futex (میکروثانیه)
+void rpc_server_set_spin(rpc_server_t *server, unsigned spin_us);
+
+// پردازش درخواست‌های آماده همه کلاینت‌ها بدون انتظار؛ تعداد درخواست‌های پردازش‌شده را برمی‌گرداند
+int rpc_server_poll(rpc_server_t *server);
+
+// حلقه اصلی سرور تا فراخوانی rpc_server_stop (حتی از فرآیند دیگر)
+int rpc_server_run(rpc_server_t *server);
+
+// توقف حلقه سرور
+void rpc_server_stop(rpc_server_t *server);
+
+// ایجاد کلاینت در فرآیند سرور با عمق صف depth (به توان ۲ گرد می‌شود) و حداکثر اندازه داده max_payload
+// از هر نخی قابل فراخوانی است، حتی وقتی rpc_server_run در نخ دیگری اجرا می‌شود
+rpc_client_t* rpc_client_create(rpc_server_t *server, container_config_t *config, const char *client_name,
+                                uint32_t depth, size_t max_payload);
+
+// ثبت کلاینت برای فرآیند دیگر؛ سگمنت تا rpc_server_destroy متعلق به سرور می‌ماند
+int rpc_server_add_client(rpc_server_t *server, container_config_t *config, const char *client_name,
+                          uint32_t depth, size_t max_payload);
+
+// اتصال از فرآیند دیگر به کلاینت ثبت‌شده با نام سرور و نام کلاینت؛ سرآیند حلقه‌ها پیش از استفاده بررسی می‌شود
+rpc_client_t* rpc_client_attach(const char *server_name, const char *client_name);
+
+// آزادسازی کلاینت؛ برای کلاینت متصل‌شده فقط نگاشت‌ها جدا می‌شوند و سرور دیگر به آن پاسخ نمی‌دهد
+void rpc_client_destroy(rpc_client_t *client);
+
+// مدت busy-polling کلاینت پیش از خوابیدن روی futex (میکروثانیه)
+void rpc_client_set_spin(rpc_client_t *client, unsigned spin_us);
+
+// افزودن درخواست به حلقه بدون به صدا درآوردن doorbell
+int rpc_submit(rpc_client_t *client, uint32_t method, const void *request, size_t request_size, uint64_t *request_id);
+
+// انتشار همه درخواست‌های افزوده‌شده با یک به‌روزرسانی اندیس و حداکثر یک بیدارباش
+int rpc_flush(rpc_client_t *client);
+
+// دریافت پاسخ بعدی (به ترتیب ارسال)؛ اندازه پاسخ، -1 برای خطا یا RPC_TIMEOUT را برمی‌گرداند
+int rpc_wait_completion(rpc_client_t *client, uint64_t *request_id, int *status,
+                        void *response, size_t response_capacity, int timeout_ms);
+
+// فراخوانی همگام: ارسال، انتظار و دریافت پاسخ همان درخواست
+int rpc_call(rpc_client_t *client, uint32_t method, const void *request, size_t request_size,
+             void *response, size_t response_capacity, int timeout_ms);
+
+#endif /* RPC_H */
@@ -0,0 +1,58 @@
+#ifndef SECCOMP_H
+#define SECCOMP_H
+
+#include <stdint.h>
+#include <linux/filter.h>
+
+// بزرگ‌ترین شماره syscall پذیرفته در پروفایل
+#define SECCOMP_MAX_SYSCALL 1024
+
+// سقف دستورهای cBPF یک فیلتر (BPF_MAXINSNS هسته)
+#define SECCOMP_MAX_INSNS 4096
+
+// سقف syscall های پرتکرار که پیش از درخت جست‌وجو با مقایسه مستقیم بررسی می‌شوند
+#define SECCOMP_HOT_MAX 16
+
+// تصمیم فیلتر برای یک syscall
+typedef enum {
+    SECCOMP_ACTION_ALLOW = 0,
+    SECCOMP_ACTION_ERRNO,       // بازگشت EPERM بدون اجرای syscall
+    SECCOMP_ACTION_KILL,        // کشتن کل فرآیند
+    SECCOMP_ACTION_LOG          // اجرا و ثبت در audit log
+} seccomp_action_t;
+
+// قاعده یک syscall؛ count تعداد فراخوانی ثبت‌شده برای ترتیب بررسی (0 یعنی نامعلوم)
+typedef struct {
+    int nr;
+    seccomp_action_t action;
+    uint64_t count;
+} seccomp_rule_t;
+
+// پروفایل: تصمیم پیش‌فرض و قاعده‌های صریح، هر syscall حداکثر یک بار
+typedef struct {
+    seccomp_action_t default_action;
+    int rule_count;
+    seccomp_rule_t rules[SECCOMP_MAX_SYSCALL];
+} seccomp_profile_t;
+
+// نام و شماره syscall های معماری جاری؛ -1 یا NULL برای ناشناخته
+int seccomp_syscall_number(const char *name);
+const char* seccomp_syscall_name(int nr);
+
+// پارس تصمیم: allow، errno، kill یا log
+int seccomp_action_parse(const char *text, seccomp_action_t *action);
+
+// افزودن یا جایگزینی قاعده یک syscall
+int seccomp_profile_add(seccomp_profile_t *profile, int nr, seccomp_action_t action, uint64_t count);
+
+// فایل پروفایل با خطوط "default <تصمیم>" و "<تصمیم> <نام یا شماره syscall> [تعداد]"؛ # توضیح است
+int seccomp_profile_load(const char *path, seccomp_profile_t *profile);
+
+// ترجمه پروفایل به cBPF: بررسی معماری، مقایسه مستقیم syscall های پرتکرار و درخت دودویی روی
+// بازه‌های هم‌تصمیم شماره‌ها؛ تعداد دستورها یا -1
+int seccomp_compile(const seccomp_profile_t *profile, struct sock_filter *prog, int max_insns);
+
+// نصب فیلتر روی thread جاری؛ no_new_privs فقط بدون CAP_SYS_ADMIN در user namespace تنظیم می‌شود
+int seccomp_install(const struct sock_filter *prog, int count);
+
+#endif /* SECCOMP_H */
@@ -0,0 +1,48 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include "container.h"
+
+// ریشه پیش‌فرض وقتی کانتینر تصویر لایه‌ای ندارد
+#define SNAPSHOT_BASE_ROOTFS "/var/lib/simplecontainer/rootfs/base"
+
+// حداکثر طول مسیر یک لایه پایینی
+#define SNAPSHOT_PATH_MAX 1024
+
+// زیردایرکتوری overlay_workdir برای نسخه idmapped لایه‌های پایینی
+#define SNAPSHOT_IDMAP_DIR "idmap"
+
+// روش ساخت و پاک‌سازی فایل‌سیستم ریشه کانتینر
+// prepare پس از ایجاد دایرکتوری‌های rootfs و overlay_workdir فراخوانی می‌شود
+// cleanup باید rootfs را جدا و دایرکتوری‌های کانتینر را به reaper بسپارد
+typedef struct {
+    const char *name;
+    int (*prepare)(container_config_t *config);
+    int (*cleanup)(container_config_t *config);
+} snapshotter_t;
+
+// snapshotter متناظر با نوع (نوع نامعتبر به overlay برمی‌گردد)
+const snapshotter_t* snapshotter_get(snapshot_type_t type);
+
+// تبدیل نام ("overlay", "tmpfs", "reflink", "bind") به نوع
+int snapshotter_parse(const char *name, snapshot_type_t *type);
+
+// مسیر لایه‌های پایینی کانتینر از بالا به پایین؛ تعداد لایه‌ها یا -1
+// بدون تصویر فقط rootfs پایه برگردانده می‌شود
+int snapshot_lower_dirs(const container_config_t *config, char (*lowers)[SNAPSHOT_PATH_MAX], int max);
+
+// مقدار گزینه lowerdir برای overlayfs؛ top در صورت وجود بالاترین لایه می‌شود
+// با نگاشت شناسه مسیرها به نسخه‌های idmapped نصب‌شده با snapshot_idmap_lowers اشاره می‌کنند
+int snapshot_lowerdir_option(const container_config_t *config, const char *top, char *buffer, size_t size);
+
+// نصب نسخه idmapped لایه‌های پایینی با نگاشت شناسه کانتینر؛ لایه مشترک روی دیسک بدون chown با
+// شناسه‌های هر کانتینر دیده می‌شود. overlayfs هنگام نصب clone خصوصی لایه‌ها را نگه می‌دارد، پس
+// پس از نصب (موفق یا ناموفق) snapshot_idmap_release نسخه‌ها را جدا می‌کند
+int snapshot_idmap_lowers(const container_config_t *config);
+void snapshot_idmap_release(const container_config_t *config);
+
+// دایرکتوری‌ای که نوشته‌های کانتینر در آن می‌نشیند؛ NULL برای bind که لایه قابل نوشتن ندارد
+const char* snapshot_writable_dir(const container_config_t *config);
+
+#endif /* SNAPSHOT_H */
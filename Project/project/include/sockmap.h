@@ -0,0 +1,25 @@
+#ifndef SOCKMAP_H
+#define SOCKMAP_H
+
+// شتاب‌دهنده TCP محلی: برنامه sockops سوکت‌های برقرارشده کانتینرها را در sockhash ثبت می‌کند و برنامه
+// sk_msg داده هر sendmsg را مستقیماً به صف دریافت سوکت مقابل می‌فرستد (بدون عبور از پشته TCP/IP)
+// فقط اتصال‌های IPv4 روی loopback (در همان netns) یا زیرشبکه bridge کانتینرها شتاب می‌گیرند؛
+// اگر سوکت مقابل در map نباشد داده از مسیر عادی TCP می‌رود و برنامه‌ها تفاوتی نمی‌بینند
+
+// حداکثر سوکت‌های ثبت‌شده
+#define SOCKMAP_MAX_ENTRIES 65536
+
+// بارگذاری map و برنامه‌ها با فراخوان bpf() یا استفاده از نسخه pin‌شده
+int sockmap_init();
+
+// اتصال برنامه sockops به cgroup v2؛ فقط اتصال‌هایی که پس از آن برقرار شوند ثبت می‌شوند
+int sockmap_attach_cgroup(const char *cgroup_path);
+int sockmap_detach_cgroup(const char *cgroup_path);
+
+// تعداد سوکت‌های فعلی در sockhash یا -1
+int sockmap_socket_count();
+
+// بستن توصیف‌گرها؛ برنامه‌های متصل و نسخه pin‌شده باقی می‌مانند
+void sockmap_cleanup();
+
+#endif /* SOCKMAP_H */
@@ -0,0 +1,22 @@
+#ifndef SYSLEARN_H
+#define SYSLEARN_H
+
+// حالت یادگیری پروفایل seccomp: برنامه eBPF روی raw tracepoint sys_enter فقط فرآیندهای زیر cgroup
+// کانتینر را می‌شمارد و برای syscall هایی که یک آرگومان انتخابگر دارند (خانواده socket، گزینه prctl، ...)
+// مقادیر دیده‌شده را نگه می‌دارد. شمارش با نخستین execve درون cgroup آغاز می‌شود تا آماده‌سازی پیش از
+// اجرای برنامه کاربر، که پیش از نصب فیلتر انجام می‌شود، در پروفایل نیاید
+
+// آرگومان‌های با مقدار بیشتر از این در یک دسته "بزرگ‌تر" ثبت می‌شوند
+#define SYSLEARN_CLASS_MAX 63
+
+// شروع ضبط برای cgroup_path؛ پروفایل با syslearn_finish در profile_path نوشته می‌شود
+int syslearn_start(const char *id, const char *cgroup_path, const char *profile_path);
+
+// پایان ضبط id و نوشتن پروفایل کمینه (default errno و allow برای syscall های دیده‌شده به ترتیب تکرار،
+// با تعداد و مقادیر آرگومان انتخابگر به صورت توضیح)؛ اگر ضبطی نباشد 0
+int syslearn_finish(const char *id);
+
+// پایان ضبط id بدون نوشتن پروفایل، برای کانتینری که شروع آن شکست خورده است
+void syslearn_discard(const char *id);
+
+#endif /* SYSLEARN_H */
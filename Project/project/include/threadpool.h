@@ -0,0 +1,27 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+
+// تابع کار؛ در یکی از thread های مخزن اجرا می‌شود
+typedef void (*threadpool_task_t)(void *arg);
+
+// مخزن thread با صف محدود؛ ارسال کار هنگام پر بودن صف مسدود می‌شود
+typedef struct threadpool threadpool_t;
+
+// ایجاد مخزن (threads = 0 یعنی تعداد CPU های در دسترس)
+threadpool_t* threadpool_create(int threads, size_t queue_capacity);
+
+// افزودن کار به صف
+int threadpool_submit(threadpool_t *pool, threadpool_task_t task, void *arg);
+
+// انتظار تا اجرای همه کارهای ارسال‌شده
+void threadpool_wait(threadpool_t *pool);
+
+// تعداد thread های مخزن
+int threadpool_size(const threadpool_t *pool);
+
+// پایان کارهای باقیمانده و آزادسازی مخزن
+void threadpool_destroy(threadpool_t *pool);
+
+#endif /* THREADPOOL_H */
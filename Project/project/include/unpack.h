@@ -0,0 +1,33 @@
+#ifndef UNPACK_H
+#define UNPACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// گزینه‌های باز کردن آرشیو
+typedef struct {
+    int threads;                // تعداد thread های نوشتن (0 = تعداد CPU ها)
+    bool preserve_owner;        // اعمال uid/gid ثبت‌شده در آرشیو
+    bool convert_whiteouts;     // تبدیل فایل‌های .wh. لایه به whiteout های overlayfs
+    const char *expected_digest; // digest آرشیو ("sha256:<hex>") که همزمان با باز کردن بررسی می‌شود، یا NULL
+} unpack_options_t;
+
+// آمار باز کردن آرشیو
+typedef struct {
+    uint64_t files;
+    uint64_t directories;
+    uint64_t symlinks;
+    uint64_t hardlinks;
+    uint64_t whiteouts;
+    uint64_t bytes;             // حجم داده فایل‌های معمولی
+} unpack_stats_t;
+
+// گزینه‌های پیش‌فرض
+void unpack_default_options(unpack_options_t *options);
+
+// باز کردن جریانی آرشیو tar (بدون فشرده‌سازی یا gzip/zstd/xz/bzip2) در destination
+// options و stats می‌توانند NULL باشند
+int unpack_tar(const char *archive_path, const char *destination,
+               const unpack_options_t *options, unpack_stats_t *stats);
+
+#endif /* UNPACK_H */
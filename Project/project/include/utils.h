@@ -16,19 +16,60 @@ int create_directory(const char *path, int mode);
 // حذف دایرکتوری
 int remove_directory(const char *path);
 
+// حذف بازگشتی name زیر dir_fd با openat/unlinkat؛ on_remove (اختیاری) پس از حذف هر ورودی فراخوانی می‌شود
+int remove_directory_at(int dir_fd, const char *name, void (*on_remove)(void *arg), void *arg);
+
+// سطوح لاگ
+typedef enum {
+    LOG_LEVEL_ERROR = 0,
+    LOG_LEVEL_INFO = 1,
+    LOG_LEVEL_DEBUG = 2
+} log_level_t;
+
+// سطح فعلی لاگ
+extern int log_level;
+
+// تنظیم سطح لاگ
+void log_set_level(log_level_t level);
+
 // ثبت لاگ
 void log_message(const char *format, ...);
 
+// ثبت لاگ جزئیات مسیرهای داغ؛ در سطح پایین‌تر از DEBUG هیچ قالب‌بندی و stdio انجام نمی‌شود
+void log_debug_message(const char *format, ...);
+#define log_debug(...) \
+    do { \
+        if (log_level >= LOG_LEVEL_DEBUG) { \
+            log_debug_message(__VA_ARGS__); \
+        } \
+    } while (0)
+
 // ثبت خطا
 void log_error(const char *format, ...);
 
 // بررسی دسترسی‌های root
 bool has_root_privileges();
 
-// کپی فایل
+// کپی فایل با حفظ مجوزها، مالکیت، زمان‌ها و حفره‌ها
+// به ترتیب reflink (FICLONE)، copy_file_range، sendfile و در نهایت بافر بزرگ امتحان می‌شوند
 int copy_file(const char *source, const char *destination);
 
+// همان کپی روی توصیف‌گرهای باز؛ dest_fd باید فایل خالی قابل نوشتن باشد
+int copy_file_fd(int source_fd, int dest_fd);
+
 // حذف فایل
 int remove_file(const char *path);
 
+// زمان یکنواخت بر حسب نانوثانیه
+uint64_t monotonic_time_ns();
+
+// استراحت کوتاه پردازنده در حلقه‌های انتظار
+void cpu_relax();
+
+// انتظار futex روی کلمه مشترک بین فرآیندها (timeout_ns منفی یعنی بدون مهلت)
+int futex_wait_shared(uint32_t *address, uint32_t expected, int64_t timeout_ns);
+
+// بیدار کردن منتظران futex
+int futex_wake_shared(uint32_t *address, int count);
+
 #endif /* UTILS_H */
\ No newline at end of file
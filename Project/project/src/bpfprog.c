@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mount.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#include "../include/bpfprog.h"
+#include "../include/utils.h"
+
+#define VERIFIER_LOG_SIZE 65536
+
+long bpf_call(int cmd, union bpf_attr *attr) {
+    return syscall(SYS_bpf, cmd, attr, sizeof(*attr));
+}
+
+int bpf_prog_load_insns(enum bpf_prog_type type, enum bpf_attach_type expected_attach_type,
+                        const struct bpf_insn *insns, size_t count) {
+    char *log = malloc(VERIFIER_LOG_SIZE);
+    if (!log) {
+        return -1;
+    }
+    log[0] = '\0';
+
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = type;
+    attr.expected_attach_type = expected_attach_type;
+    attr.insns = (uint64_t)(uintptr_t)insns;
+    attr.insn_cnt = count;
+    attr.license = (uint64_t)(uintptr_t)"GPL";
+    attr.log_buf = (uint64_t)(uintptr_t)log;
+    attr.log_size = VERIFIER_LOG_SIZE;
+    attr.log_level = 1;
+    int fd = bpf_call(BPF_PROG_LOAD, &attr);
+    if (fd < 0) {
+        log_error("خطا در بارگذاری برنامه eBPF: %s\n%s", strerror(errno), log);
+    }
+    free(log);
+    return fd;
+}
+
+bool bpf_pin_ready() {
+    struct statfs st;
+    if (statfs(BPF_FS_PATH, &st) != 0 || st.f_type != BPF_FS_MAGIC) {
+        if (mount("bpf", BPF_FS_PATH, "bpf", 0, "mode=0700") != 0) {
+            return false;
+        }
+    }
+    return create_directory(BPF_PIN_DIR, 0700) == 0;
+}
+
+int bpf_object_get(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", BPF_PIN_DIR, name);
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.pathname = (uint64_t)(uintptr_t)path;
+    return bpf_call(BPF_OBJ_GET, &attr);
+}
+
+int bpf_object_pin(int fd, const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", BPF_PIN_DIR, name);
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.pathname = (uint64_t)(uintptr_t)path;
+    attr.bpf_fd = fd;
+    return bpf_call(BPF_OBJ_PIN, &attr);
+}
+
+static int cgroup_attach_op(int cmd, const char *cgroup_path, int prog_fd, enum bpf_attach_type type) {
+    int cgroup_fd = open(cgroup_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (cgroup_fd == -1) {
+        log_error("خطا در باز کردن cgroup %s", cgroup_path);
+        return -1;
+    }
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.target_fd = cgroup_fd;
+    attr.attach_bpf_fd = prog_fd;
+    attr.attach_type = type;
+    attr.attach_flags = cmd == BPF_PROG_ATTACH ? BPF_F_ALLOW_MULTI : 0;
+    int result = bpf_call(cmd, &attr);
+    int saved_errno = errno;
+    close(cgroup_fd);
+    errno = saved_errno;
+    return result == 0 ? 0 : -1;
+}
+
+int bpf_cgroup_attach(const char *cgroup_path, int prog_fd, enum bpf_attach_type type) {
+    return cgroup_attach_op(BPF_PROG_ATTACH, cgroup_path, prog_fd, type);
+}
+
+int bpf_cgroup_detach(const char *cgroup_path, int prog_fd, enum bpf_attach_type type) {
+    return cgroup_attach_op(BPF_PROG_DETACH, cgroup_path, prog_fd, type);
+}
@@ -196,6 +196,26 @@ int cgroup_add_process(container_config_t *config, pid_t pid) {
     return 0;
 }
 
+// توقف یا ادامه فرآیندهای cgroup
+int cgroup_freeze(container_config_t *config, bool frozen) {
+    if (write_cgroup_file(config->cgroup_path, "cgroup.freeze", frozen ? "1" : "0") != 0) {
+        return -1;
+    }
+    
+    // انجماد ناهمگام است و پایان آن در cgroup.events گزارش می‌شود
+    char events[256];
+    for (int i = 0; i < 100; i++) {
+        if (read_cgroup_file(config->cgroup_path, "cgroup.events", events, sizeof(events)) == 0 &&
+            strstr(events, frozen ? "frozen 1" : "frozen 0") != NULL) {
+            return 0;
+        }
+        usleep(10000);
+    }
+    
+    log_error("تغییر وضعیت انجماد cgroup %s کامل نشد", config->cgroup_path);
+    return -1;
+}
+
 // دریافت مصرف حافظه
 int cgroup_get_memory_usage(container_config_t *config, uint64_t *usage) {
     char buffer[128];
@@ -2,10 +2,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <errno.h>
 #include <sys/wait.h>
 #include <inttypes.h>
 #include "../include/cli.h"
 #include "../include/container.h"
+#include "../include/layerstore.h"
+#include "../include/snapshot.h"
+#include "../include/prewarm.h"
+#include "../include/network.h"
+#include "../include/idmap.h"
+#include "../include/syslearn.h"
 #include "../include/utils.h"
 
 // تعاریف برای getopt
@@ -14,6 +21,20 @@ static struct option long_options[] = {
     {"memory", required_argument, 0, 'm'},
     {"cpu", required_argument, 0, 'c'},
     {"io-weight", required_argument, 0, 'i'},
+    {"image", required_argument, 0, 'I'},
+    {"verify-layers", no_argument, 0, 'V'},
+    {"snapshotter", required_argument, 0, 's'},
+    {"snapshot-size", required_argument, 0, 'S'},
+    {"record-trace", required_argument, 0, 'R'},
+    {"disk-limit", required_argument, 0, 'D'},
+    {"network", required_argument, 0, 'N'},
+    {"sockmap", no_argument, 0, 'M'},
+    {"net-rate", required_argument, 0, 'B'},
+    {"publish", required_argument, 0, 'p'},
+    {"idmap", required_argument, 0, 'U'},
+    {"seccomp", required_argument, 0, 'P'},
+    {"learn-seccomp", required_argument, 0, 'L'},
+    {"fork-server", required_argument, 0, 'F'},
     {"detach", no_argument, 0, 'd'},
     {"help", no_argument, 0, 'h'},
     {0, 0, 0, 0}
@@ -28,6 +49,8 @@ void cli_help() {
     printf("  stop <شناسه>    توقف یک کانتینر\n");
     printf("  start <شناسه>   راه‌اندازی مجدد یک کانتینر\n");
     printf("  status <شناسه>  نمایش وضعیت یک کانتینر\n");
+    printf("  commit <شناسه> <دایرکتوری>  ذخیره تغییرات کانتینر به صورت تصویر\n");
+    printf("  exec <شناسه> <فرمان> [آرگومان‌ها]  اجرای فرمان در کانتینر در حال اجرا\n");
     printf("  help            نمایش این پیام راهنما\n\n");
     
     printf("گزینه‌های run:\n");
@@ -35,10 +58,57 @@ void cli_help() {
     printf("  --memory, -m <مقدار>    محدودیت حافظه (مثال: 100M)\n");
     printf("  --cpu, -c <شماره>       تخصیص کانتینر به یک CPU خاص\n");
     printf("  --io-weight, -i <وزن>   وزن I/O (1-100)\n");
+    printf("  --image, -I <مسیر>      تصویر لایه‌ای (دایرکتوری با فایل manifest)\n");
+    printf("  --verify-layers, -V     بررسی digest لایه‌های موجود در انبار پیش از استفاده\n");
+    printf("  --snapshotter, -s <نوع> روش ساخت rootfs: overlay، tmpfs، reflink یا bind\n");
+    printf("  --snapshot-size, -S <مقدار> سقف حجم نوشتن‌ها برای snapshotter tmpfs (مثال: 256M)\n");
+    printf("  --record-trace, -R <ثانیه> ضبط فایل‌های خوانده‌شده برای پیش‌خوانی در اجراهای بعدی تصویر\n");
+    printf("  --disk-limit, -D <مقدار> سقف لایه قابل نوشتن با project quota برای overlay و reflink (مثال: 1G)\n");
+    printf("  --network, -N <حالت>    شبکه کانتینر: none (فقط loopback) یا bridge (veth روی %s)\n", NETWORK_BRIDGE_NAME);
+    printf("  --sockmap, -M           شتاب اتصال‌های TCP محلی کانتینر با eBPF sockmap\n");
+    printf("  --net-rate, -B <مقدار>  سقف ترافیک شبکه در هر جهت بر ثانیه (مثال: 10M)\n");
+    printf("  --publish, -p <میزبان:کانتینر> انتشار پورت TCP کانتینر روی میزبان (حداکثر %d بار)\n", MAX_PORT_MAPPINGS);
+    printf("  --idmap, -U <پایه[:تعداد]|subuid> نگاشت شناسه‌های کانتینر به محدوده فرعی میزبان با idmapped mount\n");
+    printf("  --seccomp, -P <مسیر>    پروفایل seccomp (خطوط \"<allow|errno|kill|log> <syscall> [تعداد]\" و \"default <تصمیم>\")\n");
+    printf("  --learn-seccomp, -L <مسیر> ضبط syscall های کانتینر و نوشتن پروفایل کمینه برای --seccomp در پایان اجرا\n");
+    printf("  --fork-server, -F <تعداد> اجرای یک‌باره برنامه و ساخت نمونه‌ها با fork از وضعیت مقداردهی‌شده (%s)\n",
+           FORKSERVER_ENV);
     printf("  --detach, -d            اجرا در پس‌زمینه\n");
     printf("  --help, -h              نمایش این پیام راهنما\n");
 }
 
+// پارس کردن اندازه با پسوند اختیاری K، M یا G (مثلاً 100M, 2G)
+static uint64_t parse_size(const char *text) {
+    char *endptr;
+    uint64_t value = strtoull(text, &endptr, 10);
+    
+    if (*endptr == 'K' || *endptr == 'k') {
+        return value * 1024;
+    } else if (*endptr == 'M' || *endptr == 'm') {
+        return value * 1024 * 1024;
+    } else if (*endptr == 'G' || *endptr == 'g') {
+        return value * 1024 * 1024 * 1024;
+    }
+    return value;
+}
+
+// پارس کردن انتشار پورت به شکل میزبان:کانتینر یا یک پورت برای هر دو (مثلاً 8080:80)
+static int parse_port_mapping(const char *text, port_mapping_t *mapping) {
+    char *endptr;
+    unsigned long host_port = strtoul(text, &endptr, 10);
+    unsigned long container_port = host_port;
+    if (*endptr == ':') {
+        container_port = strtoul(endptr + 1, &endptr, 10);
+    }
+    if (*endptr != '\0' || endptr == text || host_port == 0 || host_port > 65535 ||
+        container_port == 0 || container_port > 65535) {
+        return -1;
+    }
+    mapping->host_port = host_port;
+    mapping->container_port = container_port;
+    return 0;
+}
+
 // پردازش دستورات ورودی
 int cli_process_command(container_manager_t *manager, int argc, char **argv) {
     if (argc < 2) {
@@ -70,6 +140,18 @@ int cli_process_command(container_manager_t *manager, int argc, char **argv) {
             return 1;
         }
         return cli_status(manager, argv[2]);
+    } else if (strcmp(command, CMD_COMMIT) == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "خطا: شناسه کانتینر و دایرکتوری تصویر مشخص نشده است\n");
+            return 1;
+        }
+        return cli_commit(manager, argv[2], argv[3]);
+    } else if (strcmp(command, CMD_EXEC) == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "خطا: شناسه کانتینر و فرمان مشخص نشده است\n");
+            return 1;
+        }
+        return cli_exec(manager, argv[2], argv + 3);
     } else if (strcmp(command, CMD_HELP) == 0) {
         cli_help();
         return 0;
@@ -80,6 +162,29 @@ int cli_process_command(container_manager_t *manager, int argc, char **argv) {
     }
 }
 
+// ساخت نمونه‌ها از fork-server و انتظار برای پایان همه؛ سپس بستن سوکت سرور را پایان می‌دهد
+static int cli_run_instances(container_manager_t *manager, container_config_t *config, int count) {
+    forkserver_instance_t *instances = calloc(count, sizeof(forkserver_instance_t));
+    if (!instances) {
+        return -1;
+    }
+    
+    int created = 0;
+    while (created < count && container_fork_instance(manager, config->id, 0, &instances[created]) == 0) {
+        printf("نمونه %u با PID %d\n", instances[created].id, instances[created].pid);
+        created++;
+    }
+    for (int i = 0; i < created; i++) {
+        forkserver_instance_wait(&instances[i], -1);
+        forkserver_instance_destroy(&instances[i]);
+    }
+    free(instances);
+    
+    close(config->forkserver_fd);
+    config->forkserver_fd = -1;
+    return created == count ? 0 : -1;
+}
+
 // پردازش دستور run
 int cli_run(container_manager_t *manager, int argc, char **argv) {
     // مقادیر پیش‌فرض
@@ -88,34 +193,24 @@ int cli_run(container_manager_t *manager, int argc, char **argv) {
     int cpu_affinity = -1;
     uint64_t io_weight = 100;
     bool detach = false;
+    int instances = 0;
+    container_options_t options = { NULL, SNAPSHOT_OVERLAY, 0, 0, 0, NETWORK_NONE, false, 0, { { 0, 0 } }, 0,
+                                    { 0, 0, 0 }, NULL, NULL, false };
     
     // پارس کردن گزینه‌ها
     optind = 0;  // بازنشانی optind
     int opt;
     int option_index = 0;
     
-    while ((opt = getopt_long(argc, argv, "n:m:c:i:dh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "n:m:c:i:I:Vs:S:R:D:N:MB:p:U:P:L:F:dh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'n':
                 strncpy(container_name, optarg, sizeof(container_name) - 1);
                 break;
                 
-            case 'm': {
-                // پارس کردن محدودیت حافظه (مثلاً 100M, 2G)
-                char *endptr;
-                uint64_t value = strtoull(optarg, &endptr, 10);
-                
-                if (*endptr == 'K' || *endptr == 'k') {
-                    memory_limit = value * 1024;
-                } else if (*endptr == 'M' || *endptr == 'm') {
-                    memory_limit = value * 1024 * 1024;
-                } else if (*endptr == 'G' || *endptr == 'g') {
-                    memory_limit = value * 1024 * 1024 * 1024;
-                } else {
-                    memory_limit = value;
-                }
+            case 'm':
+                memory_limit = parse_size(optarg);
                 break;
-            }
                 
             case 'c':
                 cpu_affinity = atoi(optarg);
@@ -125,6 +220,81 @@ int cli_run(container_manager_t *manager, int argc, char **argv) {
                 io_weight = atoi(optarg);
                 break;
                 
+            case 'I':
+                options.image_path = optarg;
+                break;
+                
+            case 'V':
+                layer_store_set_verify(true);
+                break;
+                
+            case 's':
+                if (snapshotter_parse(optarg, &options.snapshotter) != 0) {
+                    fprintf(stderr, "خطا: snapshotter نامعتبر '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+                
+            case 'S':
+                options.snapshot_size = parse_size(optarg);
+                break;
+                
+            case 'R':
+                options.record_trace_seconds = atoi(optarg);
+                break;
+                
+            case 'D':
+                options.disk_limit_bytes = parse_size(optarg);
+                break;
+                
+            case 'N':
+                if (network_mode_parse(optarg, &options.network) != 0) {
+                    fprintf(stderr, "خطا: حالت شبکه نامعتبر '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+                
+            case 'M':
+                options.sockmap = true;
+                break;
+                
+            case 'B':
+                options.net_rate_bytes = parse_size(optarg);
+                break;
+                
+            case 'p':
+                if (options.port_count == MAX_PORT_MAPPINGS ||
+                    parse_port_mapping(optarg, &options.ports[options.port_count]) != 0) {
+                    fprintf(stderr, "خطا: انتشار پورت نامعتبر '%s'\n", optarg);
+                    return 1;
+                }
+                options.port_count++;
+                break;
+                
+            case 'U':
+                if (idmap_parse(optarg, &options.idmap) != 0) {
+                    fprintf(stderr, "خطا: نگاشت شناسه نامعتبر '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+                
+            case 'P':
+                options.seccomp_profile = optarg;
+                break;
+                
+            case 'L':
+                options.seccomp_learn = optarg;
+                break;
+                
+            case 'F':
+                instances = atoi(optarg);
+                if (instances <= 0) {
+                    fprintf(stderr, "خطا: تعداد نمونه نامعتبر '%s'\n", optarg);
+                    return 1;
+                }
+                options.fork_server = true;
+                break;
+                
             case 'd':
                 detach = true;
                 break;
@@ -139,6 +309,25 @@ int cli_run(container_manager_t *manager, int argc, char **argv) {
         }
     }
     
+    // bind لایه قابل نوشتن ندارد و tmpfs با --snapshot-size محدود می‌شود
+    if (options.disk_limit_bytes > 0 &&
+        (options.snapshotter == SNAPSHOT_BIND || options.snapshotter == SNAPSHOT_TMPFS)) {
+        fprintf(stderr, "خطا: --disk-limit با snapshotter %s ممکن نیست\n",
+                snapshotter_get(options.snapshotter)->name);
+        return 1;
+    }
+    
+    if (options.fork_server && detach) {
+        fprintf(stderr, "خطا: fork-server به مدیر در حال اجرا نیاز دارد و با --detach ممکن نیست\n");
+        return 1;
+    }
+    
+    // ضبط syscall ها به این فرآیند وابسته است و پروفایل هنگام توقف کانتینر توسط همین فرآیند نوشته می‌شود
+    if (options.seccomp_learn && detach) {
+        fprintf(stderr, "خطا: --learn-seccomp تا پایان کانتینر به مدیر در حال اجرا نیاز دارد و با --detach ممکن نیست\n");
+        return 1;
+    }
+    
     // بررسی وجود باینری
     if (optind >= argc) {
         fprintf(stderr, "خطا: مسیر باینری مشخص نشده است\n");
@@ -156,7 +345,8 @@ int cli_run(container_manager_t *manager, int argc, char **argv) {
     }
     
     // ایجاد کانتینر
-    if (container_create(manager, container_name, binary_path, container_args, container_argc) != 0) {
+    if (container_create_with_options(manager, container_name, &options, binary_path,
+                                      container_args, container_argc) != 0) {
         fprintf(stderr, "خطا در ایجاد کانتینر\n");
         free(container_args);
         return 1;
@@ -181,8 +371,14 @@ int cli_run(container_manager_t *manager, int argc, char **argv) {
     
     // اگر در حالت detach نیست، منتظر پایان کانتینر بمان
     if (!detach) {
+        if (options.fork_server && cli_run_instances(manager, config, instances) != 0) {
+            fprintf(stderr, "خطا در ساخت نمونه‌های fork-server\n");
+        }
+        
         int status;
         waitpid(config->container_pid, &status, 0);
+        prewarm_record_finish(config->id);
+        syslearn_finish(config->id);
         
         if (WIFEXITED(status)) {
             printf("کانتینر با کد خروج %d به پایان رسید\n", WEXITSTATUS(status));
@@ -214,6 +410,27 @@ int cli_status(container_manager_t *manager, const char *container_id) {
     return container_status(manager, container_id);
 }
 
+// ذخیره تغییرات کانتینر به صورت تصویر
+int cli_commit(container_manager_t *manager, const char *container_id, const char *image_dir) {
+    return container_commit(manager, container_id, image_dir);
+}
+
+// اجرای فرمان در کانتینر و بازگرداندن وضعیت خروج آن
+int cli_exec(container_manager_t *manager, const char *container_id, char **argv) {
+    pid_t pid = container_exec(manager, container_id, argv);
+    if (pid == -1) {
+        return 1;
+    }
+    
+    int status;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return 1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
 // پارس کردن آرگومان‌های دستور
 int cli_parse_args(int argc, char **argv, char **binary_path, char ***container_args, int *container_argc) {
     if (argc <= 0) {
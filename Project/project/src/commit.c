@@ -0,0 +1,1144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <sys/mount.h>
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include <sys/sysmacros.h>
+#include "../include/commit.h"
+#include "../include/cgroup.h"
+#include "../include/digest.h"
+#include "../include/snapshot.h"
+#include "../include/idmap.h"
+#include "../include/mounttree.h"
+#include "../include/utils.h"
+
+#define TAR_BLOCK_SIZE 512
+
+// بافر نوشتن آرشیو؛ هش آرشیو همزمان با هر flush به‌روز می‌شود
+#define COMMIT_BUFFER_SIZE (1024 * 1024)
+
+#define COMMIT_CACHE_HEADER "# simplecontainer commit cache v1"
+
+// قالب whiteout لایه‌های تصویر، همان که unpack_tar به whiteout overlayfs تبدیل می‌کند
+#define WHITEOUT_PREFIX ".wh."
+#define WHITEOUT_OPAQUE ".wh..wh..opq"
+
+// نوع ورودی در upperdir و cache
+#define KIND_FILE     'f'
+#define KIND_DIR      'd'
+#define KIND_OPAQUE   'o'   // دایرکتوری با trusted.overlay.opaque=y
+#define KIND_SYMLINK  'l'
+#define KIND_WHITEOUT 'w'   // دستگاه کاراکتری 0/0
+#define KIND_SPECIAL  's'
+
+// وضعیت یک ورودی upperdir در commit قبلی
+typedef struct {
+    char *path;                 // مسیر نسبی، "." برای ریشه
+    char kind;
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    uint64_t size;              // اندازه فایل یا rdev دستگاه
+    uint64_t ino;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+    bool has_digest;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    long entry;                 // اندیس ورودی متناظر در پیمایش فعلی، -1 اگر دیگر وجود ندارد
+} cache_record_t;
+
+// یک لایه از زنجیره commit ها، از پایین به بالا
+typedef struct {
+    char digest[DIGEST_STRING_MAX];
+    char archive[PATH_MAX];
+} cache_layer_t;
+
+typedef struct {
+    cache_record_t *records;    // مرتب بر اساس مسیر
+    size_t count;
+    size_t capacity;
+    cache_layer_t layers[MAX_IMAGE_LAYERS];
+    int layer_count;
+} commit_cache_t;
+
+// یک ورودی upperdir به ترتیب پیش‌ترتیب
+typedef struct {
+    char *path;
+    struct stat st;
+    char kind;
+    long parent;
+    bool include;               // در لایه تازه نوشته می‌شود
+    bool forced;                // زیردرخت کامل نوشته می‌شود (opaque تازه لایه‌های قبلی را پنهان می‌کند)
+    bool new_opaque;
+    bool needs_hash;
+    bool emitted;
+    bool has_digest;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    cache_record_t *record;
+} commit_entry_t;
+
+// ورودی upper که پس از commit قبلی حذف شده و whiteout صریح لازم دارد
+typedef struct {
+    long parent;
+    const char *name;
+} deletion_t;
+
+// نخستین مسیر نوشته‌شده هر inode دارای چند پیوند
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    const char *path;
+} link_entry_t;
+
+// نویسنده جریانی tar
+typedef struct {
+    int fd;
+    sha256_ctx_t sha;
+    uint8_t *buffer;
+    size_t used;
+    uint64_t written;
+} tar_writer_t;
+
+// سرآیند ustar
+typedef struct {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char padding[12];
+} tar_header_t;
+
+typedef struct {
+    const char *root;
+    commit_entry_t *entries;
+    size_t count;
+    size_t capacity;
+    deletion_t *deletions;
+    size_t deletion_count;
+    size_t deletion_capacity;
+    link_entry_t *links;        // جدول درهم‌سازی با آدرس‌دهی باز
+    size_t link_capacity;
+    commit_cache_t cache;
+    tar_writer_t writer;
+    commit_stats_t stats;
+} commit_context_t;
+
+static int64_t timespec_ns(struct timespec ts) {
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static char entry_kind(const char *path, const struct stat *st) {
+    if (S_ISREG(st->st_mode)) {
+        return KIND_FILE;
+    }
+    if (S_ISDIR(st->st_mode)) {
+        char value[2];
+        ssize_t length = lgetxattr(path, "trusted.overlay.opaque", value, sizeof(value));
+        return length == 1 && value[0] == 'y' ? KIND_OPAQUE : KIND_DIR;
+    }
+    if (S_ISLNK(st->st_mode)) {
+        return KIND_SYMLINK;
+    }
+    if (S_ISCHR(st->st_mode) && st->st_rdev == makedev(0, 0)) {
+        return KIND_WHITEOUT;
+    }
+    if (S_ISCHR(st->st_mode) || S_ISBLK(st->st_mode) || S_ISFIFO(st->st_mode)) {
+        return KIND_SPECIAL;
+    }
+    return 0;  // سوکت‌ها در tar قابل نمایش نیستند
+}
+
+static bool kind_is_dir(char kind) {
+    return kind == KIND_DIR || kind == KIND_OPAQUE;
+}
+
+// ---------- cache ----------
+
+static int compare_records(const void *a, const void *b) {
+    return strcmp(((const cache_record_t *)a)->path, ((const cache_record_t *)b)->path);
+}
+
+static cache_record_t* cache_find(commit_cache_t *cache, const char *path) {
+    cache_record_t key = { .path = (char *)path };
+    return bsearch(&key, cache->records, cache->count, sizeof(cache_record_t), compare_records);
+}
+
+static void cache_free(commit_cache_t *cache) {
+    for (size_t i = 0; i < cache->count; i++) {
+        free(cache->records[i].path);
+    }
+    free(cache->records);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// خواندن cache؛ نبودن فایل یعنی نخستین commit
+static int cache_load(commit_cache_t *cache, const char *cache_path) {
+    memset(cache, 0, sizeof(*cache));
+    FILE *file = fopen(cache_path, "r");
+    if (!file) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t length;
+    int result = 0;
+    while (result == 0 && (length = getline(&line, &line_size, file)) > 0) {
+        if (line[length - 1] == '\n') {
+            line[--length] = '\0';
+        }
+        if (line[0] == '#' || length == 0) {
+            continue;
+        }
+
+        int offset = 0;
+        if (strncmp(line, "layer ", 6) == 0) {
+            if (cache->layer_count == MAX_IMAGE_LAYERS) {
+                result = -1;
+                break;
+            }
+            cache_layer_t *layer = &cache->layers[cache->layer_count];
+            if (sscanf(line, "layer %71s%n", layer->digest, &offset) != 1 || line[offset] != ' ') {
+                result = -1;
+                break;
+            }
+            snprintf(layer->archive, sizeof(layer->archive), "%s", line + offset + 1);
+            cache->layer_count++;
+            continue;
+        }
+
+        if (cache->count == cache->capacity) {
+            size_t capacity = cache->capacity ? cache->capacity * 2 : 256;
+            cache_record_t *records = realloc(cache->records, capacity * sizeof(cache_record_t));
+            if (!records) {
+                result = -1;
+                break;
+            }
+            cache->records = records;
+            cache->capacity = capacity;
+        }
+
+        cache_record_t *record = &cache->records[cache->count];
+        memset(record, 0, sizeof(*record));
+        char digest[DIGEST_STRING_MAX];
+        unsigned mode, uid, gid;
+        if (sscanf(line, "%c %o %u %u %" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64 " %71s%n",
+                   &record->kind, &mode, &uid, &gid, &record->size, &record->ino,
+                   &record->mtime_ns, &record->ctime_ns, digest, &offset) != 9 || line[offset] != ' ') {
+            result = -1;
+            break;
+        }
+        record->mode = mode;
+        record->uid = uid;
+        record->gid = gid;
+        record->has_digest = strcmp(digest, "-") != 0 && digest_parse(digest, record->digest) == 0;
+        record->entry = -1;
+        // مسیر پس از یک فاصله تا پایان خط است و می‌تواند فاصله داشته باشد
+        if (!(record->path = strdup(line + offset + 1))) {
+            result = -1;
+            break;
+        }
+        cache->count++;
+    }
+    free(line);
+    fclose(file);
+
+    if (result != 0) {
+        log_error("فایل cache نامعتبر است: %s", cache_path);
+        cache_free(cache);
+        return -1;
+    }
+    qsort(cache->records, cache->count, sizeof(cache_record_t), compare_records);
+    return 0;
+}
+
+// نوشتن اتمیک cache: وضعیت فعلی همه ورودی‌های upper و زنجیره لایه‌ها
+static int cache_save(commit_context_t *ctx, const char *cache_path) {
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+    FILE *file = fopen(tmp_path, "w");
+    if (!file) {
+        log_error("خطا در ایجاد فایل cache %s", tmp_path);
+        return -1;
+    }
+
+    fprintf(file, "%s\n", COMMIT_CACHE_HEADER);
+    for (int i = 0; i < ctx->cache.layer_count; i++) {
+        fprintf(file, "layer %s %s\n", ctx->cache.layers[i].digest, ctx->cache.layers[i].archive);
+    }
+    for (size_t i = 0; i < ctx->count; i++) {
+        const commit_entry_t *entry = &ctx->entries[i];
+        // نام دارای خط جدید ثبت نمی‌شود و در commit بعدی دوباره نوشته می‌شود
+        if (strchr(entry->path, '\n')) {
+            continue;
+        }
+        char digest[DIGEST_STRING_MAX] = "-";
+        if (entry->has_digest) {
+            digest_format(entry->digest, digest, sizeof(digest));
+        }
+        uint64_t size = entry->kind == KIND_SPECIAL ? (uint64_t)entry->st.st_rdev : (uint64_t)entry->st.st_size;
+        fprintf(file, "%c %o %u %u %" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64 " %s %s\n",
+                entry->kind, entry->st.st_mode & 07777, entry->st.st_uid, entry->st.st_gid, size,
+                (uint64_t)entry->st.st_ino, timespec_ns(entry->st.st_mtim), timespec_ns(entry->st.st_ctim),
+                digest, entry->path);
+    }
+
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0 || fclose(file) != 0 || rename(tmp_path, cache_path) != 0) {
+        log_error("خطا در نوشتن فایل cache %s", cache_path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------- پیمایش upperdir ----------
+
+static int compare_names(const struct dirent **a, const struct dirent **b) {
+    return strcmp((*a)->d_name, (*b)->d_name);
+}
+
+static int skip_dots(const struct dirent *entry) {
+    return strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0;
+}
+
+static long add_entry(commit_context_t *ctx, const char *path, const char *relative, long parent) {
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        log_error("خطا در خواندن مشخصات %s", path);
+        return -1;
+    }
+    char kind = entry_kind(path, &st);
+    if (kind == 0) {
+        log_debug("ورودی %s در لایه نوشته نمی‌شود", path);
+        return -2;
+    }
+
+    if (ctx->count == ctx->capacity) {
+        size_t capacity = ctx->capacity ? ctx->capacity * 2 : 256;
+        commit_entry_t *entries = realloc(ctx->entries, capacity * sizeof(commit_entry_t));
+        if (!entries) {
+            return -1;
+        }
+        ctx->entries = entries;
+        ctx->capacity = capacity;
+    }
+
+    commit_entry_t *entry = &ctx->entries[ctx->count];
+    memset(entry, 0, sizeof(*entry));
+    if (!(entry->path = strdup(relative))) {
+        return -1;
+    }
+    entry->st = st;
+    entry->kind = kind;
+    entry->parent = parent;
+    return (long)ctx->count++;
+}
+
+// افزودن زیردرخت path (دایرکتوری با اندیس index) به ترتیب پیش‌ترتیب مرتب‌شده
+static int walk_upper(commit_context_t *ctx, char *path, size_t root_length, long index) {
+    struct dirent **names;
+    int count = scandir(path, &names, skip_dots, compare_names);
+    if (count < 0) {
+        log_error("خطا در باز کردن دایرکتوری: %s", path);
+        return -1;
+    }
+
+    size_t length = strlen(path);
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        size_t name_length = strlen(names[i]->d_name);
+        if (result != 0 || length + name_length + 2 > PATH_MAX) {
+            result = -1;
+            free(names[i]);
+            continue;
+        }
+        path[length] = '/';
+        memcpy(path + length + 1, names[i]->d_name, name_length + 1);
+        free(names[i]);
+
+        long child = add_entry(ctx, path, path + root_length + 1, index);
+        if (child == -1) {
+            result = -1;
+        } else if (child >= 0 && kind_is_dir(ctx->entries[child].kind)) {
+            result = walk_upper(ctx, path, root_length, child);
+        }
+        path[length] = '\0';
+    }
+
+    free(names);
+    return result;
+}
+
+// مقایسه با commit قبلی؛ فایل‌هایی که مشخصاتشان تغییر کرده برای هش علامت می‌خورند
+static void classify_entries(commit_context_t *ctx) {
+    for (size_t i = 0; i < ctx->count; i++) {
+        commit_entry_t *entry = &ctx->entries[i];
+        cache_record_t *record = cache_find(&ctx->cache, entry->path);
+        const struct stat *st = &entry->st;
+        bool forced = entry->parent >= 0 && ctx->entries[entry->parent].forced;
+        if (record) {
+            record->entry = (long)i;
+        }
+        entry->record = record;
+
+        bool same_attrs = record && record->mode == (st->st_mode & 07777) &&
+                          record->uid == st->st_uid && record->gid == st->st_gid;
+        bool same_inode = record && record->ino == (uint64_t)st->st_ino &&
+                          record->mtime_ns == timespec_ns(st->st_mtim) &&
+                          record->ctime_ns == timespec_ns(st->st_ctim);
+
+        switch (entry->kind) {
+            case KIND_DIR:
+            case KIND_OPAQUE:
+                // زمان دایرکتوری با تغییر فرزندان عوض می‌شود و مقایسه نمی‌شود
+                entry->new_opaque = entry->kind == KIND_OPAQUE && (!record || record->kind != KIND_OPAQUE);
+                entry->forced = forced || entry->new_opaque;
+                entry->include = forced || entry->new_opaque || !record ||
+                                 !kind_is_dir(record->kind) || !same_attrs;
+                break;
+
+            case KIND_FILE:
+                if (!forced && record && record->kind == KIND_FILE && same_attrs && same_inode &&
+                    record->size == (uint64_t)st->st_size && record->has_digest) {
+                    memcpy(entry->digest, record->digest, SHA256_DIGEST_SIZE);
+                    entry->has_digest = true;
+                    ctx->stats.unchanged++;
+                } else {
+                    // محتوا پس از هش با digest ثبت‌شده مقایسه می‌شود
+                    entry->needs_hash = true;
+                    entry->include = true;
+                }
+                break;
+
+            case KIND_WHITEOUT:
+                entry->include = forced || !record || record->kind != KIND_WHITEOUT;
+                break;
+
+            default:
+                entry->include = forced || !record || record->kind != entry->kind || !same_attrs || !same_inode ||
+                                 (entry->kind == KIND_SPECIAL && record->size != (uint64_t)st->st_rdev);
+                break;
+        }
+    }
+}
+
+// هش موازی فایل‌های تغییرکرده؛ بازنویسی با همان محتوا و مشخصات تغییر حساب نمی‌شود
+static int hash_changed_files(commit_context_t *ctx, int threads) {
+    size_t count = 0;
+    for (size_t i = 0; i < ctx->count; i++) {
+        count += ctx->entries[i].needs_hash;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    char **paths = calloc(count, sizeof(char *));
+    size_t *indexes = malloc(count * sizeof(size_t));
+    uint8_t (*digests)[SHA256_DIGEST_SIZE] = malloc(count * SHA256_DIGEST_SIZE);
+    int result = paths && indexes && digests ? 0 : -1;
+
+    size_t files = 0;
+    for (size_t i = 0; result == 0 && i < ctx->count; i++) {
+        if (!ctx->entries[i].needs_hash) {
+            continue;
+        }
+        if (asprintf(&paths[files], "%s/%s", ctx->root, ctx->entries[i].path) == -1) {
+            paths[files] = NULL;
+            result = -1;
+            break;
+        }
+        indexes[files++] = i;
+    }
+
+    if (result == 0) {
+        result = digest_files((const char *const *)paths, (int)files, digests, threads);
+    }
+    for (size_t i = 0; result == 0 && i < files; i++) {
+        commit_entry_t *entry = &ctx->entries[indexes[i]];
+        cache_record_t *record = entry->record;
+        memcpy(entry->digest, digests[i], SHA256_DIGEST_SIZE);
+        entry->has_digest = true;
+        ctx->stats.hashed++;
+
+        bool forced = entry->parent >= 0 && ctx->entries[entry->parent].forced;
+        if (!forced && record && record->kind == KIND_FILE && record->has_digest &&
+            memcmp(record->digest, entry->digest, SHA256_DIGEST_SIZE) == 0 &&
+            record->mode == (entry->st.st_mode & 07777) &&
+            record->uid == entry->st.st_uid && record->gid == entry->st.st_gid) {
+            entry->include = false;
+            ctx->stats.unchanged++;
+        }
+    }
+
+    for (size_t i = 0; paths && i < files; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+    free(indexes);
+    free(digests);
+    return result;
+}
+
+// ورودی‌های commit قبلی که دیگر در upper نیستند؛ فایل‌های ساخته‌شده در upper بدون whiteout حذف می‌شوند
+static int collect_deletions(commit_context_t *ctx) {
+    for (size_t i = 0; i < ctx->cache.count; i++) {
+        cache_record_t *record = &ctx->cache.records[i];
+        if (record->entry >= 0 || record->kind == KIND_WHITEOUT || strcmp(record->path, ".") == 0) {
+            continue;
+        }
+
+        // whiteout فقط برای بالاترین ورودی حذف‌شده؛ والد حذف‌شده کل زیردرخت را پوشش می‌دهد
+        const char *slash = strrchr(record->path, '/');
+        char parent_path[PATH_MAX];
+        snprintf(parent_path, sizeof(parent_path), "%.*s",
+                 slash ? (int)(slash - record->path) : 1, slash ? record->path : ".");
+        cache_record_t *parent = cache_find(&ctx->cache, parent_path);
+        if (!parent || parent->entry < 0) {
+            continue;
+        }
+        const commit_entry_t *parent_entry = &ctx->entries[parent->entry];
+        if (!kind_is_dir(parent_entry->kind) || parent_entry->forced) {
+            continue;
+        }
+
+        if (ctx->deletion_count == ctx->deletion_capacity) {
+            size_t capacity = ctx->deletion_capacity ? ctx->deletion_capacity * 2 : 64;
+            deletion_t *deletions = realloc(ctx->deletions, capacity * sizeof(deletion_t));
+            if (!deletions) {
+                return -1;
+            }
+            ctx->deletions = deletions;
+            ctx->deletion_capacity = capacity;
+        }
+        ctx->deletions[ctx->deletion_count].parent = parent->entry;
+        ctx->deletions[ctx->deletion_count].name = slash ? slash + 1 : record->path;
+        ctx->deletion_count++;
+    }
+    return 0;
+}
+
+static int compare_deletions(const void *a, const void *b) {
+    const deletion_t *x = a, *y = b;
+    if (x->parent != y->parent) {
+        return x->parent < y->parent ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+// ---------- نوشتن tar ----------
+
+static int writer_flush(tar_writer_t *writer) {
+    size_t offset = 0;
+    while (offset < writer->used) {
+        ssize_t n = write(writer->fd, writer->buffer + offset, writer->used - offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log_error("خطا در نوشتن آرشیو لایه");
+            return -1;
+        }
+        offset += n;
+    }
+    sha256_update(&writer->sha, writer->buffer, writer->used);
+    writer->written += writer->used;
+    writer->used = 0;
+    return 0;
+}
+
+static int writer_write(tar_writer_t *writer, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    while (size > 0) {
+        if (writer->used == COMMIT_BUFFER_SIZE && writer_flush(writer) != 0) {
+            return -1;
+        }
+        size_t chunk = COMMIT_BUFFER_SIZE - writer->used;
+        if (chunk > size) chunk = size;
+        memcpy(writer->buffer + writer->used, bytes, chunk);
+        writer->used += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+// صفر کردن تا مرز بلوک
+static int writer_pad(tar_writer_t *writer, uint64_t size) {
+    static const uint8_t zeros[TAR_BLOCK_SIZE];
+    size_t padding = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+    return writer_write(writer, zeros, padding);
+}
+
+// عدد octal با NUL پایانی؛ false اگر در فیلد جا نشود
+static bool tar_octal(char *field, size_t width, uint64_t value) {
+    if (value >> (3 * (width - 1))) {
+        return false;
+    }
+    snprintf(field, width, "%0*" PRIo64, (int)(width - 1), value);
+    return true;
+}
+
+// تقسیم مسیر بین prefix و name در ustar
+static bool tar_split_name(tar_header_t *header, const char *name) {
+    size_t length = strlen(name);
+    if (length <= sizeof(header->name)) {
+        memcpy(header->name, name, length);
+        return true;
+    }
+    for (const char *slash = strchr(name, '/'); slash; slash = strchr(slash + 1, '/')) {
+        size_t prefix = slash - name;
+        size_t rest = length - prefix - 1;
+        if (prefix > sizeof(header->prefix)) {
+            break;
+        }
+        if (rest > 0 && rest <= sizeof(header->name)) {
+            memcpy(header->prefix, name, prefix);
+            memcpy(header->name, slash + 1, rest);
+            return true;
+        }
+    }
+    return false;
+}
+
+// افزودن رکورد PAX ("<طول> <کلید>=<مقدار>\n")؛ طول شامل خود عدد است
+static int pax_append(char **records, size_t *size, const char *key, const char *value) {
+    size_t body = strlen(key) + strlen(value) + 3;  // فاصله، '=' و '\n'
+    size_t length = body + 1;
+    while (snprintf(NULL, 0, "%zu", length) + body != length) {
+        length++;
+    }
+    char *grown = realloc(*records, *size + length + 1);
+    if (!grown) {
+        return -1;
+    }
+    *records = grown;
+    snprintf(*records + *size, length + 1, "%zu %s=%s\n", length, key, value);
+    *size += length;
+    return 0;
+}
+
+static int write_raw_header(tar_writer_t *writer, tar_header_t *header) {
+    memcpy(header->magic, "ustar", 6);
+    memcpy(header->version, "00", 2);
+    memset(header->checksum, ' ', sizeof(header->checksum));
+    unsigned sum = 0;
+    for (size_t i = 0; i < sizeof(*header); i++) {
+        sum += ((const uint8_t *)header)[i];
+    }
+    snprintf(header->checksum, sizeof(header->checksum), "%06o", sum);
+    header->checksum[7] = ' ';
+    return writer_write(writer, header, sizeof(*header));
+}
+
+// نوشتن سرآیند ورودی؛ مقادیری که در ustar جا نمی‌شوند در سرآیند PAX پیش از آن می‌آیند
+static int tar_write_header(tar_writer_t *writer, const char *name, char type, const struct stat *st,
+                            uint64_t size, const char *linkname) {
+    tar_header_t header;
+    memset(&header, 0, sizeof(header));
+    char *pax = NULL;
+    size_t pax_size = 0;
+    int result = 0;
+    char number[32];
+
+    if (!tar_split_name(&header, name)) {
+        snprintf(header.name, sizeof(header.name), "%.99s", name);
+        result |= pax_append(&pax, &pax_size, "path", name);
+    }
+    if (linkname) {
+        if (strlen(linkname) <= sizeof(header.linkname)) {
+            memcpy(header.linkname, linkname, strlen(linkname));
+        } else {
+            result |= pax_append(&pax, &pax_size, "linkpath", linkname);
+        }
+    }
+    tar_octal(header.mode, sizeof(header.mode), st->st_mode & 07777);
+    if (!tar_octal(header.uid, sizeof(header.uid), st->st_uid)) {
+        snprintf(number, sizeof(number), "%u", st->st_uid);
+        result |= pax_append(&pax, &pax_size, "uid", number);
+    }
+    if (!tar_octal(header.gid, sizeof(header.gid), st->st_gid)) {
+        snprintf(number, sizeof(number), "%u", st->st_gid);
+        result |= pax_append(&pax, &pax_size, "gid", number);
+    }
+    if (!tar_octal(header.size, sizeof(header.size), size)) {
+        snprintf(number, sizeof(number), "%" PRIu64, size);
+        result |= pax_append(&pax, &pax_size, "size", number);
+    }
+    tar_octal(header.mtime, sizeof(header.mtime), st->st_mtim.tv_sec > 0 ? (uint64_t)st->st_mtim.tv_sec : 0);
+    header.typeflag = type;
+    if (type == '3' || type == '4') {
+        tar_octal(header.devmajor, sizeof(header.devmajor), major(st->st_rdev));
+        tar_octal(header.devminor, sizeof(header.devminor), minor(st->st_rdev));
+    }
+
+    if (result == 0 && pax) {
+        tar_header_t pax_header;
+        memset(&pax_header, 0, sizeof(pax_header));
+        memcpy(pax_header.name, "././@PaxHeader", strlen("././@PaxHeader"));
+        tar_octal(pax_header.mode, sizeof(pax_header.mode), 0644);
+        tar_octal(pax_header.uid, sizeof(pax_header.uid), 0);
+        tar_octal(pax_header.gid, sizeof(pax_header.gid), 0);
+        tar_octal(pax_header.size, sizeof(pax_header.size), pax_size);
+        memcpy(pax_header.mtime, header.mtime, sizeof(header.mtime));
+        pax_header.typeflag = 'x';
+        result = write_raw_header(writer, &pax_header) != 0 ||
+                 writer_write(writer, pax, pax_size) != 0 ||
+                 writer_pad(writer, pax_size) != 0 ? -1 : 0;
+    }
+    free(pax);
+
+    return result == 0 ? write_raw_header(writer, &header) : -1;
+}
+
+// داده فایل مستقیم در بافر نویسنده خوانده می‌شود
+static int tar_write_data(tar_writer_t *writer, const char *path, uint64_t size) {
+    int fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        log_error("خطا در باز کردن فایل: %s", path);
+        return -1;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    uint64_t remaining = size;
+    int result = 0;
+    while (remaining > 0) {
+        if (writer->used == COMMIT_BUFFER_SIZE && writer_flush(writer) != 0) {
+            result = -1;
+            break;
+        }
+        size_t chunk = COMMIT_BUFFER_SIZE - writer->used;
+        if (chunk > remaining) chunk = remaining;
+        ssize_t n = read(fd, writer->buffer + writer->used, chunk);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // فایل در میانه commit کوتاه شده است
+            log_error("خطا در خواندن فایل: %s", path);
+            result = -1;
+            break;
+        }
+        writer->used += n;
+        remaining -= n;
+    }
+    close(fd);
+    return result == 0 ? writer_pad(writer, size) : -1;
+}
+
+// مسیر ".wh.<نام>" در دایرکتوری parent
+static void whiteout_name(const char *parent, const char *name, char *buffer, size_t size) {
+    if (strcmp(parent, ".") == 0) {
+        snprintf(buffer, size, "%s%s", WHITEOUT_PREFIX, name);
+    } else {
+        snprintf(buffer, size, "%s/%s%s", parent, WHITEOUT_PREFIX, name);
+    }
+}
+
+// whiteout به صورت فایل خالی بدون مجوز، با زمان دایرکتوری والد
+static int write_whiteout(commit_context_t *ctx, const char *parent, const char *name, const struct stat *parent_st) {
+    char path[PATH_MAX + 16];
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    st.st_mtim = parent_st->st_mtim;
+    whiteout_name(parent, name, path, sizeof(path));
+    ctx->stats.whiteouts++;
+    return tar_write_header(&ctx->writer, path, '0', &st, 0, NULL);
+}
+
+static const char* link_find_or_add(commit_context_t *ctx, const commit_entry_t *entry) {
+    size_t mask = ctx->link_capacity - 1;
+    size_t slot = (size_t)(entry->st.st_ino * 0x9e3779b97f4a7c15ULL) & mask;
+    while (ctx->links[slot].path) {
+        if (ctx->links[slot].ino == entry->st.st_ino && ctx->links[slot].dev == entry->st.st_dev) {
+            return ctx->links[slot].path;
+        }
+        slot = (slot + 1) & mask;
+    }
+    ctx->links[slot].dev = entry->st.st_dev;
+    ctx->links[slot].ino = entry->st.st_ino;
+    ctx->links[slot].path = entry->path;
+    return NULL;
+}
+
+// نوشتن ورودی و دایرکتوری‌های والد آن؛ والدها با مشخصات واقعی نوشته می‌شوند
+// چون مشخصات دایرکتوری ادغام‌شده از بالاترین لایه گرفته می‌شود
+static int emit_entry(commit_context_t *ctx, long index) {
+    commit_entry_t *entry = &ctx->entries[index];
+    if (entry->emitted) {
+        return 0;
+    }
+    if (entry->parent >= 0 && emit_entry(ctx, entry->parent) != 0) {
+        return -1;
+    }
+    entry->emitted = true;
+
+    char path[PATH_MAX];
+    char name[PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/%s", ctx->root, entry->path);
+    tar_writer_t *writer = &ctx->writer;
+
+    switch (entry->kind) {
+        case KIND_DIR:
+        case KIND_OPAQUE: {
+            bool root = strcmp(entry->path, ".") == 0;
+            snprintf(name, sizeof(name), "%s/", entry->path);
+            if (tar_write_header(writer, name, '5', &entry->st, 0, NULL) != 0) {
+                return -1;
+            }
+            if (!root) {
+                ctx->stats.directories++;
+            }
+            if (entry->new_opaque) {
+                struct stat st;
+                memset(&st, 0, sizeof(st));
+                st.st_mtim = entry->st.st_mtim;
+                snprintf(name, sizeof(name), "%s%s", root ? "" : entry->path, root ? WHITEOUT_OPAQUE : "/" WHITEOUT_OPAQUE);
+                ctx->stats.opaque++;
+                return tar_write_header(writer, name, '0', &st, 0, NULL);
+            }
+            return 0;
+        }
+
+        case KIND_WHITEOUT: {
+            const char *slash = strrchr(entry->path, '/');
+            char parent[PATH_MAX];
+            snprintf(parent, sizeof(parent), "%.*s", slash ? (int)(slash - entry->path) : 1, slash ? entry->path : ".");
+            return write_whiteout(ctx, parent, slash ? slash + 1 : entry->path, &entry->st);
+        }
+
+        case KIND_SYMLINK: {
+            char target[PATH_MAX];
+            ssize_t length = readlink(path, target, sizeof(target) - 1);
+            if (length < 0) {
+                log_error("خطا در خواندن پیوند %s", path);
+                return -1;
+            }
+            target[length] = '\0';
+            ctx->stats.symlinks++;
+            return tar_write_header(writer, entry->path, '2', &entry->st, 0, target);
+        }
+
+        case KIND_SPECIAL: {
+            char type = S_ISCHR(entry->st.st_mode) ? '3' : S_ISBLK(entry->st.st_mode) ? '4' : '6';
+            ctx->stats.specials++;
+            return tar_write_header(writer, entry->path, type, &entry->st, 0, NULL);
+        }
+
+        default: {
+            const char *first = entry->st.st_nlink > 1 ? link_find_or_add(ctx, entry) : NULL;
+            if (first) {
+                ctx->stats.hardlinks++;
+                return tar_write_header(writer, entry->path, '1', &entry->st, 0, first);
+            }
+            ctx->stats.files++;
+            if (tar_write_header(writer, entry->path, '0', &entry->st, entry->st.st_size, NULL) != 0) {
+                return -1;
+            }
+            return tar_write_data(writer, path, entry->st.st_size);
+        }
+    }
+}
+
+// نوشتن لایه به ترتیب پیمایش؛ حذف‌های هر دایرکتوری درست پس از سرآیند آن می‌آیند
+static int write_layer(commit_context_t *ctx) {
+    size_t links = 0;
+    for (size_t i = 0; i < ctx->count; i++) {
+        links += ctx->entries[i].include && ctx->entries[i].kind == KIND_FILE && ctx->entries[i].st.st_nlink > 1;
+    }
+    ctx->link_capacity = 16;
+    while (ctx->link_capacity < links * 2) {
+        ctx->link_capacity *= 2;
+    }
+    ctx->links = calloc(ctx->link_capacity, sizeof(link_entry_t));
+    ctx->writer.buffer = malloc(COMMIT_BUFFER_SIZE);
+    if (!ctx->links || !ctx->writer.buffer) {
+        return -1;
+    }
+    sha256_init(&ctx->writer.sha);
+
+    size_t deletion = 0;
+    for (size_t i = 0; i < ctx->count; i++) {
+        if (ctx->entries[i].include && emit_entry(ctx, (long)i) != 0) {
+            return -1;
+        }
+        for (; deletion < ctx->deletion_count && ctx->deletions[deletion].parent == (long)i; deletion++) {
+            if (emit_entry(ctx, (long)i) != 0 ||
+                write_whiteout(ctx, ctx->entries[i].path, ctx->deletions[deletion].name, &ctx->entries[i].st) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    // دو بلوک صفر پایان آرشیو
+    static const uint8_t zeros[2 * TAR_BLOCK_SIZE];
+    return writer_write(&ctx->writer, zeros, sizeof(zeros)) == 0 && writer_flush(&ctx->writer) == 0 ? 0 : -1;
+}
+
+static void context_free(commit_context_t *ctx) {
+    for (size_t i = 0; i < ctx->count; i++) {
+        free(ctx->entries[i].path);
+    }
+    free(ctx->entries);
+    free(ctx->deletions);
+    free(ctx->links);
+    free(ctx->writer.buffer);
+    cache_free(&ctx->cache);
+}
+
+// ---------- رابط عمومی ----------
+
+int commit_layer(const char *upperdir, const char *cache_path, const char *archive_dir, int threads,
+                 char *digest, size_t digest_size, commit_stats_t *stats) {
+    uint64_t start = monotonic_time_ns();
+    commit_context_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.root = upperdir;
+    ctx.writer.fd = -1;
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s", upperdir);
+    int result = cache_load(&ctx.cache, cache_path);
+    if (result == 0 && add_entry(&ctx, path, ".", -1) != 0) {
+        result = -1;
+    }
+    if (result == 0 && !kind_is_dir(ctx.entries[0].kind)) {
+        log_error("upperdir یک دایرکتوری نیست: %s", upperdir);
+        result = -1;
+    }
+    if (result == 0) {
+        result = walk_upper(&ctx, path, strlen(path), 0);
+    }
+    if (result == 0) {
+        classify_entries(&ctx);
+        result = hash_changed_files(&ctx, threads);
+    }
+    if (result == 0) {
+        result = collect_deletions(&ctx);
+        qsort(ctx.deletions, ctx.deletion_count, sizeof(deletion_t), compare_deletions);
+    }
+
+    // ریشه همیشه نوشته می‌شود و تغییر حساب نمی‌شود
+    size_t changes = ctx.deletion_count;
+    for (size_t i = 1; result == 0 && i < ctx.count; i++) {
+        changes += ctx.entries[i].include;
+    }
+    if (result == 0 && changes == 0) {
+        // cache برای مشخصات تازه فایل‌های بازنویسی‌شده با همان محتوا به‌روز می‌شود
+        result = cache_save(&ctx, cache_path) == 0 ? 1 : -1;
+    } else if (result == 0 && ctx.cache.layer_count == MAX_IMAGE_LAYERS) {
+        log_error("زنجیره commit ها بیش از %d لایه است", MAX_IMAGE_LAYERS);
+        result = -1;
+    }
+
+    char tmp_path[PATH_MAX] = "";
+    if (result == 0) {
+        snprintf(tmp_path, sizeof(tmp_path), "%s/.commit.XXXXXX", archive_dir);
+        ctx.writer.fd = mkostemp(tmp_path, O_CLOEXEC);
+        if (ctx.writer.fd == -1) {
+            log_error("خطا در ایجاد آرشیو لایه در %s", archive_dir);
+            tmp_path[0] = '\0';
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        fchmod(ctx.writer.fd, 0644);
+        result = write_layer(&ctx);
+    }
+    if (result == 0 && fsync(ctx.writer.fd) != 0) {
+        result = -1;
+    }
+
+    if (result == 0) {
+        uint8_t hash[SHA256_DIGEST_SIZE];
+        sha256_final(&ctx.writer.sha, hash);
+        digest_format(hash, digest, digest_size);
+
+        cache_layer_t *layer = &ctx.cache.layers[ctx.cache.layer_count];
+        snprintf(layer->digest, sizeof(layer->digest), "%s", digest);
+        snprintf(layer->archive, sizeof(layer->archive), "%s/%s.tar", archive_dir, digest + strlen("sha256:"));
+        if (rename(tmp_path, layer->archive) != 0) {
+            log_error("خطا در انتقال آرشیو لایه به %s", layer->archive);
+            result = -1;
+        } else {
+            tmp_path[0] = '\0';
+            ctx.cache.layer_count++;
+            ctx.stats.bytes = ctx.writer.written;
+            result = cache_save(&ctx, cache_path);
+        }
+    }
+
+    if (ctx.writer.fd != -1) {
+        close(ctx.writer.fd);
+    }
+    if (tmp_path[0]) {
+        unlink(tmp_path);
+    }
+    if (result == 0) {
+        log_message("لایه %s در %.2f ثانیه ساخته شد: %lu فایل، %lu whiteout، %lu فایل بدون تغییر",
+                    digest, (monotonic_time_ns() - start) / 1e9, ctx.stats.files, ctx.stats.whiteouts,
+                    ctx.stats.unchanged);
+    }
+    if (stats) {
+        *stats = ctx.stats;
+    }
+    context_free(&ctx);
+    return result;
+}
+
+// افزودن خط manifest؛ منبع بیرون از image_dir با پیوند نمادین در آن قرار می‌گیرد
+static int manifest_add(FILE *manifest, const char *image_dir, const char *digest, const char *source, const char *suffix) {
+    size_t dir_length = strlen(image_dir);
+    if (strncmp(source, image_dir, dir_length) == 0 && source[dir_length] == '/') {
+        fprintf(manifest, "%s %s\n", digest, source + dir_length + 1);
+        return 0;
+    }
+
+    const char *colon = strchr(digest, ':');
+    char link_path[PATH_MAX];
+    snprintf(link_path, sizeof(link_path), "%s/%s%s", image_dir, colon ? colon + 1 : digest, suffix);
+    struct stat st;
+    if (lstat(link_path, &st) != 0 && symlink(source, link_path) != 0) {
+        log_error("خطا در ایجاد پیوند لایه %s", link_path);
+        return -1;
+    }
+    fprintf(manifest, "%s %s\n", digest, strrchr(link_path, '/') + 1);
+    return 0;
+}
+
+int commit_container(container_config_t *config, const char *image_dir, int threads, commit_stats_t *stats) {
+    if (config->snapshotter != SNAPSHOT_OVERLAY && config->snapshotter != SNAPSHOT_TMPFS) {
+        log_error("commit فقط برای snapshotter های overlay و tmpfs پشتیبانی می‌شود");
+        return -1;
+    }
+    if (config->image_path[0] == '\0') {
+        log_error("commit فقط برای کانتینرهای ساخته‌شده از تصویر پشتیبانی می‌شود");
+        return -1;
+    }
+
+    char upperdir[PATH_MAX], cache_path[PATH_MAX], dir[PATH_MAX], path[PATH_MAX];
+    snprintf(upperdir, sizeof(upperdir), "%s/upper", config->overlay_workdir);
+    snprintf(cache_path, sizeof(cache_path), "%s/%s", config->overlay_workdir, COMMIT_CACHE_NAME);
+    if (create_directory(image_dir, 0755) != 0 || !realpath(image_dir, dir)) {
+        log_error("خطا در ایجاد دایرکتوری تصویر %s", image_dir);
+        return -1;
+    }
+
+    // لایه‌های تصویر پایه با منبع مطلقشان
+    snprintf(path, sizeof(path), "%s/manifest", config->image_path);
+    FILE *base = fopen(path, "r");
+    if (!base) {
+        log_error("تصویر کانتینر یافت نشد: %s", config->image_path);
+        return -1;
+    }
+    char base_digests[MAX_IMAGE_LAYERS][80];
+    char (*base_sources)[PATH_MAX] = malloc(MAX_IMAGE_LAYERS * sizeof(*base_sources));
+    int base_count = 0;
+    char line[1024];
+    while (base_sources && base_count < MAX_IMAGE_LAYERS && fgets(line, sizeof(line), base)) {
+        char layer_dir[512];
+        if (line[0] == '#' || sscanf(line, "%79s %511s", base_digests[base_count], layer_dir) != 2) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", config->image_path, layer_dir);
+        if (!realpath(path, base_sources[base_count])) {
+            snprintf(base_sources[base_count], PATH_MAX, "%s", path);
+        }
+        base_count++;
+    }
+    fclose(base);
+    if (!base_sources) {
+        return -1;
+    }
+
+    // با نگاشت شناسه، مالک فایل‌های upper روی دیسک شناسه میزبان است؛ پیمایش از نصب idmapped با نگاشت
+    // معکوس مالکیت‌ها را به شناسه‌های کانتینر برمی‌گرداند تا لایه تازه مانند لایه‌های تصویر قابل اشتراک بماند
+    char mapped[PATH_MAX];
+    const char *source = upperdir;
+    if (config->idmap.count > 0) {
+        snprintf(mapped, sizeof(mapped), "%s/%s/upper", config->overlay_workdir, SNAPSHOT_IDMAP_DIR);
+        int userns_fd = idmap_userns_fd(&config->idmap, true);
+        int result = userns_fd == -1 || create_directory(mapped, 0755) != 0
+                         ? -1 : mount_idmapped(upperdir, mapped, userns_fd, MOUNT_ATTR_RDONLY);
+        if (userns_fd != -1) {
+            close(userns_fd);
+        }
+        if (result != 0) {
+            free(base_sources);
+            return -1;
+        }
+        source = mapped;
+    }
+
+    // کانتینر در حال اجرا منجمد می‌شود تا upperdir در میانه پیمایش تغییر نکند
+    bool frozen = config->running && cgroup_freeze(config, true) == 0;
+    char digest[DIGEST_STRING_MAX];
+    int committed = commit_layer(source, cache_path, dir, threads, digest, sizeof(digest), stats);
+    if (frozen) {
+        cgroup_freeze(config, false);
+    }
+    if (source == mapped) {
+        umount2(mapped, MNT_DETACH);
+        rmdir(mapped);
+    }
+
+    commit_cache_t cache;
+    if (committed < 0 || cache_load(&cache, cache_path) != 0) {
+        free(base_sources);
+        return -1;
+    }
+    if (base_count + cache.layer_count > MAX_IMAGE_LAYERS) {
+        log_error("تعداد لایه‌های تصویر بیش از %d است", MAX_IMAGE_LAYERS);
+        cache_free(&cache);
+        free(base_sources);
+        return -1;
+    }
+
+    // manifest تازه به صورت اتمیک جایگزین می‌شود
+    char tmp_path[PATH_MAX + 16], manifest_path[PATH_MAX + 16];
+    snprintf(tmp_path, sizeof(tmp_path), "%s/manifest.tmp", dir);
+    snprintf(manifest_path, sizeof(manifest_path), "%s/manifest", dir);
+    FILE *manifest = fopen(tmp_path, "w");
+    int result = manifest ? 0 : -1;
+    for (int i = 0; result == 0 && i < base_count; i++) {
+        result = manifest_add(manifest, dir, base_digests[i], base_sources[i], "");
+    }
+    for (int i = 0; result == 0 && i < cache.layer_count; i++) {
+        result = manifest_add(manifest, dir, cache.layers[i].digest, cache.layers[i].archive, ".tar");
+    }
+    if (manifest && fclose(manifest) != 0) {
+        result = -1;
+    }
+    if (result != 0 || rename(tmp_path, manifest_path) != 0) {
+        log_error("خطا در نوشتن manifest تصویر %s", dir);
+        unlink(tmp_path);
+        result = -1;
+    }
+
+    if (result == 0) {
+        log_message("تصویر %s با %d لایه ساخته شد%s", dir, base_count + cache.layer_count,
+                    committed == 1 ? " (بدون تغییر از commit قبلی)" : "");
+    }
+    cache_free(&cache);
+    free(base_sources);
+    return result;
+}
@@ -12,12 +12,29 @@
 #include <fcntl.h>
 #include <time.h>
 #include <signal.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
 #include <sched.h>
 #include "../include/container.h"
 #include "../include/namespace.h"
 #include "../include/cgroup.h"
 #include "../include/filesystem.h"
 #include "../include/monitor.h"
+#include "../include/layerstore.h"
+#include "../include/reaper.h"
+#include "../include/mounttree.h"
+#include "../include/prewarm.h"
+#include "../include/snapshot.h"
+#include "../include/commit.h"
+#include "../include/network.h"
+#include "../include/netpool.h"
+#include "../include/sockmap.h"
+#include "../include/netacct.h"
+#include "../include/portfwd.h"
+#include "../include/idmap.h"
+#include "../include/seccomp.h"
+#include "../include/syslearn.h"
 #include "../include/utils.h"
 
 // ایجاد مدیریت‌کننده کانتینر
@@ -44,6 +61,19 @@ container_manager_t* container_manager_create(int max_containers) {
     create_directory("/var/lib/simplecontainer/overlays", 0755);
     create_directory("/var/lib/simplecontainer/logs", 0755);
 
+    // انبار لایه و GC پس‌زمینه آن
+    if (layer_store_init() == 0) {
+        layer_store_gc_start(LAYER_GC_INTERVAL_SECONDS);
+    }
+
+    // حذف پس‌زمینه دایرکتوری‌های کانتینرهای پاک‌شده
+    if (reaper_init() == 0) {
+        reaper_start(0, REAPER_DEFAULT_RATE);
+    }
+
+    // قالب /dev که برای هر کانتینر clone می‌شود
+    mount_template_init();
+
     return manager;
 }
 
@@ -58,12 +88,33 @@ void container_manager_destroy(container_manager_t *manager) {
         }
     }
 
+    layer_store_gc_stop();
+    reaper_stop();
+    netpool_stop();
+    sockmap_cleanup();
+    netacct_cleanup();
+    portfwd_stop();
+
     free(manager->containers);
     free(manager);
 }
 
 // ایجاد کانتینر جدید
 int container_create(container_manager_t *manager, const char *name, const char *binary_path, char **args, int argc) {
+    return container_create_with_image(manager, name, NULL, binary_path, args, argc);
+}
+
+// ایجاد کانتینر جدید از روی تصویر لایه‌ای (image_path می‌تواند NULL باشد)
+int container_create_with_image(container_manager_t *manager, const char *name, const char *image_path,
+                                const char *binary_path, char **args, int argc) {
+    container_options_t options = { image_path, SNAPSHOT_OVERLAY, 0, 0, 0, NETWORK_NONE, false, 0, { { 0, 0 } }, 0,
+                                    { 0, 0, 0 }, NULL, NULL, false };
+    return container_create_with_options(manager, name, &options, binary_path, args, argc);
+}
+
+// ایجاد کانتینر جدید با تصویر و snapshotter مشخص
+int container_create_with_options(container_manager_t *manager, const char *name, const container_options_t *options,
+                                  const char *binary_path, char **args, int argc) {
     if (manager->container_count >= manager->max_containers) {
         log_error("تعداد کانتینرها به حداکثر رسیده است");
         return -1;
@@ -102,13 +153,48 @@ int container_create(container_manager_t *manager, const char *name, const char
     
     config->running = false;
     config->container_pid = -1;
+    config->pidfd = -1;
+    config->forkserver_fd = -1;
+    
+    config->snapshotter = options->snapshotter;
+    config->snapshot_size = options->snapshot_size;
+    config->record_trace_seconds = options->record_trace_seconds;
+    config->disk_limit_bytes = options->disk_limit_bytes;
+    config->network = options->network;
+    config->sockmap = options->sockmap;
+    config->net_rate_bytes = options->net_rate_bytes;
+    config->port_count = options->port_count;
+    config->idmap = options->idmap;
+    config->fork_server = options->fork_server;
+    memcpy(config->ports, options->ports, sizeof(config->ports));
+    for (int i = 0; i < MAX_PORT_MAPPINGS; i++) {
+        config->port_forwards[i] = -1;
+    }
+    config->address_lease = -1;
+    if (options->seccomp_profile) {
+        strncpy(config->seccomp_profile, options->seccomp_profile, sizeof(config->seccomp_profile) - 1);
+    }
+    if (options->seccomp_learn) {
+        strncpy(config->seccomp_learn, options->seccomp_learn, sizeof(config->seccomp_learn) - 1);
+    }
+    if (options->image_path) {
+        strncpy(config->image_path, options->image_path, sizeof(config->image_path) - 1);
+    }
     
     // تنظیم مسیر cgroup
     snprintf(config->cgroup_path, sizeof(config->cgroup_path), "/simplecontainer/%s", config->id);
     
+    // بارگذاری لایه‌های تصویر در انبار لایه
+    if (options->image_path && load_container_image(config, options->image_path) != 0) {
+        log_error("خطا در بارگذاری تصویر کانتینر");
+        free(config->args);
+        return -1;
+    }
+    
     // آماده‌سازی فایل‌سیستم کانتینر
     if (setup_container_rootfs(config) != 0) {
         log_error("خطا در آماده‌سازی فایل‌سیستم کانتینر");
+        release_container_image(config);
         free(config->args);
         return -1;
     }
@@ -119,9 +205,34 @@ int container_create(container_manager_t *manager, const char *name, const char
     return 0;
 }
 
+// آرگومان فرآیند کانتینر؛ در حالت bridge یا با نگاشت محدوده شناسه فرزند تا آماده‌سازی والد روی sync منتظر می‌ماند.
+// فیلتر seccomp در والد ترجمه می‌شود تا خطای پروفایل پیش از clone گزارش شود (filter_len صفر یعنی بدون فیلتر)
+typedef struct {
+    container_config_t *config;
+    int sync[2];
+    int forkserver_fd;          // سر کانتینر سوکت fork-server (-1 بیرون از این حالت)
+    int filter_len;
+    struct sock_filter filter[SECCOMP_MAX_INSNS];
+} container_process_args_t;
+
 // اجرای فرآیند کانتینر
 static int container_process(void *arg) {
-    container_config_t *config = (container_config_t *)arg;
+    container_process_args_t *process_args = (container_process_args_t *)arg;
+    container_config_t *config = process_args->config;
+    
+    if (process_args->sync[0] != -1) {
+        char ready;
+        close(process_args->sync[1]);
+        ssize_t n;
+        do {
+            n = read(process_args->sync[0], &ready, 1);
+        } while (n == -1 && errno == EINTR);
+        close(process_args->sync[0]);
+        if (n != 1) {
+            log_error("شبکه یا نگاشت شناسه کانتینر آماده نشد");
+            return EXIT_FAILURE;
+        }
+    }
     
     // تنظیم namespace‌ها
     if (setup_namespaces(config) != 0) {
@@ -129,6 +240,12 @@ static int container_process(void *arg) {
         return EXIT_FAILURE;
     }
     
+    // نصب فایل‌سیستم‌های ضروری؛ قالب /dev فقط پیش از chroot در دسترس است
+    if (mount_essential_filesystems(config) != 0) {
+        log_error("خطا در نصب فایل‌سیستم‌های ضروری");
+        return EXIT_FAILURE;
+    }
+    
     // تنظیم فایل‌سیستم ریشه
     if (do_chroot(config->rootfs) != 0) {
         log_error("خطا در تنظیم chroot");
@@ -141,9 +258,15 @@ static int container_process(void *arg) {
         return EXIT_FAILURE;
     }
     
-    // نصب فایل‌سیستم‌های ضروری
-    if (mount_essential_filesystems(config) != 0) {
-        log_error("خطا در نصب فایل‌سیستم‌های ضروری");
+    if (process_args->forkserver_fd != -1) {
+        char fd_text[16];
+        snprintf(fd_text, sizeof(fd_text), "%d", process_args->forkserver_fd);
+        setenv(FORKSERVER_ENV, fd_text, 1);
+    }
+    
+    // فیلتر seccomp آخرین گام است تا آماده‌سازی بالا به syscall های پروفایل محدود نشود؛ پروفایل باید execve
+    // را مجاز کند
+    if (process_args->filter_len > 0 && seccomp_install(process_args->filter, process_args->filter_len) != 0) {
         return EXIT_FAILURE;
     }
     
@@ -155,6 +278,36 @@ static int container_process(void *arg) {
     return EXIT_FAILURE;
 }
 
+// انتشار پورت‌های کانتینر روی میزبان؛ در حالت bridge مقصد نشانی eth0 کانتینر است و در غیر این صورت
+// سوکت مقصد در network namespace کانتینر به loopback آن وصل می‌شود. خطا فقط همان پورت را غیرفعال می‌کند
+static void publish_ports(container_config_t *config) {
+    if (config->port_count == 0) {
+        return;
+    }
+    int netns_fd = -1;
+    uint32_t target = config->ipv4_address;
+    if (config->network != NETWORK_BRIDGE) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/ns/net", config->container_pid);
+        netns_fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (netns_fd == -1) {
+            log_error("خطا در باز کردن network namespace کانتینر %s", config->id);
+            return;
+        }
+        target = htonl(INADDR_LOOPBACK);
+    }
+    for (int i = 0; i < config->port_count; i++) {
+        config->port_forwards[i] = portfwd_add(config->ports[i].host_port, netns_fd, target,
+                                               config->ports[i].container_port);
+        if (config->port_forwards[i] < 0) {
+            log_message("پورت %u برای کانتینر %s منتشر نشد", config->ports[i].host_port, config->id);
+        }
+    }
+    if (netns_fd != -1) {
+        close(netns_fd);
+    }
+}
+
 // شروع کانتینر
 int container_start(container_manager_t *manager, const char *container_id) {
     container_config_t *config = container_find_by_id(manager, container_id);
@@ -168,6 +321,17 @@ int container_start(container_manager_t *manager, const char *container_id) {
         return -1;
     }
     
+    // ترجمه پروفایل seccomp پیش از ساخت هر منبعی برای کانتینر
+    container_process_args_t process_args = { config, { -1, -1 }, -1, 0, { { 0, 0, 0, 0 } } };
+    if (config->seccomp_profile[0]) {
+        seccomp_profile_t profile;
+        if (seccomp_profile_load(config->seccomp_profile, &profile) != 0 ||
+            (process_args.filter_len = seccomp_compile(&profile, process_args.filter, SECCOMP_MAX_INSNS)) == -1) {
+            log_error("خطا در ترجمه پروفایل seccomp کانتینر %s", container_id);
+            return -1;
+        }
+    }
+    
     // تنظیم cgroup
     if (cgroup_setup(config) != 0) {
         log_error("خطا در تنظیم cgroup");
@@ -182,23 +346,117 @@ int container_start(container_manager_t *manager, const char *container_id) {
     }
     cgroup_set_io_weight(config, config->io_weight);
     
+    // شمارش ترافیک و سقف شبکه با cgroup_skb؛ بدون پشتیبانی هسته فقط آمار شبکه در دسترس نیست
+    if (netacct_attach_cgroup(config->cgroup_path, config->net_rate_bytes) != 0) {
+        log_message("شمارش ترافیک شبکه برای کانتینر %s فعال نشد", config->id);
+    }
+    
+    // برنامه sockops روی cgroup کانتینر؛ بدون پشتیبانی هسته کانتینر با TCP عادی اجرا می‌شود
+    if (config->sockmap && sockmap_attach_cgroup(config->cgroup_path) != 0) {
+        log_message("شتاب sockmap برای کانتینر %s فعال نشد", config->id);
+    }
+    
+    // ضبط syscall های cgroup کانتینر برای پروفایل seccomp؛ بدون پشتیبانی هسته کانتینر بدون ضبط اجرا می‌شود
+    if (config->seccomp_learn[0] &&
+        syslearn_start(config->id, config->cgroup_path, config->seccomp_learn) != 0) {
+        log_message("یادگیری پروفایل seccomp برای کانتینر %s فعال نشد", config->id);
+    }
+    
+    // از اینجا هر خطا به fail می‌رود تا برنامه‌های eBPF، ضبط‌ها و منابع شبکه برگردانده شوند
+    pid_t pid = -1;
+    int pidfd = -1;
+    int forkserver[2] = { -1, -1 };
+    
     // اندازه استک برای فرآیند فرزند
     const int stack_size = 8 * 1024 * 1024;  // 8 MB
     void *stack = malloc(stack_size);
     if (!stack) {
         log_error("خطا در تخصیص حافظه برای استک");
-        return -1;
+        goto fail;
+    }
+    
+    // پیش‌خوانی فایل‌های ثبت‌شده در trace تصویر همزمان با راه‌اندازی namespace ها،
+    // یا ضبط trace تازه؛ ضبط باید پیش از clone آغاز شود تا نخستین exec را ببیند
+    if (config->image_path[0]) {
+        char trace_path[1024];
+        snprintf(trace_path, sizeof(trace_path), "%s/%s", config->image_path, PREWARM_TRACE_NAME);
+        if (config->record_trace_seconds > 0) {
+            prewarm_record_start(config->id, config->rootfs, trace_path, config->record_trace_seconds);
+        } else {
+            prewarm_start(config->rootfs, trace_path);
+        }
     }
     
+    // network namespace آماده از استخر: clone بدون CLONE_NEWNET از thread ای که موقتاً وارد آن شده،
+    // فرزند را در همان namespace می‌سازد و ساخت و حذف netns از مسیر شروع بیرون می‌رود
+    // استخر فقط از run و start پر می‌شود؛ ورودی‌های اجرای قبلی زیر /run پذیرفته می‌شوند
+    int clone_flags = CLONE_NEWPID | CLONE_NEWNS | CLONE_NEWUTS | CLONE_NEWUSER | CLONE_NEWIPC;
+    int saved_netns = -1;
+    netpool_start(NETPOOL_DEFAULT_SIZE);
+    if (netpool_acquire(config) == 0 && netpool_enter(config, &saved_netns) != 0) {
+        netpool_release(config);
+    }
+    if (!config->netns_name[0]) {
+        clone_flags |= CLONE_NEWNET;
+        // فرآیندهای run جدا از هم نشانی می‌گیرند، پس تخصیص از اجاره‌های مشترک زیر /run است
+        if (config->network == NETWORK_BRIDGE && network_address_acquire(config) != 0) {
+            goto fail;
+        }
+    }
+    
+    // فرزند تا ساخت veth، نوشتن نگاشت شناسه و در حالت یادگیری ورود به cgroup توسط والد منتظر می‌ماند
+    bool attach_network = (clone_flags & CLONE_NEWNET) && config->network == NETWORK_BRIDGE;
+    if ((attach_network || config->idmap.count > 0 || config->seccomp_learn[0]) &&
+        pipe2(process_args.sync, O_CLOEXEC) != 0) {
+        log_error("خطا در ایجاد pipe همگام‌سازی کانتینر");
+        goto fail;
+    }
+    
+    // سوکت fork-server: سر فرزند از execv عبور می‌کند و شماره آن در FORKSERVER_ENV است
+    if (config->fork_server && socketpair(AF_UNIX, SOCK_SEQPACKET, 0, forkserver) != 0) {
+        log_error("خطا در ایجاد سوکت fork-server");
+        goto fail;
+    }
+    if (forkserver[0] != -1) {
+        fcntl(forkserver[0], F_SETFD, FD_CLOEXEC);
+    }
+    process_args.forkserver_fd = forkserver[1];
+    
     // ایجاد فرآیند کانتینر با clone
-    pid_t pid = clone(container_process, stack + stack_size,
-                      CLONE_NEWPID | CLONE_NEWNS | CLONE_NEWUTS | CLONE_NEWUSER | CLONE_NEWNET | CLONE_NEWIPC,
-                      config);
+    pid = clone(container_process, stack + stack_size, clone_flags | CLONE_PIDFD, &process_args, &pidfd);
+    if (saved_netns != -1) {
+        netpool_leave(saved_netns);
+    }
+    if (forkserver[1] != -1) {
+        close(forkserver[1]);
+        forkserver[1] = -1;
+    }
     
     if (pid == -1) {
         log_error("خطا در ایجاد فرآیند کانتینر");
-        free(stack);
-        return -1;
+        goto fail;
+    }
+    if (config->netns_name[0]) {
+        netpool_set_owner(config, pid);
+    }
+    network_address_set_owner(config, pid);
+    
+    // نگاشت محدوده شناسه فقط از namespace والد نوشته می‌شود و veth در netns فرزند ساخته می‌شود، سپس
+    // فرزند آزاد می‌شود؛ در صورت خطا بستن pipe فرزند را متوقف می‌کند. در حالت یادگیری فرزند پیش از execv
+    // در cgroup است تا نخستین execve شمارش را آغاز کند
+    if (process_args.sync[0] != -1) {
+        close(process_args.sync[0]);
+        process_args.sync[0] = -1;
+        int ready = (config->idmap.count == 0 || idmap_write(pid, &config->idmap, false) == 0) &&
+                    (!attach_network || network_attach_container(config, pid) == 0) &&
+                    (!config->seccomp_learn[0] || cgroup_add_process(config, pid) == 0) &&
+                    write(process_args.sync[1], "1", 1) == 1;
+        close(process_args.sync[1]);
+        process_args.sync[1] = -1;
+        if (!ready) {
+            log_error("خطا در آماده‌سازی شبکه یا نگاشت شناسه کانتینر %s", container_id);
+            goto fail;
+        }
     }
     
     // اضافه کردن PID به cgroup
@@ -209,9 +467,7 @@ int container_start(container_manager_t *manager, const char *container_id) {
     int fd = open(cgroup_procs_path, O_WRONLY);
     if (fd == -1) {
         log_error("خطا در باز کردن فایل cgroup.procs");
-        kill(pid, SIGKILL);
-        free(stack);
-        return -1;
+        goto fail;
     }
     
     write(fd, pid_str, strlen(pid_str));
@@ -219,8 +475,13 @@ int container_start(container_manager_t *manager, const char *container_id) {
     
     // به‌روزرسانی وضعیت کانتینر
     config->container_pid = pid;
+    config->pidfd = pidfd;
+    config->forkserver_fd = forkserver[0];
+    config->forkserver_ready = false;
     config->running = true;
     
+    publish_ports(config);
+    
     // شروع مانیتورینگ
     monitor_container(config);
     
@@ -228,6 +489,34 @@ int container_start(container_manager_t *manager, const char *container_id) {
     log_message("کانتینر %s با PID %d شروع شد", container_id, pid);
     
     return 0;
+
+fail:
+    // فرزند با بسته شدن pipe همگام‌سازی یا SIGKILL متوقف می‌شود؛ پروفایل seccomp شروع ناموفق نوشته نمی‌شود
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    if (pidfd != -1) {
+        close(pidfd);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (process_args.sync[i] != -1) {
+            close(process_args.sync[i]);
+        }
+        if (forkserver[i] != -1) {
+            close(forkserver[i]);
+        }
+    }
+    prewarm_record_finish(config->id);
+    syslearn_discard(config->id);
+    if (config->sockmap) {
+        sockmap_detach_cgroup(config->cgroup_path);
+    }
+    netacct_detach_cgroup(config->cgroup_path);
+    netpool_release(config);
+    network_address_release(config);
+    free(stack);
+    return -1;
 }
 
 // توقف کانتینر
@@ -266,13 +555,33 @@ int container_stop(container_manager_t *manager, const char *container_id) {
         waitpid(config->container_pid, &status, 0);
     }
     
-    // توقف مانیتورینگ
+    // توقف مانیتورینگ و ضبط trace
     monitor_stop_container(config);
-    
-    // پاک‌سازی cgroup
+    prewarm_record_finish(config->id);
+    syslearn_finish(config->id);
+    
+    // بستن پورت‌های منتشرشده، پاک‌سازی cgroup و بازگرداندن network namespace به استخر
+    for (int i = 0; i < config->port_count; i++) {
+        if (config->port_forwards[i] >= 0) {
+            portfwd_remove(config->port_forwards[i]);
+            config->port_forwards[i] = -1;
+        }
+    }
+    if (config->sockmap) {
+        sockmap_detach_cgroup(config->cgroup_path);
+    }
+    netacct_detach_cgroup(config->cgroup_path);
     cgroup_cleanup(config);
+    netpool_release(config);
+    network_address_release(config);
     
     // به‌روزرسانی وضعیت کانتینر
+    close(config->pidfd);
+    config->pidfd = -1;
+    if (config->forkserver_fd != -1) {
+        close(config->forkserver_fd);
+        config->forkserver_fd = -1;
+    }
     config->container_pid = -1;
     config->running = false;
     
@@ -281,6 +590,66 @@ int container_stop(container_manager_t *manager, const char *container_id) {
     return 0;
 }
 
+// اجرای فرمان در کانتینر در حال اجرا
+// ورود به همه namespace ها با یک setns روی pidfd و به cgroup با CLONE_INTO_CGROUP، بدون پیمایش /proc
+pid_t container_exec(container_manager_t *manager, const char *container_id, char *const argv[]) {
+    container_config_t *config = container_find_by_id(manager, container_id);
+    if (!config) {
+        log_error("کانتینر با شناسه %s پیدا نشد", container_id);
+        return -1;
+    }
+    
+    if (!config->running || config->pidfd == -1) {
+        log_error("کانتینر %s در حال اجرا نیست", container_id);
+        return -1;
+    }
+    
+    int cgroup_fd = open(config->cgroup_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (cgroup_fd == -1) {
+        log_error("خطا در باز کردن cgroup کانتینر %s", container_id);
+        return -1;
+    }
+    
+    pid_t pid = namespace_exec(config->pidfd, NAMESPACE_EXEC_TYPES, cgroup_fd, config->rootfs, argv);
+    close(cgroup_fd);
+    if (pid != -1) {
+        log_debug("فرمان %s در کانتینر %s با PID %d اجرا شد", argv[0], container_id, pid);
+    }
+    return pid;
+}
+
+// نمونه تازه از fork-server کانتینر در cgroup فرزند instance-<n>؛ نخستین درخواست منتظر آمادگی می‌ماند
+int container_fork_instance(container_manager_t *manager, const char *container_id, int unshare_flags,
+                            forkserver_instance_t *instance) {
+    container_config_t *config = container_find_by_id(manager, container_id);
+    if (!config) {
+        log_error("کانتینر با شناسه %s پیدا نشد", container_id);
+        return -1;
+    }
+    
+    if (!config->running || config->forkserver_fd == -1) {
+        log_error("کانتینر %s در حالت fork-server اجرا نمی‌شود", container_id);
+        return -1;
+    }
+    
+    if (!config->forkserver_ready) {
+        if (forkserver_wait_ready(config->forkserver_fd, FORKSERVER_READY_TIMEOUT_MS) != 0) {
+            return -1;
+        }
+        config->forkserver_ready = true;
+    }
+    
+    char cgroup_path[600];
+    snprintf(cgroup_path, sizeof(cgroup_path), "%s/instance-%u", config->cgroup_path, config->instance_count);
+    if (forkserver_fork(config->forkserver_fd, config->instance_count, cgroup_path, unshare_flags, instance) != 0) {
+        log_error("خطا در ساخت نمونه کانتینر %s", container_id);
+        return -1;
+    }
+    config->instance_count++;
+    log_debug("نمونه %u کانتینر %s با PID %d ساخته شد", instance->id, container_id, instance->pid);
+    return 0;
+}
+
 // بررسی وضعیت کانتینر
 int container_status(container_manager_t *manager, const char *container_id) {
     container_config_t *config = container_find_by_id(manager, container_id);
@@ -292,6 +661,23 @@ int container_status(container_manager_t *manager, const char *container_id) {
     printf("شناسه: %s\n", config->id);
     printf("نام: %s\n", config->name);
     printf("وضعیت: %s\n", config->running ? "در حال اجرا" : "متوقف");
+    printf("شبکه: %s", network_mode_name(config->network));
+    if (config->network == NETWORK_BRIDGE) {
+        char address[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &config->ipv4_address, address, sizeof(address));
+        printf(" (%s/%d)", address, NETWORK_PREFIX);
+    }
+    if (config->netns_name[0]) {
+        printf(" [netns آماده: %s]", config->netns_name);
+    }
+    if (config->sockmap) {
+        printf(" [sockmap: %d سوکت]", sockmap_socket_count());
+    }
+    printf("\n");
+    for (int i = 0; i < config->port_count; i++) {
+        printf("پورت: %u -> %u%s\n", config->ports[i].host_port, config->ports[i].container_port,
+               config->running && config->port_forwards[i] < 0 ? " (غیرفعال)" : "");
+    }
     
     if (config->running) {
         printf("PID: %d\n", config->container_pid);
@@ -304,6 +690,14 @@ int container_status(container_manager_t *manager, const char *container_id) {
             printf("خواندن I/O: %lu KB\n", io_read / 1024);
             printf("نوشتن I/O: %lu KB\n", io_write / 1024);
         }
+        
+        netacct_stats_t net;
+        if (monitor_get_network_usage(config, &net) == 0) {
+            printf("دریافت شبکه: %lu KB، %lu بسته (%lu دور ریخته)\n", net.rx_bytes / 1024, net.rx_packets,
+                   net.rx_dropped);
+            printf("ارسال شبکه: %lu KB، %lu بسته (%lu دور ریخته)\n", net.tx_bytes / 1024, net.tx_packets,
+                   net.tx_dropped);
+        }
     }
     
     printf("محدودیت حافظه: %lu MB\n", config->mem_limit_bytes / (1024 * 1024));
@@ -311,7 +705,55 @@ int container_status(container_manager_t *manager, const char *container_id) {
     printf("تخصیص CPU: %s\n", config->cpu_affinity >= 0 ? 
            (char[]){config->cpu_affinity + '0', '\0'} : "تمام هسته‌ها");
     printf("وزن I/O: %lu\n", config->io_weight);
+    if (config->net_rate_bytes > 0) {
+        printf("سقف شبکه: %lu KB/s\n", config->net_rate_bytes / 1024);
+    }
+    printf("snapshotter: %s\n", snapshotter_get(config->snapshotter)->name);
+    if (config->idmap.count > 0) {
+        printf("نگاشت شناسه: 0-%u -> uid %u، gid %u (idmapped mount)\n", config->idmap.count - 1,
+               config->idmap.uid_base, config->idmap.gid_base);
+    }
+    if (config->seccomp_profile[0]) {
+        printf("پروفایل seccomp: %s\n", config->seccomp_profile);
+    }
+    if (config->seccomp_learn[0]) {
+        printf("ضبط پروفایل seccomp در: %s\n", config->seccomp_learn);
+    }
+    if (config->fork_server) {
+        printf("fork-server: %s، %u نمونه ساخته شده\n", config->forkserver_ready ? "آماده" : "در حال مقداردهی",
+               config->instance_count);
+    }
+    
+    disk_usage_t disk;
+    if (monitor_get_disk_usage(config, &disk) == 0) {
+        printf("لایه قابل نوشتن: %lu KB، %lu inode (%s)\n", disk.bytes / 1024, disk.inodes,
+               disk.from_quota ? "project quota" : "پیمایش");
+    }
+    if (config->disk_limit_bytes > 0) {
+        printf("سقف دیسک: %lu MB\n", config->disk_limit_bytes / (1024 * 1024));
+    }
+    
+    return 0;
+}
+
+// ذخیره تغییرات کانتینر به صورت تصویر
+int container_commit(container_manager_t *manager, const char *container_id, const char *image_dir) {
+    container_config_t *config = container_find_by_id(manager, container_id);
+    if (!config) {
+        log_error("کانتینر با شناسه %s پیدا نشد", container_id);
+        return -1;
+    }
+    
+    commit_stats_t stats;
+    if (commit_container(config, image_dir, 0, &stats) != 0) {
+        return -1;
+    }
     
+    printf("تصویر: %s\n", image_dir);
+    printf("فایل‌ها: %lu (%lu بدون تغییر، %lu هش‌شده)\n", stats.files, stats.unchanged, stats.hashed);
+    printf("دایرکتوری‌ها: %lu، پیوندها: %lu، whiteout ها: %lu\n", stats.directories,
+           stats.symlinks + stats.hardlinks, stats.whiteouts);
+    printf("حجم لایه: %lu KB\n", stats.bytes / 1024);
     return 0;
 }
 
@@ -415,3 +857,21 @@ int container_set_io_weight(container_manager_t *manager, const char *container_
     
     return 0;
 }
+
+// تنظیم سقف ترافیک شبکه
+int container_set_network_rate(container_manager_t *manager, const char *container_id, uint64_t rate_bytes) {
+    container_config_t *config = container_find_by_id(manager, container_id);
+    if (!config) {
+        log_error("کانتینر با شناسه %s پیدا نشد", container_id);
+        return -1;
+    }
+    
+    config->net_rate_bytes = rate_bytes;
+    
+    // اگر کانتینر در حال اجراست، سقف را اعمال کن
+    if (config->running) {
+        return netacct_set_rate(config->cgroup_path, rate_bytes);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,468 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include "../include/copy.h"
+#include "../include/threadpool.h"
+#include "../include/utils.h"
+
+// حداکثر فایل‌ها و حجم یک کار؛ فایل‌های کوچک دسته‌ای کپی می‌شوند تا هزینه صف سرشکن شود
+#define COPY_BATCH_FILES 64
+#define COPY_BATCH_BYTES (4 * 1024 * 1024)
+
+// ظرفیت صف thread pool
+#define COPY_QUEUE_CAPACITY 64
+
+// دایرکتوری که مشخصاتش پس از کپی محتوا اعمال می‌شود (ایجاد فایل زمان تغییر آن را عوض می‌کند)
+typedef struct {
+    char *path;
+    struct stat st;
+} deferred_dir_t;
+
+// hardlink که پس از پایان کپی فایل‌ها ساخته می‌شود
+typedef struct {
+    char *path;
+    char *target;
+} deferred_link_t;
+
+// نخستین مسیر هر inode دارای چند پیوند
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    char *path;
+} inode_entry_t;
+
+typedef struct copy_job copy_job_t;
+
+// وضعیت کپی درخت
+typedef struct {
+    int source_fd;
+    int dest_fd;
+    int error;
+    bool overlay;               // ادغام لایه overlay روی محتوای موجود مقصد
+    copy_stats_t stats;
+
+    deferred_dir_t *dirs;
+    size_t dir_count;
+    size_t dir_capacity;
+
+    deferred_link_t *links;
+    size_t link_count;
+    size_t link_capacity;
+
+    inode_entry_t *inodes;      // جدول درهم‌سازی با آدرس‌دهی باز
+    size_t inode_count;
+    size_t inode_capacity;
+
+    copy_job_t *batch;
+} copy_context_t;
+
+// یک کار: دسته‌ای از فایل‌ها با مسیر نسبی
+struct copy_job {
+    copy_context_t *ctx;
+    int count;
+    uint64_t bytes;
+    char *paths[COPY_BATCH_FILES];
+};
+
+static void copy_fail(copy_context_t *ctx) {
+    __atomic_store_n(&ctx->error, 1, __ATOMIC_RELAXED);
+}
+
+static bool copy_failed(copy_context_t *ctx) {
+    return __atomic_load_n(&ctx->error, __ATOMIC_RELAXED) != 0;
+}
+
+// افزودن عنصر به آرایه پویا
+static void* array_append(void *array, size_t *count, size_t *capacity, size_t element_size) {
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 64;
+        void *grown = realloc(array, new_capacity * element_size);
+        if (!grown) {
+            return NULL;
+        }
+        array = grown;
+        *capacity = new_capacity;
+    }
+    (*count)++;
+    return array;
+}
+
+// ---------- hardlink ها ----------
+
+static size_t inode_slot(const inode_entry_t *table, size_t capacity, dev_t dev, ino_t ino) {
+    size_t slot = (size_t)((ino * 0x9E3779B97F4A7C15ULL) ^ dev) & (capacity - 1);
+    while (table[slot].path && (table[slot].ino != ino || table[slot].dev != dev)) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return slot;
+}
+
+// مسیر قبلی همین inode، یا NULL و ثبت path به عنوان نخستین مسیر
+static const char* inode_find_or_add(copy_context_t *ctx, const struct stat *st, const char *path) {
+    if (ctx->inode_capacity > 0) {
+        size_t slot = inode_slot(ctx->inodes, ctx->inode_capacity, st->st_dev, st->st_ino);
+        if (ctx->inodes[slot].path) {
+            return ctx->inodes[slot].path;
+        }
+    }
+
+    if ((ctx->inode_count + 1) * 2 > ctx->inode_capacity) {
+        size_t capacity = ctx->inode_capacity ? ctx->inode_capacity * 2 : 256;
+        inode_entry_t *table = calloc(capacity, sizeof(inode_entry_t));
+        if (!table) {
+            copy_fail(ctx);
+            return NULL;
+        }
+        for (size_t i = 0; i < ctx->inode_capacity; i++) {
+            if (ctx->inodes[i].path) {
+                table[inode_slot(table, capacity, ctx->inodes[i].dev, ctx->inodes[i].ino)] = ctx->inodes[i];
+            }
+        }
+        free(ctx->inodes);
+        ctx->inodes = table;
+        ctx->inode_capacity = capacity;
+    }
+
+    size_t slot = inode_slot(ctx->inodes, ctx->inode_capacity, st->st_dev, st->st_ino);
+    ctx->inodes[slot].dev = st->st_dev;
+    ctx->inodes[slot].ino = st->st_ino;
+    ctx->inodes[slot].path = strdup(path);
+    if (!ctx->inodes[slot].path) {
+        copy_fail(ctx);
+        return NULL;
+    }
+    ctx->inode_count++;
+    return NULL;
+}
+
+// ---------- کپی موازی فایل‌ها ----------
+
+static void copy_job_run(void *arg) {
+    copy_job_t *job = arg;
+    copy_context_t *ctx = job->ctx;
+
+    for (int i = 0; i < job->count; i++) {
+        if (!copy_failed(ctx)) {
+            int source_fd = openat(ctx->source_fd, job->paths[i], O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+            int dest_fd = source_fd == -1 ? -1 :
+                openat(ctx->dest_fd, job->paths[i], O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+            if (dest_fd == -1 || copy_file_fd(source_fd, dest_fd) != 0) {
+                log_error("خطا در کپی فایل %s", job->paths[i]);
+                copy_fail(ctx);
+            }
+            if (source_fd != -1) close(source_fd);
+            if (dest_fd != -1) close(dest_fd);
+        }
+        free(job->paths[i]);
+    }
+    free(job);
+}
+
+static void submit_job(threadpool_t *pool, copy_job_t *job) {
+    if (!pool || threadpool_submit(pool, copy_job_run, job) != 0) {
+        copy_job_run(job);
+    }
+}
+
+static void flush_batch(copy_context_t *ctx, threadpool_t *pool) {
+    if (ctx->batch) {
+        submit_job(pool, ctx->batch);
+        ctx->batch = NULL;
+    }
+}
+
+// افزودن فایل به دسته جاری؛ فایل‌های بزرگ کار جداگانه دارند تا بین thread ها پخش شوند
+static int queue_file(copy_context_t *ctx, threadpool_t *pool, const char *path, uint64_t size) {
+    char *copy = strdup(path);
+    if (!copy) {
+        return -1;
+    }
+
+    if (size >= COPY_BATCH_BYTES) {
+        copy_job_t *job = calloc(1, sizeof(copy_job_t));
+        if (!job) {
+            free(copy);
+            return -1;
+        }
+        job->ctx = ctx;
+        job->paths[job->count++] = copy;
+        submit_job(pool, job);
+        return 0;
+    }
+
+    if (!ctx->batch) {
+        ctx->batch = calloc(1, sizeof(copy_job_t));
+        if (!ctx->batch) {
+            free(copy);
+            return -1;
+        }
+        ctx->batch->ctx = ctx;
+    }
+    ctx->batch->paths[ctx->batch->count++] = copy;
+    ctx->batch->bytes += size;
+    if (ctx->batch->count == COPY_BATCH_FILES || ctx->batch->bytes >= COPY_BATCH_BYTES) {
+        flush_batch(ctx, pool);
+    }
+    return 0;
+}
+
+// ---------- پیمایش ----------
+
+// اعمال مالکیت، مجوزها و زمان‌ها روی مسیر نسبی در مقصد
+static void apply_metadata_at(copy_context_t *ctx, const char *path, const struct stat *st) {
+    if ((st->st_uid != geteuid() || st->st_gid != getegid()) &&
+        fchownat(ctx->dest_fd, path, st->st_uid, st->st_gid, AT_SYMLINK_NOFOLLOW) != 0) {
+        log_debug("خطا در تنظیم مالکیت %s", path);
+    }
+    if (!S_ISLNK(st->st_mode)) {
+        fchmodat(ctx->dest_fd, path, st->st_mode & 07777, 0);
+    }
+    struct timespec times[2] = { st->st_atim, st->st_mtim };
+    utimensat(ctx->dest_fd, path, times, AT_SYMLINK_NOFOLLOW);
+}
+
+// ایجاد یک ورودی غیر از فایل معمولی و دایرکتوری
+static int copy_special(copy_context_t *ctx, int dir_fd, const char *name, const char *path, const struct stat *st) {
+    if (S_ISLNK(st->st_mode)) {
+        char target[PATH_MAX];
+        ssize_t length = readlinkat(dir_fd, name, target, sizeof(target) - 1);
+        if (length < 0) {
+            return -1;
+        }
+        target[length] = '\0';
+        if (symlinkat(target, ctx->dest_fd, path) != 0) {
+            return -1;
+        }
+        ctx->stats.symlinks++;
+    } else {
+        if (mknodat(ctx->dest_fd, path, st->st_mode, st->st_rdev) != 0) {
+            return -1;
+        }
+        ctx->stats.specials++;
+    }
+    apply_metadata_at(ctx, path, st);
+    return 0;
+}
+
+// آماده‌سازی مقصد برای ورودی یک لایه overlay؛ true یعنی ورودی whiteout بود و کار تمام است
+// ورودی‌های غیر دایرکتوری موجود جایگزین و دایرکتوری‌های opaque خالی می‌شوند
+static bool overlay_replace(copy_context_t *ctx, int dir_fd, const char *name, const char *path,
+                            const struct stat *st) {
+    bool whiteout = S_ISCHR(st->st_mode) && st->st_rdev == 0;
+    struct stat existing;
+    bool exists = fstatat(ctx->dest_fd, path, &existing, AT_SYMLINK_NOFOLLOW) == 0;
+
+    if (exists && (whiteout || !S_ISDIR(st->st_mode) || !S_ISDIR(existing.st_mode))) {
+        remove_directory_at(ctx->dest_fd, path, NULL, NULL);
+    } else if (exists && S_ISDIR(st->st_mode)) {
+        char value[2];
+        int fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd != -1 && fgetxattr(fd, "trusted.overlay.opaque", value, sizeof(value)) == 1 && value[0] == 'y') {
+            remove_directory_at(ctx->dest_fd, path, NULL, NULL);
+        }
+        if (fd != -1) close(fd);
+    }
+
+    if (whiteout) {
+        ctx->stats.whiteouts++;
+    }
+    return whiteout;
+}
+
+// پیمایش بازگشتی؛ path مسیر نسبی دایرکتوری جاری است ("" برای ریشه)
+static int copy_walk(copy_context_t *ctx, threadpool_t *pool, char *path, size_t length) {
+    int fd = openat(ctx->source_fd, length ? path : ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR *dir = fd != -1 ? fdopendir(fd) : NULL;
+    if (!dir) {
+        log_error("خطا در باز کردن دایرکتوری: %s", length ? path : ".");
+        if (fd != -1) close(fd);
+        return -1;
+    }
+
+    int result = 0;
+    struct dirent *entry;
+    while (result == 0 && !copy_failed(ctx) && (entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        size_t name_length = strlen(entry->d_name);
+        size_t child_length = length ? length + 1 + name_length : name_length;
+        if (child_length + 1 > PATH_MAX) {
+            log_error("مسیر خیلی طولانی است: %s/%s", path, entry->d_name);
+            result = -1;
+            break;
+        }
+        if (length) {
+            path[length] = '/';
+        }
+        memcpy(path + child_length - name_length, entry->d_name, name_length + 1);
+
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            log_error("خطا در خواندن مشخصات %s", path);
+            result = -1;
+        } else if (ctx->overlay && overlay_replace(ctx, dirfd(dir), entry->d_name, path, &st)) {
+            // whiteout: ورودی لایه‌های پایین‌تر حذف شد و چیزی ساخته نمی‌شود
+        } else if (S_ISDIR(st.st_mode)) {
+            if (mkdirat(ctx->dest_fd, path, 0700) != 0 && errno != EEXIST) {
+                log_error("خطا در ایجاد دایرکتوری %s", path);
+                result = -1;
+            } else {
+                ctx->dirs = array_append(ctx->dirs, &ctx->dir_count, &ctx->dir_capacity, sizeof(deferred_dir_t));
+                if (!ctx->dirs || !(ctx->dirs[ctx->dir_count - 1].path = strdup(path))) {
+                    result = -1;
+                } else {
+                    ctx->dirs[ctx->dir_count - 1].st = st;
+                    ctx->stats.directories++;
+                    result = copy_walk(ctx, pool, path, child_length);
+                }
+            }
+        } else if (S_ISREG(st.st_mode)) {
+            // پیوندهای لایه‌های انبار حاصل اشتراک محتوای یکسان هستند، نه hardlink واقعی تصویر
+            const char *first = st.st_nlink > 1 && !ctx->overlay ? inode_find_or_add(ctx, &st, path) : NULL;
+            if (first) {
+                ctx->links = array_append(ctx->links, &ctx->link_count, &ctx->link_capacity, sizeof(deferred_link_t));
+                deferred_link_t *link = ctx->links ? &ctx->links[ctx->link_count - 1] : NULL;
+                if (!link || !(link->path = strdup(path)) || !(link->target = strdup(first))) {
+                    result = -1;
+                } else {
+                    ctx->stats.hardlinks++;
+                }
+            } else if (queue_file(ctx, pool, path, st.st_size) != 0) {
+                result = -1;
+            } else {
+                ctx->stats.files++;
+                ctx->stats.bytes += st.st_size;
+            }
+        } else if (copy_special(ctx, dirfd(dir), entry->d_name, path, &st) != 0) {
+            log_error("خطا در کپی %s", path);
+            result = -1;
+        }
+
+        path[length] = '\0';
+    }
+
+    closedir(dir);
+    return result;
+}
+
+// ساخت hardlink ها و اعمال مشخصات دایرکتوری‌ها پس از پایان کپی فایل‌ها
+static int copy_finish(copy_context_t *ctx) {
+    for (size_t i = 0; i < ctx->link_count; i++) {
+        if (linkat(ctx->dest_fd, ctx->links[i].target, ctx->dest_fd, ctx->links[i].path, 0) != 0) {
+            log_error("خطا در ایجاد hardlink %s", ctx->links[i].path);
+            return -1;
+        }
+    }
+
+    // از عمیق‌ترین دایرکتوری تا دایرکتوری‌های بالاتر، تا دایرکتوری فقط‌خواندنی مانع کار نشود
+    for (size_t i = ctx->dir_count; i > 0; i--) {
+        apply_metadata_at(ctx, ctx->dirs[i - 1].path, &ctx->dirs[i - 1].st);
+    }
+    return 0;
+}
+
+static void copy_context_free(copy_context_t *ctx) {
+    for (size_t i = 0; i < ctx->dir_count; i++) {
+        free(ctx->dirs[i].path);
+    }
+    for (size_t i = 0; i < ctx->link_count; i++) {
+        free(ctx->links[i].path);
+        free(ctx->links[i].target);
+    }
+    for (size_t i = 0; i < ctx->inode_capacity; i++) {
+        free(ctx->inodes[i].path);
+    }
+    free(ctx->dirs);
+    free(ctx->links);
+    free(ctx->inodes);
+    if (ctx->source_fd != -1) close(ctx->source_fd);
+    if (ctx->dest_fd != -1) close(ctx->dest_fd);
+    free(ctx);
+}
+
+static int copy_tree_internal(const char *source, const char *destination, int threads,
+                              bool overlay, copy_stats_t *stats) {
+    struct stat root_st;
+    if (stat(source, &root_st) != 0 || !S_ISDIR(root_st.st_mode)) {
+        log_error("دایرکتوری منبع یافت نشد: %s", source);
+        return -1;
+    }
+    if (create_directory(destination, 0700) != 0) {
+        log_error("خطا در ایجاد دایرکتوری مقصد: %s", destination);
+        return -1;
+    }
+
+    copy_context_t *ctx = calloc(1, sizeof(copy_context_t));
+    char *path = malloc(PATH_MAX);
+    if (!ctx || !path) {
+        free(ctx);
+        free(path);
+        return -1;
+    }
+    ctx->overlay = overlay;
+    ctx->source_fd = open(source, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    ctx->dest_fd = open(destination, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (ctx->source_fd == -1 || ctx->dest_fd == -1) {
+        log_error("خطا در باز کردن %s یا %s", source, destination);
+        free(path);
+        copy_context_free(ctx);
+        return -1;
+    }
+
+    uint64_t start = monotonic_time_ns();
+    threadpool_t *pool = threadpool_create(threads, COPY_QUEUE_CAPACITY);
+    path[0] = '\0';
+    int result = copy_walk(ctx, pool, path, 0);
+    flush_batch(ctx, pool);
+
+    // پیش از ساخت hardlink ها همه فایل‌ها باید کپی شده باشند
+    if (pool) {
+        threadpool_wait(pool);
+        threadpool_destroy(pool);
+    }
+    if (copy_failed(ctx)) {
+        result = -1;
+    }
+    if (result == 0) {
+        result = copy_finish(ctx);
+    }
+    if (result == 0) {
+        if ((root_st.st_uid != geteuid() || root_st.st_gid != getegid()) &&
+            fchown(ctx->dest_fd, root_st.st_uid, root_st.st_gid) != 0) {
+            log_debug("خطا در تنظیم مالکیت %s", destination);
+        }
+        fchmod(ctx->dest_fd, root_st.st_mode & 07777);
+        struct timespec times[2] = { root_st.st_atim, root_st.st_mtim };
+        futimens(ctx->dest_fd, times);
+    }
+
+    log_debug("کپی %s: %lu فایل، %.1f MB در %.2f ثانیه", source, ctx->stats.files,
+              ctx->stats.bytes / (1024.0 * 1024.0), (monotonic_time_ns() - start) / 1e9);
+
+    if (stats) {
+        *stats = ctx->stats;
+    }
+    free(path);
+    copy_context_free(ctx);
+    return result;
+}
+
+// کپی بازگشتی درخت
+int copy_tree(const char *source, const char *destination, int threads, copy_stats_t *stats) {
+    return copy_tree_internal(source, destination, threads, false, stats);
+}
+
+// ادغام یک لایه overlay روی destination
+int copy_tree_overlay(const char *layer, const char *destination, int threads, copy_stats_t *stats) {
+    return copy_tree_internal(layer, destination, threads, true, stats);
+}
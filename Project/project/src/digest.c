@@ -0,0 +1,647 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+#include <sys/stat.h>
+#include "../include/digest.h"
+#include "../include/threadpool.h"
+#include "../include/utils.h"
+
+// اندازه بلوک SHA-256
+#define SHA256_BLOCK_SIZE 64
+
+// اندازه بافر خواندن فایل
+#define DIGEST_READ_CHUNK (256 * 1024)
+
+// فایل‌های کوچک‌تر از این مقدار کامل خوانده و با هش چندبافری پردازش می‌شوند
+#define DIGEST_SMALL_FILE_MAX (256 * 1024)
+
+// تعداد فایل‌های هر کار در هش موازی
+#define DIGEST_FILES_PER_TASK 32
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t sha256_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+// پردازش بلوک‌های کامل یک جریان
+typedef void (*sha256_blocks_fn)(uint32_t state[8], const uint8_t *data, size_t blocks);
+
+// پیاده‌سازی انتخاب‌شده
+static struct {
+    pthread_once_t once;
+    sha256_blocks_fn blocks;
+    const char *name;
+    bool has_shani;
+    bool has_avx2;
+    bool multi_buffer;          // sha256_many از مسیر AVX2 هشت‌تایی استفاده کند
+} digest_dispatch = { PTHREAD_ONCE_INIT, NULL, NULL, false, false, false };
+
+// ---------- پیاده‌سازی اسکالر ----------
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void sha256_blocks_scalar(uint32_t state[8], const uint8_t *data, size_t blocks) {
+    uint32_t w[64];
+
+    while (blocks--) {
+        for (int t = 0; t < 16; t++) {
+            w[t] = load_be32(data + t * 4);
+        }
+        for (int t = 16; t < 64; t++) {
+            uint32_t s0 = ROTR(w[t - 15], 7) ^ ROTR(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = ROTR(w[t - 2], 17) ^ ROTR(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; t++) {
+            uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[t] + w[t];
+            uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        data += SHA256_BLOCK_SIZE;
+    }
+}
+
+// مسیرهای SHA-NI و AVX2 فقط روی x86-64 ساخته می‌شوند؛ معماری‌های دیگر از پیاده‌سازی اسکالر استفاده می‌کنند
+#if defined(__x86_64__)
+
+// ---------- پیاده‌سازی SHA-NI ----------
+
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_blocks_shani(uint32_t state[8], const uint8_t *data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // چیدمان state به صورت ABEF و CDGH که دستورات sha256rnds2 انتظار دارند
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks--) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+        __m128i w[4];
+
+        // هر دور حلقه چهار round است؛ زمان‌بندی پیام با msg1/msg2 چهار گروه جلوتر محاسبه می‌شود
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; g++) {
+            if (g < 4) {
+                w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + g * 16)), byte_swap);
+            }
+            __m128i msg = _mm_add_epi32(w[g & 3], _mm_loadu_si128((const __m128i *)&sha256_k[g * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if (g >= 3 && g < 15) {
+                __m128i next = _mm_add_epi32(w[(g + 1) & 3], _mm_alignr_epi8(w[g & 3], w[(g - 1) & 3], 4));
+                w[(g + 1) & 3] = _mm_sha256msg2_epu32(next, w[g & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if (g >= 1 && g < 13) {
+                w[(g - 1) & 3] = _mm_sha256msg1_epu32(w[(g - 1) & 3], w[g & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        data += SHA256_BLOCK_SIZE;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+// ---------- پیاده‌سازی چندبافری AVX2 (هشت جریان در هشت lane) ----------
+
+#define AVX2_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+__attribute__((target("avx2")))
+static void sha256_blocks_x8_avx2(uint32_t states[8][8], const uint8_t *data[8], size_t blocks) {
+    const __m256i byte_swap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    // ترانهاده: v[i] کلمه i از state هر هشت جریان است
+    __m256i v[8];
+    for (int i = 0; i < 8; i++) {
+        v[i] = _mm256_set_epi32(states[7][i], states[6][i], states[5][i], states[4][i],
+                                states[3][i], states[2][i], states[1][i], states[0][i]);
+    }
+
+    size_t offset = 0;
+
+    while (blocks--) {
+        __m256i w[16];
+        for (int t = 0; t < 16; t++) {
+            __m256i words = _mm256_set_epi32(
+                *(const int32_t *)(data[7] + offset + t * 4), *(const int32_t *)(data[6] + offset + t * 4),
+                *(const int32_t *)(data[5] + offset + t * 4), *(const int32_t *)(data[4] + offset + t * 4),
+                *(const int32_t *)(data[3] + offset + t * 4), *(const int32_t *)(data[2] + offset + t * 4),
+                *(const int32_t *)(data[1] + offset + t * 4), *(const int32_t *)(data[0] + offset + t * 4));
+            w[t] = _mm256_shuffle_epi8(words, byte_swap);
+        }
+
+        __m256i a = v[0], b = v[1], c = v[2], d = v[3];
+        __m256i e = v[4], f = v[5], g = v[6], h = v[7];
+
+        for (int t = 0; t < 64; t++) {
+            __m256i wt;
+            if (t < 16) {
+                wt = w[t];
+            } else {
+                __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w15, 7), AVX2_ROTR(w15, 18)),
+                                              _mm256_srli_epi32(w15, 3));
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w2, 17), AVX2_ROTR(w2, 19)),
+                                              _mm256_srli_epi32(w2, 10));
+                wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+                w[t & 15] = wt;
+            }
+
+            __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(e, 6), AVX2_ROTR(e, 11)), AVX2_ROTR(e, 25));
+            __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sigma1),
+                                          _mm256_add_epi32(_mm256_add_epi32(ch, _mm256_set1_epi32(sha256_k[t])), wt));
+            __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(a, 2), AVX2_ROTR(a, 13)), AVX2_ROTR(a, 22));
+            __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            __m256i t2 = _mm256_add_epi32(sigma0, maj);
+
+            h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+            d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+        }
+
+        v[0] = _mm256_add_epi32(v[0], a); v[1] = _mm256_add_epi32(v[1], b);
+        v[2] = _mm256_add_epi32(v[2], c); v[3] = _mm256_add_epi32(v[3], d);
+        v[4] = _mm256_add_epi32(v[4], e); v[5] = _mm256_add_epi32(v[5], f);
+        v[6] = _mm256_add_epi32(v[6], g); v[7] = _mm256_add_epi32(v[7], h);
+        offset += SHA256_BLOCK_SIZE;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, v[i]);
+        for (int lane = 0; lane < 8; lane++) {
+            states[lane][i] = lanes[lane];
+        }
+    }
+}
+
+#endif /* __x86_64__ */
+
+// ---------- انتخاب پیاده‌سازی ----------
+
+// تشخیص قابلیت‌های پردازنده با cpuid
+static void digest_detect() {
+#if defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    bool ssse3 = false, sse41 = false, osxsave = false, avx = false;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        ssse3 = ecx & (1u << 9);
+        sse41 = ecx & (1u << 19);
+        osxsave = ecx & (1u << 27);
+        avx = ecx & (1u << 28);
+    }
+
+    // AVX2 فقط وقتی قابل استفاده است که سیستم‌عامل ثبات‌های YMM را ذخیره کند
+    bool ymm_enabled = false;
+    if (osxsave && avx) {
+        uint32_t xcr0_low, xcr0_high;
+        __asm__ volatile ("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+        ymm_enabled = (xcr0_low & 0x6) == 0x6;
+    }
+
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        digest_dispatch.has_shani = (ebx & (1u << 29)) && ssse3 && sse41;
+        digest_dispatch.has_avx2 = (ebx & (1u << 5)) && ymm_enabled;
+    }
+
+    // SHA-NI برای هر جریان از هشت lane نرم‌افزاری سریع‌تر است
+    if (digest_dispatch.has_shani) {
+        digest_dispatch.blocks = sha256_blocks_shani;
+        digest_dispatch.name = "shani";
+    } else if (digest_dispatch.has_avx2) {
+        digest_dispatch.blocks = sha256_blocks_scalar;
+        digest_dispatch.multi_buffer = true;
+        digest_dispatch.name = "avx2";
+    } else {
+        digest_dispatch.blocks = sha256_blocks_scalar;
+        digest_dispatch.name = "scalar";
+    }
+#else
+    digest_dispatch.blocks = sha256_blocks_scalar;
+    digest_dispatch.name = "scalar";
+#endif
+}
+
+static inline void digest_init_dispatch() {
+    pthread_once(&digest_dispatch.once, digest_detect);
+}
+
+// پیاده‌سازی انتخاب‌شده در زمان اجرا
+const char* digest_implementation() {
+    digest_init_dispatch();
+    return digest_dispatch.name;
+}
+
+// انتخاب دستی پیاده‌سازی
+int digest_set_implementation(const char *name) {
+    digest_init_dispatch();
+
+#if defined(__x86_64__)
+    if (strcmp(name, "shani") == 0 && digest_dispatch.has_shani) {
+        digest_dispatch.blocks = sha256_blocks_shani;
+        digest_dispatch.multi_buffer = false;
+    } else if (strcmp(name, "avx2") == 0 && digest_dispatch.has_avx2) {
+        digest_dispatch.blocks = sha256_blocks_scalar;
+        digest_dispatch.multi_buffer = true;
+    } else
+#endif
+    if (strcmp(name, "scalar") == 0) {
+        digest_dispatch.blocks = sha256_blocks_scalar;
+        digest_dispatch.multi_buffer = false;
+    } else {
+        log_error("پیاده‌سازی %s برای SHA-256 روی این پردازنده در دسترس نیست", name);
+        return -1;
+    }
+
+    digest_dispatch.name = strcmp(name, "shani") == 0 ? "shani" : strcmp(name, "avx2") == 0 ? "avx2" : "scalar";
+    return 0;
+}
+
+// ---------- SHA-256 افزایشی ----------
+
+void sha256_init(sha256_ctx_t *ctx) {
+    digest_init_dispatch();
+    memcpy(ctx->state, sha256_iv, sizeof(ctx->state));
+    ctx->length = 0;
+    ctx->buffered = 0;
+}
+
+void sha256_update(sha256_ctx_t *ctx, const void *data, size_t size) {
+    const uint8_t *p = data;
+    ctx->length += size;
+
+    if (ctx->buffered > 0) {
+        size_t take = SHA256_BLOCK_SIZE - ctx->buffered;
+        if (take > size) take = size;
+        memcpy(ctx->buffer + ctx->buffered, p, take);
+        ctx->buffered += take;
+        p += take;
+        size -= take;
+        if (ctx->buffered < SHA256_BLOCK_SIZE) {
+            return;
+        }
+        digest_dispatch.blocks(ctx->state, ctx->buffer, 1);
+        ctx->buffered = 0;
+    }
+
+    // بلوک‌های کامل مستقیماً از بافر ورودی پردازش می‌شوند
+    size_t blocks = size / SHA256_BLOCK_SIZE;
+    if (blocks > 0) {
+        digest_dispatch.blocks(ctx->state, p, blocks);
+        p += blocks * SHA256_BLOCK_SIZE;
+        size -= blocks * SHA256_BLOCK_SIZE;
+    }
+
+    if (size > 0) {
+        memcpy(ctx->buffer, p, size);
+        ctx->buffered = size;
+    }
+}
+
+void sha256_final(sha256_ctx_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    uint64_t bit_length = ctx->length * 8;
+
+    ctx->buffer[ctx->buffered++] = 0x80;
+    if (ctx->buffered > SHA256_BLOCK_SIZE - 8) {
+        memset(ctx->buffer + ctx->buffered, 0, SHA256_BLOCK_SIZE - ctx->buffered);
+        digest_dispatch.blocks(ctx->state, ctx->buffer, 1);
+        ctx->buffered = 0;
+    }
+    memset(ctx->buffer + ctx->buffered, 0, SHA256_BLOCK_SIZE - 8 - ctx->buffered);
+    for (int i = 0; i < 8; i++) {
+        ctx->buffer[SHA256_BLOCK_SIZE - 1 - i] = (uint8_t)(bit_length >> (i * 8));
+    }
+    digest_dispatch.blocks(ctx->state, ctx->buffer, 1);
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+// هش یک بافر
+void sha256(const void *data, size_t size, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, size);
+    sha256_final(&ctx, digest);
+}
+
+#if defined(__x86_64__)
+// پایان هش یک lane: بلوک‌های کامل پردازش شده‌اند و فقط دنباله باقی است
+static void finish_lane(const uint32_t state[8], const uint8_t *tail, size_t size, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    sha256_ctx_t ctx;
+    memcpy(ctx.state, state, sizeof(ctx.state));
+    ctx.length = size - size % SHA256_BLOCK_SIZE;
+    ctx.buffered = 0;
+    sha256_update(&ctx, tail, size % SHA256_BLOCK_SIZE);
+    sha256_final(&ctx, digest);
+}
+#endif
+
+// هش چند بافر مستقل
+void sha256_many(const uint8_t *const data[], const size_t sizes[], int count,
+                 uint8_t (*digests)[SHA256_DIGEST_SIZE]) {
+    digest_init_dispatch();
+
+    if (!digest_dispatch.multi_buffer) {
+        for (int i = 0; i < count; i++) {
+            sha256(data[i], sizes[i], digests[i]);
+        }
+        return;
+    }
+
+#if defined(__x86_64__)
+    // هر lane یک بافر را تا پایان بلوک‌های کاملش پیش می‌برد و سپس بافر بعدی را می‌گیرد
+    uint32_t states[8][8];
+    const uint8_t *pointers[8];
+    size_t blocks_left[8];
+    int lane_index[8];
+    int next = 0;
+
+    for (int lane = 0; lane < 8; lane++) {
+        lane_index[lane] = -1;
+    }
+
+    for (;;) {
+        int active = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (lane_index[lane] < 0 && next < count) {
+                lane_index[lane] = next;
+                pointers[lane] = data[next];
+                blocks_left[lane] = sizes[next] / SHA256_BLOCK_SIZE;
+                memcpy(states[lane], sha256_iv, sizeof(sha256_iv));
+                next++;
+            }
+            if (lane_index[lane] >= 0) {
+                active++;
+            }
+        }
+        if (active == 0) {
+            break;
+        }
+
+        size_t step = SIZE_MAX;
+        int any_lane = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            if (lane_index[lane] >= 0) {
+                any_lane = lane;
+                if (blocks_left[lane] < step) step = blocks_left[lane];
+            }
+        }
+
+        // با دو lane فعال یا کمتر، پردازش جداگانه ارزان‌تر از هدر دادن شش lane است
+        if (active <= 2 && next == count) {
+            for (int lane = 0; lane < 8; lane++) {
+                if (lane_index[lane] >= 0) {
+                    sha256_blocks_scalar(states[lane], pointers[lane], blocks_left[lane]);
+                    pointers[lane] += blocks_left[lane] * SHA256_BLOCK_SIZE;
+                    blocks_left[lane] = 0;
+                }
+            }
+            step = 0;
+        }
+
+        if (step > 0) {
+            // lane های خالی روی داده یک lane فعال محاسبه بیهوده انجام می‌دهند
+            const uint8_t *lane_data[8];
+            for (int lane = 0; lane < 8; lane++) {
+                lane_data[lane] = lane_index[lane] >= 0 ? pointers[lane] : pointers[any_lane];
+            }
+            sha256_blocks_x8_avx2(states, lane_data, step);
+            for (int lane = 0; lane < 8; lane++) {
+                if (lane_index[lane] >= 0) {
+                    pointers[lane] += step * SHA256_BLOCK_SIZE;
+                    blocks_left[lane] -= step;
+                }
+            }
+        }
+
+        for (int lane = 0; lane < 8; lane++) {
+            if (lane_index[lane] >= 0 && blocks_left[lane] == 0) {
+                int index = lane_index[lane];
+                finish_lane(states[lane], pointers[lane], sizes[index], digests[index]);
+                lane_index[lane] = -1;
+            }
+        }
+    }
+#endif
+}
+
+// ---------- هش فایل‌ها ----------
+
+// هش محتوای یک فایل
+int digest_file(const char *path, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        log_error("خطا در باز کردن فایل: %s", path);
+        return -1;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    uint8_t *buffer = malloc(DIGEST_READ_CHUNK);
+    if (!buffer) {
+        close(fd);
+        return -1;
+    }
+
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    ssize_t n;
+    while ((n = read(fd, buffer, DIGEST_READ_CHUNK)) > 0) {
+        sha256_update(&ctx, buffer, n);
+    }
+    free(buffer);
+    close(fd);
+
+    if (n < 0) {
+        log_error("خطا در خواندن فایل: %s", path);
+        return -1;
+    }
+    sha256_final(&ctx, digest);
+    return 0;
+}
+
+// کار هش گروهی از فایل‌ها
+typedef struct {
+    const char *const *paths;
+    uint8_t (*digests)[SHA256_DIGEST_SIZE];
+    int first;
+    int count;
+    int *error;
+} digest_task_t;
+
+// فایل‌های کوچک گروه با هم خوانده و با sha256_many هش می‌شوند؛ فایل‌های بزرگ جریانی
+static void digest_files_task(void *arg) {
+    digest_task_t *task = arg;
+    const uint8_t *data[DIGEST_FILES_PER_TASK] = { NULL };
+    size_t sizes[DIGEST_FILES_PER_TASK] = { 0 };
+    int indexes[DIGEST_FILES_PER_TASK];
+    uint8_t digests[DIGEST_FILES_PER_TASK][SHA256_DIGEST_SIZE];
+    int small = 0;
+
+    for (int i = task->first; i < task->first + task->count; i++) {
+        int fd = open(task->paths[i], O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) != 0) {
+            log_error("خطا در باز کردن فایل: %s", task->paths[i]);
+            __atomic_store_n(task->error, 1, __ATOMIC_RELAXED);
+            if (fd != -1) close(fd);
+            continue;
+        }
+
+        if (st.st_size > DIGEST_SMALL_FILE_MAX) {
+            close(fd);
+            if (digest_file(task->paths[i], task->digests[i]) != 0) {
+                __atomic_store_n(task->error, 1, __ATOMIC_RELAXED);
+            }
+            continue;
+        }
+
+        uint8_t *buffer = malloc(st.st_size ? st.st_size : 1);
+        ssize_t total = 0;
+        while (buffer && total < st.st_size) {
+            ssize_t n = read(fd, buffer + total, st.st_size - total);
+            if (n <= 0) break;
+            total += n;
+        }
+        close(fd);
+
+        if (!buffer || total != st.st_size) {
+            log_error("خطا در خواندن فایل: %s", task->paths[i]);
+            __atomic_store_n(task->error, 1, __ATOMIC_RELAXED);
+            free(buffer);
+            continue;
+        }
+        data[small] = buffer;
+        sizes[small] = total;
+        indexes[small] = i;
+        small++;
+    }
+
+    sha256_many(data, sizes, small, digests);
+    for (int i = 0; i < small; i++) {
+        memcpy(task->digests[indexes[i]], digests[i], SHA256_DIGEST_SIZE);
+        free((void *)data[i]);
+    }
+}
+
+// هش موازی چند فایل
+int digest_files(const char *const paths[], int count, uint8_t (*digests)[SHA256_DIGEST_SIZE], int threads) {
+    if (count == 0) {
+        return 0;
+    }
+
+    int task_count = (count + DIGEST_FILES_PER_TASK - 1) / DIGEST_FILES_PER_TASK;
+    digest_task_t *tasks = calloc(task_count, sizeof(digest_task_t));
+    if (!tasks) {
+        return -1;
+    }
+
+    int error = 0;
+    for (int i = 0; i < task_count; i++) {
+        tasks[i].paths = paths;
+        tasks[i].digests = digests;
+        tasks[i].first = i * DIGEST_FILES_PER_TASK;
+        tasks[i].count = count - tasks[i].first < DIGEST_FILES_PER_TASK ? count - tasks[i].first : DIGEST_FILES_PER_TASK;
+        tasks[i].error = &error;
+    }
+
+    // برای یک کار ایجاد thread ارزش ندارد
+    threadpool_t *pool = task_count > 1 ? threadpool_create(threads, 0) : NULL;
+    for (int i = 0; i < task_count; i++) {
+        if (!pool || threadpool_submit(pool, digest_files_task, &tasks[i]) != 0) {
+            digest_files_task(&tasks[i]);
+        }
+    }
+    if (pool) {
+        threadpool_wait(pool);
+        threadpool_destroy(pool);
+    }
+
+    free(tasks);
+    return error ? -1 : 0;
+}
+
+// ---------- قالب رشته‌ای ----------
+
+// قالب‌بندی به صورت "sha256:<hex>"
+void digest_format(const uint8_t digest[SHA256_DIGEST_SIZE], char *buffer, size_t buffer_size) {
+    static const char hex[] = "0123456789abcdef";
+    if (buffer_size < DIGEST_STRING_MAX) {
+        if (buffer_size > 0) buffer[0] = '\0';
+        return;
+    }
+    memcpy(buffer, "sha256:", 7);
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        buffer[7 + i * 2] = hex[digest[i] >> 4];
+        buffer[7 + i * 2 + 1] = hex[digest[i] & 0xf];
+    }
+    buffer[7 + SHA256_DIGEST_SIZE * 2] = '\0';
+}
+
+// تبدیل رشته "sha256:<hex>" به بایت‌ها
+int digest_parse(const char *digest_string, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    if (strncmp(digest_string, "sha256:", 7) != 0 || strlen(digest_string + 7) != SHA256_DIGEST_SIZE * 2) {
+        return -1;
+    }
+
+    const char *hex = digest_string + 7;
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        int value = 0;
+        for (int j = 0; j < 2; j++) {
+            char c = hex[i * 2 + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else return -1;
+        }
+        digest[i] = (uint8_t)value;
+    }
+    return 0;
+}
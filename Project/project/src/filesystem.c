@@ -8,6 +8,11 @@
 #include <sys/types.h>
 #include "../include/filesystem.h"
 #include "../include/utils.h"
+#include "../include/layerstore.h"
+#include "../include/snapshot.h"
+#include "../include/mounttree.h"
+#include "../include/diskusage.h"
+#include "../include/netpool.h"
 
 // تنظیم فایل‌سیستم ریشه کانتینر
 int setup_container_rootfs(container_config_t *config) {
@@ -17,9 +22,10 @@ int setup_container_rootfs(container_config_t *config) {
         return -1;
     }
     
-    // راه‌اندازی overlayfs
-    if (setup_overlayfs(config) != 0) {
-        log_error("خطا در راه‌اندازی overlayfs");
+    // ساخت rootfs با snapshotter انتخاب‌شده برای کانتینر
+    const snapshotter_t *snapshotter = snapshotter_get(config->snapshotter);
+    if (snapshotter->prepare(config) != 0) {
+        log_error("خطا در آماده‌سازی rootfs با snapshotter %s", snapshotter->name);
         return -1;
     }
     
@@ -28,18 +34,13 @@ int setup_container_rootfs(container_config_t *config) {
 
 // پاک‌سازی فایل‌سیستم ریشه کانتینر
 int cleanup_container_rootfs(container_config_t *config) {
-    // جدا کردن فایل‌سیستم overlayfs
-    if (umount(config->rootfs) != 0) {
-        log_error("خطا در جدا کردن فایل‌سیستم overlayfs");
+    // جدا کردن rootfs؛ دایرکتوری‌های کانتینر به trash منتقل و در پس‌زمینه حذف می‌شوند
+    if (snapshotter_get(config->snapshotter)->cleanup(config) != 0) {
         return -1;
     }
     
-    // حذف دایرکتوری‌های کانتینر
-    if (remove_directory(config->rootfs) != 0 ||
-        remove_directory(config->overlay_workdir) != 0) {
-        log_error("خطا در حذف دایرکتوری‌های کانتینر");
-        return -1;
-    }
+    // لایه‌ها در انبار می‌مانند تا GC پس از مهلت نگهداری حذفشان کند
+    release_container_image(config);
     
     return 0;
 }
@@ -47,7 +48,7 @@ int cleanup_container_rootfs(container_config_t *config) {
 // راه‌اندازی overlayfs
 int setup_overlayfs(container_config_t *config) {
     // مسیرهای مورد نیاز برای overlayfs - افزایش اندازه buffer
-    char lowerdir[2048] = "/var/lib/simplecontainer/rootfs/base";
+    char lowerdir[4096];
     char upperdir[2048];
     char workdir[2048];
     char mountopts[4096];  // افزایش اندازه به 4KB
@@ -62,6 +63,17 @@ int setup_overlayfs(container_config_t *config) {
         return -1;
     }
     
+    // لایه‌های تصویر به ترتیب بالا به پایین در lowerdir قرار می‌گیرند
+    if (snapshot_lowerdir_option(config, NULL, lowerdir, sizeof(lowerdir)) != 0) {
+        return -1;
+    }
+    
+    // project quota پیش از ایجاد upper و work تا هر دو شناسه را به ارث ببرند
+    if (disk_quota_setup(config->overlay_workdir, config->id, config->disk_limit_bytes, 0) != 0 &&
+        config->disk_limit_bytes > 0) {
+        log_message("هشدار: project quota روی %s فعال نیست، سقف دیسک اعمال نمی‌شود", config->overlay_workdir);
+    }
+    
     // ایجاد دایرکتوری‌های مورد نیاز
     if (create_directory(upperdir, 0755) != 0 ||
         create_directory(workdir, 0755) != 0) {
@@ -80,8 +92,20 @@ int setup_overlayfs(container_config_t *config) {
         return -1;
     }
     
+    // ریشه overlay از upper می‌آید و باید مانند ریشه لایه‌ها متعلق به root کانتینر باشد
+    if (config->idmap.count > 0 &&
+        (chown(upperdir, config->idmap.uid_base, config->idmap.gid_base) != 0 ||
+         snapshot_idmap_lowers(config) != 0)) {
+        log_error("خطا در آماده‌سازی نگاشت شناسه لایه‌ها");
+        return -1;
+    }
+    
     // نصب overlayfs
-    if (mount("overlay", config->rootfs, "overlay", 0, mountopts) != 0) {
+    int mounted = mount("overlay", config->rootfs, "overlay", 0, mountopts);
+    if (config->idmap.count > 0) {
+        snapshot_idmap_release(config);
+    }
+    if (mounted != 0) {
         log_error("خطا در نصب overlayfs");
         return -1;
     }
@@ -147,30 +171,62 @@ int prepare_container_directories(container_config_t *config) {
     return 0;
 }
 
-// نصب فایل‌سیستم‌های ضروری
+// نصب فایل‌سیستم‌های ضروری زیر rootfs، پیش از chroot و داخل mount namespace کانتینر
+// /dev از قالب مشترک clone می‌شود و superblock جدیدی نمی‌سازد، ولی proc، sysfs (بیرون از استخر)، devpts،
+// /dev/shm و /tmp به namespace یا خود کانتینر تعلق دارند و هر بار ساخته می‌شوند: 5 superblock و 24 فراخوانی
+// API نصب (22 با sysfs استخر) در برابر 5 فراخوانی mount(2) و 4 superblock پیش از آن، که devpts و /dev/shm نداشت
 int mount_essential_filesystems(container_config_t *config) {
-    (void)config;  // جلوگیری از warning unused parameter
+    char proc_dir[1024], sys_dir[1024], dev_dir[1024], tmp_dir[1024];
+    snprintf(proc_dir, sizeof(proc_dir), "%s/proc", config->rootfs);
+    snprintf(sys_dir, sizeof(sys_dir), "%s/sys", config->rootfs);
+    snprintf(dev_dir, sizeof(dev_dir), "%s/dev", config->rootfs);
+    snprintf(tmp_dir, sizeof(tmp_dir), "%s/tmp", config->rootfs);
     
-    // نصب proc
-    if (mount("proc", "/proc", "proc", 0, NULL) != 0) {
+    // proc به PID namespace فرآیند نصب‌کننده وابسته است و باید همین‌جا ساخته شود
+    if (mount_new_fs("proc", NULL, MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV | MOUNT_ATTR_NOEXEC, proc_dir) != 0) {
         log_error("خطا در نصب /proc");
         return -1;
     }
     
-    // نصب sysfs
-    if (mount("sysfs", "/sys", "sysfs", 0, NULL) != 0) {
+    // sysfs به network namespace نصب‌کننده وابسته است؛ کانتینر در namespace استخر مجوز ساخت آن را ندارد
+    // و قالب ساخته‌شده توسط استخر clone می‌شود
+    int sys_result;
+    if (config->netns_name[0]) {
+        char sysfs_template[1024];
+        snprintf(sysfs_template, sizeof(sysfs_template), "%s/%s%s", NETPOOL_DIR, config->netns_name,
+                 NETPOOL_SYSFS_SUFFIX);
+        sys_result = mount_clone_tree(sysfs_template, sys_dir);
+    } else {
+        sys_result = mount_new_fs("sysfs", NULL, MOUNT_ATTR_RDONLY | MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV |
+                                  MOUNT_ATTR_NOEXEC, sys_dir);
+    }
+    if (sys_result != 0) {
         log_error("خطا در نصب /sys");
         return -1;
     }
     
-    // نصب devtmpfs
-    if (mount("devtmpfs", "/dev", "devtmpfs", 0, NULL) != 0) {
+    if (mount_clone_tree(MOUNT_TEMPLATE_DEV, dev_dir) != 0) {
         log_error("خطا در نصب /dev");
         return -1;
     }
+
+    // نمونه devpts مستقل تا /dev/ptmx قالب به pts/ptmx همین کانتینر برسد، و /dev/shm قابل نوشتن
+    char pts_dir[1100], shm_dir[1100];
+    snprintf(pts_dir, sizeof(pts_dir), "%s/pts", dev_dir);
+    snprintf(shm_dir, sizeof(shm_dir), "%s/shm", dev_dir);
+    // از هسته 4.7 هر نصب devpts نمونه جدیدی است و newinstance لازم نیست
+    if (mount_new_fs("devpts", "ptmxmode=0666,mode=0620",
+                     MOUNT_ATTR_NOSUID | MOUNT_ATTR_NOEXEC, pts_dir) != 0) {
+        log_error("خطا در نصب /dev/pts");
+        return -1;
+    }
+    // حالت پیش‌فرض ریشه tmpfs همان 1777 است و fsconfig جداگانه‌ای لازم ندارد
+    if (mount_new_fs("tmpfs", NULL, MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV, shm_dir) != 0) {
+        log_error("خطا در نصب /dev/shm");
+        return -1;
+    }
     
-    // نصب tmpfs
-    if (mount("tmpfs", "/tmp", "tmpfs", 0, NULL) != 0) {
+    if (mount_new_fs("tmpfs", NULL, MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV, tmp_dir) != 0) {
         log_error("خطا در نصب /tmp");
         return -1;
     }
@@ -181,27 +237,74 @@ int mount_essential_filesystems(container_config_t *config) {
 
 // بارگذاری تصویر کانتینر (اختیاری)
 int load_container_image(container_config_t *config, const char *image_path) {
-    (void)config;  // جلوگیری از warning unused parameter
-    
     // بررسی وجود تصویر
-    struct stat st;
-    if (stat(image_path, &st) != 0) {
+    char manifest_path[1024];
+    snprintf(manifest_path, sizeof(manifest_path), "%s/manifest", image_path);
+    FILE *manifest = fopen(manifest_path, "r");
+    if (!manifest) {
         log_error("تصویر کانتینر یافت نشد: %s", image_path);
         return -1;
     }
     
-    // مسیر پایه برای تصاویر
-    char base_image_dir[512];
-    snprintf(base_image_dir, sizeof(base_image_dir), "/var/lib/simplecontainer/images");
+    config->image_layer_count = 0;
+    int result = 0;
+    char line[1024];
     
-    // ایجاد دایرکتوری تصاویر
-    if (create_directory(base_image_dir, 0755) != 0) {
-        log_error("خطا در ایجاد دایرکتوری تصاویر");
-        return -1;
+    while (result == 0 && fgets(line, sizeof(line), manifest)) {
+        char digest[80], layer_dir[512];
+        if (line[0] == '#' || sscanf(line, "%79s %511s", digest, layer_dir) != 2) {
+            continue;
+        }
+        
+        if (config->image_layer_count >= MAX_IMAGE_LAYERS) {
+            log_error("تعداد لایه‌های تصویر بیش از %d است", MAX_IMAGE_LAYERS);
+            result = -1;
+            break;
+        }
+        
+        // هر لایه فقط یک بار در انبار باز می‌شود و بین کانتینرها مشترک است
+        if (!layer_store_has(digest)) {
+            // لایه می‌تواند آرشیو tar یا دایرکتوری باز شده باشد
+            char source[1024];
+            snprintf(source, sizeof(source), "%s/%s", image_path, layer_dir);
+            struct stat st;
+            int imported = stat(source, &st) == 0 && S_ISREG(st.st_mode)
+                         ? layer_store_import_tar(digest, source)
+                         : layer_store_import_dir(digest, source);
+            if (imported != 0) {
+                result = -1;
+                break;
+            }
+        } else if (layer_store_verify_enabled() && layer_store_verify(digest) != 0) {
+            // لایه‌های تازه واردشده همان لحظه بررسی شده‌اند
+            result = -1;
+            break;
+        }
+        
+        if (layer_store_ref(digest) != 0) {
+            result = -1;
+            break;
+        }
+        
+        strncpy(config->image_layers[config->image_layer_count], digest, sizeof(config->image_layers[0]) - 1);
+        config->image_layer_count++;
     }
     
-    // در پیاده‌سازی کامل، اینجا تصویر استخراج می‌شود
-    log_message("تصویر %s بارگذاری شد", image_path);
+    fclose(manifest);
     
+    if (result != 0) {
+        release_container_image(config);
+        return -1;
+    }
+    
+    log_message("تصویر %s با %d لایه بارگذاری شد", image_path, config->image_layer_count);
     return 0;
-}
\ No newline at end of file
+}
+
+// رها کردن ارجاع لایه‌های تصویر کانتینر
+void release_container_image(container_config_t *config) {
+    for (int i = 0; i < config->image_layer_count; i++) {
+        layer_store_unref(config->image_layers[i]);
+    }
+    config->image_layer_count = 0;
+}
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/pidfd.h>
+#include "../include/forkserver.h"
+#include "../include/cgroup.h"
+#include "../include/utils.h"
+
+// ارسال پیام با توصیف‌گر اختیاری (pass_fd منفی یعنی بدون SCM_RIGHTS)
+static int send_msg(int fd, uint32_t type, uint32_t instance, int32_t value, int pass_fd) {
+    forkserver_msg_t msg = { type, instance, value };
+    struct iovec iov = { &msg, sizeof(msg) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    if (pass_fd >= 0) {
+        memset(&control, 0, sizeof(control));
+        header.msg_control = control.buf;
+        header.msg_controllen = sizeof(control.buf);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &pass_fd, sizeof(int));
+    }
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &header, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+    return sent == sizeof(msg) ? 0 : -1;
+}
+
+// دریافت پیام؛ توصیف‌گر همراه در recv_fd (یا -1) و اعتبارنامه فرستنده در pid اگر ارسال شده باشد.
+// 0 با پیام، 1 با بسته شدن سوکت و -1 در خطا
+static int recv_msg(int fd, forkserver_msg_t *msg, int *recv_fd, pid_t *pid) {
+    struct iovec iov = { msg, sizeof(*msg) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct ucred))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buf;
+    header.msg_controllen = sizeof(control.buf);
+
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &header, MSG_CMSG_CLOEXEC);
+    } while (received == -1 && errno == EINTR);
+    if (recv_fd) {
+        *recv_fd = -1;
+    }
+    if (received <= 0) {
+        return received == 0 ? 1 : -1;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (cmsg->cmsg_type == SCM_RIGHTS) {
+            int passed;
+            memcpy(&passed, CMSG_DATA(cmsg), sizeof(int));
+            if (recv_fd && *recv_fd == -1) {
+                *recv_fd = passed;
+            } else {
+                close(passed);
+            }
+        } else if (cmsg->cmsg_type == SCM_CREDENTIALS && pid) {
+            struct ucred cred;
+            memcpy(&cred, CMSG_DATA(cmsg), sizeof(cred));
+            *pid = cred.pid;
+        }
+    }
+    if (received != sizeof(*msg) || (header.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        if (recv_fd && *recv_fd != -1) {
+            close(*recv_fd);
+            *recv_fd = -1;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+// ---------- سمت برنامه کانتینر ----------
+
+// ادامه در فرزند: namespace های تازه، معرفی روی کانال و انتظار برای انتقال به cgroup
+static int instance_start(int channel, const forkserver_msg_t *request) {
+    int32_t result = 0;
+    if (request->value != 0 && unshare(request->value) != 0) {
+        result = -errno;
+    }
+    forkserver_msg_t reply;
+    if (send_msg(channel, FORKSERVER_MSG_FORKED, request->instance, result, -1) != 0 || result != 0 ||
+        recv_msg(channel, &reply, NULL, NULL) != 0 || reply.type != FORKSERVER_MSG_GO) {
+        _exit(1);
+    }
+    return channel;
+}
+
+int forkserver_run(void) {
+    const char *fd_text = getenv(FORKSERVER_ENV);
+    if (!fd_text) {
+        return FORKSERVER_STANDALONE;
+    }
+    int server_fd = atoi(fd_text);
+    unsetenv(FORKSERVER_ENV);
+    if (fcntl(server_fd, F_SETFD, FD_CLOEXEC) != 0 ||
+        send_msg(server_fd, FORKSERVER_MSG_READY, 0, 0, -1) != 0) {
+        log_error("خطا در اعلام آمادگی fork-server");
+        return -1;
+    }
+
+    // نمونه‌ها فرزند سرورند و بدون waitpid جمع‌آوری می‌شوند
+    struct sigaction ignore, saved;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    ignore.sa_flags = SA_NOCLDWAIT;
+    sigaction(SIGCHLD, &ignore, &saved);
+
+    for (;;) {
+        forkserver_msg_t request;
+        int channel;
+        int result = recv_msg(server_fd, &request, &channel, NULL);
+        if (result == 1) {
+            sigaction(SIGCHLD, &saved, NULL);
+            close(server_fd);
+            return -1;
+        }
+        if (result != 0 || request.type != FORKSERVER_MSG_FORK || channel == -1) {
+            if (result == 0 && channel != -1) {
+                close(channel);
+            }
+            log_error("درخواست نامعتبر در fork-server");
+            continue;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(server_fd);
+            sigaction(SIGCHLD, &saved, NULL);
+            return instance_start(channel, &request);
+        }
+        if (pid == -1) {
+            send_msg(channel, FORKSERVER_MSG_FORKED, request.instance, -errno, -1);
+        }
+        close(channel);
+    }
+}
+
+// ---------- سمت مدیر ----------
+
+static int wait_readable(int fd, int timeout_ms) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeout_ms);
+    } while (ready == -1 && errno == EINTR);
+    return ready;
+}
+
+int forkserver_wait_ready(int server_fd, int timeout_ms) {
+    forkserver_msg_t msg;
+    if (wait_readable(server_fd, timeout_ms) != 1 || recv_msg(server_fd, &msg, NULL, NULL) != 0 ||
+        msg.type != FORKSERVER_MSG_READY) {
+        log_error("fork-server آماده نشد");
+        return -1;
+    }
+    return 0;
+}
+
+int forkserver_fork(int server_fd, uint32_t id, const char *cgroup_path, int unshare_flags,
+                    forkserver_instance_t *instance) {
+    if (unshare_flags & ~FORKSERVER_UNSHARE_TYPES) {
+        log_error("پرچم unshare نامعتبر برای نمونه: 0x%x", unshare_flags);
+        return -1;
+    }
+    memset(instance, 0, sizeof(*instance));
+    instance->id = id;
+    instance->pidfd = -1;
+    snprintf(instance->cgroup_path, sizeof(instance->cgroup_path), "%s", cgroup_path);
+
+    // اعتبارنامه باید پیش از ارسال پیام نمونه روی سوکت گیرنده فعال باشد
+    int channel[2];
+    int one = 1;
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0) {
+        log_error("خطا در ایجاد کانال نمونه: %s", strerror(errno));
+        return -1;
+    }
+    instance->channel_fd = channel[0];
+    if (setsockopt(channel[0], SOL_SOCKET, SO_PASSCRED, &one, sizeof(one)) != 0 ||
+        send_msg(server_fd, FORKSERVER_MSG_FORK, id, unshare_flags, channel[1]) != 0) {
+        log_error("خطا در ارسال درخواست نمونه %u", id);
+        close(channel[0]);
+        close(channel[1]);
+        return -1;
+    }
+    close(channel[1]);
+
+    forkserver_msg_t reply = { 0, 0, 0 };
+    pid_t pid = 0;
+    if (recv_msg(channel[0], &reply, NULL, &pid) != 0 || reply.type != FORKSERVER_MSG_FORKED ||
+        reply.value != 0 || pid <= 0) {
+        log_error("نمونه %u ساخته نشد: %s", id, reply.value < 0 ? strerror(-reply.value) : "پاسخ نامعتبر");
+        close(channel[0]);
+        return -1;
+    }
+    instance->pid = pid;
+
+    // نمونه تا GO روی کانال منتظر است، پس شماره آن آزاد و دوباره استفاده نمی‌شود
+    char pid_str[16];
+    snprintf(pid_str, sizeof(pid_str), "%d", pid);
+    instance->pidfd = pidfd_open(pid, 0);
+    if (instance->pidfd == -1 || create_directory(cgroup_path, 0755) != 0 ||
+        write_cgroup_file(cgroup_path, "cgroup.procs", pid_str) != 0 ||
+        send_msg(channel[0], FORKSERVER_MSG_GO, id, 0, -1) != 0) {
+        log_error("خطا در انتقال نمونه %u به %s", id, cgroup_path);
+        forkserver_instance_destroy(instance);
+        return -1;
+    }
+    return 0;
+}
+
+int forkserver_instance_wait(forkserver_instance_t *instance, int timeout_ms) {
+    int ready = wait_readable(instance->pidfd, timeout_ms);
+    return ready == 1 ? 0 : ready == 0 ? 1 : -1;
+}
+
+int forkserver_instance_destroy(forkserver_instance_t *instance) {
+    int result = 0;
+    if (instance->pidfd != -1) {
+        // cgroup.kill فرزندان نمونه را هم می‌کشد؛ بدون آن (هسته پیش از 5.14) فقط خود نمونه
+        if (forkserver_instance_wait(instance, 0) == 1 &&
+            write_cgroup_file(instance->cgroup_path, "cgroup.kill", "1") != 0) {
+            pidfd_send_signal(instance->pidfd, SIGKILL, NULL, 0);
+        }
+        forkserver_instance_wait(instance, -1);
+        close(instance->pidfd);
+        instance->pidfd = -1;
+    }
+    if (instance->channel_fd != -1) {
+        close(instance->channel_fd);
+        instance->channel_fd = -1;
+    }
+    if (instance->cgroup_path[0] && rmdir(instance->cgroup_path) != 0 && errno != ENOENT) {
+        log_error("خطا در حذف cgroup نمونه %s", instance->cgroup_path);
+        result = -1;
+    }
+    return result;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <pwd.h>
+#include <sys/wait.h>
+#include "../include/idmap.h"
+#include "../include/utils.h"
+
+int idmap_parse(const char *text, id_mapping_t *map) {
+    if (strcmp(text, "subuid") == 0) {
+        char user[32];
+        struct passwd *pw = getpwuid(getuid());
+        snprintf(user, sizeof(user), "%s", pw ? pw->pw_name : "root");
+        uint32_t uid_count, gid_count;
+        if (idmap_read_subid(IDMAP_SUBUID_PATH, user, &map->uid_base, &uid_count) != 0 ||
+            idmap_read_subid(IDMAP_SUBGID_PATH, user, &map->gid_base, &gid_count) != 0) {
+            return -1;
+        }
+        map->count = uid_count < gid_count ? uid_count : gid_count;
+        return 0;
+    }
+
+    char *endptr;
+    unsigned long long base = strtoull(text, &endptr, 10);
+    unsigned long long count = IDMAP_DEFAULT_COUNT;
+    if (*endptr == ':') {
+        count = strtoull(endptr + 1, &endptr, 10);
+    }
+    if (*endptr != '\0' || endptr == text || count == 0 || base + count > UINT32_MAX) {
+        log_error("نگاشت شناسه نامعتبر: %s", text);
+        return -1;
+    }
+    map->uid_base = base;
+    map->gid_base = base;
+    map->count = count;
+    return 0;
+}
+
+int idmap_read_subid(const char *path, const char *user, uint32_t *base, uint32_t *count) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        log_error("خطا در باز کردن %s", path);
+        return -1;
+    }
+
+    char uid_text[16];
+    snprintf(uid_text, sizeof(uid_text), "%u", getuid());
+    char line[256], name[128];
+    unsigned long start, length;
+    int result = -1;
+    while (result != 0 && fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%127[^:]:%lu:%lu", name, &start, &length) == 3 && length > 0 &&
+            (strcmp(name, user) == 0 || strcmp(name, uid_text) == 0)) {
+            *base = start;
+            *count = length;
+            result = 0;
+        }
+    }
+    fclose(file);
+
+    if (result != 0) {
+        log_error("محدوده‌ای برای %s در %s نیست", user, path);
+    }
+    return result;
+}
+
+static int write_map(pid_t pid, const char *file, uint32_t base, uint32_t count, bool inverse) {
+    char path[64], map[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", pid, file);
+    int length = inverse ? snprintf(map, sizeof(map), "%u 0 %u\n", base, count)
+                         : snprintf(map, sizeof(map), "0 %u %u\n", base, count);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1 || write(fd, map, length) != length) {
+        log_error("خطا در نوشتن %s: %s", path, strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+int idmap_write(pid_t pid, const id_mapping_t *map, bool inverse) {
+    if (write_map(pid, "uid_map", map->uid_base, map->count, inverse) != 0 ||
+        write_map(pid, "gid_map", map->gid_base, map->count, inverse) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// فرزند تک‌thread با unshare یک user namespace می‌سازد و تا نوشتن نگاشت و باز شدن توصیف‌گر آن
+// منتظر می‌ماند؛ namespace با همان توصیف‌گر زنده می‌ماند
+int idmap_userns_fd(const id_mapping_t *map, bool inverse) {
+    int ready[2], hold[2];
+    if (pipe2(ready, O_CLOEXEC) != 0) {
+        log_error("خطا در ایجاد pipe برای user namespace");
+        return -1;
+    }
+    if (pipe2(hold, O_CLOEXEC) != 0) {
+        log_error("خطا در ایجاد pipe برای user namespace");
+        close(ready[0]);
+        close(ready[1]);
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(ready[0]);
+        close(hold[1]);
+        char byte = unshare(CLONE_NEWUSER) == 0;
+        if (write(ready[1], &byte, 1) == 1 && byte) {
+            while (read(hold[0], &byte, 1) > 0) {
+            }
+        }
+        _exit(0);
+    }
+    close(ready[1]);
+    close(hold[0]);
+
+    int fd = -1;
+    char byte = 0;
+    if (pid != -1 && read(ready[0], &byte, 1) == 1 && byte && idmap_write(pid, map, inverse) == 0) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/ns/user", pid);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+    close(ready[0]);
+    close(hold[1]);
+    if (pid != -1) {
+        waitpid(pid, NULL, 0);
+    }
+
+    if (fd == -1) {
+        log_error("خطا در ساخت user namespace برای نگاشت شناسه");
+    }
+    return fd;
+}
@@ -3,6 +3,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ipc.h>
@@ -10,195 +17,1060 @@
 #include <sys/sem.h>
 #include <sys/msg.h>
 #include "../include/ipc.h"
+#include "../include/ipc_layout.h"
+#include "../include/cgroup.h"
 #include "../include/utils.h"
 
+// انواع کانال
+#define IPC_CHANNEL_SHM 1
+#define IPC_CHANNEL_SEM 2
+#define IPC_CHANNEL_MSG 3
+#define IPC_CHANNEL_BROADCAST 4
+
+// اندازه پیش‌فرض سگمنت حافظه مشترک هر کانال
+#define IPC_SHM_SIZE 4096
+
+// اندازه صفحه بزرگ (2MB)
+#define IPC_HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+
+// تعداد کلیدهای متوالی که پس از برخورد هش نام امتحان می‌شوند
+#define IPC_KEY_PROBES 8
+
+// خواننده هر این تعداد دور انتظار روی seq فرد بررسی می‌کند نویسنده هنوز زنده است
+#define IPC_BROADCAST_SPIN_CHECK 4096
+
+// اندازه اولیه جدول هش (توان ۲)
+#define IPC_INITIAL_BUCKETS 64
+
 // ساختار کانال IPC
-typedef struct {
+struct ipc_channel {
     char name[64];
-    int type;        // نوع کانال: 1=shm, 2=sem, 3=msg
-    int id;          // شناسه منبع IPC
-    key_t key;       // کلید منبع IPC
-} ipc_channel_t;
+    int type;                   // نوع کانال: 1=shm, 2=sem, 3=msg, 4=broadcast
+    int id;                     // شناسه منبع IPC
+    key_t key;                  // کلید منبع IPC
+    void *map;                  // نگاشت دائمی سگمنت در این فرآیند (از سرآیند سگمنت)
+    void *addr;                 // ابتدای ساختار کانال پس از سرآیند سگمنت
+    size_t size;                // اندازه واقعی سگمنت منهای سرآیند
+    bool huge;                  // سگمنت با صفحات 2MB پشتیبانی می‌شود
+    uint32_t ring_capacity;     // اندازه ناحیه داده صف رکوردها
+    uint32_t hash;              // هش نام برای جستجو و تغییر اندازه جدول
+    int refcount;               // یک ارجاع متعلق به جدول و بقیه متعلق به handle ها
+    ipc_channel_stats_t stats;  // آمار کانال
+    struct ipc_channel *next;   // کانال بعدی در همان bucket
+};
+
+// جدول کانال‌ها: هش با زنجیره؛ کانال‌ها جداگانه تخصیص می‌یابند تا handle ها پس از تغییر اندازه معتبر بمانند
+static struct {
+    ipc_channel_t **buckets;
+    size_t bucket_count;
+    size_t channel_count;
+    pthread_mutex_t lock;
+} registry = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+// هش FNV-1a برای نام کانال
+static uint32_t hash_name(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// ایجاد جدول در صورت نیاز (با قفل گرفته‌شده)
+static int registry_init_locked() {
+    if (registry.buckets != NULL) {
+        return 0;
+    }
+
+    registry.buckets = calloc(IPC_INITIAL_BUCKETS, sizeof(ipc_channel_t *));
+    if (!registry.buckets) {
+        log_error("خطا در تخصیص حافظه برای جدول کانال‌های IPC");
+        return -1;
+    }
+    registry.bucket_count = IPC_INITIAL_BUCKETS;
+    registry.channel_count = 0;
+    return 0;
+}
+
+// دو برابر کردن جدول هش وقتی ضریب بار از 0.75 بیشتر شود (با قفل گرفته‌شده)
+static void registry_grow_locked() {
+    if (registry.channel_count * 4 < registry.bucket_count * 3) {
+        return;
+    }
+
+    size_t new_count = registry.bucket_count * 2;
+    ipc_channel_t **new_buckets = calloc(new_count, sizeof(ipc_channel_t *));
+    if (!new_buckets) {
+        // جدول بزرگ نمی‌شود ولی همچنان درست کار می‌کند
+        return;
+    }
+
+    for (size_t i = 0; i < registry.bucket_count; i++) {
+        ipc_channel_t *channel = registry.buckets[i];
+        while (channel) {
+            ipc_channel_t *next = channel->next;
+            size_t index = channel->hash & (new_count - 1);
+            channel->next = new_buckets[index];
+            new_buckets[index] = channel;
+            channel = next;
+        }
+    }
+
+    free(registry.buckets);
+    registry.buckets = new_buckets;
+    registry.bucket_count = new_count;
+}
+
+// یافتن یک کانال با نام (با قفل گرفته‌شده)
+static ipc_channel_t* find_channel_locked(const char *channel_name, uint32_t hash) {
+    if (registry.buckets == NULL) {
+        return NULL;
+    }
+
+    ipc_channel_t *channel = registry.buckets[hash & (registry.bucket_count - 1)];
+    while (channel) {
+        if (channel->hash == hash && strcmp(channel->name, channel_name) == 0) {
+            return channel;
+        }
+        channel = channel->next;
+    }
+    return NULL;
+}
+
+// جدا کردن کانال از جدول (با قفل گرفته‌شده)
+static void unlink_channel_locked(ipc_channel_t *target) {
+    ipc_channel_t **link = &registry.buckets[target->hash & (registry.bucket_count - 1)];
+    while (*link) {
+        if (*link == target) {
+            *link = target->next;
+            target->next = NULL;
+            registry.channel_count--;
+            return;
+        }
+        link = &(*link)->next;
+    }
+}
+
+// آزادسازی منبع IPC و حافظه کانال
+static void release_channel(ipc_channel_t *channel) {
+    if (channel->map != NULL) {
+        shmdt(channel->map);
+    }
+    free(channel);
+}
 
-// حداکثر تعداد کانال‌های IPC
-#define MAX_IPC_CHANNELS 32
+// کاهش شمارنده ارجاع و آزادسازی در آخرین ارجاع
+static void channel_unref(ipc_channel_t *channel) {
+    if (__atomic_sub_fetch(&channel->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        release_channel(channel);
+    }
+}
 
-// آرایه کانال‌های IPC
-static ipc_channel_t channels[MAX_IPC_CHANNELS];
-static int channel_count = 0;
+// حذف منبع سیستمی کانال؛ سگمنت تا جدا شدن آخرین نگاشت باقی می‌ماند
+static void remove_channel_resource(ipc_channel_t *channel) {
+    if (channel->type == IPC_CHANNEL_SHM || channel->type == IPC_CHANNEL_BROADCAST) {
+        // حافظه مشترک
+        shmctl(channel->id, IPC_RMID, NULL);
+    } else if (channel->type == IPC_CHANNEL_SEM) {
+        // سمافور
+        semctl(channel->id, 0, IPC_RMID);
+    } else if (channel->type == IPC_CHANNEL_MSG) {
+        // صف پیام
+        msgctl(channel->id, IPC_RMID, NULL);
+    }
+}
 
 // راه‌اندازی IPC
 int ipc_setup() {
-    // پاک‌سازی آرایه کانال‌ها
-    memset(channels, 0, sizeof(channels));
-    channel_count = 0;
-    
+    pthread_mutex_lock(&registry.lock);
+    int result = registry_init_locked();
+    pthread_mutex_unlock(&registry.lock);
+
+    if (result != 0) {
+        return -1;
+    }
+
     log_message("سیستم IPC راه‌اندازی شد");
     return 0;
 }
 
 // پاک‌سازی IPC
 int ipc_cleanup() {
+    pthread_mutex_lock(&registry.lock);
+
     // آزادسازی تمام منابع IPC
-    for (int i = 0; i < channel_count; i++) {
-        if (channels[i].type == 1) {
-            // حافظه مشترک
-            shmctl(channels[i].id, IPC_RMID, NULL);
-        } else if (channels[i].type == 2) {
-            // سمافور
-            semctl(channels[i].id, 0, IPC_RMID);
-        } else if (channels[i].type == 3) {
-            // صف پیام
-            msgctl(channels[i].id, IPC_RMID, NULL);
-        }
-    }
-    
-    // پاک‌سازی آرایه کانال‌ها
-    memset(channels, 0, sizeof(channels));
-    channel_count = 0;
-    
+    for (size_t i = 0; i < registry.bucket_count; i++) {
+        ipc_channel_t *channel = registry.buckets[i];
+        while (channel) {
+            ipc_channel_t *next = channel->next;
+            channel->next = NULL;
+            remove_channel_resource(channel);
+            channel_unref(channel);
+            channel = next;
+        }
+    }
+
+    // پاک‌سازی جدول کانال‌ها
+    free(registry.buckets);
+    registry.buckets = NULL;
+    registry.bucket_count = 0;
+    registry.channel_count = 0;
+
+    pthread_mutex_unlock(&registry.lock);
+
     log_message("منابع IPC پاک‌سازی شدند");
     return 0;
 }
 
-// یافتن یک کانال با نام
-static ipc_channel_t* find_channel(const char *channel_name) {
-    for (int i = 0; i < channel_count; i++) {
-        if (strcmp(channels[i].name, channel_name) == 0) {
-            return &channels[i];
+// ایجاد انحصاری سگمنت با کلید key یا کلیدهای بعدی آن
+// سگمنت موجود فقط وقتی کنار گذاشته می‌شود که نام ذخیره‌شده در آن همین کانال باشد و دیگر به آن وصل نباشد
+// (مانده از اجرای قبلی)؛ سگمنت متعلق به نام دیگر یعنی برخورد هش و کلید بعدی امتحان می‌شود.
+// -1 در خطای ایجاد و -2 وقتی کانال هم‌نام در فرآیند دیگری در حال استفاده است
+static int create_segment(const char *channel_name, key_t *key, size_t size, int flags) {
+    for (int probe = 0; probe < IPC_KEY_PROBES; ) {
+        int shm_id = shmget(*key, size, IPC_CREAT | IPC_EXCL | flags | 0666);
+        if (shm_id != -1 || errno != EEXIST) {
+            return shm_id;
+        }
+
+        bool same_name = false;
+        struct shmid_ds info;
+        int existing = shmget(*key, 0, 0);
+        if (existing != -1 && shmctl(existing, IPC_STAT, &info) == 0) {
+            ipc_segment_header_t *segment = shmat(existing, NULL, SHM_RDONLY);
+            if (segment != (void *) -1) {
+                same_name = info.shm_segsz >= sizeof(*segment) &&
+                            __atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) == IPC_SEGMENT_MAGIC &&
+                            strncmp(segment->name, channel_name, sizeof(segment->name)) == 0;
+                shmdt(segment);
+            }
+        }
+
+        if (!same_name) {
+            *key = *key == 0x7fffffff ? 1 : *key + 1;
+            probe++;
+            continue;
+        }
+        if (info.shm_nattch > 0) {
+            log_error("کانال IPC با نام %s در فرآیند دیگری در حال استفاده است", channel_name);
+            return -2;
         }
+        log_message("حذف سگمنت مانده از کانال قبلی %s", channel_name);
+        shmctl(existing, IPC_RMID, NULL);
+        probe++;
     }
-    return NULL;
+
+    log_error("کلید آزادی برای کانال IPC %s پیدا نشد", channel_name);
+    errno = EEXIST;
+    return -1;
 }
 
-// ایجاد کانال IPC برای کانتینر
-int ipc_create_channel(container_config_t *config, const char *channel_name) {
-    if (channel_count >= MAX_IPC_CHANNELS) {
-        log_error("حداکثر تعداد کانال‌های IPC ایجاد شده است");
+// پیش‌تخصیص صفحات سگمنت از داخل cgroup کانتینر
+// صفحات shmem به cgroup فرآیندی که اولین بار آن‌ها را لمس می‌کند نسبت داده می‌شوند،
+// پس یک فرآیند کمکی در cgroup کانتینر همه صفحات را لمس می‌کند و خارج می‌شود.
+// این کار باید پیش از هر نوشتن مدیر در سگمنت انجام شود، وگرنه صفحه سرآیند (و با صفحات بزرگ
+// کل 2MB اول) به cgroup مدیر می‌رسد.
+// فرزندِ فرآیند چندنخی فقط فراخوانی‌های async-signal-safe انجام می‌دهد و نتیجه را با وضعیت خروج گزارش می‌کند.
+// 0 پس از شارژ، 1 وقتی cgroup هنوز وجود ندارد و -1 در خطا
+static int charge_segment_to_cgroup(container_config_t *config, const char *channel_name,
+                                    char *map, size_t length, bool huge) {
+    if (!directory_exists(config->cgroup_path)) {
+        return 1;
+    }
+
+    char procs_path[PATH_MAX];
+    snprintf(procs_path, sizeof(procs_path), "%s/cgroup.procs", config->cgroup_path);
+    size_t step = huge ? IPC_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        log_error("خطا در ایجاد فرآیند کمکی برای شارژ حافظه کانال");
         return -1;
     }
-    
+
+    if (pid == 0) {
+        // نوشتن 0 در cgroup.procs خود فرآیند نویسنده را منتقل می‌کند
+        int fd = open(procs_path, O_WRONLY | O_CLOEXEC);
+        if (fd == -1) {
+            _exit(1);
+        }
+        if (write(fd, "0", 1) != 1) {
+            _exit(2);
+        }
+        close(fd);
+
+        // افزودن صفر به‌صورت اتمیک صفحه را برای نوشتن تخصیص می‌دهد بدون اینکه داده را تغییر دهد
+        for (size_t offset = 0; offset < length; offset += step) {
+            __atomic_fetch_add(map + offset, 0, __ATOMIC_RELAXED);
+        }
+        _exit(0);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        const char *reason = !WIFEXITED(status) ? "پایان غیرعادی فرآیند کمکی"
+                             : WEXITSTATUS(status) == 1 ? "باز کردن cgroup.procs"
+                                                        : "پیوستن به cgroup";
+        log_error("خطا در شارژ حافظه کانال %s به cgroup کانتینر %s (%s)", channel_name, config->id, reason);
+        return -1;
+    }
+    return 0;
+}
+
+// ایجاد و ثبت یک کانال مبتنی بر حافظه مشترک
+// نتیجه charge_segment_to_cgroup در charged برگردانده می‌شود
+static ipc_channel_t* create_shm_channel(container_config_t *config, const char *channel_name, int type,
+                                         size_t segment_size, bool huge_pages, int *charged) {
+    if (strlen(channel_name) >= sizeof(((ipc_channel_t *)0)->name)) {
+        log_error("نام کانال IPC خیلی طولانی است: %s", channel_name);
+        return NULL;
+    }
+
+    uint32_t hash = hash_name(channel_name);
+
+    pthread_mutex_lock(&registry.lock);
+
+    if (registry_init_locked() != 0) {
+        pthread_mutex_unlock(&registry.lock);
+        return NULL;
+    }
+
     // بررسی وجود کانال با نام تکراری
-    if (find_channel(channel_name) != NULL) {
+    if (find_channel_locked(channel_name, hash) != NULL) {
+        pthread_mutex_unlock(&registry.lock);
         log_error("کانال IPC با نام %s قبلاً ایجاد شده است", channel_name);
-        return -1;
+        return NULL;
     }
-    
-    // ایجاد کلید IPC منحصر به فرد
-    key_t key = ftok("/var/lib/simplecontainer", channel_count + 1);
-    if (key == -1) {
-        log_error("خطا در ایجاد کلید IPC");
-        return -1;
+
+    // کلید IPC از هش نام ساخته می‌شود تا فرآیندهای دیگر بتوانند با همان نام به سگمنت برسند
+    key_t key = (key_t)(hash & 0x7fffffff);
+    if (key == IPC_PRIVATE) {
+        key = 1;
+    }
+    segment_size += sizeof(ipc_segment_header_t);
+
+    // ایجاد حافظه مشترک؛ در صورت نبود صفحات بزرگ رزروشده به صفحات معمولی برمی‌گردیم
+    int shm_id = -1;
+    bool huge = false;
+    if (huge_pages) {
+        size_t huge_size = (segment_size + IPC_HUGE_PAGE_SIZE - 1) & ~(IPC_HUGE_PAGE_SIZE - 1);
+        shm_id = create_segment(channel_name, &key, huge_size, SHM_HUGETLB);
+        if (shm_id >= 0) {
+            segment_size = huge_size;
+            huge = true;
+        } else if (shm_id == -1) {
+            log_message("صفحات بزرگ برای کانال %s در دسترس نیست، استفاده از صفحات معمولی", channel_name);
+        }
     }
-    
-    // ایجاد حافظه مشترک
-    int shm_id = shmget(key, 4096, IPC_CREAT | 0666);
     if (shm_id == -1) {
-        log_error("خطا در ایجاد حافظه مشترک");
-        return -1;
+        shm_id = create_segment(channel_name, &key, segment_size, 0);
+    }
+    if (shm_id < 0) {
+        pthread_mutex_unlock(&registry.lock);
+        if (shm_id == -1) {
+            log_error("خطا در ایجاد حافظه مشترک");
+        }
+        return NULL;
+    }
+
+    // نگاشت یک‌باره سگمنت برای همه پیام‌ها
+    void *shm_map = shmat(shm_id, NULL, 0);
+    if (shm_map == (void *) -1) {
+        shmctl(shm_id, IPC_RMID, NULL);
+        pthread_mutex_unlock(&registry.lock);
+        log_error("خطا در اتصال به حافظه مشترک");
+        return NULL;
+    }
+
+    // در حالت بازگشت، THP برای shmem (در صورت فعال بودن) حداقل فشار TLB را کم می‌کند
+    if (huge_pages && !huge) {
+        madvise(shm_map, segment_size, MADV_HUGEPAGE);
     }
-    
+
+    // خطای شارژ مانع استفاده از کانال نیست، ولی صفحات به cgroup هر فرآیندی که اول لمسشان کند می‌رسند
+    *charged = charge_segment_to_cgroup(config, channel_name, shm_map, segment_size, huge);
+
+    ipc_segment_header_t *segment = shm_map;
+    strncpy(segment->name, channel_name, sizeof(segment->name) - 1);
+    segment->type = (uint32_t)type;
+    __atomic_store_n(&segment->magic, IPC_SEGMENT_MAGIC, __ATOMIC_RELEASE);
+    void *shm_addr = segment + 1;
+    segment_size -= sizeof(ipc_segment_header_t);
+
+    ipc_channel_t *channel = calloc(1, sizeof(ipc_channel_t));
+    if (!channel) {
+        shmdt(shm_map);
+        shmctl(shm_id, IPC_RMID, NULL);
+        pthread_mutex_unlock(&registry.lock);
+        log_error("خطا در تخصیص حافظه برای کانال IPC");
+        return NULL;
+    }
+
     // ثبت کانال جدید
-    ipc_channel_t *channel = &channels[channel_count++];
     strncpy(channel->name, channel_name, sizeof(channel->name) - 1);
-    channel->type = 1;  // حافظه مشترک
+    channel->type = type;
     channel->id = shm_id;
     channel->key = key;
-    
-    log_message("کانال IPC %s برای کانتینر %s ایجاد شد", channel_name, config->id);
+    channel->map = shm_map;
+    channel->addr = shm_addr;
+    channel->size = segment_size;
+    channel->huge = huge;
+    channel->hash = hash;
+    channel->refcount = 1;  // ارجاع جدول
+
+    size_t index = hash & (registry.bucket_count - 1);
+    channel->next = registry.buckets[index];
+    registry.buckets[index] = channel;
+    registry.channel_count++;
+    registry_grow_locked();
+
+    pthread_mutex_unlock(&registry.lock);
+    return channel;
+}
+
+// ایجاد کانال IPC برای کانتینر
+int ipc_create_channel(container_config_t *config, const char *channel_name) {
+    return ipc_create_channel_ex(config, channel_name, NULL);
+}
+
+// ایجاد کانال IPC با اندازه و نوع صفحه دلخواه
+int ipc_create_channel_ex(container_config_t *config, const char *channel_name, const ipc_channel_options_t *options) {
+    size_t size = IPC_SHM_SIZE;
+    bool huge_pages = false;
+    if (options != NULL) {
+        if (options->size > 0) {
+            if (options->size > (1UL << 30)) {
+                log_error("اندازه کانال IPC خیلی بزرگ است: %lu", options->size);
+                return -1;
+            }
+            // صف باید حداقل یک رکورد با بیشترین اندازه و فاصله 8 بایتی را جا دهد
+            size = sizeof(ipc_ring_header_t) + IPC_RECORD_SPACE(options->size) + 8;
+        }
+        huge_pages = options->huge_pages;
+    }
+
+    int charged;
+    ipc_channel_t *channel = create_shm_channel(config, channel_name, IPC_CHANNEL_SHM, size, huge_pages, &charged);
+    if (channel == NULL) {
+        return -1;
+    }
+
+    // مقداردهی صف رکوردها
+    ipc_ring_header_t *ring = channel->addr;
+    memset(ring, 0, sizeof(*ring));
+    channel->ring_capacity = (uint32_t)((channel->size - sizeof(ipc_ring_header_t)) & ~(size_t)7);
+    ring->capacity = channel->ring_capacity;
+
+    log_message("کانال IPC %s برای کانتینر %s ایجاد شد (%lu بایت%s)%s",
+                channel_name, config->id, channel->size, channel->huge ? "، صفحات 2MB" : "",
+                charged == 0 ? "" : "؛ حافظه به cgroup کانتینر نسبت داده نشد");
+    return 0;
+}
+
+// ایجاد کانال broadcast
+int ipc_create_broadcast_channel(container_config_t *config, const char *channel_name, size_t max_payload) {
+    if (max_payload == 0 || max_payload > UINT32_MAX) {
+        log_error("اندازه داده کانال broadcast نامعتبر است: %lu", max_payload);
+        return -1;
+    }
+
+    int charged;
+    ipc_channel_t *channel = create_shm_channel(config, channel_name, IPC_CHANNEL_BROADCAST,
+                                                sizeof(ipc_broadcast_header_t) + max_payload, false, &charged);
+    if (channel == NULL) {
+        return -1;
+    }
+
+    // سرآیند پیش از انتشار هر نسخه‌ای مقداردهی می‌شود
+    ipc_broadcast_header_t *header = channel->addr;
+    memset(header, 0, sizeof(*header));
+    header->capacity = max_payload;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header->writer_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    __atomic_store_n(&header->magic, IPC_BROADCAST_MAGIC, __ATOMIC_RELEASE);
+
+    log_message("کانال broadcast %s برای کانتینر %s ایجاد شد (حداکثر %lu بایت)%s",
+                channel_name, config->id, max_payload,
+                charged == 0 ? "" : "؛ حافظه به cgroup کانتینر نسبت داده نشد");
     return 0;
 }
 
+// حذف یک کانال
+int ipc_destroy_channel(const char *channel_name) {
+    uint32_t hash = hash_name(channel_name);
+
+    pthread_mutex_lock(&registry.lock);
+    ipc_channel_t *channel = find_channel_locked(channel_name, hash);
+    if (channel == NULL) {
+        pthread_mutex_unlock(&registry.lock);
+        log_error("کانال IPC با نام %s پیدا نشد", channel_name);
+        return -1;
+    }
+    unlink_channel_locked(channel);
+    pthread_mutex_unlock(&registry.lock);
+
+    remove_channel_resource(channel);
+    channel_unref(channel);
+
+    log_message("کانال IPC %s حذف شد", channel_name);
+    return 0;
+}
+
+// تعداد کانال‌های ثبت‌شده
+size_t ipc_channel_count() {
+    pthread_mutex_lock(&registry.lock);
+    size_t count = registry.channel_count;
+    pthread_mutex_unlock(&registry.lock);
+    return count;
+}
+
 // اتصال دو کانتینر از طریق IPC
 int ipc_connect_containers(const char *container_id1, const char *container_id2, const char *channel_name) {
     // بررسی وجود کانال
-    ipc_channel_t *channel = find_channel(channel_name);
+    ipc_channel_t *channel = ipc_channel_open(channel_name);
     if (channel == NULL) {
-        log_error("کانال IPC با نام %s پیدا نشد", channel_name);
         return -1;
     }
-    
-    log_message("کانتینرهای %s و %s از طریق کانال %s به هم متصل شدند", 
+    ipc_channel_close(channel);
+
+    log_message("کانتینرهای %s و %s از طریق کانال %s به هم متصل شدند",
                 container_id1, container_id2, channel_name);
     return 0;
 }
 
-// ارسال پیام بین کانتینرها
-int ipc_send_message(const char *channel_name, const void *data, size_t data_size) {
-    // بررسی وجود کانال
-    ipc_channel_t *channel = find_channel(channel_name);
+// گرفتن handle یک کانال
+ipc_channel_t* ipc_channel_open(const char *channel_name) {
+    uint32_t hash = hash_name(channel_name);
+
+    pthread_mutex_lock(&registry.lock);
+    ipc_channel_t *channel = find_channel_locked(channel_name, hash);
+    if (channel != NULL) {
+        __atomic_add_fetch(&channel->refcount, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&registry.lock);
+
     if (channel == NULL) {
         log_error("کانال IPC با نام %s پیدا نشد", channel_name);
+    }
+    return channel;
+}
+
+// اتصال به کانالی که فرآیند دیگری با این نام ساخته است
+// کلیدها به همان ترتیب create_segment امتحان می‌شوند و نام و نوع از سرآیند سگمنت خوانده می‌شود
+ipc_channel_t* ipc_channel_attach(const char *channel_name) {
+    if (strlen(channel_name) >= sizeof(((ipc_channel_t *)0)->name)) {
+        log_error("نام کانال IPC خیلی طولانی است: %s", channel_name);
+        return NULL;
+    }
+
+    uint32_t hash = hash_name(channel_name);
+    key_t key = (key_t)(hash & 0x7fffffff);
+    if (key == IPC_PRIVATE) {
+        key = 1;
+    }
+
+    for (int probe = 0; probe < IPC_KEY_PROBES; probe++, key = key == 0x7fffffff ? 1 : key + 1) {
+        struct shmid_ds info;
+        int shm_id = shmget(key, 0, 0);
+        if (shm_id == -1 || shmctl(shm_id, IPC_STAT, &info) != 0 || info.shm_segsz < sizeof(ipc_segment_header_t)) {
+            continue;
+        }
+
+        ipc_segment_header_t *segment = shmat(shm_id, NULL, 0);
+        if (segment == (void *) -1) {
+            continue;
+        }
+        uint32_t type = segment->type;
+        size_t size = info.shm_segsz - sizeof(ipc_segment_header_t);
+        bool valid = __atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) == IPC_SEGMENT_MAGIC &&
+                     strncmp(segment->name, channel_name, sizeof(segment->name)) == 0 &&
+                     ((type == IPC_CHANNEL_SHM && size >= sizeof(ipc_ring_header_t)) ||
+                      (type == IPC_CHANNEL_BROADCAST && size >= sizeof(ipc_broadcast_header_t)));
+        if (!valid) {
+            shmdt(segment);
+            continue;
+        }
+
+        ipc_channel_t *channel = calloc(1, sizeof(ipc_channel_t));
+        if (!channel) {
+            shmdt(segment);
+            log_error("خطا در تخصیص حافظه برای کانال IPC");
+            return NULL;
+        }
+
+        // handle خارج از جدول کانال‌ها است و تنها ارجاع آن متعلق به فراخواننده است
+        // ظرفیت صف مانند ipc_create_channel_ex از اندازه سگمنت محاسبه می‌شود، نه از سرآیند مشترک
+        strncpy(channel->name, channel_name, sizeof(channel->name) - 1);
+        channel->type = (int)type;
+        channel->id = shm_id;
+        channel->key = key;
+        channel->map = segment;
+        channel->addr = segment + 1;
+        channel->size = size;
+        if (type == IPC_CHANNEL_SHM) {
+            channel->ring_capacity = (uint32_t)((size - sizeof(ipc_ring_header_t)) & ~(size_t)7);
+        }
+        channel->hash = hash;
+        channel->refcount = 1;
+        return channel;
+    }
+
+    log_error("سگمنت کانال IPC با نام %s پیدا نشد", channel_name);
+    return NULL;
+}
+
+// رها کردن handle
+void ipc_channel_close(ipc_channel_t *channel) {
+    if (channel != NULL) {
+        channel_unref(channel);
+    }
+}
+
+// نام کانال
+const char* ipc_channel_name(const ipc_channel_t *channel) {
+    return channel->name;
+}
+
+// حداکثر اندازه پیام کانال
+size_t ipc_channel_capacity(const ipc_channel_t *channel) {
+    if (channel->type == IPC_CHANNEL_BROADCAST) {
+        return ((const ipc_broadcast_header_t *)channel->addr)->capacity;
+    }
+    return channel->ring_capacity - IPC_RECORD_HEADER - 8;
+}
+
+// آیا سگمنت کانال با صفحات بزرگ پشتیبانی می‌شود
+bool ipc_channel_uses_huge_pages(const ipc_channel_t *channel) {
+    return channel->huge;
+}
+
+// دسترسی مستقیم به سگمنت برای لایه‌هایی با ساختار داده خودشان
+void* ipc_channel_map(ipc_channel_t *channel, size_t *size) {
+    if (channel->type != IPC_CHANNEL_SHM && channel->type != IPC_CHANNEL_BROADCAST) {
+        log_error("کانال %s از نوع حافظه مشترک نیست", channel->name);
+        return NULL;
+    }
+    if (size != NULL) {
+        *size = channel->size;
+    }
+    return channel->addr;
+}
+
+// کپی به حلقه با در نظر گرفتن چرخش به ابتدای ناحیه داده
+static inline void ring_copy_in(char *data, uint32_t capacity, uint32_t offset, const void *src, size_t size) {
+    size_t first = capacity - offset < size ? capacity - offset : size;
+    memcpy(data + offset, src, first);
+    if (first < size) {
+        memcpy(data, (const char *)src + first, size - first);
+    }
+}
+
+// کپی از حلقه با در نظر گرفتن چرخش به ابتدای ناحیه داده
+static inline void ring_copy_out(const char *data, uint32_t capacity, uint32_t offset, void *dst, size_t size) {
+    size_t first = capacity - offset < size ? capacity - offset : size;
+    memcpy(dst, data + offset, first);
+    if (first < size) {
+        memcpy((char *)dst + first, data, size - first);
+    }
+}
+
+// بررسی اینکه handle یک کانال صف رکورد معتبر است
+static ipc_ring_header_t* ring_header(ipc_channel_t *channel) {
+    if (channel->type != IPC_CHANNEL_SHM) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+        log_error("کانال %s از نوع حافظه مشترک نیست", channel->name);
+        return NULL;
+    }
+    return channel->addr;
+}
+
+// ارسال چند رکورد با یک انتشار اندیس و حداکثر یک بیدارباش
+int ipc_send_batch(ipc_channel_t *channel, const struct iovec *records, int count) {
+    ipc_ring_header_t *ring = ring_header(channel);
+    if (ring == NULL) {
+        return -1;
+    }
+
+    uint32_t capacity = channel->ring_capacity;
+    char *data = (char *)ring + sizeof(ipc_ring_header_t);
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    // هر دو اندیس در حافظه قابل نوشتن طرف مقابل‌اند؛ نوشتن با اندیس خراب بیرون از سگمنت می‌رود
+    if (head >= capacity || tail >= capacity || ((head | tail) & 7)) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+        log_error("اندیس‌های صف کانال %s خراب است (head=%u tail=%u)", channel->name, head, tail);
         return -1;
     }
-    
-    // بررسی نوع کانال
-    if (channel->type != 1) {
-        log_error("کانال %s از نوع حافظه مشترک نیست", channel_name);
+    uint32_t free_space = (head + capacity - tail - 8) % capacity;
+
+    int sent = 0;
+    uint64_t bytes = 0;
+    for (; sent < count; sent++) {
+        size_t size = records[sent].iov_len;
+        if (size > capacity - IPC_RECORD_HEADER - 8) {
+            if (sent == 0) {
+                __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+                log_error("رکورد بزرگتر از ظرفیت کانال %s است (%lu)", channel->name, size);
+                return -1;
+            }
+            break;
+        }
+
+        size_t space = IPC_RECORD_SPACE(size);
+        if (space > free_space) {
+            break;  // صف پر است؛ باقی رکوردها در فراخوانی بعدی
+        }
+
+        uint32_t header[2] = { (uint32_t)size, 0 };
+        memcpy(data + tail, header, sizeof(header));
+        ring_copy_in(data, capacity, (tail + IPC_RECORD_HEADER) % capacity, records[sent].iov_base, size);
+
+        tail = (tail + space) % capacity;
+        free_space -= space;
+        bytes += size;
+    }
+
+    if (sent == 0) {
+        return 0;
+    }
+
+    // یک انتشار برای کل دسته و بیدارباش فقط اگر گیرنده خوابیده باشد
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->receiver_waiting, __ATOMIC_RELAXED)) {
+        futex_wake_shared(&ring->tail, 1);
+    }
+
+    __atomic_add_fetch(&channel->stats.messages_sent, sent, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&channel->stats.bytes_sent, bytes, __ATOMIC_RELAXED);
+
+    log_debug("%d رکورد (%lu بایت) از طریق کانال %s ارسال شد", sent, bytes, channel->name);
+    return sent;
+}
+
+// دریافت تا count رکورد با یک انتشار اندیس
+int ipc_recv_batch(ipc_channel_t *channel, struct iovec *records, int count, int timeout_ms) {
+    ipc_ring_header_t *ring = ring_header(channel);
+    if (ring == NULL) {
         return -1;
     }
-    
-    // دسترسی به حافظه مشترک
-    void *shm_addr = shmat(channel->id, NULL, 0);
-    if (shm_addr == (void *) -1) {
-        log_error("خطا در اتصال به حافظه مشترک");
+
+    uint32_t capacity = channel->ring_capacity;
+    const char *data = (const char *)ring + sizeof(ipc_ring_header_t);
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    // انتظار روی futex تا رسیدن رکورد یا پایان مهلت
+    if (head == tail && timeout_ms != 0) {
+        uint64_t deadline = monotonic_time_ns() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0) * 1000000ULL;
+        while (head == tail) {
+            int64_t remaining = -1;
+            if (timeout_ms > 0) {
+                uint64_t now = monotonic_time_ns();
+                if (now >= deadline) {
+                    return 0;
+                }
+                remaining = (int64_t)(deadline - now);
+            }
+
+            __atomic_store_n(&ring->receiver_waiting, 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == tail &&
+                futex_wait_shared(&ring->tail, tail, remaining) == -1 && errno != ETIMEDOUT) {
+                __atomic_store_n(&ring->receiver_waiting, 0, __ATOMIC_RELAXED);
+                log_error("خطا در انتظار روی کانال %s", channel->name);
+                return -1;
+            }
+            __atomic_store_n(&ring->receiver_waiting, 0, __ATOMIC_RELAXED);
+            tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    // head و tail و طول رکوردها در حافظه قابل نوشتن طرف مقابل‌اند و پیش از استفاده بررسی می‌شوند
+    if (head >= capacity || tail >= capacity || ((head | tail) & 7)) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+        log_error("اندیس‌های صف کانال %s خراب است (head=%u tail=%u)", channel->name, head, tail);
         return -1;
     }
-    
-    // کپی داده به حافظه مشترک
-    if (data_size > 4096) {
-        data_size = 4096;  // محدود کردن اندازه داده
-    }
-    
-    // ساختار داده: 4 بایت اول اندازه و بقیه داده اصلی
-    *((uint32_t *)shm_addr) = data_size;
-    memcpy((char *)shm_addr + 4, data, data_size);
-    
-    // جدا شدن از حافظه مشترک
-    shmdt(shm_addr);
-    
-    log_message("%lu بایت داده از طریق کانال %s ارسال شد", data_size, channel_name);
-    return 0;
+
+    int received = 0;
+    uint64_t bytes = 0;
+    while (received < count && head != tail) {
+        uint32_t header[2];
+        memcpy(header, data + head, sizeof(header));
+        size_t size = header[0];
+
+        uint32_t available = (tail + capacity - head) % capacity;
+        if (size > capacity - IPC_RECORD_HEADER - 8 || IPC_RECORD_SPACE(size) > available) {
+            __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+            log_error("طول رکورد نامعتبر در کانال %s (%lu، %u بایت در صف)", channel->name, size, available);
+            if (received == 0) {
+                return -1;
+            }
+            break;
+        }
+
+        if (size > records[received].iov_len) {
+            if (received == 0) {
+                __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+                log_error("بافر کوچکتر از داده است (%lu > %lu)", size, records[received].iov_len);
+                return -1;
+            }
+            break;  // این رکورد در صف می‌ماند
+        }
+
+        ring_copy_out(data, capacity, (head + IPC_RECORD_HEADER) % capacity, records[received].iov_base, size);
+        records[received].iov_len = size;
+
+        head = (head + IPC_RECORD_SPACE(size)) % capacity;
+        bytes += size;
+        received++;
+    }
+
+    if (received == 0) {
+        return 0;
+    }
+
+    __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&channel->stats.messages_received, received, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&channel->stats.bytes_received, bytes, __ATOMIC_RELAXED);
+
+    log_debug("%d رکورد (%lu بایت) از طریق کانال %s دریافت شد", received, bytes, channel->name);
+    return received;
 }
 
-// دریافت پیام از کانتینر دیگر
-int ipc_receive_message(const char *channel_name, void *buffer, size_t buffer_size) {
-    // بررسی وجود کانال
-    ipc_channel_t *channel = find_channel(channel_name);
-    if (channel == NULL) {
-        log_error("کانال IPC با نام %s پیدا نشد", channel_name);
+// ارسال پیام از طریق handle
+int ipc_channel_send(ipc_channel_t *channel, const void *data, size_t data_size) {
+    if (channel->type == IPC_CHANNEL_SHM && data_size > ipc_channel_capacity(channel)) {
+        data_size = ipc_channel_capacity(channel);  // محدود کردن اندازه داده
+    }
+
+    struct iovec record = { (void *)data, data_size };
+    int sent = ipc_send_batch(channel, &record, 1);
+    if (sent == 0) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+        log_error("صف کانال %s پر است", channel->name);
         return -1;
     }
-    
-    // بررسی نوع کانال
-    if (channel->type != 1) {
-        log_error("کانال %s از نوع حافظه مشترک نیست", channel_name);
+    return sent < 0 ? -1 : 0;
+}
+
+// دریافت پیام از طریق handle؛ در صف خالی 0 برمی‌گرداند
+int ipc_channel_receive(ipc_channel_t *channel, void *buffer, size_t buffer_size) {
+    struct iovec record = { buffer, buffer_size };
+    int received = ipc_recv_batch(channel, &record, 1, 0);
+    if (received <= 0) {
+        return received;
+    }
+    return (int)record.iov_len;
+}
+
+// بررسی اینکه handle یک کانال broadcast معتبر است
+static ipc_broadcast_header_t* broadcast_header(ipc_channel_t *channel) {
+    if (channel->type != IPC_CHANNEL_BROADCAST) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+        log_error("کانال %s از نوع broadcast نیست", channel->name);
+        return NULL;
+    }
+    return channel->addr;
+}
+
+// seq فرد مانده از نویسنده‌ای است که بدون پایان انتشار از بین رفته: قفل آزاد است یا هسته آن را برای
+// مالک مرده علامت زده است. خواننده قفل را فقط برای همین بررسی کوتاه می‌گیرد
+static bool writer_abandoned(ipc_broadcast_header_t *header) {
+    int result = pthread_mutex_trylock(&header->writer_lock);
+    if (result == EOWNERDEAD) {
+        pthread_mutex_consistent(&header->writer_lock);
+    } else if (result != 0) {
+        return result == ENOTRECOVERABLE;
+    }
+    bool abandoned = __atomic_load_n(&header->seq, __ATOMIC_ACQUIRE) & 1;
+    pthread_mutex_unlock(&header->writer_lock);
+    return abandoned;
+}
+
+// انتشار snapshot جدید؛ خواننده‌ها هرگز نویسنده را متوقف نمی‌کنند
+int ipc_broadcast_publish(ipc_channel_t *channel, const void *data, size_t data_size) {
+    ipc_broadcast_header_t *header = broadcast_header(channel);
+    if (header == NULL) {
         return -1;
     }
-    
-    // دسترسی به حافظه مشترک
-    void *shm_addr = shmat(channel->id, NULL, SHM_RDONLY);
-    if (shm_addr == (void *) -1) {
-        log_error("خطا در اتصال به حافظه مشترک");
+
+    if (data_size > header->capacity) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+        log_error("داده بزرگتر از ظرفیت کانال broadcast است (%lu > %u)", data_size, header->capacity);
         return -1;
     }
-    
-    // خواندن اندازه داده
-    uint32_t data_size = *((uint32_t *)shm_addr);
-    
-    // بررسی اندازه بافر
+
+    // گرفتن قفل نویسنده؛ قفل گرفته‌شده با seq زوج فقط بررسی کوتاه یک خواننده است، اما seq فرد یعنی
+    // نویسنده دیگری همزمان در حال نوشتن است
+    for (;;) {
+        int result = pthread_mutex_trylock(&header->writer_lock);
+        if (result == 0) {
+            break;
+        }
+        if (result == EOWNERDEAD) {
+            pthread_mutex_consistent(&header->writer_lock);
+            break;
+        }
+        if (result != EBUSY || (__atomic_load_n(&header->seq, __ATOMIC_RELAXED) & 1)) {
+            __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+            log_error("کانال broadcast %s فقط یک نویسنده همزمان می‌پذیرد", channel->name);
+            return -1;
+        }
+        cpu_relax();
+    }
+
+    // seq فرد مانده از نویسنده مرده فرد می‌ماند تا خواننده‌ها نسخه نیمه‌کاره را هرگز نپذیرند
+    uint32_t seq = __atomic_load_n(&header->seq, __ATOMIC_RELAXED);
+    uint32_t locked = seq | 1;
+    __atomic_store_n(&header->seq, locked, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(header->data, data, data_size);
+    __atomic_store_n(&header->size, (uint32_t)data_size, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->version, header->version + 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&header->seq, locked + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&header->writer_lock);
+
+    // بیدار کردن خواننده‌های منتظر فقط در صورت وجود؛ خواننده‌های polling هزینه‌ای ندارند
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->waiters, __ATOMIC_RELAXED) > 0) {
+        futex_wake_shared(&header->seq, INT_MAX);
+    }
+
+    __atomic_add_fetch(&channel->stats.messages_sent, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&channel->stats.bytes_sent, data_size, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// خواندن آخرین snapshot بدون قفل
+int ipc_broadcast_read(ipc_channel_t *channel, void *buffer, size_t buffer_size, uint64_t *version) {
+    ipc_broadcast_header_t *header = broadcast_header(channel);
+    if (header == NULL) {
+        return -1;
+    }
+
+    uint32_t seq_begin, seq_end, data_size;
+    uint64_t snapshot_version;
+    uint32_t spins = 0;
+    do {
+        seq_begin = __atomic_load_n(&header->seq, __ATOMIC_ACQUIRE);
+        if (seq_begin & 1) {
+            // نویسنده‌ای که وسط نوشتن مرده seq را برای همیشه فرد می‌گذارد؛ انتشار طولانی منتظر می‌ماند
+            if (++spins % IPC_BROADCAST_SPIN_CHECK == 0 && writer_abandoned(header)) {
+                __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
+                log_error("نویسنده کانال broadcast %s در میانه انتشار متوقف شده است", channel->name);
+                return -1;
+            }
+            cpu_relax();
+            continue;
+        }
+
+        data_size = __atomic_load_n(&header->size, __ATOMIC_RELAXED);
+        snapshot_version = __atomic_load_n(&header->version, __ATOMIC_RELAXED);
+        if (data_size > header->capacity) {
+            data_size = header->capacity;  // مقدار ناقص؛ در بررسی seq رد می‌شود
+        }
+        if (data_size <= buffer_size) {
+            memcpy(buffer, header->data, data_size);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_end = __atomic_load_n(&header->seq, __ATOMIC_RELAXED);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+
     if (data_size > buffer_size) {
+        __atomic_add_fetch(&channel->stats.errors, 1, __ATOMIC_RELAXED);
         log_error("بافر کوچکتر از داده است (%u > %lu)", data_size, buffer_size);
-        shmdt(shm_addr);
         return -1;
     }
-    
-    // کپی داده از حافظه مشترک
-    memcpy(buffer, (char *)shm_addr + 4, data_size);
-    
-    // جدا شدن از حافظه مشترک
-    shmdt(shm_addr);
-    
-    log_message("%u بایت داده از طریق کانال %s دریافت شد", data_size, channel_name);
+
+    if (version != NULL) {
+        *version = snapshot_version;
+    }
+
+    __atomic_add_fetch(&channel->stats.messages_received, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&channel->stats.bytes_received, data_size, __ATOMIC_RELAXED);
     return data_size;
-}
\ No newline at end of file
+}
+
+// انتظار برای نسخه‌ای جدیدتر از last_version
+int ipc_broadcast_wait(ipc_channel_t *channel, uint64_t last_version, int timeout_ms) {
+    ipc_broadcast_header_t *header = broadcast_header(channel);
+    if (header == NULL) {
+        return -1;
+    }
+
+    uint64_t deadline = monotonic_time_ns() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0) * 1000000ULL;
+
+    int result = 0;
+    __atomic_add_fetch(&header->waiters, 1, __ATOMIC_SEQ_CST);
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&header->seq, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&header->version, __ATOMIC_ACQUIRE) != last_version) {
+            break;
+        }
+
+        int64_t remaining = -1;
+        if (timeout_ms >= 0) {
+            uint64_t now = monotonic_time_ns();
+            if (now >= deadline) {
+                result = 1;  // پایان مهلت
+                break;
+            }
+            remaining = (int64_t)(deadline - now);
+        }
+
+        if (futex_wait_shared(&header->seq, seq, remaining) == -1 && errno != ETIMEDOUT) {
+            log_error("خطا در انتظار روی کانال broadcast %s", channel->name);
+            result = -1;
+            break;
+        }
+    }
+    __atomic_sub_fetch(&header->waiters, 1, __ATOMIC_SEQ_CST);
+
+    return result;
+}
+
+// دریافت آمار کانال
+int ipc_channel_get_stats(const ipc_channel_t *channel, ipc_channel_stats_t *stats) {
+    stats->messages_sent = __atomic_load_n(&channel->stats.messages_sent, __ATOMIC_RELAXED);
+    stats->messages_received = __atomic_load_n(&channel->stats.messages_received, __ATOMIC_RELAXED);
+    stats->bytes_sent = __atomic_load_n(&channel->stats.bytes_sent, __ATOMIC_RELAXED);
+    stats->bytes_received = __atomic_load_n(&channel->stats.bytes_received, __ATOMIC_RELAXED);
+    stats->errors = __atomic_load_n(&channel->stats.errors, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// ارسال پیام بین کانتینرها
+int ipc_send_message(const char *channel_name, const void *data, size_t data_size) {
+    ipc_channel_t *channel = ipc_channel_open(channel_name);
+    if (channel == NULL) {
+        return -1;
+    }
+
+    int result = ipc_channel_send(channel, data, data_size);
+    ipc_channel_close(channel);
+    return result;
+}
+
+// دریافت پیام از کانتینر دیگر
+int ipc_receive_message(const char *channel_name, void *buffer, size_t buffer_size) {
+    ipc_channel_t *channel = ipc_channel_open(channel_name);
+    if (channel == NULL) {
+        return -1;
+    }
+
+    int result = ipc_channel_receive(channel, buffer, buffer_size);
+    ipc_channel_close(channel);
+    return result;
+}
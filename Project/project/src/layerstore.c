@@ -0,0 +1,874 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+#include "../include/layerstore.h"
+#include "../include/unpack.h"
+#include "../include/digest.h"
+#include "../include/copy.h"
+#include "../include/utils.h"
+
+// دایرکتوری اشیای مشترک: هر محتوای یکتا یک بار ذخیره می‌شود و لایه‌ها به آن hardlink دارند
+#define LAYER_OBJECTS_PATH LAYER_STORE_PATH "/objects"
+
+// دایرکتوری واردسازی‌های در حال انجام
+#define LAYER_TMP_PATH LAYER_STORE_PATH "/tmp"
+
+// دایرکتوری لایه‌هایی که برای حذف کنار گذاشته شده‌اند
+#define LAYER_TRASH_PATH LAYER_STORE_PATH "/trash"
+
+// وضعیت thread پس‌زمینه GC
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool running;               // thread ساخته شده و هنوز join نشده است
+    bool stop_requested;
+    unsigned interval_seconds;
+} gc_state = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, false, false, 0 };
+
+// شمارنده برای نام‌های یکتا در trash
+static unsigned trash_counter = 0;
+
+// آمار یک واردسازی
+typedef struct {
+    char dst[PATH_MAX];
+    size_t files;
+    size_t deduplicated;
+} import_context_t;
+
+// یک ورودی درخت لایه
+typedef struct {
+    char *path;
+    struct stat st;
+} tree_entry_t;
+
+// فهرست مرتب ورودی‌های درخت لایه و هش فایل‌های معمولی آن
+typedef struct {
+    tree_entry_t *entries;
+    size_t count;
+    size_t capacity;
+    size_t root_length;
+    uint8_t (*digests)[SHA256_DIGEST_SIZE];
+} layer_tree_t;
+
+// بررسی لایه‌ها پیش از استفاده در کانتینر
+static bool verify_on_use = false;
+
+// بررسی قالب digest (مانند sha256:<hex>)
+bool layer_digest_valid(const char *digest) {
+    const char *colon = strchr(digest, ':');
+    if (colon == NULL || colon == digest || colon - digest > 16) {
+        return false;
+    }
+
+    for (const char *p = digest; p < colon; p++) {
+        if (!((*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9'))) {
+            return false;
+        }
+    }
+
+    size_t hex_length = strlen(colon + 1);
+    if (hex_length < 32 || hex_length > 128) {
+        return false;
+    }
+    for (const char *p = colon + 1; *p; p++) {
+        if (!((*p >= 'a' && *p <= 'f') || (*p >= '0' && *p <= '9'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// مسیر دایرکتوری لایه: layers/<algo>/<hex>
+static int layer_dir(const char *digest, char *buffer, size_t buffer_size) {
+    if (!layer_digest_valid(digest)) {
+        log_error("digest لایه نامعتبر است: %s", digest);
+        return -1;
+    }
+
+    const char *colon = strchr(digest, ':');
+    int ret = snprintf(buffer, buffer_size, "%s/%.*s/%s", LAYER_STORE_PATH,
+                       (int)(colon - digest), digest, colon + 1);
+    return ret >= (int)buffer_size ? -1 : 0;
+}
+
+// مسیر یک فایل داخل دایرکتوری لایه
+static int layer_file(const char *digest, const char *name, char *buffer, size_t buffer_size) {
+    char dir[PATH_MAX];
+    if (layer_dir(digest, dir, sizeof(dir)) != 0) {
+        return -1;
+    }
+    int ret = snprintf(buffer, buffer_size, "%s/%s", dir, name);
+    return ret >= (int)buffer_size ? -1 : 0;
+}
+
+// راه‌اندازی دایرکتوری‌های انبار لایه
+int layer_store_init() {
+    if (create_directory(LAYER_STORE_PATH, 0755) != 0 ||
+        create_directory(LAYER_OBJECTS_PATH, 0700) != 0 ||
+        create_directory(LAYER_TMP_PATH, 0700) != 0 ||
+        create_directory(LAYER_TRASH_PATH, 0700) != 0) {
+        log_error("خطا در ایجاد دایرکتوری‌های انبار لایه");
+        return -1;
+    }
+    return 0;
+}
+
+// بررسی وجود لایه در انبار
+bool layer_store_has(const char *digest) {
+    char path[PATH_MAX];
+    if (layer_store_path(digest, path, sizeof(path)) != 0) {
+        return false;
+    }
+    return directory_exists(path);
+}
+
+// مسیر فایل‌سیستم باز شده یک لایه
+int layer_store_path(const char *digest, char *buffer, size_t buffer_size) {
+    return layer_file(digest, "fs", buffer, buffer_size);
+}
+
+// مقایسه نام‌ها بدون وابستگی به locale تا ترتیب پیمایش و digest درخت همه‌جا یکسان باشد
+static int compare_names(const struct dirent **a, const struct dirent **b) {
+    return strcmp((*a)->d_name, (*b)->d_name);
+}
+
+static int skip_dots(const struct dirent *entry) {
+    return strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0;
+}
+
+// افزودن مسیرهای زیر path به فهرست به ترتیب پیش‌ترتیب مرتب‌شده
+static int collect_tree(layer_tree_t *tree, char *path, size_t path_size) {
+    struct dirent **names;
+    int count = scandir(path, &names, skip_dots, compare_names);
+    if (count < 0) {
+        log_error("خطا در باز کردن دایرکتوری: %s", path);
+        return -1;
+    }
+
+    size_t length = strlen(path);
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        size_t name_length = strlen(names[i]->d_name);
+        if (result != 0 || length + name_length + 2 > path_size) {
+            result = -1;
+            free(names[i]);
+            continue;
+        }
+        path[length] = '/';
+        memcpy(path + length + 1, names[i]->d_name, name_length + 1);
+        free(names[i]);
+
+        if (tree->count == tree->capacity) {
+            size_t capacity = tree->capacity ? tree->capacity * 2 : 256;
+            tree_entry_t *entries = realloc(tree->entries, capacity * sizeof(tree_entry_t));
+            if (!entries) {
+                result = -1;
+                continue;
+            }
+            tree->entries = entries;
+            tree->capacity = capacity;
+        }
+
+        tree_entry_t *entry = &tree->entries[tree->count];
+        if (lstat(path, &entry->st) != 0 || (entry->path = strdup(path)) == NULL) {
+            log_error("خطا در خواندن مشخصات %s", path);
+            result = -1;
+        } else {
+            tree->count++;
+            if (S_ISDIR(entry->st.st_mode)) {
+                result = collect_tree(tree, path, path_size);
+            }
+        }
+        path[length] = '\0';
+    }
+
+    free(names);
+    return result;
+}
+
+static void free_tree(layer_tree_t *tree) {
+    for (size_t i = 0; i < tree->count; i++) {
+        free(tree->entries[i].path);
+    }
+    free(tree->entries);
+    free(tree->digests);
+}
+
+// پیمایش درخت لایه و هش موازی همه فایل‌های معمولی
+static int scan_tree(const char *root, layer_tree_t *tree) {
+    memset(tree, 0, sizeof(*tree));
+    tree->root_length = strlen(root);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s", root);
+    if (collect_tree(tree, path, sizeof(path)) != 0) {
+        free_tree(tree);
+        return -1;
+    }
+
+    const char **paths = malloc((tree->count + 1) * sizeof(char *));
+    size_t *indexes = malloc((tree->count + 1) * sizeof(size_t));
+    uint8_t (*digests)[SHA256_DIGEST_SIZE] = malloc((tree->count + 1) * SHA256_DIGEST_SIZE);
+    tree->digests = calloc(tree->count + 1, SHA256_DIGEST_SIZE);
+    if (!paths || !indexes || !digests || !tree->digests) {
+        free(paths);
+        free(indexes);
+        free(digests);
+        free_tree(tree);
+        return -1;
+    }
+
+    int files = 0;
+    for (size_t i = 0; i < tree->count; i++) {
+        if (S_ISREG(tree->entries[i].st.st_mode)) {
+            paths[files] = tree->entries[i].path;
+            indexes[files] = i;
+            files++;
+        }
+    }
+
+    int result = digest_files(paths, files, digests, 0);
+    for (int i = 0; result == 0 && i < files; i++) {
+        memcpy(tree->digests[indexes[i]], digests[i], SHA256_DIGEST_SIZE);
+    }
+
+    free(paths);
+    free(indexes);
+    free(digests);
+    if (result != 0) {
+        free_tree(tree);
+    }
+    return result;
+}
+
+// digest درخت: مسیر نسبی، نوع و مجوز، مالکیت، اندازه و هش محتوا یا مقصد پیوند هر ورودی
+// زمان‌ها و تعداد پیوندها شامل نمی‌شوند چون اشتراک فایل‌ها آن‌ها را تغییر می‌دهد
+static int tree_digest(const layer_tree_t *tree, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    sha256_ctx_t sha;
+    sha256_init(&sha);
+
+    for (size_t i = 0; i < tree->count; i++) {
+        const tree_entry_t *entry = &tree->entries[i];
+        const char *relative = entry->path + tree->root_length + 1;
+        char fields[128];
+        int length = snprintf(fields, sizeof(fields), "%o %u %u %ld %lx",
+                              entry->st.st_mode, entry->st.st_uid, entry->st.st_gid,
+                              S_ISREG(entry->st.st_mode) ? (long)entry->st.st_size : 0L,
+                              S_ISCHR(entry->st.st_mode) || S_ISBLK(entry->st.st_mode)
+                                  ? (unsigned long)entry->st.st_rdev : 0UL);
+        sha256_update(&sha, relative, strlen(relative) + 1);
+        sha256_update(&sha, fields, length + 1);
+
+        if (S_ISREG(entry->st.st_mode)) {
+            sha256_update(&sha, tree->digests[i], SHA256_DIGEST_SIZE);
+        } else if (S_ISLNK(entry->st.st_mode)) {
+            char target[PATH_MAX];
+            ssize_t target_length = readlink(entry->path, target, sizeof(target));
+            if (target_length < 0) {
+                log_error("خطا در خواندن پیوند %s", entry->path);
+                return -1;
+            }
+            sha256_update(&sha, target, target_length);
+        }
+    }
+
+    sha256_final(&sha, digest);
+    return 0;
+}
+
+// مسیر شیء مشترک برای محتوای فایل؛ مجوز و مالکیت در نام هستند چون hardlink ها inode مشترک دارند
+static void object_path(const uint8_t digest[SHA256_DIGEST_SIZE], const struct stat *st,
+                        char *object, size_t object_size) {
+    char hex[DIGEST_STRING_MAX];
+    digest_format(digest, hex, sizeof(hex));
+    snprintf(object, object_size, "%s/%s-%o-%u-%u", LAYER_OBJECTS_PATH,
+             hex + strlen("sha256:"), st->st_mode & 07777, st->st_uid, st->st_gid);
+}
+
+// جایگزینی فایل باز شده در محل با شیء مشترک، یا ثبت آن به عنوان شیء جدید
+// نام شیء هش SHA-256 محتواست و نیازی به مقایسه بایتی نیست
+static void share_file(import_context_t *ctx, const char *path, const struct stat *st,
+                       const uint8_t digest[SHA256_DIGEST_SIZE]) {
+    char object[PATH_MAX];
+    object_path(digest, st, object, sizeof(object));
+    ctx->files++;
+
+    struct stat object_st;
+    if (lstat(object, &object_st) == 0) {
+        if (object_st.st_ino == st->st_ino && object_st.st_dev == st->st_dev) {
+            return;
+        }
+        // جایگزینی اتمیک تا فایل هیچ لحظه‌ای ناپدید نشود
+        char tmp_path[PATH_MAX + 8];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.dedup", path);
+        if (link(object, tmp_path) == 0) {
+            if (rename(tmp_path, path) == 0) {
+                ctx->deduplicated++;
+                return;
+            }
+            unlink(tmp_path);
+        }
+        return;
+    }
+
+    // EEXIST یعنی واردسازی همزمان و فقط از اشتراک صرف‌نظر می‌شود
+    link(path, object);
+}
+
+// اشتراک فایل‌های یکسان و محاسبه digest درخت در یک پیمایش؛ هش فایل‌ها موازی انجام می‌شود
+static int share_tree(import_context_t *ctx, uint8_t tree_hash[SHA256_DIGEST_SIZE]) {
+    struct stat root_st;
+    if (stat(ctx->dst, &root_st) != 0) {
+        return -1;
+    }
+
+    layer_tree_t tree;
+    if (scan_tree(ctx->dst, &tree) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < tree.count; i++) {
+        const tree_entry_t *entry = &tree.entries[i];
+        if (S_ISREG(entry->st.st_mode) && entry->st.st_nlink == 1) {
+            share_file(ctx, entry->path, &entry->st, tree.digests[i]);
+        }
+    }
+
+    // زمان دایرکتوری‌ها با جایگزینی فایل‌ها تغییر می‌کند و بازگردانده می‌شود
+    for (size_t i = 0; i < tree.count; i++) {
+        const tree_entry_t *entry = &tree.entries[i];
+        if (S_ISDIR(entry->st.st_mode)) {
+            struct timespec times[2] = { entry->st.st_atim, entry->st.st_mtim };
+            utimensat(AT_FDCWD, entry->path, times, AT_SYMLINK_NOFOLLOW);
+        }
+    }
+    struct timespec times[2] = { root_st.st_atim, root_st.st_mtim };
+    utimensat(AT_FDCWD, ctx->dst, times, 0);
+
+    int result = tree_digest(&tree, tree_hash);
+    free_tree(&tree);
+    return result;
+}
+
+// نوشتن مقدار شمارنده در فایل refs (زمان تغییر فایل، زمان آخرین استفاده است)
+static int write_refcount(int fd, long count) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "%ld\n", count);
+    if (ftruncate(fd, 0) != 0 || pwrite(fd, buffer, length, 0) != length) {
+        return -1;
+    }
+    return 0;
+}
+
+// خواندن مقدار شمارنده از فایل refs
+static long read_refcount(int fd) {
+    char buffer[32];
+    ssize_t n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0) {
+        return 0;
+    }
+    buffer[n] = '\0';
+    return strtol(buffer, NULL, 10);
+}
+
+// آماده‌سازی واردسازی: دایرکتوری موقت با زیرشاخه fs
+// خروجی: 0 = آماده، 1 = لایه از قبل وجود دارد، -1 = خطا
+static int import_begin(const char *digest, char *final_dir, size_t final_dir_size,
+                        char *tmp_dir, size_t tmp_dir_size, import_context_t **ctx) {
+    if (layer_dir(digest, final_dir, final_dir_size) != 0) {
+        return -1;
+    }
+
+    if (layer_store_has(digest)) {
+        return 1;  // لایه فقط یک بار باز می‌شود
+    }
+
+    if (layer_store_init() != 0) {
+        return -1;
+    }
+
+    // واردسازی در دایرکتوری موقت و انتقال اتمیک به مسیر نهایی
+    snprintf(tmp_dir, tmp_dir_size, "%s/import.XXXXXX", LAYER_TMP_PATH);
+    if (mkdtemp(tmp_dir) == NULL) {
+        log_error("خطا در ایجاد دایرکتوری موقت واردسازی");
+        return -1;
+    }
+
+    *ctx = calloc(1, sizeof(import_context_t));
+    if (!*ctx) {
+        rmdir(tmp_dir);
+        return -1;
+    }
+    snprintf((*ctx)->dst, sizeof((*ctx)->dst), "%s/fs", tmp_dir);
+    if (mkdir((*ctx)->dst, 0755) != 0) {
+        log_error("خطا در ایجاد دایرکتوری %s", (*ctx)->dst);
+        free(*ctx);
+        rmdir(tmp_dir);
+        return -1;
+    }
+    return 0;
+}
+
+// پایان واردسازی: ایجاد فایل refs و انتقال به مسیر نهایی، یا پاک‌سازی در صورت خطا
+static int import_finish(const char *digest, const char *final_dir, const char *tmp_dir,
+                         import_context_t *ctx, const uint8_t tree_hash[SHA256_DIGEST_SIZE], int result) {
+    if (result == 0) {
+        result = -1;
+        char refs_path[PATH_MAX];
+        snprintf(refs_path, sizeof(refs_path), "%s/refs", tmp_dir);
+        int fd = open(refs_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd != -1 && write_refcount(fd, 0) == 0) {
+            result = 0;
+        }
+        if (fd != -1) close(fd);
+    }
+
+    if (result == 0) {
+        // digest درخت برای بررسی‌های بعدی لایه بدون نیاز به آرشیو اصلی
+        result = -1;
+        char verify_path[PATH_MAX], verify[DIGEST_STRING_MAX + 1];
+        snprintf(verify_path, sizeof(verify_path), "%s/verify", tmp_dir);
+        digest_format(tree_hash, verify, DIGEST_STRING_MAX);
+        strcat(verify, "\n");
+        int fd = open(verify_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd != -1 && write(fd, verify, strlen(verify)) == (ssize_t)strlen(verify)) {
+            result = 0;
+        }
+        if (fd != -1) close(fd);
+    }
+
+    if (result == 0) {
+        // ایجاد دایرکتوری الگوریتم (مثلاً layers/sha256)
+        char algo_dir[PATH_MAX];
+        strncpy(algo_dir, final_dir, sizeof(algo_dir) - 1);
+        algo_dir[sizeof(algo_dir) - 1] = '\0';
+        *strrchr(algo_dir, '/') = '\0';
+        create_directory(algo_dir, 0755);
+
+        if (rename(tmp_dir, final_dir) != 0) {
+            if (errno == EEXIST || errno == ENOTEMPTY) {
+                // واردسازی همزمان دیگری زودتر تمام شده است
+                remove_directory(tmp_dir);
+            } else {
+                log_error("خطا در انتقال لایه %s به انبار", digest);
+                result = -1;
+            }
+        }
+    }
+
+    if (result != 0) {
+        remove_directory(tmp_dir);
+    } else {
+        log_message("لایه %s وارد شد: %lu فایل، %lu فایل مشترک با لایه‌های دیگر",
+                    digest, ctx->files, ctx->deduplicated);
+    }
+
+    free(ctx);
+    return result;
+}
+
+// وارد کردن یک دایرکتوری باز شده به عنوان لایه
+int layer_store_import_dir(const char *digest, const char *source_dir) {
+    struct stat root_st;
+    if (stat(source_dir, &root_st) != 0 || !S_ISDIR(root_st.st_mode)) {
+        log_error("دایرکتوری لایه یافت نشد: %s", source_dir);
+        return -1;
+    }
+
+    char final_dir[PATH_MAX], tmp_dir[256];
+    import_context_t *ctx;
+    int begun = import_begin(digest, final_dir, sizeof(final_dir), tmp_dir, sizeof(tmp_dir), &ctx);
+    if (begun != 0) {
+        return begun > 0 ? 0 : -1;
+    }
+
+    // کپی موازی با حفظ مشخصات و سپس اشتراک فایل‌های یکسان، مانند واردسازی از tar
+    uint8_t tree_hash[SHA256_DIGEST_SIZE];
+    int result = copy_tree(source_dir, ctx->dst, 0, NULL);
+    if (result == 0) {
+        result = share_tree(ctx, tree_hash);
+    }
+
+    return import_finish(digest, final_dir, tmp_dir, ctx, tree_hash, result);
+}
+
+// وارد کردن آرشیو tar لایه: باز کردن جریانی همراه با بررسی digest و سپس اشتراک فایل‌های یکسان
+int layer_store_import_tar(const char *digest, const char *archive_path) {
+    uint8_t expected[SHA256_DIGEST_SIZE];
+    if (digest_parse(digest, expected) != 0) {
+        log_error("فقط لایه‌های sha256 از آرشیو وارد می‌شوند: %s", digest);
+        return -1;
+    }
+
+    char final_dir[PATH_MAX], tmp_dir[256];
+    import_context_t *ctx;
+    int begun = import_begin(digest, final_dir, sizeof(final_dir), tmp_dir, sizeof(tmp_dir), &ctx);
+    if (begun != 0) {
+        return begun > 0 ? 0 : -1;
+    }
+
+    unpack_options_t options;
+    unpack_default_options(&options);
+    options.expected_digest = digest;
+
+    unpack_stats_t stats;
+    uint8_t tree_hash[SHA256_DIGEST_SIZE];
+    int result = unpack_tar(archive_path, ctx->dst, &options, &stats);
+    if (result == 0) {
+        result = share_tree(ctx, tree_hash);
+    } else {
+        log_error("خطا در باز کردن آرشیو لایه %s", archive_path);
+    }
+
+    return import_finish(digest, final_dir, tmp_dir, ctx, tree_hash, result);
+}
+
+// بررسی محتوای لایه با digest درخت ثبت‌شده در زمان واردسازی
+int layer_store_verify(const char *digest) {
+    char path[PATH_MAX], recorded[DIGEST_STRING_MAX + 1];
+    uint8_t expected[SHA256_DIGEST_SIZE], actual[SHA256_DIGEST_SIZE];
+
+    if (layer_file(digest, "verify", path, sizeof(path)) != 0) {
+        return -1;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    ssize_t n = fd != -1 ? read(fd, recorded, sizeof(recorded) - 1) : -1;
+    if (fd != -1) close(fd);
+    if (n <= 0) {
+        log_error("رکورد بررسی لایه %s یافت نشد", digest);
+        return -1;
+    }
+    recorded[n] = '\0';
+    recorded[strcspn(recorded, "\n")] = '\0';
+    if (digest_parse(recorded, expected) != 0) {
+        log_error("رکورد بررسی لایه %s نامعتبر است", digest);
+        return -1;
+    }
+
+    layer_tree_t tree;
+    uint64_t start = monotonic_time_ns();
+    if (layer_store_path(digest, path, sizeof(path)) != 0 || scan_tree(path, &tree) != 0) {
+        return -1;
+    }
+    int result = tree_digest(&tree, actual);
+    free_tree(&tree);
+
+    if (result == 0 && memcmp(expected, actual, SHA256_DIGEST_SIZE) != 0) {
+        log_error("محتوای لایه %s با digest ثبت‌شده مطابقت ندارد", digest);
+        result = -1;
+    }
+    log_debug("بررسی لایه %s در %.2f ثانیه", digest, (monotonic_time_ns() - start) / 1e9);
+    return result;
+}
+
+// فعال کردن بررسی لایه‌ها پیش از استفاده در کانتینر
+void layer_store_set_verify(bool enabled) {
+    verify_on_use = enabled;
+}
+
+bool layer_store_verify_enabled() {
+    return verify_on_use;
+}
+
+// تغییر شمارنده ارجاع زیر قفل فایل
+// باز کردن و قفل کردن فایل refs
+// اگر پیش از گرفتن قفل، لایه به trash منتقل یا دوباره وارد شده باشد، فایل باز شده دیگر فایل مسیر
+// نیست و دوباره امتحان می‌شود. -1 وقتی لایه دیگر در انبار نیست
+static int lock_refs(const char *refs_path) {
+    for (;;) {
+        int fd = open(refs_path, O_RDWR | O_CLOEXEC);
+        if (fd == -1) {
+            return -1;
+        }
+
+        flock(fd, LOCK_EX);
+        struct stat opened, current;
+        if (fstat(fd, &opened) == 0 && stat(refs_path, &current) == 0 &&
+            opened.st_dev == current.st_dev && opened.st_ino == current.st_ino) {
+            return fd;
+        }
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+}
+
+static int update_refcount(const char *digest, int delta) {
+    char refs_path[PATH_MAX];
+    if (layer_file(digest, "refs", refs_path, sizeof(refs_path)) != 0) {
+        return -1;
+    }
+
+    int fd = lock_refs(refs_path);
+    if (fd == -1) {
+        log_error("لایه %s در انبار وجود ندارد", digest);
+        return -1;
+    }
+
+    long count = read_refcount(fd) + delta;
+    if (count < 0) {
+        count = 0;
+    }
+    if (delta != 0 && write_refcount(fd, count) != 0) {
+        log_error("خطا در به‌روزرسانی شمارنده ارجاع لایه %s", digest);
+        count = -1;
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+
+    return (int)count;
+}
+
+// افزایش شمارنده ارجاع
+int layer_store_ref(const char *digest) {
+    return update_refcount(digest, 1) < 0 ? -1 : 0;
+}
+
+// کاهش شمارنده ارجاع؛ حذف واقعی به GC سپرده می‌شود
+int layer_store_unref(const char *digest) {
+    return update_refcount(digest, -1) < 0 ? -1 : 0;
+}
+
+// مقدار شمارنده ارجاع
+int layer_store_refcount(const char *digest) {
+    return update_refcount(digest, 0);
+}
+
+// آیا توقف GC درخواست شده است
+static bool gc_should_stop() {
+    return __atomic_load_n(&gc_state.stop_requested, __ATOMIC_RELAXED);
+}
+
+// انتقال دایرکتوری به trash؛ پس از آن حذف کند بدون نگه داشتن قفل انجام می‌شود
+static int move_to_trash(const char *path, const char *name, char *trash_path, size_t trash_path_size) {
+    snprintf(trash_path, trash_path_size, "%s/%s.%d.%u", LAYER_TRASH_PATH, name, getpid(),
+             __atomic_add_fetch(&trash_counter, 1, __ATOMIC_RELAXED));
+    return rename(path, trash_path);
+}
+
+// حذف لایه‌های بدون ارجاعی که مهلت نگهداری آن‌ها گذشته است
+static int gc_layers(time_t now) {
+    DIR *store = opendir(LAYER_STORE_PATH);
+    if (!store) {
+        return 0;
+    }
+
+    int removed = 0;
+    struct dirent *algo;
+    while (!gc_should_stop() && (algo = readdir(store)) != NULL) {
+        if (algo->d_name[0] == '.' || strcmp(algo->d_name, "objects") == 0 ||
+            strcmp(algo->d_name, "tmp") == 0 || strcmp(algo->d_name, "trash") == 0) {
+            continue;
+        }
+
+        char algo_dir[PATH_MAX];
+        snprintf(algo_dir, sizeof(algo_dir), "%s/%s", LAYER_STORE_PATH, algo->d_name);
+        DIR *layers = opendir(algo_dir);
+        if (!layers) {
+            continue;
+        }
+
+        struct dirent *layer;
+        while (!gc_should_stop() && (layer = readdir(layers)) != NULL) {
+            if (layer->d_name[0] == '.') {
+                continue;
+            }
+
+            char digest[512];
+            snprintf(digest, sizeof(digest), "%s:%s", algo->d_name, layer->d_name);
+            char refs_path[PATH_MAX], dir[PATH_MAX];
+            if (layer_file(digest, "refs", refs_path, sizeof(refs_path)) != 0 ||
+                layer_dir(digest, dir, sizeof(dir)) != 0) {
+                continue;
+            }
+
+            // قفل تا پایان انتقال به trash نگه داشته می‌شود تا ارجاع همزمان از دست نرود
+            int fd = lock_refs(refs_path);
+            if (fd == -1) {
+                continue;
+            }
+
+            struct stat st;
+            if (read_refcount(fd) == 0 && fstat(fd, &st) == 0 &&
+                now - st.st_mtime >= LAYER_GC_GRACE_SECONDS) {
+                char trash_path[PATH_MAX];
+                if (move_to_trash(dir, layer->d_name, trash_path, sizeof(trash_path)) == 0) {
+                    flock(fd, LOCK_UN);
+                    close(fd);
+                    fd = -1;
+                    remove_directory(trash_path);
+                    log_message("لایه بدون استفاده %s حذف شد", digest);
+                    removed++;
+                }
+            }
+            if (fd != -1) {
+                flock(fd, LOCK_UN);
+                close(fd);
+            }
+        }
+        closedir(layers);
+    }
+
+    closedir(store);
+    return removed;
+}
+
+// حذف اشیایی که هیچ لایه‌ای به آن‌ها hardlink ندارد
+static int gc_objects() {
+    DIR *objects = opendir(LAYER_OBJECTS_PATH);
+    if (!objects) {
+        return 0;
+    }
+
+    int removed = 0;
+    struct dirent *entry;
+    while (!gc_should_stop() && (entry = readdir(objects)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        struct stat st;
+        if (fstatat(dirfd(objects), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && st.st_nlink == 1 &&
+            unlinkat(dirfd(objects), entry->d_name, 0) == 0) {
+            removed++;
+        }
+    }
+
+    closedir(objects);
+    return removed;
+}
+
+// حذف باقیمانده‌های trash و واردسازی‌های رهاشده
+static void gc_leftovers(time_t now) {
+    const char *dirs[] = { LAYER_TRASH_PATH, LAYER_TMP_PATH };
+    for (int i = 0; i < 2 && !gc_should_stop(); i++) {
+        DIR *dir = opendir(dirs[i]);
+        if (!dir) {
+            continue;
+        }
+
+        struct dirent *entry;
+        while (!gc_should_stop() && (entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", dirs[i], entry->d_name);
+            struct stat st;
+            // واردسازی‌های تازه ممکن است هنوز در جریان باشند
+            if (i == 1 && (stat(path, &st) != 0 || now - st.st_mtime < LAYER_GC_GRACE_SECONDS)) {
+                continue;
+            }
+            char trash_path[PATH_MAX];
+            if (i == 0) {
+                remove_directory(path);
+            } else if (move_to_trash(path, entry->d_name, trash_path, sizeof(trash_path)) == 0) {
+                remove_directory(trash_path);
+            }
+        }
+        closedir(dir);
+    }
+}
+
+// یک دور جمع‌آوری زباله
+int layer_store_gc() {
+    time_t now = time(NULL);
+
+    gc_leftovers(now);
+    int layers = gc_layers(now);
+    int objects = gc_objects();
+
+    if (layers > 0 || objects > 0) {
+        log_message("GC انبار لایه: %d لایه و %d شیء حذف شد", layers, objects);
+    }
+    return layers;
+}
+
+// حلقه thread پس‌زمینه GC
+static void* gc_thread_main(void *arg) {
+    (void)arg;
+
+    // اولویت SCHED_IDLE تا GC با کارهای اصلی رقابت نکند
+    struct sched_param param = { 0 };
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+    pthread_mutex_lock(&gc_state.lock);
+    while (!gc_state.stop_requested) {
+        pthread_mutex_unlock(&gc_state.lock);
+        layer_store_gc();
+        pthread_mutex_lock(&gc_state.lock);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += gc_state.interval_seconds;
+        while (!gc_state.stop_requested &&
+               pthread_cond_timedwait(&gc_state.cond, &gc_state.lock, &deadline) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&gc_state.lock);
+    return NULL;
+}
+
+// برداشتن thread از وضعیت و join آن بیرون از قفل (با قفل گرفته‌شده فراخوانی و با قفل گرفته‌شده برمی‌گردد)
+static void gc_join_locked() {
+    if (!gc_state.running) {
+        return;
+    }
+    pthread_t thread = gc_state.thread;
+    gc_state.running = false;
+    __atomic_store_n(&gc_state.stop_requested, true, __ATOMIC_RELAXED);
+    pthread_cond_signal(&gc_state.cond);
+    pthread_mutex_unlock(&gc_state.lock);
+    pthread_join(thread, NULL);
+    pthread_mutex_lock(&gc_state.lock);
+}
+
+// اجرای دوره‌ای GC در پس‌زمینه
+int layer_store_gc_start(unsigned interval_seconds) {
+    pthread_mutex_lock(&gc_state.lock);
+    if (gc_state.running && !gc_state.stop_requested) {
+        pthread_mutex_unlock(&gc_state.lock);
+        return 0;
+    }
+
+    // thread قبلی که توقفش درخواست شده ولی هنوز تمام نشده پیش از شروع دوباره join می‌شود
+    gc_join_locked();
+    if (gc_state.running) {
+        pthread_mutex_unlock(&gc_state.lock);
+        return 0;  // فراخواننده همزمان دیگری آن را شروع کرده است
+    }
+
+    gc_state.interval_seconds = interval_seconds;
+    gc_state.stop_requested = false;
+
+    if (pthread_create(&gc_state.thread, NULL, gc_thread_main, NULL) != 0) {
+        pthread_mutex_unlock(&gc_state.lock);
+        log_error("خطا در ایجاد thread جمع‌آوری زباله لایه‌ها");
+        return -1;
+    }
+
+    gc_state.running = true;
+    pthread_mutex_unlock(&gc_state.lock);
+    return 0;
+}
+
+// توقف GC پس‌زمینه؛ دور در حال اجرا در نخستین بررسی gc_should_stop رها می‌شود و thread join می‌شود.
+// حذف‌ها ابتدا به trash منتقل می‌شوند پس رها کردن دور در میانه کار ایمن است
+void layer_store_gc_stop() {
+    pthread_mutex_lock(&gc_state.lock);
+    gc_join_locked();
+    pthread_mutex_unlock(&gc_state.lock);
+}
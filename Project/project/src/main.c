@@ -10,6 +10,11 @@
 #define MAX_CONTAINERS 100
 
 int main(int argc, char **argv) {
+    // فعال‌سازی لاگ‌های جزئیات با متغیر محیطی
+    if (getenv("SIMPLECONTAINER_DEBUG") != NULL) {
+        log_set_level(LOG_LEVEL_DEBUG);
+    }
+
     // بررسی دسترسی‌های root
     if (!has_root_privileges()) {
         fprintf(stderr, "این برنامه نیاز به دسترسی root دارد\n");
@@ -9,6 +9,7 @@
 #include "../include/monitor.h"
 #include "../include/utils.h"
 #include "../include/cgroup.h"
+#include "../include/snapshot.h"
 
 // ساختار داده‌های eBPF
 struct ebpf_event {
@@ -172,6 +173,19 @@ int monitor_get_resource_usage(container_config_t *config, uint64_t *cpu_usage,
     return 0;
 }
 
+int monitor_get_disk_usage(container_config_t *config, disk_usage_t *usage) {
+    const char *path = snapshot_writable_dir(config);
+    if (!path) {
+        memset(usage, 0, sizeof(disk_usage_t));
+        return 0;
+    }
+    return disk_usage_get(path, usage);
+}
+
+int monitor_get_network_usage(container_config_t *config, netacct_stats_t *stats) {
+    return netacct_read(config->cgroup_path, stats);
+}
+
 // باقی توابع بدون تغییر...
 int monitor_namespace_events() {
     return 0;
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mount.h>
+#include <sys/types.h>
+#include <sys/sysmacros.h>
+#include "../include/mounttree.h"
+#include "../include/utils.h"
+
+// گره‌های دستگاه قالب /dev
+static const struct {
+    const char *name;
+    unsigned int major;
+    unsigned int minor;
+} dev_nodes[] = {
+    { "null", 1, 3 },
+    { "zero", 1, 5 },
+    { "full", 1, 7 },
+    { "random", 1, 8 },
+    { "urandom", 1, 9 },
+    { "tty", 5, 0 },
+};
+
+// پیوندهای نمادین استاندارد قالب /dev
+static const struct {
+    const char *name;
+    const char *target;
+} dev_links[] = {
+    { "fd", "/proc/self/fd" },
+    { "stdin", "/proc/self/fd/0" },
+    { "stdout", "/proc/self/fd/1" },
+    { "stderr", "/proc/self/fd/2" },
+    { "ptmx", "pts/ptmx" },
+};
+
+// تبدیل MOUNT_ATTR_* به پرچم‌های mount() برای مسیر جایگزین
+static unsigned long attrs_to_flags(unsigned int attrs) {
+    unsigned long flags = 0;
+    if (attrs & MOUNT_ATTR_RDONLY) flags |= MS_RDONLY;
+    if (attrs & MOUNT_ATTR_NOSUID) flags |= MS_NOSUID;
+    if (attrs & MOUNT_ATTR_NODEV) flags |= MS_NODEV;
+    if (attrs & MOUNT_ATTR_NOEXEC) flags |= MS_NOEXEC;
+    return flags;
+}
+
+// ثبت پیام خطای هسته که روی fd زمینه fsopen قابل خواندن است
+static void log_fs_context_error(int fs_fd, const char *fstype) {
+    char message[256];
+    ssize_t length = read(fs_fd, message, sizeof(message) - 1);
+    if (length > 0) {
+        message[length] = '\0';
+        message[strcspn(message, "\n")] = '\0';
+        log_error("خطا در پیکربندی %s: %s", fstype, message);
+    } else {
+        log_error("خطا در پیکربندی %s", fstype);
+    }
+}
+
+// اعمال گزینه‌های "key=value,flag" روی زمینه fsopen
+static int configure_fs(int fs_fd, const char *options) {
+    if (!options || !options[0]) {
+        return 0;
+    }
+    char *copy = strdup(options);
+    if (!copy) {
+        return -1;
+    }
+
+    int result = 0;
+    char *saveptr;
+    for (char *option = strtok_r(copy, ",", &saveptr); option && result == 0;
+         option = strtok_r(NULL, ",", &saveptr)) {
+        char *value = strchr(option, '=');
+        if (value) {
+            *value++ = '\0';
+            result = fsconfig(fs_fd, FSCONFIG_SET_STRING, option, value, 0);
+        } else {
+            result = fsconfig(fs_fd, FSCONFIG_SET_FLAG, option, NULL, 0);
+        }
+    }
+    free(copy);
+    return result;
+}
+
+// نصب فایل‌سیستم تازه با API جدید نصب
+int mount_new_fs(const char *fstype, const char *options, unsigned int attrs, const char *target) {
+    int fs_fd = fsopen(fstype, FSOPEN_CLOEXEC);
+    if (fs_fd == -1) {
+        if (errno == ENOSYS) {
+            // هسته پیش از 5.2
+            if (mount(fstype, target, fstype, attrs_to_flags(attrs), options) != 0) {
+                log_error("خطا در نصب %s روی %s", fstype, target);
+                return -1;
+            }
+            return 0;
+        }
+        log_error("خطا در fsopen برای %s", fstype);
+        return -1;
+    }
+
+    if (configure_fs(fs_fd, options) != 0 ||
+        fsconfig(fs_fd, FSCONFIG_CMD_CREATE, NULL, NULL, 0) != 0) {
+        log_fs_context_error(fs_fd, fstype);
+        close(fs_fd);
+        return -1;
+    }
+
+    int mount_fd = fsmount(fs_fd, FSMOUNT_CLOEXEC, attrs);
+    close(fs_fd);
+    if (mount_fd == -1) {
+        log_error("خطا در fsmount برای %s", fstype);
+        return -1;
+    }
+
+    int result = move_mount(mount_fd, "", AT_FDCWD, target, MOVE_MOUNT_F_EMPTY_PATH);
+    close(mount_fd);
+    if (result != 0) {
+        log_error("خطا در اتصال %s روی %s", fstype, target);
+        return -1;
+    }
+    return 0;
+}
+
+// clone و اتصال درخت نصب
+int mount_clone_tree(const char *source, const char *target) {
+    int tree_fd = open_tree(AT_FDCWD, source, OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC);
+    if (tree_fd == -1) {
+        if (errno == ENOSYS) {
+            // bind پرچم‌های نصب مبدأ (مانند فقط‌خواندنی) را هم کپی می‌کند
+            if (mount(source, target, NULL, MS_BIND, NULL) != 0) {
+                log_error("خطا در bind کردن %s روی %s", source, target);
+                return -1;
+            }
+            return 0;
+        }
+        log_error("خطا در clone درخت نصب %s", source);
+        return -1;
+    }
+
+    int result = move_mount(tree_fd, "", AT_FDCWD, target, MOVE_MOUNT_F_EMPTY_PATH);
+    close(tree_fd);
+    if (result != 0) {
+        log_error("خطا در اتصال %s روی %s", source, target);
+        return -1;
+    }
+    return 0;
+}
+
+// نصب idmapped؛ نگاشت فقط روی نصب جداشده و پیش از اتصال قابل تنظیم است
+int mount_idmapped(const char *source, const char *target, int userns_fd, unsigned int attrs) {
+    int tree_fd = open_tree(AT_FDCWD, source, OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC);
+    if (tree_fd == -1) {
+        log_error("خطا در clone نصب %s", source);
+        return -1;
+    }
+
+    struct mount_attr attr = { .attr_set = MOUNT_ATTR_IDMAP | attrs, .userns_fd = userns_fd };
+    if (mount_setattr(tree_fd, "", AT_EMPTY_PATH, &attr, sizeof(attr)) != 0) {
+        log_error("خطا در نگاشت شناسه نصب %s: %s", source, strerror(errno));
+        close(tree_fd);
+        return -1;
+    }
+
+    int result = move_mount(tree_fd, "", AT_FDCWD, target, MOVE_MOUNT_F_EMPTY_PATH);
+    close(tree_fd);
+    if (result != 0) {
+        log_error("خطا در اتصال %s روی %s", source, target);
+        return -1;
+    }
+    return 0;
+}
+
+// خصوصی کردن انتشار نصب‌ها
+int mount_make_private(const char *path) {
+    struct mount_attr attr = { .propagation = MS_PRIVATE };
+    if (mount_setattr(AT_FDCWD, path, AT_RECURSIVE, &attr, sizeof(attr)) == 0) {
+        return 0;
+    }
+    if (errno == ENOSYS && mount(NULL, path, NULL, MS_REC | MS_PRIVATE, NULL) == 0) {
+        return 0;
+    }
+    log_error("خطا در تنظیم MS_PRIVATE برای %s", path);
+    return -1;
+}
+
+// بررسی نصب بودن path (دستگاه متفاوت با دایرکتوری والد)
+static bool is_mount_point(const char *path) {
+    char parent[1024];
+    snprintf(parent, sizeof(parent), "%s/..", path);
+    struct stat st, parent_st;
+    return stat(path, &st) == 0 && stat(parent, &parent_st) == 0 && st.st_dev != parent_st.st_dev;
+}
+
+// ساخت گره‌ها و پیوندهای قالب /dev
+static int populate_dev(const char *path) {
+    int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return -1;
+    }
+
+    int result = 0;
+    for (size_t i = 0; i < sizeof(dev_nodes) / sizeof(dev_nodes[0]) && result == 0; i++) {
+        result = mknodat(dir_fd, dev_nodes[i].name, S_IFCHR | 0666,
+                         makedev(dev_nodes[i].major, dev_nodes[i].minor));
+        if (result == 0) {
+            // umask روی mknodat اثر دارد
+            result = fchmodat(dir_fd, dev_nodes[i].name, 0666, 0);
+        }
+    }
+    for (size_t i = 0; i < sizeof(dev_links) / sizeof(dev_links[0]) && result == 0; i++) {
+        result = symlinkat(dev_links[i].target, dir_fd, dev_links[i].name);
+    }
+    // نقاط نصب devpts و /dev/shm که برای هر کانتینر روی clone قالب نصب می‌شوند
+    if (result == 0) {
+        result = mkdirat(dir_fd, "pts", 0755);
+    }
+    if (result == 0) {
+        result = mkdirat(dir_fd, "shm", 0755);
+    }
+
+    close(dir_fd);
+    return result;
+}
+
+// ساخت قالب‌ها
+int mount_template_init() {
+    if (create_directory(MOUNT_TEMPLATE_DEV, 0755) != 0) {
+        log_error("خطا در ایجاد دایرکتوری %s", MOUNT_TEMPLATE_DEV);
+        return -1;
+    }
+    if (is_mount_point(MOUNT_TEMPLATE_DEV)) {
+        if (access(MOUNT_TEMPLATE_DEV "/shm", F_OK) == 0) {
+            return 0;
+        }
+        // قالب ساخته‌شده توسط نسخه قبلی نقطه نصب /dev/shm ندارد
+        umount2(MOUNT_TEMPLATE_DEV, MNT_DETACH);
+    }
+
+    // قالب فقط یک بار در هر راه‌اندازی سیستم ساخته می‌شود، پس هزینه remount مهم نیست
+    if (mount_new_fs("tmpfs", "mode=0755,size=64k,nr_inodes=64",
+                     MOUNT_ATTR_NOSUID | MOUNT_ATTR_NOEXEC, MOUNT_TEMPLATE_DEV) != 0) {
+        return -1;
+    }
+    if (populate_dev(MOUNT_TEMPLATE_DEV) != 0 ||
+        mount(NULL, MOUNT_TEMPLATE_DEV, NULL, MS_REMOUNT | MS_BIND | MS_RDONLY | MS_NOSUID | MS_NOEXEC, NULL) != 0) {
+        log_error("خطا در ساخت قالب %s", MOUNT_TEMPLATE_DEV);
+        umount2(MOUNT_TEMPLATE_DEV, MNT_DETACH);
+        return -1;
+    }
+
+    log_message("قالب %s ساخته شد", MOUNT_TEMPLATE_DEV);
+    return 0;
+}
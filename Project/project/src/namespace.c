@@ -4,10 +4,18 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sched.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <linux/sched.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include "../include/namespace.h"
+#include "../include/mounttree.h"
+#include "../include/network.h"
 #include "../include/utils.h"
 
 // تنظیم همه namespace ها
@@ -30,14 +38,14 @@ int setup_namespaces(container_config_t *config) {
         return -1;
     }
     
-    // تنظیم user namespace
-    if (setup_user_namespace() != 0) {
+    // تنظیم user namespace؛ نگاشت محدوده شناسه را والد پیش از آزاد کردن فرزند نوشته است
+    if (config->idmap.count == 0 && setup_user_namespace() != 0) {
         log_error("خطا در تنظیم user namespace");
         return -1;
     }
     
     // تنظیم network namespace
-    if (setup_network_namespace() != 0) {
+    if (setup_network_namespace(config) != 0) {
         log_error("خطا در تنظیم network namespace");
         return -1;
     }
@@ -103,22 +111,14 @@ int setup_user_namespace() {
 // تنظیم PID namespace
 int setup_pid_namespace() {
     // namespace PID قبلاً با فراخوانی clone ایجاد شده است
-    // نصب procfs برای نمایش صحیح PID‌ها
-    if (mount("proc", "/proc", "proc", 0, NULL) != 0) {
-        log_error("خطا در نصب /proc");
-        return -1;
-    }
+    // procfs یک بار همراه با فایل‌سیستم‌های ضروری زیر rootfs نصب می‌شود
     return 0;
 }
 
 // تنظیم mount namespace
 int setup_mount_namespace() {
     // ایزوله کردن mount namespace با تنظیم MS_PRIVATE
-    if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) != 0) {
-        log_error("خطا در تنظیم MS_PRIVATE برای /");
-        return -1;
-    }
-    return 0;
+    return mount_make_private("/");
 }
 
 // تنظیم UTS namespace
@@ -132,10 +132,13 @@ int setup_uts_namespace(const char *hostname) {
 }
 
 // تنظیم network namespace
-int setup_network_namespace() {
-    // فعال‌سازی interface loopback
-    system("ip link set lo up");
-    return 0;
+int setup_network_namespace(container_config_t *config) {
+    // namespace برداشته‌شده از استخر از پیش پیکربندی شده است و متعلق به user namespace میزبان است
+    if (config->netns_name[0]) {
+        return 0;
+    }
+    // loopback و رابط veth با یک دور rtnetlink، بدون اجرای ip داخل کانتینر
+    return network_configure_container(config);
 }
 
 // تنظیم IPC namespace
@@ -218,4 +221,91 @@ bool namespace_exists(pid_t pid, int nstype) {
     }
     
     return false;
-}
\ No newline at end of file
+}
+
+// clone3 بدون پشته جدا (مانند fork)؛ فرزند CLONE_PARENT سیگنال خروج خود را از فراخواننده می‌گیرد
+static pid_t clone3_process(uint64_t flags, int cgroup_fd) {
+    struct clone_args args;
+    memset(&args, 0, sizeof(args));
+    args.flags = flags;
+    args.exit_signal = (flags & CLONE_PARENT) ? 0 : SIGCHLD;
+    if (cgroup_fd != -1) {
+        args.flags |= CLONE_INTO_CGROUP;
+        args.cgroup = cgroup_fd;
+    }
+    return syscall(SYS_clone3, &args, sizeof(args));
+}
+
+// اجرای فرمان در namespace های یک فرآیند موجود
+// فرآیند واسط در cgroup مقصد ساخته می‌شود و چون تک‌thread است می‌تواند به user و mount namespace
+// وارد شود؛ ورود به PID namespace فقط روی فرزندان اثر دارد، پس فرمان در فرزند دوم اجرا می‌شود که با
+// CLONE_PARENT فرزند فراخواننده است. PID فرمان (مثبت) و خطاها (منفی errno) از pipe گزارش می‌شوند و
+// بسته شدن pipe با exec پایان راه‌اندازی است
+pid_t namespace_exec(int pidfd, int nstypes, int cgroup_fd, const char *root, char *const argv[]) {
+    int report[2];
+    if (pipe2(report, O_CLOEXEC) != 0) {
+        log_error("خطا در ایجاد pipe گزارش exec");
+        return -1;
+    }
+
+    pid_t helper = clone3_process(0, cgroup_fd);
+    if (helper == -1) {
+        log_error("خطا در ایجاد فرآیند در cgroup مقصد: %s", strerror(errno));
+        close(report[0]);
+        close(report[1]);
+        return -1;
+    }
+    if (helper == 0) {
+        close(report[0]);
+        int result = -EINVAL;
+        if (setns(pidfd, nstypes) != 0) {
+            result = -errno;
+        } else {
+            pid_t pid = clone3_process(CLONE_PARENT, -1);
+            if (pid == 0) {
+                // chroot ویژگی فرآیند است و با setns منتقل نمی‌شود
+                if ((root == NULL || chroot(root) == 0) && chdir("/") == 0) {
+                    execvp(argv[0], argv);
+                }
+                result = -errno;
+                write(report[1], &result, sizeof(result));
+                _exit(127);
+            }
+            result = pid == -1 ? -errno : pid;
+        }
+        write(report[1], &result, sizeof(result));
+        _exit(0);
+    }
+    close(report[1]);
+
+    pid_t pid = -1;
+    int error = 0, value;
+    ssize_t n;
+    while ((n = read(report[0], &value, sizeof(value))) != 0) {
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n != sizeof(value)) {
+            error = n == -1 ? -errno : -EIO;
+            break;
+        }
+        if (value > 0) {
+            pid = value;
+        } else {
+            error = value;
+        }
+    }
+    close(report[0]);
+    while (waitpid(helper, NULL, 0) == -1 && errno == EINTR) {
+    }
+
+    if (error != 0 || pid == -1) {
+        if (pid != -1) {
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+        }
+        log_error("خطا در اجرای %s در namespace مقصد: %s", argv[0], strerror(error ? -error : ESRCH));
+        return -1;
+    }
+    return pid;
+}
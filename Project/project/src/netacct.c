@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "../include/netacct.h"
+#include "../include/bpfprog.h"
+#include "../include/utils.h"
+
+#define NSEC_PER_SEC 1000000000
+
+// مقدار cgroup storage برای هر cgroup و جهت
+typedef struct {
+    uint64_t bytes;
+    uint64_t packets;
+    uint64_t dropped;
+    uint64_t rate;          // بایت بر ثانیه (0 یعنی بدون سقف)
+    uint64_t burst;         // اندازه سطل
+    uint64_t tokens;
+    uint64_t last_ns;       // زمان آخرین پر شدن سطل
+} netacct_counters_t;
+
+static struct {
+    pthread_mutex_t lock;
+    int map_fd;
+    int ingress_fd;
+    int egress_fd;
+} netacct_state = { PTHREAD_MUTEX_INITIALIZER, -1, -1, -1 };
+
+#define COUNTER(field) offsetof(netacct_counters_t, field)
+
+// شمارش بسته و سطل توکن؛ به‌روزرسانی سطل بدون قفل و در ترافیک همزمان چند CPU تقریبی است
+// drop_verdict در خروجی 2 است (دور ریختن با اعلام ازدحام تا TCP سرعت را کم کند)
+static int load_program(int map_fd, enum bpf_attach_type type, int drop_verdict) {
+    struct bpf_insn program[] = {
+        MOV64_REG(BPF_REG_6, BPF_REG_1),
+        LDX_W(BPF_REG_8, BPF_REG_6, offsetof(struct __sk_buff, len)),
+        LD_MAP_FD(BPF_REG_1, map_fd),
+        MOV64_IMM(BPF_REG_2, 0),
+        CALL(BPF_FUNC_get_local_storage),
+        MOV64_REG(BPF_REG_7, BPF_REG_0),
+        LDX_DW(BPF_REG_1, BPF_REG_7, COUNTER(rate)),
+        JEQ_IMM(BPF_REG_1, 0, 17),
+        // پر کردن سطل به اندازه زمان گذشته (حداکثر یک ثانیه تا ضرب سرریز نکند)
+        CALL(BPF_FUNC_ktime_get_ns),
+        LDX_DW(BPF_REG_2, BPF_REG_7, COUNTER(last_ns)),
+        STX_DW(BPF_REG_7, BPF_REG_0, COUNTER(last_ns)),
+        ALU64_REG(BPF_SUB, BPF_REG_0, BPF_REG_2),
+        JLE_IMM(BPF_REG_0, NSEC_PER_SEC, 1),
+        MOV64_IMM(BPF_REG_0, NSEC_PER_SEC),
+        LDX_DW(BPF_REG_1, BPF_REG_7, COUNTER(rate)),
+        ALU64_REG(BPF_MUL, BPF_REG_0, BPF_REG_1),
+        ALU64_IMM(BPF_DIV, BPF_REG_0, NSEC_PER_SEC),
+        LDX_DW(BPF_REG_2, BPF_REG_7, COUNTER(tokens)),
+        ALU64_REG(BPF_ADD, BPF_REG_2, BPF_REG_0),
+        LDX_DW(BPF_REG_1, BPF_REG_7, COUNTER(burst)),
+        JLE_REG(BPF_REG_2, BPF_REG_1, 1),
+        MOV64_REG(BPF_REG_2, BPF_REG_1),
+        JLT_REG(BPF_REG_2, BPF_REG_8, 7),
+        ALU64_REG(BPF_SUB, BPF_REG_2, BPF_REG_8),
+        STX_DW(BPF_REG_7, BPF_REG_2, COUNTER(tokens)),
+        // شمارش
+        ATOMIC_ADD_DW(BPF_REG_7, BPF_REG_8, COUNTER(bytes)),
+        MOV64_IMM(BPF_REG_1, 1),
+        ATOMIC_ADD_DW(BPF_REG_7, BPF_REG_1, COUNTER(packets)),
+        MOV64_IMM(BPF_REG_0, 1),
+        EXIT(),
+        // سطل خالی
+        STX_DW(BPF_REG_7, BPF_REG_2, COUNTER(tokens)),
+        MOV64_IMM(BPF_REG_1, 1),
+        ATOMIC_ADD_DW(BPF_REG_7, BPF_REG_1, COUNTER(dropped)),
+        MOV64_IMM(BPF_REG_0, drop_verdict),
+        EXIT(),
+    };
+    return bpf_prog_load_insns(BPF_PROG_TYPE_CGROUP_SKB, type, program, sizeof(program) / sizeof(program[0]));
+}
+
+static void close_fds() {
+    if (netacct_state.egress_fd != -1) close(netacct_state.egress_fd);
+    if (netacct_state.ingress_fd != -1) close(netacct_state.ingress_fd);
+    if (netacct_state.map_fd != -1) close(netacct_state.map_fd);
+    netacct_state.map_fd = netacct_state.ingress_fd = netacct_state.egress_fd = -1;
+}
+
+static int load_objects() {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_CGROUP_STORAGE;
+    attr.key_size = sizeof(struct bpf_cgroup_storage_key);
+    attr.value_size = sizeof(netacct_counters_t);
+    strncpy(attr.map_name, "sc_netacct", sizeof(attr.map_name) - 1);
+    netacct_state.map_fd = bpf_call(BPF_MAP_CREATE, &attr);
+    if (netacct_state.map_fd < 0) {
+        log_error("خطا در ایجاد map شمارش شبکه: %s", strerror(errno));
+        return -1;
+    }
+
+    netacct_state.ingress_fd = load_program(netacct_state.map_fd, BPF_CGROUP_INET_INGRESS, 0);
+    if (netacct_state.ingress_fd >= 0) {
+        netacct_state.egress_fd = load_program(netacct_state.map_fd, BPF_CGROUP_INET_EGRESS, 2);
+    }
+    return netacct_state.ingress_fd >= 0 && netacct_state.egress_fd >= 0 ? 0 : -1;
+}
+
+int netacct_init() {
+    pthread_mutex_lock(&netacct_state.lock);
+    if (netacct_state.map_fd != -1) {
+        pthread_mutex_unlock(&netacct_state.lock);
+        return 0;
+    }
+
+    // نسخه pin‌شده اجرای قبلی: کانتینرهای آن به همین برنامه‌ها متصل‌اند
+    bool pinned = bpf_pin_ready();
+    if (pinned) {
+        netacct_state.map_fd = bpf_object_get("netacct");
+        netacct_state.ingress_fd = bpf_object_get("netacct_ingress");
+        netacct_state.egress_fd = bpf_object_get("netacct_egress");
+        if (netacct_state.map_fd >= 0 && netacct_state.ingress_fd >= 0 && netacct_state.egress_fd >= 0) {
+            pthread_mutex_unlock(&netacct_state.lock);
+            return 0;
+        }
+        close_fds();
+    }
+
+    if (load_objects() != 0) {
+        close_fds();
+        pthread_mutex_unlock(&netacct_state.lock);
+        return -1;
+    }
+    if (pinned && (bpf_object_pin(netacct_state.map_fd, "netacct") != 0 ||
+                   bpf_object_pin(netacct_state.ingress_fd, "netacct_ingress") != 0 ||
+                   bpf_object_pin(netacct_state.egress_fd, "netacct_egress") != 0)) {
+        log_debug("pin کردن شمارش شبکه در %s ممکن نشد", BPF_PIN_DIR);
+    }
+    pthread_mutex_unlock(&netacct_state.lock);
+    return 0;
+}
+
+// کلید storage: شناسه cgroup v2 همان شماره inode دایرکتوری آن است
+static int storage_key(const char *cgroup_path, enum bpf_attach_type type, struct bpf_cgroup_storage_key *key) {
+    struct stat st;
+    if (stat(cgroup_path, &st) != 0) {
+        log_error("خطا در خواندن cgroup %s", cgroup_path);
+        return -1;
+    }
+    memset(key, 0, sizeof(*key));
+    key->cgroup_inode_id = st.st_ino;
+    key->attach_type = type;
+    return 0;
+}
+
+static int storage_op(int cmd, struct bpf_cgroup_storage_key *key, netacct_counters_t *value) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = netacct_state.map_fd;
+    attr.key = (uint64_t)(uintptr_t)key;
+    attr.value = (uint64_t)(uintptr_t)value;
+    attr.flags = cmd == BPF_MAP_UPDATE_ELEM ? BPF_EXIST : 0;
+    return bpf_call(cmd, &attr) == 0 ? 0 : -1;
+}
+
+int netacct_set_rate(const char *cgroup_path, uint64_t rate_bytes) {
+    if (netacct_state.map_fd == -1) {
+        return -1;
+    }
+    enum bpf_attach_type types[] = { BPF_CGROUP_INET_INGRESS, BPF_CGROUP_INET_EGRESS };
+    for (int i = 0; i < 2; i++) {
+        struct bpf_cgroup_storage_key key;
+        netacct_counters_t counters;
+        if (storage_key(cgroup_path, types[i], &key) != 0 ||
+            storage_op(BPF_MAP_LOOKUP_ELEM, &key, &counters) != 0) {
+            log_error("شمارش شبکه به cgroup %s متصل نیست", cgroup_path);
+            return -1;
+        }
+        // سطل پر شروع می‌شود؛ اندازه آن یک دهم ثانیه ترافیک
+        counters.rate = rate_bytes;
+        counters.burst = rate_bytes / 10 > NETACCT_MIN_BURST ? rate_bytes / 10 : NETACCT_MIN_BURST;
+        counters.tokens = counters.burst;
+        counters.last_ns = 0;
+        if (storage_op(BPF_MAP_UPDATE_ELEM, &key, &counters) != 0) {
+            log_error("خطا در تنظیم سقف شبکه cgroup %s: %s", cgroup_path, strerror(errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int netacct_attach_cgroup(const char *cgroup_path, uint64_t rate_bytes) {
+    if (netacct_init() != 0) {
+        return -1;
+    }
+    if (bpf_cgroup_attach(cgroup_path, netacct_state.ingress_fd, BPF_CGROUP_INET_INGRESS) != 0) {
+        log_error("خطا در اتصال شمارش شبکه به cgroup %s: %s", cgroup_path, strerror(errno));
+        return -1;
+    }
+    if (bpf_cgroup_attach(cgroup_path, netacct_state.egress_fd, BPF_CGROUP_INET_EGRESS) != 0) {
+        log_error("خطا در اتصال شمارش شبکه به cgroup %s: %s", cgroup_path, strerror(errno));
+        bpf_cgroup_detach(cgroup_path, netacct_state.ingress_fd, BPF_CGROUP_INET_INGRESS);
+        return -1;
+    }
+    if (rate_bytes > 0 && netacct_set_rate(cgroup_path, rate_bytes) != 0) {
+        netacct_detach_cgroup(cgroup_path);
+        return -1;
+    }
+    return 0;
+}
+
+int netacct_detach_cgroup(const char *cgroup_path) {
+    if (netacct_state.map_fd == -1) {
+        return -1;
+    }
+    int result = bpf_cgroup_detach(cgroup_path, netacct_state.ingress_fd, BPF_CGROUP_INET_INGRESS);
+    if (bpf_cgroup_detach(cgroup_path, netacct_state.egress_fd, BPF_CGROUP_INET_EGRESS) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+int netacct_read(const char *cgroup_path, netacct_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (netacct_state.map_fd == -1) {
+        return -1;
+    }
+    struct bpf_cgroup_storage_key key;
+    netacct_counters_t ingress, egress;
+    if (storage_key(cgroup_path, BPF_CGROUP_INET_INGRESS, &key) != 0 ||
+        storage_op(BPF_MAP_LOOKUP_ELEM, &key, &ingress) != 0) {
+        return -1;
+    }
+    key.attach_type = BPF_CGROUP_INET_EGRESS;
+    if (storage_op(BPF_MAP_LOOKUP_ELEM, &key, &egress) != 0) {
+        return -1;
+    }
+    stats->rx_bytes = ingress.bytes;
+    stats->rx_packets = ingress.packets;
+    stats->rx_dropped = ingress.dropped;
+    stats->tx_bytes = egress.bytes;
+    stats->tx_packets = egress.packets;
+    stats->tx_dropped = egress.dropped;
+    return 0;
+}
+
+void netacct_cleanup() {
+    pthread_mutex_lock(&netacct_state.lock);
+    close_fds();
+    pthread_mutex_unlock(&netacct_state.lock);
+}
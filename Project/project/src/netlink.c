@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/veth.h>
+#include "../include/netlink.h"
+#include "../include/utils.h"
+
+#define NETLINK_RECV_SIZE 32768
+
+int netlink_open(netlink_t *nl) {
+    memset(nl, 0, sizeof(*nl));
+    nl->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (nl->fd == -1) {
+        log_error("خطا در ایجاد سوکت netlink");
+        return -1;
+    }
+
+    // پاسخ خطا فقط سرآیند درخواست را برمی‌گرداند، نه کل پیام
+    int one = 1;
+    setsockopt(nl->fd, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+    setsockopt(nl->fd, SOL_NETLINK, NETLINK_EXT_ACK, &one, sizeof(one));
+
+    struct sockaddr_nl address = { .nl_family = AF_NETLINK };
+    if (bind(nl->fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        log_error("خطا در bind سوکت netlink");
+        close(nl->fd);
+        nl->fd = -1;
+        return -1;
+    }
+    nl->seq = (uint32_t)monotonic_time_ns();
+    return 0;
+}
+
+void netlink_close(netlink_t *nl) {
+    if (nl->fd != -1) {
+        close(nl->fd);
+    }
+    free(nl->buffer);
+    memset(nl, 0, sizeof(*nl));
+    nl->fd = -1;
+}
+
+// ---------- ساخت پیام ----------
+
+// رزرو فضای هم‌تراز در بافر دسته؛ اشاره‌گرها با رشد بافر جابه‌جا می‌شوند و فقط offset نگه داشته می‌شود
+static void* nl_reserve(netlink_t *nl, size_t size) {
+    size_t aligned = NLMSG_ALIGN(size);
+    if (nl->error) {
+        return NULL;
+    }
+    if (nl->used + aligned > nl->capacity) {
+        size_t capacity = nl->capacity ? nl->capacity * 2 : 4096;
+        while (capacity < nl->used + aligned) {
+            capacity *= 2;
+        }
+        char *buffer = realloc(nl->buffer, capacity);
+        if (!buffer) {
+            nl->error = 1;
+            return NULL;
+        }
+        nl->buffer = buffer;
+        nl->capacity = capacity;
+    }
+    void *data = nl->buffer + nl->used;
+    memset(data, 0, aligned);
+    nl->used += aligned;
+    return data;
+}
+
+static struct nlmsghdr* nl_current(netlink_t *nl) {
+    return (struct nlmsghdr *)(nl->buffer + nl->message);
+}
+
+// آغاز پیام با سرآیند خانواده (ifinfomsg، ifaddrmsg یا rtmsg)
+static void* nl_begin(netlink_t *nl, const char *operation, uint16_t type, uint16_t flags, size_t header_size) {
+    if (nl->count == NETLINK_BATCH_MAX) {
+        log_error("دسته netlink پر است");
+        nl->error = 1;
+        return NULL;
+    }
+    size_t offset = nl->used;
+    struct nlmsghdr *header = nl_reserve(nl, NLMSG_HDRLEN);
+    if (!header || !nl_reserve(nl, header_size)) {
+        return NULL;
+    }
+    nl->message = offset;
+    header = nl_current(nl);
+    header->nlmsg_type = type;
+    header->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+    header->nlmsg_seq = nl->seq + nl->count;
+    nl->operations[nl->count] = operation;
+    return (char *)header + NLMSG_HDRLEN;
+}
+
+// پایان پیام: طول نهایی در سرآیند
+static int nl_end(netlink_t *nl) {
+    if (nl->error) {
+        return -1;
+    }
+    nl_current(nl)->nlmsg_len = nl->used - nl->message;
+    nl->count++;
+    return 0;
+}
+
+static void nl_attr(netlink_t *nl, uint16_t type, const void *data, size_t size) {
+    struct rtattr *attr = nl_reserve(nl, RTA_LENGTH(size));
+    if (attr) {
+        attr->rta_type = type;
+        attr->rta_len = RTA_LENGTH(size);
+        memcpy(RTA_DATA(attr), data, size);
+    }
+}
+
+static void nl_attr_string(netlink_t *nl, uint16_t type, const char *value) {
+    nl_attr(nl, type, value, strlen(value) + 1);
+}
+
+static void nl_attr_u32(netlink_t *nl, uint16_t type, uint32_t value) {
+    nl_attr(nl, type, &value, sizeof(value));
+}
+
+// ویژگی تودرتو؛ offset آن برای تکمیل طول برگردانده می‌شود
+static size_t nl_nest_begin(netlink_t *nl, uint16_t type) {
+    size_t offset = nl->used;
+    struct rtattr *attr = nl_reserve(nl, RTA_LENGTH(0));
+    if (attr) {
+        attr->rta_type = type;
+    }
+    return offset;
+}
+
+static void nl_nest_end(netlink_t *nl, size_t offset) {
+    if (!nl->error) {
+        ((struct rtattr *)(nl->buffer + offset))->rta_len = nl->used - offset;
+    }
+}
+
+static bool nl_ifname_valid(netlink_t *nl, const char *ifname) {
+    if (strlen(ifname) >= IFNAMSIZ) {
+        log_error("نام رابط خیلی طولانی است: %s", ifname);
+        nl->error = 1;
+        return false;
+    }
+    return true;
+}
+
+// ---------- عملیات ----------
+
+int netlink_link_up(netlink_t *nl, const char *ifname) {
+    if (!nl_ifname_valid(nl, ifname)) {
+        return -1;
+    }
+    struct ifinfomsg *info = nl_begin(nl, "link up", RTM_NEWLINK, 0, sizeof(struct ifinfomsg));
+    if (info) {
+        info->ifi_family = AF_UNSPEC;
+        info->ifi_flags = IFF_UP;
+        info->ifi_change = IFF_UP;
+    }
+    nl_attr_string(nl, IFLA_IFNAME, ifname);
+    return nl_end(nl);
+}
+
+// ایجاد veth؛ netns_attr نوع ارجاع به namespace سر دیگر (IFLA_NET_NS_PID یا IFLA_NET_NS_FD)
+static int veth_create(netlink_t *nl, const char *ifname, const char *peer, uint16_t netns_attr, uint32_t netns,
+                       int master) {
+    if (!nl_ifname_valid(nl, ifname) || !nl_ifname_valid(nl, peer)) {
+        return -1;
+    }
+    // سر میزبان در همان پیام ایجاد روشن و به bridge متصل می‌شود
+    struct ifinfomsg *info = nl_begin(nl, "veth create", RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL,
+                                      sizeof(struct ifinfomsg));
+    if (info) {
+        info->ifi_family = AF_UNSPEC;
+        info->ifi_flags = IFF_UP;
+        info->ifi_change = IFF_UP;
+    }
+    nl_attr_string(nl, IFLA_IFNAME, ifname);
+    if (master > 0) {
+        nl_attr_u32(nl, IFLA_MASTER, master);
+    }
+
+    size_t linkinfo = nl_nest_begin(nl, IFLA_LINKINFO);
+    nl_attr_string(nl, IFLA_INFO_KIND, "veth");
+    size_t data = nl_nest_begin(nl, IFLA_INFO_DATA);
+    size_t peer_info = nl_nest_begin(nl, VETH_INFO_PEER);
+    struct ifinfomsg *peer_header = nl_reserve(nl, sizeof(struct ifinfomsg));
+    if (peer_header) {
+        peer_header->ifi_family = AF_UNSPEC;
+    }
+    nl_attr_string(nl, IFLA_IFNAME, peer);
+    if (netns_attr) {
+        nl_attr_u32(nl, netns_attr, netns);
+    }
+    nl_nest_end(nl, peer_info);
+    nl_nest_end(nl, data);
+    nl_nest_end(nl, linkinfo);
+    return nl_end(nl);
+}
+
+int netlink_veth_create(netlink_t *nl, const char *ifname, const char *peer, pid_t peer_pid, int master) {
+    return veth_create(nl, ifname, peer, peer_pid > 0 ? IFLA_NET_NS_PID : 0, peer_pid, master);
+}
+
+int netlink_veth_create_in(netlink_t *nl, const char *ifname, const char *peer, int netns_fd, int master) {
+    return veth_create(nl, ifname, peer, IFLA_NET_NS_FD, netns_fd, master);
+}
+
+int netlink_bridge_create(netlink_t *nl, const char *ifname) {
+    if (!nl_ifname_valid(nl, ifname)) {
+        return -1;
+    }
+    // بدون NLM_F_EXCL: bridge موجود فقط روشن می‌شود
+    struct ifinfomsg *info = nl_begin(nl, "bridge create", RTM_NEWLINK, NLM_F_CREATE, sizeof(struct ifinfomsg));
+    if (info) {
+        info->ifi_family = AF_UNSPEC;
+        info->ifi_flags = IFF_UP;
+        info->ifi_change = IFF_UP;
+    }
+    nl_attr_string(nl, IFLA_IFNAME, ifname);
+    size_t linkinfo = nl_nest_begin(nl, IFLA_LINKINFO);
+    nl_attr_string(nl, IFLA_INFO_KIND, "bridge");
+    nl_nest_end(nl, linkinfo);
+    return nl_end(nl);
+}
+
+int netlink_addr_add(netlink_t *nl, int ifindex, uint32_t address, int prefix) {
+    struct ifaddrmsg *info = nl_begin(nl, "address add", RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE,
+                                      sizeof(struct ifaddrmsg));
+    if (info) {
+        info->ifa_family = AF_INET;
+        info->ifa_prefixlen = prefix;
+        info->ifa_scope = RT_SCOPE_UNIVERSE;
+        info->ifa_index = ifindex;
+    }
+    nl_attr(nl, IFA_LOCAL, &address, sizeof(address));
+    nl_attr(nl, IFA_ADDRESS, &address, sizeof(address));
+    return nl_end(nl);
+}
+
+int netlink_route_add(netlink_t *nl, uint32_t destination, int prefix, uint32_t gateway, int ifindex) {
+    struct rtmsg *info = nl_begin(nl, "route add", RTM_NEWROUTE, NLM_F_CREATE | NLM_F_REPLACE, sizeof(struct rtmsg));
+    if (info) {
+        info->rtm_family = AF_INET;
+        info->rtm_dst_len = prefix;
+        info->rtm_table = RT_TABLE_MAIN;
+        info->rtm_protocol = RTPROT_BOOT;
+        info->rtm_scope = RT_SCOPE_UNIVERSE;
+        info->rtm_type = RTN_UNICAST;
+    }
+    if (prefix > 0) {
+        nl_attr(nl, RTA_DST, &destination, sizeof(destination));
+    }
+    nl_attr(nl, RTA_GATEWAY, &gateway, sizeof(gateway));
+    nl_attr_u32(nl, RTA_OIF, ifindex);
+    return nl_end(nl);
+}
+
+// ---------- ارسال دسته ----------
+
+int netlink_commit(netlink_t *nl) {
+    int count = nl->count;
+    int result = nl->error ? -1 : 0;
+    uint32_t first = nl->seq;
+    nl->seq += count;
+    nl->count = 0;
+    nl->error = 0;
+
+    if (result != 0 || count == 0) {
+        nl->used = 0;
+        return result;
+    }
+
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    struct iovec iov = { nl->buffer, nl->used };
+    struct msghdr message = { .msg_name = &kernel, .msg_namelen = sizeof(kernel), .msg_iov = &iov, .msg_iovlen = 1 };
+    ssize_t sent;
+    do {
+        sent = sendmsg(nl->fd, &message, 0);
+    } while (sent == -1 && errno == EINTR);
+    nl->used = 0;
+    if (sent == -1) {
+        log_error("خطا در ارسال درخواست‌های netlink");
+        return -1;
+    }
+
+    // هر درخواست دقیقاً یک ACK یا خطا دارد؛ درخواست‌ها پس از خطا هم پردازش می‌شوند
+    char *buffer = malloc(NETLINK_RECV_SIZE);
+    if (!buffer) {
+        return -1;
+    }
+    int acked = 0;
+    while (acked < count) {
+        ssize_t length = recv(nl->fd, buffer, NETLINK_RECV_SIZE, 0);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            log_error("خطا در دریافت پاسخ netlink");
+            result = -1;
+            break;
+        }
+        for (struct nlmsghdr *header = (struct nlmsghdr *)buffer; NLMSG_OK(header, (size_t)length);
+             header = NLMSG_NEXT(header, length)) {
+            uint32_t index = header->nlmsg_seq - first;
+            if (header->nlmsg_type != NLMSG_ERROR || index >= (uint32_t)count) {
+                continue;
+            }
+            acked++;
+            const struct nlmsgerr *error = NLMSG_DATA(header);
+            if (error->error != 0) {
+                errno = -error->error;
+                log_error("خطای netlink در %s: %s", nl->operations[index], strerror(errno));
+                result = -1;
+            }
+        }
+    }
+    free(buffer);
+    return result;
+}
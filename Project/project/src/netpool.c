@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <sys/file.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#include "../include/netpool.h"
+#include "../include/network.h"
+#include "../include/mounttree.h"
+#include "../include/utils.h"
+
+#define NETPOOL_MODES 2
+
+// شماره ورودی‌ها در نام، veth میزبان و نشانی؛ تا این حد چرخشی است
+#define NETPOOL_NUMBER_MAX 0x7ff0
+
+// وضعیت یک ورودی استخر
+typedef enum {
+    ENTRY_UNUSED = 0,
+    ENTRY_CREATING,             // در حال ساخت توسط thread پر کردن
+    ENTRY_FREE,                 // آماده برداشت
+    ENTRY_BUSY,                 // در اختیار کانتینر
+    ENTRY_DIRTY,                // بازگشته، در انتظار پاک‌سازی
+    ENTRY_SCRUBBING,            // در حال پاک‌سازی
+    ENTRY_FOREIGN               // در اختیار کانتینر زنده فرآیند دیگر
+} entry_state_t;
+
+typedef struct {
+    entry_state_t state;
+    network_mode_t mode;
+    int number;
+} netpool_entry_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool running;
+    bool stop_requested;
+    int size;
+    bool wanted[NETPOOL_MODES];     // حالت‌هایی که درخواست شده‌اند؛ فقط این‌ها پر می‌شوند
+    int next_number;
+    netpool_entry_t entries[NETPOOL_MAX];
+} pool_state = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false, false, 0, { false, false }, 0, { { 0 } } };
+
+static void entry_name(const netpool_entry_t *entry, char *buffer, size_t size) {
+    snprintf(buffer, size, "%s-%d", network_mode_name(entry->mode), entry->number);
+}
+
+static void entry_path(const netpool_entry_t *entry, const char *suffix, char *buffer, size_t size) {
+    char name[32];
+    entry_name(entry, name, sizeof(name));
+    snprintf(buffer, size, "%s/%s%s", NETPOOL_DIR, name, suffix);
+}
+
+static uint32_t entry_address(const netpool_entry_t *entry) {
+    return entry->mode == NETWORK_BRIDGE ? network_container_address(NETPOOL_ADDRESS_BASE + entry->number) : 0;
+}
+
+static bool is_filesystem(const char *path, long type) {
+    struct statfs st;
+    return statfs(path, &st) == 0 && st.f_type == type;
+}
+
+static int write_owner(const netpool_entry_t *entry, pid_t pid) {
+    char path[PATH_MAX], text[16];
+    entry_path(entry, NETPOOL_BUSY_SUFFIX, path, sizeof(path));
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    int length = snprintf(text, sizeof(text), "%d\n", pid);
+    int result = write(fd, text, length) == length ? 0 : -1;
+    close(fd);
+    return result;
+}
+
+// مالک ثبت‌شده هنوز زنده است؛ ادعای خود این فرآیند زنده به حساب نمی‌آید چون وضعیت درون فرآیند
+// (pool_state) کارهای خود آن را مرتب می‌کند
+static bool owner_alive(const char *busy_path) {
+    FILE *file = fopen(busy_path, "r");
+    if (!file) {
+        return false;
+    }
+    int pid = 0;
+    bool alive = fscanf(file, "%d", &pid) == 1 && pid > 0 && pid != getpid() &&
+                 (kill(pid, 0) == 0 || errno == EPERM);
+    fclose(file);
+    return alive;
+}
+
+// قفل سراسری فایل‌های مالک؛ فرآیندهای run همزمان هر کدام استخر خود را از همین دایرکتوری می‌سازند
+static int claim_lock() {
+    int fd = open(NETPOOL_DIR "/.lock", O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd != -1 && flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static void claim_unlock(int fd) {
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+// ادعای ورودی برای فرآیند فعلی پیش از برداشت، پاک‌سازی، ساخت یا حذف آن: بررسی مالک و نوشتن
+// فایل مالک زیر یک قفل انجام می‌شود، پس از دو فرآیند فقط یکی موفق می‌شود. ساخت ورودی‌ای را که
+// فایل namespace آن را فرآیند دیگری ساخته است ادعا نمی‌کند
+static bool claim_entry(const netpool_entry_t *entry, bool creating) {
+    int lock_fd = claim_lock();
+    if (lock_fd == -1) {
+        return false;
+    }
+    char path[PATH_MAX], busy_path[PATH_MAX];
+    entry_path(entry, "", path, sizeof(path));
+    entry_path(entry, NETPOOL_BUSY_SUFFIX, busy_path, sizeof(busy_path));
+    bool claimed = !owner_alive(busy_path) && (!creating || access(path, F_OK) != 0) &&
+                   write_owner(entry, getpid()) == 0;
+    claim_unlock(lock_fd);
+    return claimed;
+}
+
+// حذف فایل‌های ورودی؛ netns با جدا شدن آخرین ارجاع (و veth میزبان همراه آن) آزاد می‌شود
+static void destroy_files(const netpool_entry_t *entry) {
+    char path[PATH_MAX];
+    entry_path(entry, NETPOOL_SYSFS_SUFFIX, path, sizeof(path));
+    umount2(path, MNT_DETACH);
+    rmdir(path);
+    entry_path(entry, "", path, sizeof(path));
+    umount2(path, MNT_DETACH);
+    unlink(path);
+    entry_path(entry, NETPOOL_BUSY_SUFFIX, path, sizeof(path));
+    unlink(path);
+}
+
+// ---------- کار روی namespace ها (بیرون از قفل) ----------
+
+// فقط رابط‌های مورد انتظار در namespace وجود دارند
+static bool links_expected(network_mode_t mode) {
+    struct if_nameindex *links = if_nameindex();
+    if (!links) {
+        return false;
+    }
+    bool expected = true;
+    for (struct if_nameindex *link = links; link->if_index != 0; link++) {
+        if (strcmp(link->if_name, "lo") != 0 &&
+            !(mode == NETWORK_BRIDGE && strcmp(link->if_name, NETWORK_CONTAINER_IFNAME) == 0)) {
+            expected = false;
+        }
+    }
+    if_freenameindex(links);
+    return expected;
+}
+
+// رساندن namespace ورودی به حالت آماده: veth، loopback، نشانی، مسیر و قالب sysfs
+// همه مراحل idempotent هستند و برای ساخت، پاک‌سازی و پذیرش ورودی‌های ناقص به کار می‌روند
+static int scrub_entry(const netpool_entry_t *entry) {
+    char path[PATH_MAX], sysfs_path[PATH_MAX];
+    entry_path(entry, "", path, sizeof(path));
+    entry_path(entry, NETPOOL_SYSFS_SUFFIX, sysfs_path, sizeof(sysfs_path));
+
+    int saved_fd = open("/proc/thread-self/ns/net", O_RDONLY | O_CLOEXEC);
+    int netns_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (saved_fd == -1 || netns_fd == -1 || !is_filesystem(path, NSFS_MAGIC)) {
+        if (saved_fd != -1) close(saved_fd);
+        if (netns_fd != -1) close(netns_fd);
+        return -1;
+    }
+
+    int result = -1;
+    if (setns(netns_fd, CLONE_NEWNET) == 0) {
+        bool has_veth = if_nametoindex(NETWORK_CONTAINER_IFNAME) > 0;
+        setns(saved_fd, CLONE_NEWNET);
+
+        // سر میزبان veth با سوکت netlink در namespace میزبان ساخته می‌شود
+        char host_ifname[IFNAMSIZ];
+        snprintf(host_ifname, sizeof(host_ifname), "scp%d", entry->number);
+        if (entry->mode != NETWORK_BRIDGE || has_veth || network_attach_netns(host_ifname, netns_fd) == 0) {
+            if (setns(netns_fd, CLONE_NEWNET) == 0) {
+                if (links_expected(entry->mode) && network_configure(entry->mode, entry_address(entry)) == 0) {
+                    // sysfs تگ namespace thread سازنده را می‌گیرد
+                    create_directory(sysfs_path, 0755);
+                    result = is_filesystem(sysfs_path, SYSFS_MAGIC) ||
+                             mount_new_fs("sysfs", NULL, MOUNT_ATTR_RDONLY | MOUNT_ATTR_NOSUID |
+                                          MOUNT_ATTR_NODEV | MOUNT_ATTR_NOEXEC, sysfs_path) == 0 ? 0 : -1;
+                }
+                setns(saved_fd, CLONE_NEWNET);
+            }
+        }
+    }
+    close(netns_fd);
+    close(saved_fd);
+
+    if (result == 0) {
+        entry_path(entry, NETPOOL_BUSY_SUFFIX, path, sizeof(path));
+        unlink(path);
+    }
+    return result;
+}
+
+// ساخت netns تازه روی thread جاری و bind آن زیر NETPOOL_DIR
+static int create_entry(const netpool_entry_t *entry) {
+    char path[PATH_MAX];
+    entry_path(entry, "", path, sizeof(path));
+
+    int saved_fd = open("/proc/thread-self/ns/net", O_RDONLY | O_CLOEXEC);
+    if (saved_fd == -1) {
+        return -1;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0444);
+    if (fd != -1) {
+        close(fd);
+    }
+
+    // unshare فقط namespace این thread را عوض می‌کند
+    int result = -1;
+    if (fd != -1 && unshare(CLONE_NEWNET) == 0) {
+        result = mount("/proc/thread-self/ns/net", path, NULL, MS_BIND, NULL);
+        setns(saved_fd, CLONE_NEWNET);
+    }
+    close(saved_fd);
+
+    if (result != 0 || scrub_entry(entry) != 0) {
+        log_error("خطا در ساخت network namespace آماده %s", path);
+        destroy_files(entry);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------- استخر ----------
+
+static int count_entries(network_mode_t mode, entry_state_t state) {
+    int count = 0;
+    for (int i = 0; i < NETPOOL_MAX; i++) {
+        count += pool_state.entries[i].state == state && pool_state.entries[i].mode == mode;
+    }
+    return count;
+}
+
+// خانه خالی با شماره تازه؛ NULL اگر استخر پر است
+// شماره‌ها بلافاصله دوباره استفاده نمی‌شوند چون حذف netns و veth میزبان آن در هسته با تأخیر انجام می‌شود
+static netpool_entry_t* allocate_entry(network_mode_t mode) {
+    netpool_entry_t *slot = NULL;
+    for (int i = 0; i < NETPOOL_MAX && !slot; i++) {
+        if (pool_state.entries[i].state == ENTRY_UNUSED) {
+            slot = &pool_state.entries[i];
+        }
+    }
+    if (!slot) {
+        return NULL;
+    }
+    for (;;) {
+        int number = pool_state.next_number;
+        pool_state.next_number = (number + 1) % NETPOOL_NUMBER_MAX;
+        bool used = false;
+        for (int i = 0; i < NETPOOL_MAX && !used; i++) {
+            used = pool_state.entries[i].state != ENTRY_UNUSED && pool_state.entries[i].number == number;
+        }
+        if (!used) {
+            slot->mode = mode;
+            slot->number = number;
+            return slot;
+        }
+    }
+}
+
+static netpool_entry_t* find_entry(const char *name) {
+    char entry[32];
+    for (int i = 0; i < NETPOOL_MAX; i++) {
+        if (pool_state.entries[i].state != ENTRY_UNUSED) {
+            entry_name(&pool_state.entries[i], entry, sizeof(entry));
+            if (strcmp(entry, name) == 0) {
+                return &pool_state.entries[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+// یک کار: پاک‌سازی یک ورودی بازگشتی یا ساخت یک ورودی تازه؛ false اگر کاری نبود
+// قفل هنگام فراخوانی گرفته شده است و در طول کار آزاد می‌شود
+static bool fill_step() {
+    for (int i = 0; i < NETPOOL_MAX; i++) {
+        netpool_entry_t *entry = &pool_state.entries[i];
+        if (entry->state != ENTRY_DIRTY) {
+            continue;
+        }
+        entry->state = ENTRY_SCRUBBING;
+        netpool_entry_t copy = *entry;
+        bool keep = count_entries(copy.mode, ENTRY_FREE) < pool_state.size;
+        pthread_mutex_unlock(&pool_state.lock);
+
+        // ورودی پذیرفته‌شده ممکن است در این فاصله به کانتینر فرآیند دیگری رسیده باشد
+        if (!claim_entry(&copy, false)) {
+            pthread_mutex_lock(&pool_state.lock);
+            entry->state = ENTRY_FOREIGN;
+            return true;
+        }
+        bool ready = keep && scrub_entry(&copy) == 0;
+        if (!ready) {
+            destroy_files(&copy);
+        }
+
+        pthread_mutex_lock(&pool_state.lock);
+        entry->state = ready ? ENTRY_FREE : ENTRY_UNUSED;
+        return true;
+    }
+
+    for (int mode = 0; mode < NETPOOL_MODES; mode++) {
+        if (!pool_state.wanted[mode] ||
+            count_entries(mode, ENTRY_FREE) + count_entries(mode, ENTRY_CREATING) >= pool_state.size) {
+            continue;
+        }
+        netpool_entry_t *entry = allocate_entry(mode);
+        if (!entry) {
+            return false;
+        }
+        entry->state = ENTRY_CREATING;
+        netpool_entry_t copy = *entry;
+        pthread_mutex_unlock(&pool_state.lock);
+
+        // شماره در فرآیند دیگری در حال استفاده است؛ دور بعد شماره تازه‌ای گرفته می‌شود
+        if (!claim_entry(&copy, true)) {
+            pthread_mutex_lock(&pool_state.lock);
+            entry->state = ENTRY_UNUSED;
+            return true;
+        }
+        bool ready = create_entry(&copy) == 0;
+
+        pthread_mutex_lock(&pool_state.lock);
+        entry->state = ready ? ENTRY_FREE : ENTRY_UNUSED;
+        if (!ready) {
+            // بدون این، ساخت ناموفق بی‌وقفه تکرار می‌شود
+            pool_state.wanted[mode] = false;
+        }
+        return true;
+    }
+    return false;
+}
+
+int netpool_fill() {
+    int steps = 0;
+    pthread_mutex_lock(&pool_state.lock);
+    while (fill_step()) {
+        steps++;
+    }
+    pthread_mutex_unlock(&pool_state.lock);
+    return steps;
+}
+
+static void* netpool_thread_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool_state.lock);
+    while (!pool_state.stop_requested) {
+        if (!fill_step()) {
+            pthread_cond_wait(&pool_state.cond, &pool_state.lock);
+        }
+    }
+    pool_state.running = false;
+    pthread_mutex_unlock(&pool_state.lock);
+    return NULL;
+}
+
+// پذیرش ورودی‌های اجرای قبلی: آزاد یا رهاشده به صف پاک‌سازی، در استفاده کانتینر زنده کنار گذاشته می‌شود
+static void adopt_entries() {
+    DIR *dir = opendir(NETPOOL_DIR);
+    if (!dir) {
+        return;
+    }
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        char mode_name[16];
+        int number, length = 0;
+        network_mode_t mode;
+        if (dirent->d_name[0] == '.' || strchr(dirent->d_name, '.') ||
+            sscanf(dirent->d_name, "%15[a-z]-%d%n", mode_name, &number, &length) != 2 ||
+            dirent->d_name[length] != '\0' || network_mode_parse(mode_name, &mode) != 0 ||
+            find_entry(dirent->d_name)) {
+            continue;
+        }
+
+        netpool_entry_t *entry = allocate_entry(mode);
+        if (!entry) {
+            break;
+        }
+        entry->number = number;
+        if (number >= pool_state.next_number && number < NETPOOL_NUMBER_MAX) {
+            pool_state.next_number = number + 1;
+        }
+
+        char path[PATH_MAX], busy_path[PATH_MAX];
+        entry_path(entry, "", path, sizeof(path));
+        entry_path(entry, NETPOOL_BUSY_SUFFIX, busy_path, sizeof(busy_path));
+        if (!is_filesystem(path, NSFS_MAGIC)) {
+            // ساخت نیمه‌تمام پیش از نصب؛ ساخت در جریان فرآیند دیگر ادعای زنده دارد
+            if (claim_entry(entry, false)) {
+                destroy_files(entry);
+            } else {
+                entry->state = ENTRY_FOREIGN;
+            }
+        } else if (owner_alive(busy_path)) {
+            entry->state = ENTRY_FOREIGN;
+        } else {
+            entry->state = ENTRY_DIRTY;
+            pool_state.wanted[mode] = true;
+        }
+    }
+    closedir(dir);
+}
+
+int netpool_start(int size) {
+    if (create_directory(NETPOOL_DIR, 0755) != 0) {
+        log_error("خطا در ایجاد دایرکتوری %s", NETPOOL_DIR);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool_state.lock);
+    pool_state.size = size;
+    adopt_entries();
+    if (pool_state.running || size == 0) {
+        pthread_mutex_unlock(&pool_state.lock);
+        return 0;
+    }
+
+    pool_state.stop_requested = false;
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attr, netpool_thread_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        pthread_mutex_unlock(&pool_state.lock);
+        log_error("خطا در ایجاد thread استخر network namespace");
+        return -1;
+    }
+    pool_state.running = true;
+    pthread_mutex_unlock(&pool_state.lock);
+    return 0;
+}
+
+void netpool_stop() {
+    pthread_mutex_lock(&pool_state.lock);
+    pool_state.stop_requested = true;
+    pthread_cond_signal(&pool_state.cond);
+    pthread_mutex_unlock(&pool_state.lock);
+}
+
+int netpool_acquire(container_config_t *config) {
+    pthread_mutex_lock(&pool_state.lock);
+    pool_state.wanted[config->network] = true;
+    netpool_entry_t *entry = NULL;
+    for (int i = 0; i < NETPOOL_MAX && !entry; i++) {
+        netpool_entry_t *candidate = &pool_state.entries[i];
+        if (candidate->state != ENTRY_FREE || candidate->mode != config->network) {
+            continue;
+        }
+        // ورودی آزاد همین فرآیند ممکن است توسط فرآیند دیگری برداشته شده باشد
+        if (claim_entry(candidate, false)) {
+            entry = candidate;
+        } else {
+            candidate->state = ENTRY_FOREIGN;
+        }
+    }
+    if (entry) {
+        entry->state = ENTRY_BUSY;
+        entry_name(entry, config->netns_name, sizeof(config->netns_name));
+        if (config->network == NETWORK_BRIDGE) {
+            config->ipv4_address = entry_address(entry);
+        }
+    }
+    // جایگزینی ورودی برداشته‌شده یا پر کردن پس از نخستین درخواست
+    pthread_cond_signal(&pool_state.cond);
+    pthread_mutex_unlock(&pool_state.lock);
+    return entry ? 0 : -1;
+}
+
+int netpool_set_owner(const container_config_t *config, pid_t pid) {
+    pthread_mutex_lock(&pool_state.lock);
+    netpool_entry_t *entry = find_entry(config->netns_name);
+    int lock_fd = entry ? claim_lock() : -1;
+    int result = lock_fd != -1 ? write_owner(entry, pid) : -1;
+    if (lock_fd != -1) {
+        claim_unlock(lock_fd);
+    }
+    pthread_mutex_unlock(&pool_state.lock);
+    return result;
+}
+
+void netpool_release(container_config_t *config) {
+    if (!config->netns_name[0]) {
+        return;
+    }
+    pthread_mutex_lock(&pool_state.lock);
+    netpool_entry_t *entry = find_entry(config->netns_name);
+    if (entry && entry->state == ENTRY_BUSY) {
+        entry->state = ENTRY_DIRTY;
+        pthread_cond_signal(&pool_state.cond);
+    }
+    pthread_mutex_unlock(&pool_state.lock);
+    config->netns_name[0] = '\0';
+}
+
+int netpool_enter(const container_config_t *config, int *saved_fd) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", NETPOOL_DIR, config->netns_name);
+    int netns_fd = open(path, O_RDONLY | O_CLOEXEC);
+    *saved_fd = open("/proc/thread-self/ns/net", O_RDONLY | O_CLOEXEC);
+    if (netns_fd == -1 || *saved_fd == -1 || setns(netns_fd, CLONE_NEWNET) != 0) {
+        log_error("خطا در ورود به network namespace %s", path);
+        if (netns_fd != -1) close(netns_fd);
+        if (*saved_fd != -1) close(*saved_fd);
+        *saved_fd = -1;
+        return -1;
+    }
+    close(netns_fd);
+    return 0;
+}
+
+int netpool_leave(int saved_fd) {
+    int result = setns(saved_fd, CLONE_NEWNET);
+    close(saved_fd);
+    if (result != 0) {
+        log_error("خطا در بازگشت به network namespace میزبان");
+    }
+    return result;
+}
+
+int netpool_purge() {
+    int removed = 0;
+    pthread_mutex_lock(&pool_state.lock);
+    adopt_entries();
+    for (int i = 0; i < NETPOOL_MAX; i++) {
+        netpool_entry_t *entry = &pool_state.entries[i];
+        if (entry->state != ENTRY_FREE && entry->state != ENTRY_DIRTY) {
+            continue;
+        }
+        if (claim_entry(entry, false)) {
+            destroy_files(entry);
+            entry->state = ENTRY_UNUSED;
+            removed++;
+        } else {
+            entry->state = ENTRY_FOREIGN;
+        }
+    }
+    pool_state.wanted[NETWORK_NONE] = pool_state.wanted[NETWORK_BRIDGE] = false;
+    pthread_mutex_unlock(&pool_state.lock);
+    return removed;
+}
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/file.h>
+#include "../include/network.h"
+#include "../include/netlink.h"
+#include "../include/utils.h"
+
+static const char *network_mode_names[] = { "none", "bridge" };
+
+// شاخص bridge میزبان پس از نخستین ایجاد
+static int bridge_ifindex = 0;
+static pthread_mutex_t bridge_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int network_mode_parse(const char *name, network_mode_t *mode) {
+    for (size_t i = 0; i < sizeof(network_mode_names) / sizeof(network_mode_names[0]); i++) {
+        if (strcmp(name, network_mode_names[i]) == 0) {
+            *mode = (network_mode_t)i;
+            return 0;
+        }
+    }
+    log_error("حالت شبکه ناشناخته: %s", name);
+    return -1;
+}
+
+const char* network_mode_name(network_mode_t mode) {
+    return mode == NETWORK_BRIDGE ? "bridge" : "none";
+}
+
+uint32_t network_container_address(int index) {
+    // .0 شبکه و .1 gateway است
+    return htonl(NETWORK_SUBNET | (uint32_t)((index + 2) & 0xffff));
+}
+
+static void lease_path(int index, char *buffer, size_t size) {
+    snprintf(buffer, size, "%s/%d", NETWORK_LEASE_DIR, index);
+}
+
+// قفل سراسری اجاره‌ها؛ همه فرآیندهای run روی آن صف می‌شوند تا بررسی مالک و نوشتن اجاره اتمی باشد
+static int lease_lock() {
+    if (create_directory(NETWORK_LEASE_DIR, 0755) != 0) {
+        log_error("خطا در ایجاد %s", NETWORK_LEASE_DIR);
+        return -1;
+    }
+    int fd = open(NETWORK_LEASE_DIR "/.lock", O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1 || flock(fd, LOCK_EX) != 0) {
+        log_error("خطا در قفل کردن اجاره نشانی‌ها");
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void lease_unlock(int fd) {
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+static int write_lease(int fd, pid_t pid) {
+    char text[16];
+    int length = snprintf(text, sizeof(text), "%d\n", pid);
+    return ftruncate(fd, 0) == 0 && pwrite(fd, text, length, 0) == length ? 0 : -1;
+}
+
+// PID مالک ثبت‌شده در اجاره (0 برای اجاره خالی)
+static pid_t lease_owner(int fd) {
+    char text[16];
+    ssize_t length = pread(fd, text, sizeof(text) - 1, 0);
+    if (length <= 0) {
+        return 0;
+    }
+    text[length] = '\0';
+    return atoi(text);
+}
+
+int network_address_acquire(container_config_t *config) {
+    int lock_fd = lease_lock();
+    if (lock_fd == -1) {
+        return -1;
+    }
+
+    int result = -1;
+    for (int index = 0; index < NETWORK_LEASE_MAX && result != 0; index++) {
+        char path[PATH_MAX];
+        lease_path(index, path, sizeof(path));
+        int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            log_error("خطا در باز کردن اجاره %s", path);
+            break;
+        }
+        // اجاره مالک مرده (کانتینری که بدون stop از بین رفت) دوباره تخصیص می‌یابد
+        pid_t owner = lease_owner(fd);
+        bool alive = owner > 0 && (kill(owner, 0) == 0 || errno == EPERM);
+        if (!alive && write_lease(fd, getpid()) == 0) {
+            config->address_lease = index;
+            config->ipv4_address = network_container_address(index);
+            result = 0;
+        }
+        close(fd);
+    }
+    if (result != 0) {
+        log_error("نشانی آزادی در زیرشبکه کانتینرها باقی نمانده است");
+    }
+
+    lease_unlock(lock_fd);
+    return result;
+}
+
+int network_address_set_owner(const container_config_t *config, pid_t pid) {
+    if (config->address_lease < 0) {
+        return 0;
+    }
+    int lock_fd = lease_lock();
+    if (lock_fd == -1) {
+        return -1;
+    }
+    char path[PATH_MAX];
+    lease_path(config->address_lease, path, sizeof(path));
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    int result = fd != -1 && lease_owner(fd) == getpid() && write_lease(fd, pid) == 0 ? 0 : -1;
+    if (fd != -1) {
+        close(fd);
+    }
+    lease_unlock(lock_fd);
+    return result;
+}
+
+void network_address_release(container_config_t *config) {
+    if (config->address_lease < 0) {
+        return;
+    }
+    // اجاره‌ای که پس از مرگ مالک به کانتینر دیگری رسیده است حذف نمی‌شود
+    int lock_fd = lease_lock();
+    if (lock_fd != -1) {
+        char path[PATH_MAX];
+        lease_path(config->address_lease, path, sizeof(path));
+        int fd = open(path, O_RDWR | O_CLOEXEC);
+        if (fd != -1) {
+            pid_t owner = lease_owner(fd);
+            if (owner == getpid() || (config->container_pid > 0 && owner == config->container_pid)) {
+                ftruncate(fd, 0);
+            }
+            close(fd);
+        }
+        lease_unlock(lock_fd);
+    }
+    config->address_lease = -1;
+}
+
+void network_host_ifname(const container_config_t *config, char *buffer, size_t size) {
+    snprintf(buffer, size, "sc%.12s", config->id);
+}
+
+// ایجاد bridge با نشانی gateway؛ دو دور لازم است چون نشانی به شاخص رابط تازه نیاز دارد
+static int ensure_bridge(netlink_t *nl) {
+    pthread_mutex_lock(&bridge_lock);
+    int ifindex = bridge_ifindex;
+    if (ifindex == 0) {
+        netlink_bridge_create(nl, NETWORK_BRIDGE_NAME);
+        if (netlink_commit(nl) == 0 && (ifindex = if_nametoindex(NETWORK_BRIDGE_NAME)) > 0) {
+            netlink_addr_add(nl, ifindex, htonl(NETWORK_GATEWAY), NETWORK_PREFIX);
+            if (netlink_commit(nl) == 0) {
+                bridge_ifindex = ifindex;
+            } else {
+                ifindex = 0;
+            }
+        } else {
+            ifindex = 0;
+        }
+    }
+    pthread_mutex_unlock(&bridge_lock);
+
+    if (ifindex == 0) {
+        log_error("خطا در آماده‌سازی bridge %s", NETWORK_BRIDGE_NAME);
+        return -1;
+    }
+    return ifindex;
+}
+
+// ایجاد veth متصل به bridge با سر کانتینر در netns فرآیند pid یا توصیف‌گر netns_fd
+static int attach_veth(const char *host_ifname, pid_t pid, int netns_fd) {
+    netlink_t nl;
+    if (netlink_open(&nl) != 0) {
+        return -1;
+    }
+    int master = ensure_bridge(&nl);
+    if (master < 0) {
+        netlink_close(&nl);
+        return -1;
+    }
+
+    // سر کانتینر مستقیماً در netns مقصد ساخته می‌شود و جابه‌جایی جداگانه لازم نیست؛
+    // با پایان netns هر دو سر veth توسط هسته حذف می‌شوند
+    if (netns_fd >= 0) {
+        netlink_veth_create_in(&nl, host_ifname, NETWORK_CONTAINER_IFNAME, netns_fd, master);
+    } else {
+        netlink_veth_create(&nl, host_ifname, NETWORK_CONTAINER_IFNAME, pid, master);
+    }
+    int result = netlink_commit(&nl);
+    netlink_close(&nl);
+    return result;
+}
+
+int network_attach_container(container_config_t *config, pid_t pid) {
+    if (config->network != NETWORK_BRIDGE) {
+        return 0;
+    }
+
+    char host_ifname[IFNAMSIZ];
+    network_host_ifname(config, host_ifname, sizeof(host_ifname));
+    if (attach_veth(host_ifname, pid, -1) != 0) {
+        log_error("خطا در ایجاد veth برای کانتینر %s", config->id);
+        return -1;
+    }
+    return 0;
+}
+
+int network_attach_netns(const char *host_ifname, int netns_fd) {
+    return attach_veth(host_ifname, 0, netns_fd);
+}
+
+int network_configure(network_mode_t mode, uint32_t address) {
+    netlink_t nl;
+    if (netlink_open(&nl) != 0) {
+        return -1;
+    }
+
+    netlink_link_up(&nl, "lo");
+    if (mode == NETWORK_BRIDGE) {
+        int ifindex = if_nametoindex(NETWORK_CONTAINER_IFNAME);
+        if (ifindex == 0) {
+            log_error("رابط %s در کانتینر وجود ندارد", NETWORK_CONTAINER_IFNAME);
+            netlink_close(&nl);
+            return -1;
+        }
+        // هسته پیام‌های یک دسته را به ترتیب اجرا می‌کند؛ مسیر پس از روشن شدن رابط و نشانی افزوده می‌شود
+        netlink_link_up(&nl, NETWORK_CONTAINER_IFNAME);
+        netlink_addr_add(&nl, ifindex, address, NETWORK_PREFIX);
+        netlink_route_add(&nl, 0, 0, htonl(NETWORK_GATEWAY), ifindex);
+    }
+    int result = netlink_commit(&nl);
+    netlink_close(&nl);
+    return result;
+}
+
+int network_configure_container(const container_config_t *config) {
+    return network_configure(config->network, config->ipv4_address);
+}
@@ -0,0 +1,518 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "../include/portfwd.h"
+#include "../include/utils.h"
+
+#define PORTFWD_MAX_EVENTS 64
+
+// نوع شیء ثبت‌شده در epoll (اولین فیلد هر ساختار)
+typedef enum {
+    ITEM_WAKE = 0,
+    ITEM_LISTENER,
+    ITEM_CONNECTION
+} portfwd_item_t;
+
+// یک جهت اتصال: fd_in -> pipe -> fd_out
+typedef struct {
+    int fd_in;
+    int fd_out;
+    int pipe[2];
+    size_t pending;             // بایت‌های درون pipe
+    bool eof;
+} portfwd_flow_t;
+
+struct portfwd_forward;
+
+typedef struct portfwd_connection {
+    portfwd_item_t type;
+    struct portfwd_forward *forward;
+    int client_fd;
+    int upstream_fd;
+    bool connecting;            // connect غیرمسدود مقصد هنوز کامل نشده
+    bool closed;                // بسته‌شده؛ در پایان دور epoll آزاد می‌شود
+    portfwd_flow_t flows[2];    // 0: مشتری به مقصد، 1: مقصد به مشتری
+    struct portfwd_connection *next;
+    struct portfwd_connection *prev;
+} portfwd_connection_t;
+
+typedef struct portfwd_forward {
+    portfwd_item_t type;
+    bool used;
+    bool remove_requested;
+    int id;
+    int listen_fd;
+    int netns_fd;
+    uint16_t port;
+    struct sockaddr_in target;
+    portfwd_connection_t *connections;
+} portfwd_forward_t;
+
+static portfwd_item_t wake_item = ITEM_WAKE;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool running;
+    bool stop_requested;
+    int epoll_fd;
+    int wake_fd;
+    int next_id;
+    int connection_count;
+    portfwd_forward_t forwards[PORTFWD_MAX];
+} portfwd_state = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false, false, -1, -1, 0, 0, { { 0 } } };
+
+// وضعیت محلی thread حلقه
+static int host_netns_fd = -1;
+static int pipe_cache[PORTFWD_PIPE_CACHE][2];
+static int pipe_cache_count = 0;
+static portfwd_connection_t *closed_connections = NULL;
+
+static int pipe_get(int fds[2]) {
+    if (pipe_cache_count > 0) {
+        pipe_cache_count--;
+        fds[0] = pipe_cache[pipe_cache_count][0];
+        fds[1] = pipe_cache[pipe_cache_count][1];
+        return 0;
+    }
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+        return -1;
+    }
+    // ممکن است با سقف صفحات pipe کاربر رد شود؛ اندازه پیش‌فرض هم کار می‌کند
+    fcntl(fds[0], F_SETPIPE_SZ, PORTFWD_PIPE_SIZE);
+    return 0;
+}
+
+// pipe با داده باقیمانده دوباره استفاده نمی‌شود
+static void pipe_put(int fds[2], size_t pending) {
+    if (fds[0] == -1) {
+        return;
+    }
+    if (pending == 0 && pipe_cache_count < PORTFWD_PIPE_CACHE) {
+        pipe_cache[pipe_cache_count][0] = fds[0];
+        pipe_cache[pipe_cache_count][1] = fds[1];
+        pipe_cache_count++;
+    } else {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    fds[0] = fds[1] = -1;
+}
+
+static void connection_close(portfwd_connection_t *connection) {
+    if (connection->closed) {
+        return;
+    }
+    connection->closed = true;
+    close(connection->client_fd);
+    close(connection->upstream_fd);
+    for (int i = 0; i < 2; i++) {
+        pipe_put(connection->flows[i].pipe, connection->flows[i].pending);
+    }
+
+    portfwd_forward_t *forward = connection->forward;
+    if (connection->prev) {
+        connection->prev->next = connection->next;
+    } else {
+        forward->connections = connection->next;
+    }
+    if (connection->next) {
+        connection->next->prev = connection->prev;
+    }
+    __atomic_sub_fetch(&portfwd_state.connection_count, 1, __ATOMIC_RELAXED);
+
+    // رویدادهای دیگر همین دور ممکن است هنوز به آن اشاره کنند
+    connection->next = closed_connections;
+    closed_connections = connection;
+}
+
+// انتقال تا جایی که سوکت یا pipe اجازه دهد؛ -1 یعنی خطای اتصال
+static int flow_pump(portfwd_flow_t *flow) {
+    for (;;) {
+        while (flow->pending > 0) {
+            ssize_t n = splice(flow->pipe[0], NULL, flow->fd_out, NULL, flow->pending,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0) {
+                flow->pending -= n;
+                continue;
+            }
+            return n < 0 && errno == EAGAIN ? 0 : -1;
+        }
+        if (flow->eof) {
+            return 0;
+        }
+        ssize_t n = splice(flow->fd_in, NULL, flow->pipe[1], NULL, PORTFWD_PIPE_SIZE,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            flow->pending += n;
+        } else if (n == 0) {
+            // نیمه‌بسته شدن به طرف مقابل منتقل می‌شود و جهت دیگر ادامه دارد
+            flow->eof = true;
+            shutdown(flow->fd_out, SHUT_WR);
+            return 0;
+        } else {
+            return errno == EAGAIN ? 0 : -1;
+        }
+    }
+}
+
+static void connection_event(portfwd_connection_t *connection, uint32_t events) {
+    if (connection->closed) {
+        return;
+    }
+    // تا کامل شدن connect فقط سوکت مقصد در epoll است
+    if (connection->connecting) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            return;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        struct epoll_event event = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data.ptr = connection };
+        if (getsockopt(connection->upstream_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0 ||
+            epoll_ctl(portfwd_state.epoll_fd, EPOLL_CTL_ADD, connection->client_fd, &event) != 0) {
+            connection_close(connection);
+            return;
+        }
+        connection->connecting = false;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (flow_pump(&connection->flows[i]) != 0) {
+            connection_close(connection);
+            return;
+        }
+    }
+    if (connection->flows[0].eof && connection->flows[1].eof &&
+        connection->flows[0].pending == 0 && connection->flows[1].pending == 0) {
+        connection_close(connection);
+    }
+}
+
+// سوکت مقصد در network namespace کانتینر ساخته می‌شود و پس از آن مستقل از thread است
+static int upstream_socket(portfwd_forward_t *forward) {
+    if (forward->netns_fd != -1 && setns(forward->netns_fd, CLONE_NEWNET) != 0) {
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (forward->netns_fd != -1 && setns(host_netns_fd, CLONE_NEWNET) != 0) {
+        log_error("خطا در بازگشت به network namespace میزبان");
+    }
+    return fd;
+}
+
+static void connection_open(portfwd_forward_t *forward, int client_fd) {
+    portfwd_connection_t *connection = calloc(1, sizeof(portfwd_connection_t));
+    int upstream_fd = connection ? upstream_socket(forward) : -1;
+    if (upstream_fd == -1) {
+        free(connection);
+        close(client_fd);
+        return;
+    }
+    connection->type = ITEM_CONNECTION;
+    connection->forward = forward;
+    connection->client_fd = client_fd;
+    connection->upstream_fd = upstream_fd;
+    connection->flows[0] = (portfwd_flow_t){ client_fd, upstream_fd, { -1, -1 }, 0, false };
+    connection->flows[1] = (portfwd_flow_t){ upstream_fd, client_fd, { -1, -1 }, 0, false };
+
+    int one = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(upstream_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int result = connect(upstream_fd, (struct sockaddr *)&forward->target, sizeof(forward->target));
+    connection->connecting = result != 0;
+    bool ok = result == 0 || errno == EINPROGRESS;
+    ok = ok && pipe_get(connection->flows[0].pipe) == 0 && pipe_get(connection->flows[1].pipe) == 0;
+
+    // هر دو سوکت با edge-triggered و همان اشاره‌گر؛ هر رویداد هر دو جهت را پیش می‌برد
+    struct epoll_event event = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data.ptr = connection };
+    ok = ok && epoll_ctl(portfwd_state.epoll_fd, EPOLL_CTL_ADD, upstream_fd, &event) == 0 &&
+         (connection->connecting || epoll_ctl(portfwd_state.epoll_fd, EPOLL_CTL_ADD, client_fd, &event) == 0);
+
+    connection->next = forward->connections;
+    if (forward->connections) {
+        forward->connections->prev = connection;
+    }
+    forward->connections = connection;
+    __atomic_add_fetch(&portfwd_state.connection_count, 1, __ATOMIC_RELAXED);
+    if (!ok) {
+        connection_close(connection);
+    }
+}
+
+static void listener_event(portfwd_forward_t *forward) {
+    // forward ممکن است در همین دور epoll بسته شده باشد
+    while (forward->listen_fd != -1) {
+        int client_fd = accept4(forward->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd == -1) {
+            if (errno == ECONNABORTED || errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                log_error("خطا در پذیرش اتصال پورت %u: %s", forward->port, strerror(errno));
+            }
+            return;
+        }
+        connection_open(forward, client_fd);
+    }
+}
+
+// بستن forward در thread حلقه؛ جای آن پس از آزاد شدن اتصال‌ها دوباره قابل استفاده است
+static void forward_close(portfwd_forward_t *forward) {
+    while (forward->connections) {
+        connection_close(forward->connections);
+    }
+    close(forward->listen_fd);
+    if (forward->netns_fd != -1) {
+        close(forward->netns_fd);
+    }
+    forward->listen_fd = forward->netns_fd = -1;
+}
+
+static void free_closed_connections() {
+    while (closed_connections) {
+        portfwd_connection_t *next = closed_connections->next;
+        free(closed_connections);
+        closed_connections = next;
+    }
+}
+
+// درخواست‌های حذف و توقف
+static bool handle_requests() {
+    uint64_t value;
+    if (read(portfwd_state.wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        return false;
+    }
+    pthread_mutex_lock(&portfwd_state.lock);
+    bool stop = portfwd_state.stop_requested;
+    for (int i = 0; i < PORTFWD_MAX; i++) {
+        portfwd_forward_t *forward = &portfwd_state.forwards[i];
+        if (forward->used && (forward->remove_requested || stop)) {
+            forward_close(forward);
+            forward->used = false;
+        }
+    }
+    pthread_cond_broadcast(&portfwd_state.cond);
+    pthread_mutex_unlock(&portfwd_state.lock);
+    return stop;
+}
+
+static void* portfwd_thread_main(void *arg) {
+    (void)arg;
+    // splice به سوکت بسته‌شده SIGPIPE همین thread را می‌فرستد؛ بسته ماندن آن فرآیند را نگه می‌دارد
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    struct epoll_event events[PORTFWD_MAX_EVENTS];
+    bool stop = false;
+    while (!stop) {
+        int count = epoll_wait(portfwd_state.epoll_fd, events, PORTFWD_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            log_error("خطا در epoll انتقال پورت: %s", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            portfwd_item_t type = *(portfwd_item_t *)events[i].data.ptr;
+            if (type == ITEM_LISTENER) {
+                listener_event(events[i].data.ptr);
+            } else if (type == ITEM_CONNECTION) {
+                connection_event(events[i].data.ptr, events[i].events);
+            } else {
+                stop = handle_requests();
+            }
+        }
+        free_closed_connections();
+    }
+
+    pthread_mutex_lock(&portfwd_state.lock);
+    for (int i = 0; i < PORTFWD_MAX; i++) {
+        if (portfwd_state.forwards[i].used) {
+            forward_close(&portfwd_state.forwards[i]);
+            portfwd_state.forwards[i].used = false;
+        }
+    }
+    free_closed_connections();
+    while (pipe_cache_count > 0) {
+        pipe_cache_count--;
+        close(pipe_cache[pipe_cache_count][0]);
+        close(pipe_cache[pipe_cache_count][1]);
+    }
+    close(portfwd_state.epoll_fd);
+    close(portfwd_state.wake_fd);
+    close(host_netns_fd);
+    portfwd_state.epoll_fd = portfwd_state.wake_fd = host_netns_fd = -1;
+    portfwd_state.running = false;
+    pthread_cond_broadcast(&portfwd_state.cond);
+    pthread_mutex_unlock(&portfwd_state.lock);
+    return NULL;
+}
+
+// ساخت epoll و thread حلقه؛ با قفل گرفته‌شده فراخوانی می‌شود
+static int portfwd_start_locked() {
+    if (portfwd_state.running) {
+        return 0;
+    }
+    portfwd_state.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    portfwd_state.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    host_netns_fd = open("/proc/thread-self/ns/net", O_RDONLY | O_CLOEXEC);
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = &wake_item };
+    if (portfwd_state.epoll_fd == -1 || portfwd_state.wake_fd == -1 || host_netns_fd == -1 ||
+        epoll_ctl(portfwd_state.epoll_fd, EPOLL_CTL_ADD, portfwd_state.wake_fd, &event) != 0) {
+        log_error("خطا در راه‌اندازی انتقال پورت: %s", strerror(errno));
+        goto fail;
+    }
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attr, portfwd_thread_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        log_error("خطا در ایجاد thread انتقال پورت");
+        goto fail;
+    }
+    portfwd_state.stop_requested = false;
+    portfwd_state.running = true;
+    return 0;
+
+fail:
+    if (portfwd_state.epoll_fd != -1) close(portfwd_state.epoll_fd);
+    if (portfwd_state.wake_fd != -1) close(portfwd_state.wake_fd);
+    if (host_netns_fd != -1) close(host_netns_fd);
+    portfwd_state.epoll_fd = portfwd_state.wake_fd = host_netns_fd = -1;
+    return -1;
+}
+
+static void wake_loop() {
+    uint64_t one = 1;
+    if (write(portfwd_state.wake_fd, &one, sizeof(one)) != sizeof(one)) {
+        log_error("خطا در بیدار کردن thread انتقال پورت");
+    }
+}
+
+int portfwd_add(uint16_t host_port, int netns_fd, uint32_t target_address, uint16_t target_port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1) {
+        log_error("خطا در ایجاد سوکت انتقال پورت: %s", strerror(errno));
+        return -1;
+    }
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(host_port),
+                                   .sin_addr.s_addr = htonl(INADDR_ANY) };
+    socklen_t length = sizeof(address);
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0 ||
+        getsockname(listen_fd, (struct sockaddr *)&address, &length) != 0) {
+        log_error("خطا در گوش دادن روی پورت %u: %s", host_port, strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+    int netns_copy = -1;
+    if (netns_fd != -1 && (netns_copy = fcntl(netns_fd, F_DUPFD_CLOEXEC, 0)) == -1) {
+        close(listen_fd);
+        return -1;
+    }
+
+    pthread_mutex_lock(&portfwd_state.lock);
+    portfwd_forward_t *forward = NULL;
+    for (int i = 0; i < PORTFWD_MAX && !forward; i++) {
+        if (!portfwd_state.forwards[i].used) {
+            forward = &portfwd_state.forwards[i];
+        }
+    }
+    if (!forward || portfwd_start_locked() != 0) {
+        pthread_mutex_unlock(&portfwd_state.lock);
+        if (!forward) log_error("حداکثر %d انتقال پورت همزمان", PORTFWD_MAX);
+        close(listen_fd);
+        if (netns_copy != -1) close(netns_copy);
+        return -1;
+    }
+
+    memset(forward, 0, sizeof(*forward));
+    forward->type = ITEM_LISTENER;
+    forward->used = true;
+    forward->id = portfwd_state.next_id++;
+    forward->listen_fd = listen_fd;
+    forward->netns_fd = netns_copy;
+    forward->port = ntohs(address.sin_port);
+    forward->target.sin_family = AF_INET;
+    forward->target.sin_addr.s_addr = target_address;
+    forward->target.sin_port = htons(target_port);
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = forward };
+    if (epoll_ctl(portfwd_state.epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) != 0) {
+        forward->used = false;
+        pthread_mutex_unlock(&portfwd_state.lock);
+        close(listen_fd);
+        if (netns_copy != -1) close(netns_copy);
+        return -1;
+    }
+    int id = forward->id;
+    pthread_mutex_unlock(&portfwd_state.lock);
+    return id;
+}
+
+static portfwd_forward_t* find_forward(int id) {
+    for (int i = 0; i < PORTFWD_MAX; i++) {
+        if (portfwd_state.forwards[i].used && portfwd_state.forwards[i].id == id) {
+            return &portfwd_state.forwards[i];
+        }
+    }
+    return NULL;
+}
+
+int portfwd_remove(int id) {
+    pthread_mutex_lock(&portfwd_state.lock);
+    portfwd_forward_t *forward = find_forward(id);
+    if (!forward) {
+        pthread_mutex_unlock(&portfwd_state.lock);
+        return -1;
+    }
+    forward->remove_requested = true;
+    wake_loop();
+    while (find_forward(id)) {
+        pthread_cond_wait(&portfwd_state.cond, &portfwd_state.lock);
+    }
+    pthread_mutex_unlock(&portfwd_state.lock);
+    return 0;
+}
+
+int portfwd_port(int id) {
+    pthread_mutex_lock(&portfwd_state.lock);
+    portfwd_forward_t *forward = find_forward(id);
+    int port = forward ? forward->port : -1;
+    pthread_mutex_unlock(&portfwd_state.lock);
+    return port;
+}
+
+int portfwd_connection_count() {
+    return __atomic_load_n(&portfwd_state.connection_count, __ATOMIC_RELAXED);
+}
+
+void portfwd_stop() {
+    pthread_mutex_lock(&portfwd_state.lock);
+    if (portfwd_state.running) {
+        portfwd_state.stop_requested = true;
+        wake_loop();
+        while (portfwd_state.running) {
+            pthread_cond_wait(&portfwd_state.cond, &portfwd_state.lock);
+        }
+    }
+    pthread_mutex_unlock(&portfwd_state.lock);
+}
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/eventfd.h>
+#include <sys/fanotify.h>
+#include <sys/syscall.h>
+#include <linux/openat2.h>
+#include "../include/prewarm.h"
+#include "../include/threadpool.h"
+#include "../include/utils.h"
+
+// اندازه بافر خواندن رویدادهای fanotify
+#define PREWARM_EVENT_BUFFER 65536
+
+// ضبط در حال اجرای یک کانتینر
+typedef struct prewarm_recorder {
+    char id[64];
+    char root[PATH_MAX];
+    char trace_path[PATH_MAX];
+    unsigned seconds;
+    int fanotify_fd;
+    int stop_fd;                // eventfd برای پایان زودتر از مهلت
+    pthread_t thread;
+
+    char **files;               // مسیرهای نسبی به ترتیب نخستین باز شدن
+    size_t file_count;
+    size_t file_capacity;
+    char **seen;                // جدول درهم‌سازی با آدرس‌دهی باز روی files
+    size_t seen_capacity;
+
+    struct prewarm_recorder *next;
+} prewarm_recorder_t;
+
+static pthread_mutex_t recorders_lock = PTHREAD_MUTEX_INITIALIZER;
+static prewarm_recorder_t *recorders = NULL;
+
+// یک کار پیش‌خوانی: همه محدوده‌های یک فایل
+typedef struct {
+    int root_fd;
+    char *path;
+    size_t count;
+    size_t capacity;
+    struct { uint64_t offset, length; } *ranges;
+    prewarm_stats_t *stats;
+} prewarm_job_t;
+
+// باز کردن مسیر نسبی با تفسیر پیوندهای نمادین درون root (مانند داخل کانتینر)
+static int open_in_root(int root_fd, const char *path) {
+    struct open_how how = { .flags = O_RDONLY | O_CLOEXEC, .resolve = RESOLVE_IN_ROOT | RESOLVE_NO_MAGICLINKS };
+    int fd = syscall(SYS_openat2, root_fd, path, &how, sizeof(how));
+    if (fd == -1 && errno == ENOSYS) {
+        // هسته پیش از 5.6: فقط مسیرهای بدون ".." پذیرفته می‌شوند
+        if (strcmp(path, "..") == 0 || strncmp(path, "../", 3) == 0 || strstr(path, "/../") ||
+            (strlen(path) >= 3 && strcmp(path + strlen(path) - 3, "/..") == 0)) {
+            errno = EINVAL;
+            return -1;
+        }
+        fd = openat(root_fd, path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    }
+    return fd;
+}
+
+// ---------- ضبط ----------
+
+static uint64_t hash_path(const char *path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// افزودن مسیر نسبی اگر پیش‌تر دیده نشده باشد
+static int recorder_add(prewarm_recorder_t *recorder, const char *path) {
+    if ((recorder->file_count + 1) * 2 > recorder->seen_capacity) {
+        size_t capacity = recorder->seen_capacity ? recorder->seen_capacity * 2 : 1024;
+        char **seen = calloc(capacity, sizeof(char *));
+        if (!seen) {
+            return -1;
+        }
+        for (size_t i = 0; i < recorder->file_count; i++) {
+            size_t slot = hash_path(recorder->files[i]) & (capacity - 1);
+            while (seen[slot]) slot = (slot + 1) & (capacity - 1);
+            seen[slot] = recorder->files[i];
+        }
+        free(recorder->seen);
+        recorder->seen = seen;
+        recorder->seen_capacity = capacity;
+    }
+
+    size_t slot = hash_path(path) & (recorder->seen_capacity - 1);
+    while (recorder->seen[slot]) {
+        if (strcmp(recorder->seen[slot], path) == 0) {
+            return 0;
+        }
+        slot = (slot + 1) & (recorder->seen_capacity - 1);
+    }
+
+    if (recorder->file_count == recorder->file_capacity) {
+        size_t capacity = recorder->file_capacity ? recorder->file_capacity * 2 : 256;
+        char **files = realloc(recorder->files, capacity * sizeof(char *));
+        if (!files) {
+            return -1;
+        }
+        recorder->files = files;
+        recorder->file_capacity = capacity;
+    }
+    char *copy = strdup(path);
+    if (!copy) {
+        return -1;
+    }
+    recorder->files[recorder->file_count++] = copy;
+    recorder->seen[slot] = copy;
+    return 0;
+}
+
+// ثبت فایل یک رویداد در صورتی که زیر root باشد
+static void recorder_handle_event(prewarm_recorder_t *recorder, int fd) {
+    char link[64], path[PATH_MAX];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    ssize_t length = readlink(link, path, sizeof(path) - 1);
+    if (length <= 0) {
+        return;
+    }
+    path[length] = '\0';
+
+    size_t root_length = strlen(recorder->root);
+    if (strncmp(path, recorder->root, root_length) == 0 && path[root_length] == '/' &&
+        !strchr(path, '\n')) {
+        recorder_add(recorder, path + root_length + 1);
+    }
+}
+
+// نوشتن محدوده‌های مقیم در حافظه نهان هر فایل به ترتیب باز شدن
+static int recorder_write_trace(prewarm_recorder_t *recorder, prewarm_stats_t *stats) {
+    char tmp_path[PATH_MAX + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", recorder->trace_path);
+    FILE *trace = fopen(tmp_path, "w");
+    int root_fd = open(recorder->root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (!trace || root_fd == -1) {
+        log_error("خطا در ایجاد trace %s", recorder->trace_path);
+        if (trace) fclose(trace);
+        if (root_fd != -1) close(root_fd);
+        return -1;
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    fprintf(trace, "# prewarm trace: <offset> <length> <path>\n");
+    for (size_t i = 0; i < recorder->file_count; i++) {
+        int fd = open_in_root(root_fd, recorder->files[i]);
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            if (fd != -1) close(fd);
+            continue;
+        }
+
+        size_t pages = (st.st_size + page_size - 1) / page_size;
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        unsigned char *residency = map != MAP_FAILED ? malloc(pages) : NULL;
+        if (residency && mincore(map, st.st_size, residency) == 0) {
+            // صفحه‌های مقیم پیوسته (با تحمل فاصله‌های کوچک) یک محدوده می‌شوند
+            size_t start = 0, end = 0;
+            bool open_range = false;
+            for (size_t page = 0; page <= pages; page++) {
+                bool resident = page < pages && (residency[page] & 1);
+                if (resident && open_range && page - end > PREWARM_MERGE_PAGES) {
+                    fprintf(trace, "%zu %zu %s\n", start * page_size, (end - start) * page_size, recorder->files[i]);
+                    stats->ranges++;
+                    stats->bytes += (end - start) * page_size;
+                    open_range = false;
+                }
+                if (resident && !open_range) {
+                    start = page;
+                    open_range = true;
+                }
+                if (resident) {
+                    end = page + 1;
+                }
+            }
+            if (open_range) {
+                fprintf(trace, "%zu %zu %s\n", start * page_size, (end - start) * page_size, recorder->files[i]);
+                stats->ranges++;
+                stats->bytes += (end - start) * page_size;
+            }
+            stats->files++;
+        }
+        free(residency);
+        if (map != MAP_FAILED) munmap(map, st.st_size);
+        close(fd);
+    }
+    close(root_fd);
+
+    if (fclose(trace) != 0 || rename(tmp_path, recorder->trace_path) != 0) {
+        log_error("خطا در نوشتن trace %s", recorder->trace_path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static void* recorder_thread_main(void *arg) {
+    prewarm_recorder_t *recorder = arg;
+    char *buffer = malloc(PREWARM_EVENT_BUFFER);
+    uint64_t deadline = monotonic_time_ns() + recorder->seconds * 1000000000ULL;
+
+    while (buffer) {
+        uint64_t now = monotonic_time_ns();
+        if (now >= deadline) {
+            break;
+        }
+        struct pollfd fds[2] = { { recorder->fanotify_fd, POLLIN, 0 }, { recorder->stop_fd, POLLIN, 0 } };
+        int ready = poll(fds, 2, (int)((deadline - now + 999999) / 1000000));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ready == 0) {
+            break;
+        }
+
+        ssize_t length;
+        while ((fds[0].revents & POLLIN) &&
+               (length = read(recorder->fanotify_fd, buffer, PREWARM_EVENT_BUFFER)) > 0) {
+            struct fanotify_event_metadata *event = (struct fanotify_event_metadata *)buffer;
+            for (; FAN_EVENT_OK(event, length); event = FAN_EVENT_NEXT(event, length)) {
+                if (event->vers != FANOTIFY_METADATA_VERSION) {
+                    continue;
+                }
+                if (event->fd >= 0) {
+                    recorder_handle_event(recorder, event->fd);
+                    close(event->fd);
+                }
+            }
+        }
+
+        // درخواست پایان پس از خواندن رویدادهای در صف
+        if (fds[1].revents) {
+            break;
+        }
+    }
+    free(buffer);
+
+    // پیش از mincore ضبط بسته می‌شود تا باز کردن‌های خود ما ثبت نشوند
+    close(recorder->fanotify_fd);
+    recorder->fanotify_fd = -1;
+
+    prewarm_stats_t stats = { 0 };
+    if (recorder_write_trace(recorder, &stats) == 0) {
+        log_message("trace %s: %lu فایل، %lu محدوده، %.1f MB", recorder->trace_path,
+                    stats.files, stats.ranges, stats.bytes / (1024.0 * 1024.0));
+    }
+    return NULL;
+}
+
+static void recorder_free(prewarm_recorder_t *recorder) {
+    for (size_t i = 0; i < recorder->file_count; i++) {
+        free(recorder->files[i]);
+    }
+    free(recorder->files);
+    free(recorder->seen);
+    if (recorder->fanotify_fd != -1) close(recorder->fanotify_fd);
+    if (recorder->stop_fd != -1) close(recorder->stop_fd);
+    free(recorder);
+}
+
+// شروع ضبط؛ علامت fanotify پیش از بازگشت ثبت می‌شود تا نخستین exec از دست نرود
+int prewarm_record_start(const char *id, const char *root, const char *trace_path, unsigned seconds) {
+    prewarm_recorder_t *recorder = calloc(1, sizeof(prewarm_recorder_t));
+    if (!recorder) {
+        return -1;
+    }
+    strncpy(recorder->id, id, sizeof(recorder->id) - 1);
+    if (!realpath(root, recorder->root)) {
+        log_error("مسیر ضبط یافت نشد: %s", root);
+        free(recorder);
+        return -1;
+    }
+    strncpy(recorder->trace_path, trace_path, sizeof(recorder->trace_path) - 1);
+    recorder->seconds = seconds;
+    recorder->stop_fd = eventfd(0, EFD_CLOEXEC);
+
+    // علامت روی کل فایل‌سیستم: mount namespace کانتینر نسخه دیگری از نصب rootfs دارد
+    // ولی superblock آن یکی است
+    recorder->fanotify_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK,
+                                          O_RDONLY | O_LARGEFILE | O_CLOEXEC);
+    if (recorder->fanotify_fd == -1 || recorder->stop_fd == -1 ||
+        fanotify_mark(recorder->fanotify_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, FAN_OPEN,
+                      AT_FDCWD, recorder->root) != 0) {
+        log_error("خطا در راه‌اندازی fanotify روی %s", recorder->root);
+        recorder_free(recorder);
+        return -1;
+    }
+
+    if (pthread_create(&recorder->thread, NULL, recorder_thread_main, recorder) != 0) {
+        log_error("خطا در ایجاد thread ضبط");
+        recorder_free(recorder);
+        return -1;
+    }
+
+    pthread_mutex_lock(&recorders_lock);
+    recorder->next = recorders;
+    recorders = recorder;
+    pthread_mutex_unlock(&recorders_lock);
+    return 0;
+}
+
+// پایان ضبط و انتظار برای نوشتن trace
+int prewarm_record_finish(const char *id) {
+    pthread_mutex_lock(&recorders_lock);
+    prewarm_recorder_t **link = &recorders;
+    while (*link && strcmp((*link)->id, id) != 0) {
+        link = &(*link)->next;
+    }
+    prewarm_recorder_t *recorder = *link;
+    if (recorder) {
+        *link = recorder->next;
+    }
+    pthread_mutex_unlock(&recorders_lock);
+
+    if (!recorder) {
+        return 0;
+    }
+    uint64_t one = 1;
+    if (write(recorder->stop_fd, &one, sizeof(one)) != sizeof(one)) {
+        log_debug("خطا در اعلام پایان ضبط %s", id);
+    }
+    pthread_join(recorder->thread, NULL);
+    recorder_free(recorder);
+    return 0;
+}
+
+// ---------- پیش‌خوانی ----------
+
+static void prewarm_job_run(void *arg) {
+    prewarm_job_t *job = arg;
+    int fd = open_in_root(job->root_fd, job->path);
+    if (fd != -1) {
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < job->count; i++) {
+            // WILLNEED خواندن ناهمگام را آغاز می‌کند و overlayfs آن را به فایل لایه پایینی می‌رساند
+            if (posix_fadvise(fd, job->ranges[i].offset, job->ranges[i].length, POSIX_FADV_WILLNEED) == 0) {
+                bytes += job->ranges[i].length;
+            }
+        }
+        close(fd);
+        __atomic_add_fetch(&job->stats->files, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&job->stats->ranges, job->count, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&job->stats->bytes, bytes, __ATOMIC_RELAXED);
+    }
+    free(job->path);
+    free(job->ranges);
+    free(job);
+}
+
+static void submit_job(threadpool_t *pool, prewarm_job_t *job) {
+    if (!pool || threadpool_submit(pool, prewarm_job_run, job) != 0) {
+        prewarm_job_run(job);
+    }
+}
+
+int prewarm_replay(const char *root, const char *trace_path, int threads, prewarm_stats_t *stats) {
+    if (stats) {
+        memset(stats, 0, sizeof(prewarm_stats_t));
+    }
+    FILE *trace = fopen(trace_path, "r");
+    if (!trace) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd == -1) {
+        log_error("مسیر پیش‌خوانی یافت نشد: %s", root);
+        fclose(trace);
+        return -1;
+    }
+
+    prewarm_stats_t local = { 0 };
+    uint64_t start = monotonic_time_ns();
+    threadpool_t *pool = threadpool_create(threads, 0);
+    prewarm_job_t *job = NULL;
+    int result = 0;
+
+    char line[PATH_MAX + 64];
+    while (result == 0 && fgets(line, sizeof(line), trace)) {
+        unsigned long long offset, length;
+        int path_start;
+        if (line[0] == '#' || sscanf(line, "%llu %llu %n", &offset, &length, &path_start) != 2) {
+            continue;
+        }
+        char *path = line + path_start;
+        path[strcspn(path, "\n")] = '\0';
+
+        // خطوط پشت سر هم یک فایل در یک کار جمع می‌شوند
+        if (job && strcmp(job->path, path) != 0) {
+            submit_job(pool, job);
+            job = NULL;
+        }
+        if (!job) {
+            job = calloc(1, sizeof(prewarm_job_t));
+            if (!job || !(job->path = strdup(path))) {
+                free(job);
+                job = NULL;
+                result = -1;
+                break;
+            }
+            job->root_fd = root_fd;
+            job->stats = &local;
+        }
+        if (job->count == job->capacity) {
+            size_t capacity = job->capacity ? job->capacity * 2 : 4;
+            void *ranges = realloc(job->ranges, capacity * sizeof(*job->ranges));
+            if (!ranges) {
+                result = -1;
+                break;
+            }
+            job->ranges = ranges;
+            job->capacity = capacity;
+        }
+        job->ranges[job->count].offset = offset;
+        job->ranges[job->count].length = length;
+        job->count++;
+    }
+    if (job) {
+        submit_job(pool, job);
+    }
+
+    if (pool) {
+        threadpool_wait(pool);
+        threadpool_destroy(pool);
+    }
+    fclose(trace);
+    close(root_fd);
+
+    log_debug("پیش‌خوانی %s: %lu فایل، %.1f MB در %.2f ثانیه", trace_path, local.files,
+              local.bytes / (1024.0 * 1024.0), (monotonic_time_ns() - start) / 1e9);
+    if (stats) {
+        *stats = local;
+    }
+    return result;
+}
+
+// آرگومان thread پیش‌خوانی پس‌زمینه
+typedef struct {
+    char root[PATH_MAX];
+    char trace_path[PATH_MAX];
+} prewarm_task_t;
+
+static void* prewarm_thread_main(void *arg) {
+    prewarm_task_t *task = arg;
+    prewarm_replay(task->root, task->trace_path, PREWARM_THREADS, NULL);
+    free(task);
+    return NULL;
+}
+
+int prewarm_start(const char *root, const char *trace_path) {
+    if (access(trace_path, R_OK) != 0) {
+        return 0;
+    }
+    prewarm_task_t *task = malloc(sizeof(prewarm_task_t));
+    if (!task) {
+        return -1;
+    }
+    snprintf(task->root, sizeof(task->root), "%s", root);
+    snprintf(task->trace_path, sizeof(task->trace_path), "%s", trace_path);
+
+    // thread جدا شده است؛ پیش‌خوانی فقط یک بهینه‌سازی است و کسی منتظر آن نمی‌ماند
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&thread, &attr, prewarm_thread_main, task);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        log_error("خطا در ایجاد thread پیش‌خوانی");
+        free(task);
+        return -1;
+    }
+    return 0;
+}
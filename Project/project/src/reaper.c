@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "../include/reaper.h"
+#include "../include/threadpool.h"
+#include "../include/utils.h"
+
+// اولویت I/O کلاس idle (linux/ioprio.h در همه توزیع‌ها نصب نیست)
+#define REAPER_IOPRIO_WHO_PROCESS 1
+#define REAPER_IOPRIO_CLASS_IDLE 3
+#define REAPER_IOPRIO_CLASS_SHIFT 13
+
+// هر چند حذف یک بار سرعت با سقف مقایسه می‌شود
+#define REAPER_THROTTLE_BATCH 64
+
+// وضعیت reaper پس‌زمینه
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool running;               // thread ساخته شده و هنوز join نشده است
+    bool stop_requested;
+    bool pending;               // مورد تازه‌ای به trash اضافه شده است
+    uint64_t drain_deadline;    // پس از درخواست توقف، حذف تا این زمان ادامه می‌یابد
+    int threads;
+    unsigned rate;
+} reaper_state = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, false, false, false, 0, 0,
+                   REAPER_DEFAULT_RATE };
+
+// شمارنده برای نام‌های یکتا در trash
+static unsigned trash_counter = 0;
+
+// یک کار حذف: زیردرخت name در دایرکتوری parent_fd
+typedef struct {
+    int parent_fd;
+    char *name;
+    unsigned rate;              // سهم این thread از سقف سرعت
+} reaper_task_t;
+
+// شمارش سرعت هر thread؛ پنجره پس از بیکاری طولانی از نو شروع می‌شود تا اعتبار انباشته نشود
+typedef struct {
+    unsigned rate;
+    uint64_t window_start;
+    uint64_t count;
+} reaper_throttle_t;
+
+// کار حذف پس از درخواست توقف فقط تا پایان مهلت تخلیه ادامه می‌یابد
+static bool reaper_should_stop() {
+    return __atomic_load_n(&reaper_state.stop_requested, __ATOMIC_ACQUIRE) &&
+           monotonic_time_ns() >= __atomic_load_n(&reaper_state.drain_deadline, __ATOMIC_RELAXED);
+}
+
+// کاهش اولویت CPU و I/O thread جاری
+static void lower_priority() {
+    static __thread bool lowered = false;
+    if (lowered) {
+        return;
+    }
+    struct sched_param param = { 0 };
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    syscall(SYS_ioprio_set, REAPER_IOPRIO_WHO_PROCESS, 0,
+            REAPER_IOPRIO_CLASS_IDLE << REAPER_IOPRIO_CLASS_SHIFT);
+    lowered = true;
+}
+
+// فراخوانی پس از هر حذف؛ در صورت جلو بودن از سقف سرعت می‌خوابد
+static void reaper_throttle(void *arg) {
+    reaper_throttle_t *throttle = arg;
+    if (throttle->rate == 0 || ++throttle->count % REAPER_THROTTLE_BATCH != 0) {
+        return;
+    }
+
+    uint64_t now = monotonic_time_ns();
+    uint64_t elapsed = now - throttle->window_start;
+    uint64_t expected = throttle->count * 1000000000ULL / throttle->rate;
+    if (elapsed > expected + 1000000000ULL) {
+        throttle->window_start = now;
+        throttle->count = 0;
+    } else if (elapsed < expected) {
+        uint64_t delay = expected - elapsed;
+        struct timespec ts = { delay / 1000000000ULL, delay % 1000000000ULL };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void reaper_task_run(void *arg) {
+    reaper_task_t *task = arg;
+    lower_priority();
+
+    if (!reaper_should_stop()) {
+        reaper_throttle_t throttle = { task->rate, monotonic_time_ns(), 0 };
+        remove_directory_at(task->parent_fd, task->name, reaper_throttle, &throttle);
+    }
+    free(task->name);
+    free(task);
+}
+
+// ارسال کار حذف یک زیردرخت
+static void submit_subtree(threadpool_t *pool, int parent_fd, const char *name, unsigned rate) {
+    reaper_task_t *task = malloc(sizeof(reaper_task_t));
+    if (task) {
+        task->parent_fd = parent_fd;
+        task->name = strdup(name);
+        task->rate = rate;
+    }
+    if (!task || !task->name || !pool || threadpool_submit(pool, reaper_task_run, task) != 0) {
+        if (task) {
+            free(task->name);
+            free(task);
+        }
+        remove_directory_at(parent_fd, name, NULL, NULL);
+    }
+}
+
+// پخش زیردرخت‌های یک مورد trash بین thread ها
+// دو سطح اول شکسته می‌شوند چون دایرکتوری overlay فقط upper و work را در سطح اول دارد
+static void reap_item(threadpool_t *pool, int trash_fd, const char *name, unsigned rate) {
+    int item_fd = openat(trash_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR *item = item_fd != -1 ? fdopendir(item_fd) : NULL;
+    if (!item) {
+        if (item_fd != -1) close(item_fd);
+        unlinkat(trash_fd, name, 0);
+        return;
+    }
+
+    // دایرکتوری‌های سطح اول تا پایان کارها باز می‌مانند چون کارها نسبت به آن‌ها کار می‌کنند
+    DIR *children[256];
+    int child_count = 0;
+
+    struct dirent *entry;
+    while (!reaper_should_stop() && (entry = readdir(item)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        DIR *child = NULL;
+        if (entry->d_type == DT_DIR && child_count < (int)(sizeof(children) / sizeof(children[0]))) {
+            int child_fd = openat(item_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            child = child_fd != -1 ? fdopendir(child_fd) : NULL;
+            if (!child && child_fd != -1) close(child_fd);
+        }
+
+        if (!child) {
+            submit_subtree(pool, item_fd, entry->d_name, rate);
+            continue;
+        }
+
+        children[child_count++] = child;
+        struct dirent *grandchild;
+        while (!reaper_should_stop() && (grandchild = readdir(child)) != NULL) {
+            if (strcmp(grandchild->d_name, ".") != 0 && strcmp(grandchild->d_name, "..") != 0) {
+                submit_subtree(pool, dirfd(child), grandchild->d_name, rate);
+            }
+        }
+    }
+
+    if (pool) {
+        threadpool_wait(pool);
+    }
+    for (int i = 0; i < child_count; i++) {
+        closedir(children[i]);
+    }
+    closedir(item);
+
+    // اسکلت خالی باقیمانده
+    if (!reaper_should_stop()) {
+        remove_directory_at(trash_fd, name, NULL, NULL);
+    }
+}
+
+// راه‌اندازی دایرکتوری trash
+int reaper_init() {
+    if (create_directory(REAPER_TRASH_PATH, 0700) != 0) {
+        log_error("خطا در ایجاد دایرکتوری %s", REAPER_TRASH_PATH);
+        return -1;
+    }
+    return 0;
+}
+
+// یک دور حذف همه موارد trash
+int reaper_collect() {
+    int trash_fd = open(REAPER_TRASH_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR *trash = trash_fd != -1 ? fdopendir(trash_fd) : NULL;
+    if (!trash) {
+        if (trash_fd != -1) close(trash_fd);
+        return 0;
+    }
+
+    pthread_mutex_lock(&reaper_state.lock);
+    int threads = reaper_state.threads;
+    unsigned rate = reaper_state.rate;
+    reaper_state.pending = false;
+    pthread_mutex_unlock(&reaper_state.lock);
+
+    threadpool_t *pool = NULL;
+    int removed = 0;
+    uint64_t start = monotonic_time_ns();
+    struct dirent *entry;
+    while (!reaper_should_stop() && (entry = readdir(trash)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        // thread pool فقط وقتی چیزی برای حذف هست ساخته می‌شود
+        if (!pool) {
+            pool = threadpool_create(threads, 0);
+        }
+        unsigned thread_rate = rate && pool ? (rate + threadpool_size(pool) - 1) / threadpool_size(pool) : rate;
+        reap_item(pool, trash_fd, entry->d_name, thread_rate);
+        removed++;
+    }
+
+    if (pool) {
+        threadpool_destroy(pool);
+    }
+    closedir(trash);
+
+    if (removed > 0) {
+        log_debug("reaper: %d مورد در %.2f ثانیه حذف شد", removed, (monotonic_time_ns() - start) / 1e9);
+    }
+    return removed;
+}
+
+// انتقال path به trash
+int reaper_discard(const char *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    char trash_path[PATH_MAX];
+    snprintf(trash_path, sizeof(trash_path), "%s/%s.%d.%u", REAPER_TRASH_PATH, name, getpid(),
+             __atomic_add_fetch(&trash_counter, 1, __ATOMIC_RELAXED));
+
+    if (reaper_init() != 0 || rename(path, trash_path) != 0) {
+        // فایل‌سیستم دیگر (EXDEV) یا trash در دسترس نیست
+        log_debug("انتقال %s به trash ممکن نیست، حذف همزمان", path);
+        return remove_directory(path);
+    }
+
+    pthread_mutex_lock(&reaper_state.lock);
+    bool running = reaper_state.running;
+    reaper_state.pending = true;
+    pthread_cond_signal(&reaper_state.cond);
+    pthread_mutex_unlock(&reaper_state.lock);
+
+    if (!running) {
+        return remove_directory(trash_path);
+    }
+    return 0;
+}
+
+// حلقه thread پس‌زمینه reaper
+static void* reaper_thread_main(void *arg) {
+    (void)arg;
+    lower_priority();
+
+    pthread_mutex_lock(&reaper_state.lock);
+    while (!reaper_state.stop_requested) {
+        pthread_mutex_unlock(&reaper_state.lock);
+        reaper_collect();
+        pthread_mutex_lock(&reaper_state.lock);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += REAPER_INTERVAL_SECONDS;
+        while (!reaper_state.stop_requested && !reaper_state.pending &&
+               pthread_cond_timedwait(&reaper_state.cond, &reaper_state.lock, &deadline) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&reaper_state.lock);
+
+    // فرآیند CLI پس از توقف خارج می‌شود؛ آنچه پس از آخرین دور به trash رفته تا پایان مهلت حذف می‌شود
+    reaper_collect();
+    return NULL;
+}
+
+// برداشتن thread از وضعیت، درخواست توقف با مهلت تخلیه و join بیرون از قفل
+// (با قفل گرفته‌شده فراخوانی و با قفل گرفته‌شده برمی‌گردد)
+static void reaper_join_locked(uint64_t drain_ns) {
+    if (!reaper_state.running) {
+        return;
+    }
+    pthread_t thread = reaper_state.thread;
+    reaper_state.running = false;
+    if (!reaper_state.stop_requested) {
+        __atomic_store_n(&reaper_state.drain_deadline, monotonic_time_ns() + drain_ns, __ATOMIC_RELAXED);
+        __atomic_store_n(&reaper_state.stop_requested, true, __ATOMIC_RELEASE);
+    }
+    pthread_cond_signal(&reaper_state.cond);
+    pthread_mutex_unlock(&reaper_state.lock);
+    pthread_join(thread, NULL);
+    pthread_mutex_lock(&reaper_state.lock);
+}
+
+// اجرای reaper پس‌زمینه؛ باقیمانده‌های اجرای قبلی در اولین دور حذف می‌شوند
+int reaper_start(int threads, unsigned rate) {
+    pthread_mutex_lock(&reaper_state.lock);
+    if (reaper_state.running && !reaper_state.stop_requested) {
+        pthread_mutex_unlock(&reaper_state.lock);
+        return 0;
+    }
+
+    // thread قبلی که توقفش درخواست شده پیش از شروع دوباره join می‌شود
+    reaper_join_locked(0);
+    if (reaper_state.running) {
+        pthread_mutex_unlock(&reaper_state.lock);
+        return 0;  // فراخواننده همزمان دیگری آن را شروع کرده است
+    }
+
+    reaper_state.threads = threads;
+    reaper_state.rate = rate;
+    reaper_state.stop_requested = false;
+
+    if (pthread_create(&reaper_state.thread, NULL, reaper_thread_main, NULL) != 0) {
+        pthread_mutex_unlock(&reaper_state.lock);
+        log_error("خطا در ایجاد thread حذف پس‌زمینه");
+        return -1;
+    }
+
+    reaper_state.running = true;
+    pthread_mutex_unlock(&reaper_state.lock);
+    return 0;
+}
+
+// توقف reaper پس‌زمینه
+void reaper_stop() {
+    pthread_mutex_lock(&reaper_state.lock);
+    reaper_join_locked(REAPER_DRAIN_SECONDS * 1000000000ULL);
+    pthread_mutex_unlock(&reaper_state.lock);
+}
@@ -0,0 +1,611 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "../include/rpc.h"
+#include "../include/ipc.h"
+#include "../include/utils.h"
+
+// نشانه معتبر بودن سرآیند حلقه‌ها
+#define RPC_RING_MAGIC 0x52504352u
+
+// اندازه خط کش؛ اندیس‌های هر طرف روی خط جداگانه قرار می‌گیرند
+#define RPC_CACHE_LINE 64
+
+// مدت پیش‌فرض busy-polling (میکروثانیه)
+#define RPC_DEFAULT_SPIN_US 50
+
+// حداکثر مدت هر خواب سرور برای بررسی دوباره درخواست توقف (نانوثانیه)
+#define RPC_SERVER_SLEEP_NS (100ULL * 1000000ULL)
+
+// doorbell مشترک سرور؛ کلاینت‌ها فقط وقتی سرور خوابیده است آن را به صدا درمی‌آورند
+typedef struct {
+    uint32_t doorbell;          // کلمه futex
+    uint32_t sleeping;          // سرور روی futex خوابیده است
+    uint32_t stop;              // درخواست توقف حلقه سرور
+} rpc_doorbell_t;
+
+// سرآیند سگمنت هر کلاینت: حلقه ارسال و حلقه پاسخ SPSC
+typedef struct {
+    uint32_t magic;
+    uint32_t depth;             // تعداد خانه‌های هر حلقه (توان ۲)
+    uint32_t slot_size;         // اندازه هر خانه
+    uint32_t closed;            // کلاینت بسته شده است
+    uint32_t sq_head __attribute__((aligned(RPC_CACHE_LINE)));         // نوشته‌شده توسط سرور
+    uint32_t sq_tail __attribute__((aligned(RPC_CACHE_LINE)));         // نوشته‌شده توسط کلاینت
+    uint32_t cq_head __attribute__((aligned(RPC_CACHE_LINE)));         // نوشته‌شده توسط کلاینت
+    uint32_t cq_tail __attribute__((aligned(RPC_CACHE_LINE)));         // نوشته‌شده توسط سرور؛ کلمه futex کلاینت
+    uint32_t client_waiting __attribute__((aligned(RPC_CACHE_LINE)));  // کلاینت روی futex خوابیده است
+} __attribute__((aligned(RPC_CACHE_LINE))) rpc_ring_header_t;
+
+// خانه حلقه؛ در حلقه پاسخ فیلد code وضعیت است
+typedef struct {
+    uint64_t id;
+    int32_t code;               // method در درخواست، status در پاسخ
+    uint32_t size;
+    char payload[];
+} rpc_slot_t;
+
+struct rpc_client {
+    char channel_name[64];
+    rpc_server_t *server;       // NULL برای کلاینتی که از فرآیند دیگر متصل شده است
+    ipc_channel_t *channel;
+    ipc_channel_t *doorbell_channel;  // فقط در کلاینت متصل‌شده؛ در غیر این صورت doorbell از سرور است
+    rpc_ring_header_t *ring;
+    rpc_doorbell_t *doorbell;
+    char *sq_slots;
+    char *cq_slots;
+    size_t max_payload;
+    uint32_t depth;             // نسخه خصوصی پارامترهای حلقه؛ سرآیند مشترک را طرف مقابل می‌تواند تغییر دهد
+    uint32_t slot_size;
+    uint32_t sq_tail_local;     // درخواست‌های افزوده‌شده، شامل منتشرنشده‌ها
+    uint64_t next_id;
+    unsigned spin_us;
+};
+
+struct rpc_server {
+    char name[64];
+    ipc_channel_t *channel;
+    rpc_doorbell_t *doorbell;
+    rpc_handler_t handler;
+    void *user_data;
+    pthread_mutex_t lock;       // از فهرست کلاینت‌ها در برابر ثبت و حذف هم‌زمان با حلقه سرور محافظت می‌کند
+    rpc_client_t **clients;
+    size_t client_count;
+    size_t client_capacity;
+    unsigned spin_us;
+};
+
+// گرد کردن به توان ۲ بعدی
+static uint32_t round_up_pow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// خانه شماره index از یک حلقه
+static inline rpc_slot_t* ring_slot(char *slots, const rpc_client_t *client, uint32_t index) {
+    return (rpc_slot_t *)(slots + (size_t)(index & (client->depth - 1)) * client->slot_size);
+}
+
+// ایجاد سرور RPC
+rpc_server_t* rpc_server_create(container_config_t *config, const char *name, rpc_handler_t handler, void *user_data) {
+    rpc_server_t *server = calloc(1, sizeof(rpc_server_t));
+    if (!server) {
+        log_error("خطا در تخصیص حافظه برای سرور RPC");
+        return NULL;
+    }
+
+    strncpy(server->name, name, sizeof(server->name) - 1);
+    server->handler = handler;
+    server->user_data = user_data;
+    server->spin_us = RPC_DEFAULT_SPIN_US;
+    pthread_mutex_init(&server->lock, NULL);
+
+    // سگمنت doorbell از طریق لایه IPC ساخته می‌شود
+    ipc_channel_options_t options = { .size = sizeof(rpc_doorbell_t), .huge_pages = false };
+    if (ipc_create_channel_ex(config, name, &options) != 0) {
+        pthread_mutex_destroy(&server->lock);
+        free(server);
+        return NULL;
+    }
+
+    server->channel = ipc_channel_open(name);
+    server->doorbell = server->channel ? ipc_channel_map(server->channel, NULL) : NULL;
+    if (server->doorbell == NULL) {
+        ipc_channel_close(server->channel);
+        ipc_destroy_channel(name);
+        pthread_mutex_destroy(&server->lock);
+        free(server);
+        return NULL;
+    }
+    memset(server->doorbell, 0, sizeof(rpc_doorbell_t));
+
+    log_message("سرور RPC %s ایجاد شد", name);
+    return server;
+}
+
+// آزادسازی سرور و همه کلاینت‌های آن
+void rpc_server_destroy(rpc_server_t *server) {
+    if (!server) return;
+
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        rpc_client_t *client = server->client_count > 0 ? server->clients[server->client_count - 1] : NULL;
+        pthread_mutex_unlock(&server->lock);
+        if (client == NULL) {
+            break;
+        }
+        rpc_client_destroy(client);
+    }
+    free(server->clients);
+
+    ipc_channel_close(server->channel);
+    ipc_destroy_channel(server->name);
+    pthread_mutex_destroy(&server->lock);
+    free(server);
+}
+
+// مدت busy-polling سرور
+void rpc_server_set_spin(rpc_server_t *server, unsigned spin_us) {
+    server->spin_us = spin_us;
+}
+
+// پردازش درخواست‌های آماده یک کلاینت
+static int serve_client(rpc_server_t *server, rpc_client_t *client) {
+    rpc_ring_header_t *ring = client->ring;
+    if (__atomic_load_n(&ring->closed, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+
+    uint32_t head = ring->sq_head;
+    uint32_t tail = __atomic_load_n(&ring->sq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return 0;
+    }
+    // سرآیند و خانه‌ها در حافظه قابل نوشتن کلاینت‌اند؛ بیش از یک حلقه درخواست پذیرفته نمی‌شود
+    if (tail - head > client->depth) {
+        tail = head + client->depth;
+    }
+
+    uint32_t cq_tail = ring->cq_tail;
+    int processed = 0;
+    while (head != tail) {
+        rpc_slot_t *request = ring_slot(client->sq_slots, client, head);
+        rpc_slot_t *response = ring_slot(client->cq_slots, client, cq_tail);
+
+        // اندازه یک بار خوانده می‌شود تا کلاینت نتواند پس از بررسی آن را تغییر دهد
+        uint32_t request_size = __atomic_load_n(&request->size, __ATOMIC_RELAXED);
+        int result;
+        if (request_size > client->max_payload) {
+            log_error("درخواست RPC بزرگتر از ظرفیت خانه از کلاینت %s (%u)", client->channel_name, request_size);
+            result = -EMSGSIZE;
+        } else {
+            result = server->handler((uint32_t)request->code, request->payload, request_size,
+                                     response->payload, client->max_payload, server->user_data);
+            if (result > (int)client->max_payload) {
+                result = (int)client->max_payload;
+            }
+        }
+
+        response->id = request->id;
+        response->code = result < 0 ? result : 0;
+        response->size = result < 0 ? 0 : (uint32_t)result;
+
+        head++;
+        cq_tail++;
+        processed++;
+    }
+
+    // یک انتشار برای کل دسته و بیدارباش فقط اگر کلاینت خوابیده باشد
+    __atomic_store_n(&ring->sq_head, head, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->cq_tail, cq_tail, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->client_waiting, __ATOMIC_RELAXED)) {
+        futex_wake_shared(&ring->cq_tail, 1);
+    }
+
+    return processed;
+}
+
+// پردازش درخواست‌های آماده همه کلاینت‌ها
+// قفل در تمام دور نگه داشته می‌شود تا کلاینتی که هم‌زمان حذف می‌شود وسط پردازش آزاد نشود
+int rpc_server_poll(rpc_server_t *server) {
+    int processed = 0;
+    pthread_mutex_lock(&server->lock);
+    for (size_t i = 0; i < server->client_count; i++) {
+        processed += serve_client(server, server->clients[i]);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return processed;
+}
+
+// حلقه اصلی سرور: busy-polling و سپس خواب روی doorbell
+int rpc_server_run(rpc_server_t *server) {
+    rpc_doorbell_t *doorbell = server->doorbell;
+    uint64_t idle_since = monotonic_time_ns();
+
+    while (!__atomic_load_n(&doorbell->stop, __ATOMIC_ACQUIRE)) {
+        if (rpc_server_poll(server) > 0) {
+            idle_since = monotonic_time_ns();
+            continue;
+        }
+
+        if (monotonic_time_ns() - idle_since < (uint64_t)server->spin_us * 1000ULL) {
+            cpu_relax();
+            continue;
+        }
+
+        // اعلام خواب و بررسی دوباره؛ کلاینتی که پس از این نقطه منتشر کند doorbell را به صدا درمی‌آورد
+        uint32_t ring_count = __atomic_load_n(&doorbell->doorbell, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&doorbell->sleeping, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        if (rpc_server_poll(server) == 0 && !__atomic_load_n(&doorbell->stop, __ATOMIC_ACQUIRE)) {
+            if (futex_wait_shared(&doorbell->doorbell, ring_count, RPC_SERVER_SLEEP_NS) == -1 &&
+                errno != ETIMEDOUT) {
+                __atomic_store_n(&doorbell->sleeping, 0, __ATOMIC_RELAXED);
+                log_error("خطا در انتظار روی doorbell سرور RPC %s", server->name);
+                return -1;
+            }
+        }
+
+        __atomic_store_n(&doorbell->sleeping, 0, __ATOMIC_RELAXED);
+        idle_since = monotonic_time_ns();
+    }
+
+    return 0;
+}
+
+// توقف حلقه سرور
+void rpc_server_stop(rpc_server_t *server) {
+    rpc_doorbell_t *doorbell = server->doorbell;
+    __atomic_store_n(&doorbell->stop, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&doorbell->doorbell, 1, __ATOMIC_SEQ_CST);
+    futex_wake_shared(&doorbell->doorbell, 1);
+}
+
+// ساخت سگمنت کلاینت و ثبت آن در فهرست سرور
+static rpc_client_t* register_client(rpc_server_t *server, container_config_t *config, const char *client_name,
+                                     uint32_t depth, size_t max_payload) {
+    if (depth == 0 || depth > (1U << 16) || max_payload == 0 || max_payload > UINT32_MAX) {
+        log_error("پارامترهای کلاینت RPC نامعتبر است");
+        return NULL;
+    }
+
+    rpc_client_t *client = calloc(1, sizeof(rpc_client_t));
+    if (!client) {
+        log_error("خطا در تخصیص حافظه برای کلاینت RPC");
+        return NULL;
+    }
+
+    int ret = snprintf(client->channel_name, sizeof(client->channel_name), "%s.%s", server->name, client_name);
+    if (ret >= (int)sizeof(client->channel_name)) {
+        log_error("نام کلاینت RPC خیلی طولانی است: %s", client_name);
+        free(client);
+        return NULL;
+    }
+
+    depth = round_up_pow2(depth);
+    size_t slot_size = (sizeof(rpc_slot_t) + max_payload + RPC_CACHE_LINE - 1) & ~(size_t)(RPC_CACHE_LINE - 1);
+    size_t segment_size = sizeof(rpc_ring_header_t) + 2 * (size_t)depth * slot_size;
+
+    ipc_channel_options_t options = { .size = segment_size, .huge_pages = false };
+    if (ipc_create_channel_ex(config, client->channel_name, &options) != 0) {
+        free(client);
+        return NULL;
+    }
+
+    client->channel = ipc_channel_open(client->channel_name);
+    char *base = client->channel ? ipc_channel_map(client->channel, NULL) : NULL;
+    if (base == NULL) {
+        ipc_channel_close(client->channel);
+        ipc_destroy_channel(client->channel_name);
+        free(client);
+        return NULL;
+    }
+
+    client->server = server;
+    client->ring = (rpc_ring_header_t *)base;
+    client->doorbell = server->doorbell;
+    client->sq_slots = base + sizeof(rpc_ring_header_t);
+    client->cq_slots = client->sq_slots + (size_t)depth * slot_size;
+    client->max_payload = max_payload;
+    client->depth = depth;
+    client->slot_size = slot_size;
+    client->spin_us = RPC_DEFAULT_SPIN_US;
+
+    memset(client->ring, 0, sizeof(rpc_ring_header_t));
+    client->ring->depth = depth;
+    client->ring->slot_size = slot_size;
+    __atomic_store_n(&client->ring->magic, RPC_RING_MAGIC, __ATOMIC_RELEASE);
+
+    // افزودن به فهرست سرور؛ ممکن است حلقه سرور در نخ دیگری در حال پیمایش آن باشد
+    pthread_mutex_lock(&server->lock);
+    if (server->client_count == server->client_capacity) {
+        size_t capacity = server->client_capacity ? server->client_capacity * 2 : 8;
+        rpc_client_t **clients = realloc(server->clients, capacity * sizeof(rpc_client_t *));
+        if (!clients) {
+            pthread_mutex_unlock(&server->lock);
+            log_error("خطا در تخصیص حافظه برای فهرست کلاینت‌های RPC");
+            ipc_channel_close(client->channel);
+            ipc_destroy_channel(client->channel_name);
+            free(client);
+            return NULL;
+        }
+        server->clients = clients;
+        server->client_capacity = capacity;
+    }
+    server->clients[server->client_count++] = client;
+    pthread_mutex_unlock(&server->lock);
+
+    log_message("کلاینت RPC %s با عمق %u ایجاد شد", client->channel_name, depth);
+    return client;
+}
+
+// ایجاد کلاینت در فرآیند سرور
+rpc_client_t* rpc_client_create(rpc_server_t *server, container_config_t *config, const char *client_name,
+                                uint32_t depth, size_t max_payload) {
+    return register_client(server, config, client_name, depth, max_payload);
+}
+
+// ثبت کلاینتی که فرآیند دیگری با rpc_client_attach به آن وصل می‌شود
+int rpc_server_add_client(rpc_server_t *server, container_config_t *config, const char *client_name,
+                          uint32_t depth, size_t max_payload) {
+    return register_client(server, config, client_name, depth, max_payload) != NULL ? 0 : -1;
+}
+
+// رها کردن کلاینت متصل‌شده؛ سگمنت‌ها متعلق به سرور هستند و فقط نگاشت‌ها جدا می‌شوند
+static void release_attached_client(rpc_client_t *client) {
+    ipc_channel_close(client->channel);
+    ipc_channel_close(client->doorbell_channel);
+    free(client);
+}
+
+// اتصال به کلاینتی که سرور با rpc_server_add_client ثبت کرده است
+rpc_client_t* rpc_client_attach(const char *server_name, const char *client_name) {
+    rpc_client_t *client = calloc(1, sizeof(rpc_client_t));
+    if (!client) {
+        log_error("خطا در تخصیص حافظه برای کلاینت RPC");
+        return NULL;
+    }
+
+    int ret = snprintf(client->channel_name, sizeof(client->channel_name), "%s.%s", server_name, client_name);
+    if (ret >= (int)sizeof(client->channel_name)) {
+        log_error("نام کلاینت RPC خیلی طولانی است: %s", client_name);
+        free(client);
+        return NULL;
+    }
+
+    client->doorbell_channel = ipc_channel_attach(server_name);
+    client->channel = ipc_channel_attach(client->channel_name);
+    size_t doorbell_size = 0;
+    size_t segment_size = 0;
+    rpc_doorbell_t *doorbell = client->doorbell_channel ? ipc_channel_map(client->doorbell_channel, &doorbell_size) : NULL;
+    char *base = client->channel ? ipc_channel_map(client->channel, &segment_size) : NULL;
+    if (doorbell == NULL || base == NULL || doorbell_size < sizeof(rpc_doorbell_t) ||
+        segment_size < sizeof(rpc_ring_header_t)) {
+        log_error("سرور یا کلاینت RPC %s پیدا نشد", client->channel_name);
+        release_attached_client(client);
+        return NULL;
+    }
+
+    // پارامترهای حلقه فقط وقتی پذیرفته می‌شوند که سرور ثبت را کامل کرده باشد و حلقه‌ها در سگمنت جا شوند
+    rpc_ring_header_t *ring = (rpc_ring_header_t *)base;
+    uint32_t depth = 0;
+    uint32_t slot_size = 0;
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) == RPC_RING_MAGIC) {
+        depth = ring->depth;
+        slot_size = ring->slot_size;
+    }
+    if (depth == 0 || depth > (1U << 16) || (depth & (depth - 1)) != 0 ||
+        slot_size <= sizeof(rpc_slot_t) || slot_size % RPC_CACHE_LINE != 0 ||
+        sizeof(rpc_ring_header_t) + 2 * (size_t)depth * slot_size > segment_size ||
+        __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE)) {
+        log_error("سگمنت کلاینت RPC %s معتبر نیست", client->channel_name);
+        release_attached_client(client);
+        return NULL;
+    }
+
+    client->ring = ring;
+    client->doorbell = doorbell;
+    client->sq_slots = base + sizeof(rpc_ring_header_t);
+    client->cq_slots = client->sq_slots + (size_t)depth * slot_size;
+    client->max_payload = slot_size - sizeof(rpc_slot_t);
+    client->depth = depth;
+    client->slot_size = slot_size;
+    client->sq_tail_local = ring->sq_tail;
+    client->spin_us = RPC_DEFAULT_SPIN_US;
+
+    log_message("به کلاینت RPC %s متصل شد", client->channel_name);
+    return client;
+}
+
+// آزادسازی کلاینت
+void rpc_client_destroy(rpc_client_t *client) {
+    if (!client) return;
+
+    __atomic_store_n(&client->ring->closed, 1, __ATOMIC_RELEASE);
+
+    rpc_server_t *server = client->server;
+    if (server == NULL) {
+        release_attached_client(client);
+        return;
+    }
+
+    // حذف از فهرست سرور
+    pthread_mutex_lock(&server->lock);
+    for (size_t i = 0; i < server->client_count; i++) {
+        if (server->clients[i] == client) {
+            server->clients[i] = server->clients[--server->client_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    ipc_channel_close(client->channel);
+    ipc_destroy_channel(client->channel_name);
+    free(client);
+}
+
+// مدت busy-polling کلاینت
+void rpc_client_set_spin(rpc_client_t *client, unsigned spin_us) {
+    client->spin_us = spin_us;
+}
+
+// افزودن درخواست به حلقه بدون به صدا درآوردن doorbell
+int rpc_submit(rpc_client_t *client, uint32_t method, const void *request, size_t request_size, uint64_t *request_id) {
+    rpc_ring_header_t *ring = client->ring;
+
+    if (request_size > client->max_payload) {
+        log_error("درخواست RPC بزرگتر از ظرفیت خانه است (%lu > %lu)", request_size, client->max_payload);
+        return -1;
+    }
+
+    // تعداد درخواست‌های بی‌پاسخ هرگز از عمق حلقه بیشتر نمی‌شود، پس حلقه پاسخ هم پر نمی‌شود
+    if (client->sq_tail_local - ring->cq_head >= client->depth) {
+        log_error("صف RPC کلاینت %s پر است", client->channel_name);
+        return -1;
+    }
+
+    rpc_slot_t *slot = ring_slot(client->sq_slots, client, client->sq_tail_local);
+    slot->id = ++client->next_id;
+    slot->code = (int32_t)method;
+    slot->size = (uint32_t)request_size;
+    memcpy(slot->payload, request, request_size);
+    client->sq_tail_local++;
+
+    if (request_id != NULL) {
+        *request_id = slot->id;
+    }
+    return 0;
+}
+
+// انتشار درخواست‌های افزوده‌شده
+int rpc_flush(rpc_client_t *client) {
+    rpc_ring_header_t *ring = client->ring;
+    if (ring->sq_tail == client->sq_tail_local) {
+        return 0;
+    }
+
+    __atomic_store_n(&ring->sq_tail, client->sq_tail_local, __ATOMIC_RELEASE);
+
+    // وقتی سرور در حال busy-polling است هیچ فراخوانی سیستمی انجام نمی‌شود
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&client->doorbell->sleeping, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&client->doorbell->doorbell, 1, __ATOMIC_SEQ_CST);
+        futex_wake_shared(&client->doorbell->doorbell, 1);
+    }
+    return 0;
+}
+
+// دریافت پاسخ بعدی
+int rpc_wait_completion(rpc_client_t *client, uint64_t *request_id, int *status,
+                        void *response, size_t response_capacity, int timeout_ms) {
+    rpc_ring_header_t *ring = client->ring;
+
+    // درخواست‌های منتشرنشده پیش از انتظار منتشر می‌شوند
+    rpc_flush(client);
+
+    uint64_t start = monotonic_time_ns();
+    uint64_t spin_deadline = start + (uint64_t)client->spin_us * 1000ULL;
+    uint64_t deadline = start + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0) * 1000000ULL;
+
+    uint32_t head = ring->cq_head;
+    for (;;) {
+        uint32_t tail = __atomic_load_n(&ring->cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            break;
+        }
+
+        uint64_t now = monotonic_time_ns();
+        if (now < spin_deadline && (timeout_ms < 0 || now < deadline)) {
+            cpu_relax();
+            continue;
+        }
+        if (timeout_ms >= 0 && now >= deadline) {
+            return RPC_TIMEOUT;
+        }
+
+        // اعلام انتظار و بررسی دوباره پیش از خوابیدن
+        __atomic_store_n(&ring->client_waiting, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ring->cq_tail, __ATOMIC_SEQ_CST) == tail) {
+            int64_t remaining = timeout_ms < 0 ? -1 : (int64_t)(deadline - now);
+            if (futex_wait_shared(&ring->cq_tail, tail, remaining) == -1 && errno != ETIMEDOUT) {
+                __atomic_store_n(&ring->client_waiting, 0, __ATOMIC_RELAXED);
+                log_error("خطا در انتظار پاسخ RPC روی کلاینت %s", client->channel_name);
+                return -1;
+            }
+        }
+        __atomic_store_n(&ring->client_waiting, 0, __ATOMIC_RELAXED);
+    }
+
+    rpc_slot_t *slot = ring_slot(client->cq_slots, client, head);
+    uint64_t id = slot->id;
+    int code = slot->code;
+    uint32_t size = slot->size;
+    int result = (int)size;
+
+    if (size > response_capacity) {
+        log_error("بافر کوچکتر از پاسخ RPC است (%u > %lu)", size, response_capacity);
+        result = -1;
+    } else if (size > 0) {
+        memcpy(response, slot->payload, size);
+    }
+
+    __atomic_store_n(&ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+    if (request_id != NULL) {
+        *request_id = id;
+    }
+    if (status != NULL) {
+        *status = code;
+    }
+    return result;
+}
+
+// فراخوانی همگام
+int rpc_call(rpc_client_t *client, uint32_t method, const void *request, size_t request_size,
+             void *response, size_t response_capacity, int timeout_ms) {
+    uint64_t request_id;
+    if (rpc_submit(client, method, request, request_size, &request_id) != 0) {
+        return -1;
+    }
+
+    // یک مهلت مطلق برای کل فراخوانی؛ پاسخ‌های کهنه آن را از نو آغاز نمی‌کنند
+    uint64_t deadline = monotonic_time_ns() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0) * 1000000ULL;
+    for (;;) {
+        int remaining_ms = -1;
+        if (timeout_ms >= 0) {
+            uint64_t now = monotonic_time_ns();
+            remaining_ms = now >= deadline ? 0 : (int)((deadline - now + 999999ULL) / 1000000ULL);
+        }
+
+        // شناسه‌ها از 1 شروع می‌شوند، پس 0 یعنی هیچ پاسخی برداشته نشده است
+        uint64_t completed_id = 0;
+        int status = 0;
+        int result = rpc_wait_completion(client, &completed_id, &status, response, response_capacity, remaining_ms);
+        if (result == RPC_TIMEOUT) {
+            return RPC_TIMEOUT;
+        }
+        if (result == -1 && completed_id == 0) {
+            return -1;
+        }
+
+        // پاسخ‌های دیرهنگام فراخوانی‌هایی که قبلاً مهلتشان تمام شده دور ریخته می‌شوند
+        if (completed_id != request_id) {
+            continue;
+        }
+        if (result < 0 || status < 0) {
+            return -1;
+        }
+        return result;
+    }
+}
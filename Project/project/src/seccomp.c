@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/seccomp.h>
+#include <linux/audit.h>
+#include "../include/seccomp.h"
+#include "../include/utils.h"
+
+#if !defined(__x86_64__)
+#error "جدول syscall و بررسی معماری فیلتر فقط برای x86_64 نوشته شده است"
+#endif
+
+#define SECCOMP_AUDIT_ARCH AUDIT_ARCH_X86_64
+
+typedef struct {
+    const char *name;
+    int nr;
+} syscall_entry_t;
+
+#define SYSCALL(name) { #name, __NR_##name }
+
+// syscall های x86_64 به ترتیب شماره؛ شماره‌های تازه‌تر هسته در پروفایل به صورت عددی پذیرفته می‌شوند
+static const syscall_entry_t syscall_table[] = {
+    SYSCALL(read), SYSCALL(write), SYSCALL(open), SYSCALL(close), SYSCALL(stat), SYSCALL(fstat), SYSCALL(lstat),
+    SYSCALL(poll), SYSCALL(lseek), SYSCALL(mmap), SYSCALL(mprotect), SYSCALL(munmap), SYSCALL(brk),
+    SYSCALL(rt_sigaction), SYSCALL(rt_sigprocmask), SYSCALL(rt_sigreturn), SYSCALL(ioctl), SYSCALL(pread64),
+    SYSCALL(pwrite64), SYSCALL(readv), SYSCALL(writev), SYSCALL(access), SYSCALL(pipe), SYSCALL(select),
+    SYSCALL(sched_yield), SYSCALL(mremap), SYSCALL(msync), SYSCALL(mincore), SYSCALL(madvise), SYSCALL(shmget),
+    SYSCALL(shmat), SYSCALL(shmctl), SYSCALL(dup), SYSCALL(dup2), SYSCALL(pause), SYSCALL(nanosleep),
+    SYSCALL(getitimer), SYSCALL(alarm), SYSCALL(setitimer), SYSCALL(getpid), SYSCALL(sendfile), SYSCALL(socket),
+    SYSCALL(connect), SYSCALL(accept), SYSCALL(sendto), SYSCALL(recvfrom), SYSCALL(sendmsg), SYSCALL(recvmsg),
+    SYSCALL(shutdown), SYSCALL(bind), SYSCALL(listen), SYSCALL(getsockname), SYSCALL(getpeername),
+    SYSCALL(socketpair), SYSCALL(setsockopt), SYSCALL(getsockopt), SYSCALL(clone), SYSCALL(fork), SYSCALL(vfork),
+    SYSCALL(execve), SYSCALL(exit), SYSCALL(wait4), SYSCALL(kill), SYSCALL(uname), SYSCALL(semget), SYSCALL(semop),
+    SYSCALL(semctl), SYSCALL(shmdt), SYSCALL(msgget), SYSCALL(msgsnd), SYSCALL(msgrcv), SYSCALL(msgctl),
+    SYSCALL(fcntl), SYSCALL(flock), SYSCALL(fsync), SYSCALL(fdatasync), SYSCALL(truncate), SYSCALL(ftruncate),
+    SYSCALL(getdents), SYSCALL(getcwd), SYSCALL(chdir), SYSCALL(fchdir), SYSCALL(rename), SYSCALL(mkdir),
+    SYSCALL(rmdir), SYSCALL(creat), SYSCALL(link), SYSCALL(unlink), SYSCALL(symlink), SYSCALL(readlink),
+    SYSCALL(chmod), SYSCALL(fchmod), SYSCALL(chown), SYSCALL(fchown), SYSCALL(lchown), SYSCALL(umask),
+    SYSCALL(gettimeofday), SYSCALL(getrlimit), SYSCALL(getrusage), SYSCALL(sysinfo), SYSCALL(times),
+    SYSCALL(ptrace), SYSCALL(getuid), SYSCALL(syslog), SYSCALL(getgid), SYSCALL(setuid), SYSCALL(setgid),
+    SYSCALL(geteuid), SYSCALL(getegid), SYSCALL(setpgid), SYSCALL(getppid), SYSCALL(getpgrp), SYSCALL(setsid),
+    SYSCALL(setreuid), SYSCALL(setregid), SYSCALL(getgroups), SYSCALL(setgroups), SYSCALL(setresuid),
+    SYSCALL(getresuid), SYSCALL(setresgid), SYSCALL(getresgid), SYSCALL(getpgid), SYSCALL(setfsuid),
+    SYSCALL(setfsgid), SYSCALL(getsid), SYSCALL(capget), SYSCALL(capset), SYSCALL(rt_sigpending),
+    SYSCALL(rt_sigtimedwait), SYSCALL(rt_sigqueueinfo), SYSCALL(rt_sigsuspend), SYSCALL(sigaltstack),
+    SYSCALL(utime), SYSCALL(mknod), SYSCALL(uselib), SYSCALL(personality), SYSCALL(ustat), SYSCALL(statfs),
+    SYSCALL(fstatfs), SYSCALL(sysfs), SYSCALL(getpriority), SYSCALL(setpriority), SYSCALL(sched_setparam),
+    SYSCALL(sched_getparam), SYSCALL(sched_setscheduler), SYSCALL(sched_getscheduler),
+    SYSCALL(sched_get_priority_max), SYSCALL(sched_get_priority_min), SYSCALL(sched_rr_get_interval),
+    SYSCALL(mlock), SYSCALL(munlock), SYSCALL(mlockall), SYSCALL(munlockall), SYSCALL(vhangup), SYSCALL(modify_ldt),
+    SYSCALL(pivot_root), SYSCALL(_sysctl), SYSCALL(prctl), SYSCALL(arch_prctl), SYSCALL(adjtimex),
+    SYSCALL(setrlimit), SYSCALL(chroot), SYSCALL(sync), SYSCALL(acct), SYSCALL(settimeofday), SYSCALL(mount),
+    SYSCALL(umount2), SYSCALL(swapon), SYSCALL(swapoff), SYSCALL(reboot), SYSCALL(sethostname),
+    SYSCALL(setdomainname), SYSCALL(iopl), SYSCALL(ioperm), SYSCALL(create_module), SYSCALL(init_module),
+    SYSCALL(delete_module), SYSCALL(get_kernel_syms), SYSCALL(query_module), SYSCALL(quotactl), SYSCALL(nfsservctl),
+    SYSCALL(getpmsg), SYSCALL(putpmsg), SYSCALL(afs_syscall), SYSCALL(tuxcall), SYSCALL(security), SYSCALL(gettid),
+    SYSCALL(readahead), SYSCALL(setxattr), SYSCALL(lsetxattr), SYSCALL(fsetxattr), SYSCALL(getxattr),
+    SYSCALL(lgetxattr), SYSCALL(fgetxattr), SYSCALL(listxattr), SYSCALL(llistxattr), SYSCALL(flistxattr),
+    SYSCALL(removexattr), SYSCALL(lremovexattr), SYSCALL(fremovexattr), SYSCALL(tkill), SYSCALL(time),
+    SYSCALL(futex), SYSCALL(sched_setaffinity), SYSCALL(sched_getaffinity), SYSCALL(set_thread_area),
+    SYSCALL(io_setup), SYSCALL(io_destroy), SYSCALL(io_getevents), SYSCALL(io_submit), SYSCALL(io_cancel),
+    SYSCALL(get_thread_area), SYSCALL(lookup_dcookie), SYSCALL(epoll_create), SYSCALL(epoll_ctl_old),
+    SYSCALL(epoll_wait_old), SYSCALL(remap_file_pages), SYSCALL(getdents64), SYSCALL(set_tid_address),
+    SYSCALL(restart_syscall), SYSCALL(semtimedop), SYSCALL(fadvise64), SYSCALL(timer_create),
+    SYSCALL(timer_settime), SYSCALL(timer_gettime), SYSCALL(timer_getoverrun), SYSCALL(timer_delete),
+    SYSCALL(clock_settime), SYSCALL(clock_gettime), SYSCALL(clock_getres), SYSCALL(clock_nanosleep),
+    SYSCALL(exit_group), SYSCALL(epoll_wait), SYSCALL(epoll_ctl), SYSCALL(tgkill), SYSCALL(utimes),
+    SYSCALL(vserver), SYSCALL(mbind), SYSCALL(set_mempolicy), SYSCALL(get_mempolicy), SYSCALL(mq_open),
+    SYSCALL(mq_unlink), SYSCALL(mq_timedsend), SYSCALL(mq_timedreceive), SYSCALL(mq_notify), SYSCALL(mq_getsetattr),
+    SYSCALL(kexec_load), SYSCALL(waitid), SYSCALL(add_key), SYSCALL(request_key), SYSCALL(keyctl),
+    SYSCALL(ioprio_set), SYSCALL(ioprio_get), SYSCALL(inotify_init), SYSCALL(inotify_add_watch),
+    SYSCALL(inotify_rm_watch), SYSCALL(migrate_pages), SYSCALL(openat), SYSCALL(mkdirat), SYSCALL(mknodat),
+    SYSCALL(fchownat), SYSCALL(futimesat), SYSCALL(newfstatat), SYSCALL(unlinkat), SYSCALL(renameat),
+    SYSCALL(linkat), SYSCALL(symlinkat), SYSCALL(readlinkat), SYSCALL(fchmodat), SYSCALL(faccessat),
+    SYSCALL(pselect6), SYSCALL(ppoll), SYSCALL(unshare), SYSCALL(set_robust_list), SYSCALL(get_robust_list),
+    SYSCALL(splice), SYSCALL(tee), SYSCALL(sync_file_range), SYSCALL(vmsplice), SYSCALL(move_pages),
+    SYSCALL(utimensat), SYSCALL(epoll_pwait), SYSCALL(signalfd), SYSCALL(timerfd_create), SYSCALL(eventfd),
+    SYSCALL(fallocate), SYSCALL(timerfd_settime), SYSCALL(timerfd_gettime), SYSCALL(accept4), SYSCALL(signalfd4),
+    SYSCALL(eventfd2), SYSCALL(epoll_create1), SYSCALL(dup3), SYSCALL(pipe2), SYSCALL(inotify_init1),
+    SYSCALL(preadv), SYSCALL(pwritev), SYSCALL(rt_tgsigqueueinfo), SYSCALL(perf_event_open), SYSCALL(recvmmsg),
+    SYSCALL(fanotify_init), SYSCALL(fanotify_mark), SYSCALL(prlimit64), SYSCALL(name_to_handle_at),
+    SYSCALL(open_by_handle_at), SYSCALL(clock_adjtime), SYSCALL(syncfs), SYSCALL(sendmmsg), SYSCALL(setns),
+    SYSCALL(getcpu), SYSCALL(process_vm_readv), SYSCALL(process_vm_writev), SYSCALL(kcmp), SYSCALL(finit_module),
+    SYSCALL(sched_setattr), SYSCALL(sched_getattr), SYSCALL(renameat2), SYSCALL(seccomp), SYSCALL(getrandom),
+    SYSCALL(memfd_create), SYSCALL(kexec_file_load), SYSCALL(bpf), SYSCALL(execveat), SYSCALL(userfaultfd),
+    SYSCALL(membarrier), SYSCALL(mlock2), SYSCALL(copy_file_range), SYSCALL(preadv2), SYSCALL(pwritev2),
+    SYSCALL(pkey_mprotect), SYSCALL(pkey_alloc), SYSCALL(pkey_free), SYSCALL(statx), SYSCALL(io_pgetevents),
+    SYSCALL(rseq), SYSCALL(pidfd_send_signal), SYSCALL(io_uring_setup), SYSCALL(io_uring_enter),
+    SYSCALL(io_uring_register), SYSCALL(open_tree), SYSCALL(move_mount), SYSCALL(fsopen), SYSCALL(fsconfig),
+    SYSCALL(fsmount), SYSCALL(fspick), SYSCALL(pidfd_open), SYSCALL(clone3), SYSCALL(close_range), SYSCALL(openat2),
+    SYSCALL(pidfd_getfd), SYSCALL(faccessat2), SYSCALL(process_madvise), SYSCALL(epoll_pwait2),
+    SYSCALL(mount_setattr), SYSCALL(quotactl_fd), SYSCALL(landlock_create_ruleset), SYSCALL(landlock_add_rule),
+    SYSCALL(landlock_restrict_self), SYSCALL(memfd_secret), SYSCALL(process_mrelease), SYSCALL(futex_waitv),
+    SYSCALL(set_mempolicy_home_node),
+};
+
+#undef SYSCALL
+
+#define SYSCALL_TABLE_SIZE (sizeof(syscall_table) / sizeof(syscall_table[0]))
+
+int seccomp_syscall_number(const char *name) {
+    char *endptr;
+    long nr = strtol(name, &endptr, 10);
+    if (endptr != name && *endptr == '\0') {
+        return nr >= 0 && nr < SECCOMP_MAX_SYSCALL ? (int)nr : -1;
+    }
+    for (size_t i = 0; i < SYSCALL_TABLE_SIZE; i++) {
+        if (strcmp(syscall_table[i].name, name) == 0) {
+            return syscall_table[i].nr;
+        }
+    }
+    return -1;
+}
+
+const char* seccomp_syscall_name(int nr) {
+    for (size_t i = 0; i < SYSCALL_TABLE_SIZE; i++) {
+        if (syscall_table[i].nr == nr) {
+            return syscall_table[i].name;
+        }
+    }
+    return NULL;
+}
+
+static const char *action_names[] = { "allow", "errno", "kill", "log" };
+
+int seccomp_action_parse(const char *text, seccomp_action_t *action) {
+    for (size_t i = 0; i < sizeof(action_names) / sizeof(action_names[0]); i++) {
+        if (strcmp(text, action_names[i]) == 0) {
+            *action = (seccomp_action_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int seccomp_profile_add(seccomp_profile_t *profile, int nr, seccomp_action_t action, uint64_t count) {
+    if (nr < 0 || nr >= SECCOMP_MAX_SYSCALL) {
+        log_error("شماره syscall خارج از محدوده: %d", nr);
+        return -1;
+    }
+    int i = 0;
+    while (i < profile->rule_count && profile->rules[i].nr != nr) {
+        i++;
+    }
+    if (i == profile->rule_count) {
+        profile->rule_count++;
+    }
+    profile->rules[i] = (seccomp_rule_t){ nr, action, count };
+    return 0;
+}
+
+int seccomp_profile_load(const char *path, seccomp_profile_t *profile) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        log_error("خطا در باز کردن پروفایل seccomp %s", path);
+        return -1;
+    }
+
+    profile->default_action = SECCOMP_ACTION_ERRNO;
+    profile->rule_count = 0;
+    char line[256], action_text[16], name[64];
+    int line_number = 0;
+    int result = 0;
+    while (result == 0 && fgets(line, sizeof(line), file)) {
+        line_number++;
+        unsigned long long count = 0;
+        int fields = sscanf(line, "%15s %63s %llu", action_text, name, &count);
+        if (fields <= 0 || action_text[0] == '#') {
+            continue;
+        }
+        seccomp_action_t action;
+        if (fields < 2 || seccomp_action_parse(strcmp(action_text, "default") == 0 ? name : action_text,
+                                               &action) != 0) {
+            result = -1;
+        } else if (strcmp(action_text, "default") == 0) {
+            profile->default_action = action;
+        } else {
+            int nr = seccomp_syscall_number(name);
+            result = nr == -1 ? -1 : seccomp_profile_add(profile, nr, action, count);
+        }
+    }
+    fclose(file);
+
+    if (result != 0) {
+        log_error("خط %d پروفایل seccomp %s نامعتبر است", line_number, path);
+    }
+    return result;
+}
+
+static uint32_t action_return(seccomp_action_t action) {
+    switch (action) {
+        case SECCOMP_ACTION_ALLOW:
+            return SECCOMP_RET_ALLOW;
+        case SECCOMP_ACTION_KILL:
+            return SECCOMP_RET_KILL_PROCESS;
+        case SECCOMP_ACTION_LOG:
+            return SECCOMP_RET_LOG;
+        default:
+            return SECCOMP_RET_ERRNO | (EPERM & SECCOMP_RET_DATA);
+    }
+}
+
+// بازه‌های پیوسته شماره syscall با تصمیم یکسان؛ بازه i از start[i] تا start[i+1]-1 و آخرین تا بی‌نهایت
+typedef struct {
+    int count;
+    uint32_t start[SECCOMP_MAX_SYSCALL + 1];
+    seccomp_action_t action[SECCOMP_MAX_SYSCALL + 1];
+} interval_set_t;
+
+typedef struct {
+    struct sock_filter *prog;
+    int len;
+    int max;
+} filter_builder_t;
+
+static int emit(filter_builder_t *builder, struct sock_filter insn) {
+    if (builder->len == builder->max) {
+        log_error("فیلتر seccomp از %d دستور بیشتر است", builder->max);
+        return -1;
+    }
+    builder->prog[builder->len++] = insn;
+    return 0;
+}
+
+// گره درخت: شماره‌های >= آغاز بازه میانی به زیردرخت راست می‌روند و زیردرخت چپ بلافاصله پس از
+// گره می‌آید. برگ‌ها RET هستند و زیردرخت‌ها به بیرون پرش ندارند، پس اگر طول زیردرخت چپ از بُرد
+// 8 بیتی jt بیشتر شود یک BPF_JA پس از گره درج می‌شود بدون آنکه پرش‌های درون آن تغییر کند
+static int emit_tree(filter_builder_t *builder, const interval_set_t *intervals, int lo, int hi) {
+    if (hi - lo == 1) {
+        return emit(builder, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, action_return(intervals->action[lo])));
+    }
+
+    int mid = (lo + hi) / 2;
+    int node = builder->len;
+    if (emit(builder, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, intervals->start[mid], 0, 0)) != 0 ||
+        emit_tree(builder, intervals, lo, mid) != 0) {
+        return -1;
+    }
+    int left_len = builder->len - node - 1;
+    if (left_len <= 255) {
+        builder->prog[node].jt = left_len;
+    } else {
+        if (emit(builder, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0)) != 0) {
+            return -1;
+        }
+        memmove(&builder->prog[node + 2], &builder->prog[node + 1], left_len * sizeof(struct sock_filter));
+        builder->prog[node] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, intervals->start[mid], 0, 1);
+        builder->prog[node + 1] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JA | BPF_K, left_len, 0, 0);
+    }
+    return emit_tree(builder, intervals, mid, hi);
+}
+
+static int compare_count_desc(const void *a, const void *b) {
+    const seccomp_rule_t *left = a, *right = b;
+    return left->count < right->count ? 1 : left->count > right->count ? -1 : left->nr - right->nr;
+}
+
+// تعداد syscall های مجاز پرتکرار برای مقایسه مستقیم: کمینه هزینه مورد انتظار که در آن i امین
+// syscall داغ i+1 مقایسه و بقیه hot_count مقایسه به اضافه عمق درخت می‌خواهند
+static int choose_hot(seccomp_rule_t *hot, int candidates, uint64_t total, int depth) {
+    if (total == 0) {
+        return 0;
+    }
+    int best = 0;
+    double best_cost = depth;
+    double hot_cost = 0, hot_share = 0;
+    for (int k = 1; k <= candidates && k <= SECCOMP_HOT_MAX; k++) {
+        double share = (double)hot[k - 1].count / total;
+        hot_cost += share * k;
+        hot_share += share;
+        double cost = hot_cost + (1 - hot_share) * (k + depth);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = k;
+        }
+    }
+    return best;
+}
+
+int seccomp_compile(const seccomp_profile_t *profile, struct sock_filter *prog, int max_insns) {
+    seccomp_action_t actions[SECCOMP_MAX_SYSCALL];
+    interval_set_t intervals;
+    seccomp_rule_t hot[SECCOMP_MAX_SYSCALL];
+
+    for (int nr = 0; nr < SECCOMP_MAX_SYSCALL; nr++) {
+        actions[nr] = profile->default_action;
+    }
+    int candidates = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < profile->rule_count; i++) {
+        const seccomp_rule_t *rule = &profile->rules[i];
+        actions[rule->nr] = rule->action;
+        total += rule->count;
+        if (rule->action == SECCOMP_ACTION_ALLOW && rule->count > 0) {
+            hot[candidates++] = *rule;
+        }
+    }
+
+    // شماره‌های بالای جدول، از جمله syscall های x32، تصمیم پیش‌فرض را می‌گیرند
+    intervals.count = 0;
+    for (int nr = 0; nr <= SECCOMP_MAX_SYSCALL; nr++) {
+        seccomp_action_t action = nr < SECCOMP_MAX_SYSCALL ? actions[nr] : profile->default_action;
+        if (intervals.count == 0 || intervals.action[intervals.count - 1] != action) {
+            intervals.start[intervals.count] = nr;
+            intervals.action[intervals.count] = action;
+            intervals.count++;
+        }
+    }
+    int depth = 1;
+    while ((1 << (depth - 1)) < intervals.count) {
+        depth++;
+    }
+
+    qsort(hot, candidates, sizeof(hot[0]), compare_count_desc);
+    int hot_count = choose_hot(hot, candidates, total, depth);
+
+    // معماری دیگر (مثلاً فراخوانی int 0x80) شماره‌های متفاوتی دارد و فرآیند کشته می‌شود
+    filter_builder_t builder = { prog, 0, max_insns };
+    if (emit(&builder, (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch))) != 0 ||
+        emit(&builder, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SECCOMP_AUDIT_ARCH, 1, 0)) != 0 ||
+        emit(&builder, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS)) != 0 ||
+        emit(&builder, (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr))) != 0) {
+        return -1;
+    }
+
+    // syscall های داغ همه به یک RET ALLOW پس از خود می‌پرند و آخرین، در صورت عدم تطابق، از آن می‌گذرد
+    for (int i = 0; i < hot_count; i++) {
+        bool last = i == hot_count - 1;
+        if (emit(&builder, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, hot[i].nr,
+                                                         hot_count - 1 - i, last ? 1 : 0)) != 0) {
+            return -1;
+        }
+    }
+    if (hot_count > 0 && emit(&builder, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW)) != 0) {
+        return -1;
+    }
+
+    if (emit_tree(&builder, &intervals, 0, intervals.count) != 0) {
+        return -1;
+    }
+    return builder.len;
+}
+
+int seccomp_install(const struct sock_filter *prog, int count) {
+    struct sock_fprog fprog = { (unsigned short)count, (struct sock_filter *)prog };
+    if (syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, 0, &fprog) != 0 &&
+        (errno != EACCES || prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0 ||
+         syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, 0, &fprog) != 0)) {
+        log_error("خطا در نصب فیلتر seccomp: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mount.h>
+#include <sys/types.h>
+#include "../include/snapshot.h"
+#include "../include/diskusage.h"
+#include "../include/filesystem.h"
+#include "../include/layerstore.h"
+#include "../include/copy.h"
+#include "../include/reaper.h"
+#include "../include/idmap.h"
+#include "../include/mounttree.h"
+#include "../include/utils.h"
+
+// نقاط نصبی که mount_essential_filesystems داخل کانتینر لازم دارد
+static const char *mount_points[] = { "proc", "sys", "dev", "tmp" };
+
+// مسیر لایه‌های پایینی از بالا به پایین
+int snapshot_lower_dirs(const container_config_t *config, char (*lowers)[SNAPSHOT_PATH_MAX], int max) {
+    if (config->image_layer_count == 0) {
+        if (max < 1) {
+            return -1;
+        }
+        snprintf(lowers[0], SNAPSHOT_PATH_MAX, "%s", SNAPSHOT_BASE_ROOTFS);
+        return 1;
+    }
+
+    if (config->image_layer_count > max) {
+        log_error("تعداد لایه‌های تصویر بیش از %d است", max);
+        return -1;
+    }
+    int count = 0;
+    for (int i = config->image_layer_count - 1; i >= 0; i--) {
+        if (layer_store_path(config->image_layers[i], lowers[count], SNAPSHOT_PATH_MAX) != 0) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+// مسیر نسخه idmapped لایه index (از بالا) زیر overlay_workdir
+static void idmap_lower_path(const container_config_t *config, int index, char *buffer, size_t size) {
+    snprintf(buffer, size, "%s/%s/%d", config->overlay_workdir, SNAPSHOT_IDMAP_DIR, index);
+}
+
+// ساخت "top:lower1:lower2:..." برای گزینه lowerdir
+int snapshot_lowerdir_option(const container_config_t *config, const char *top, char *buffer, size_t size) {
+    char (*lowers)[SNAPSHOT_PATH_MAX] = malloc(MAX_IMAGE_LAYERS * sizeof(*lowers));
+    if (!lowers) {
+        return -1;
+    }
+    int count = snapshot_lower_dirs(config, lowers, MAX_IMAGE_LAYERS);
+
+    size_t used = 0;
+    int ret = top ? snprintf(buffer, size, "%s", top) : 0;
+    if (ret >= 0 && (size_t)ret < size) {
+        used = ret;
+        for (int i = 0; i < count; i++) {
+            if (config->idmap.count > 0) {
+                idmap_lower_path(config, i, lowers[i], SNAPSHOT_PATH_MAX);
+            }
+            ret = snprintf(buffer + used, size - used, "%s%s", used > 0 ? ":" : "", lowers[i]);
+            if (ret < 0 || (size_t)ret >= size - used) {
+                break;
+            }
+            used += ret;
+        }
+    }
+    free(lowers);
+
+    if (count < 0) {
+        return -1;
+    }
+    if (ret < 0 || (size_t)ret >= size - used) {
+        log_error("تعداد لایه‌های تصویر برای overlayfs خیلی زیاد است");
+        return -1;
+    }
+    return 0;
+}
+
+int snapshot_idmap_lowers(const container_config_t *config) {
+    char (*lowers)[SNAPSHOT_PATH_MAX] = malloc(MAX_IMAGE_LAYERS * sizeof(*lowers));
+    if (!lowers) {
+        return -1;
+    }
+    int count = snapshot_lower_dirs(config, lowers, MAX_IMAGE_LAYERS);
+    int userns_fd = count < 0 ? -1 : idmap_userns_fd(&config->idmap, false);
+
+    int result = userns_fd == -1 ? -1 : 0;
+    for (int i = 0; i < count && result == 0; i++) {
+        char staged[SNAPSHOT_PATH_MAX + 64];
+        idmap_lower_path(config, i, staged, sizeof(staged));
+        if (create_directory(staged, 0755) != 0 ||
+            mount_idmapped(lowers[i], staged, userns_fd, MOUNT_ATTR_RDONLY) != 0) {
+            log_error("خطا در نصب idmapped لایه %s", lowers[i]);
+            result = -1;
+        }
+    }
+    if (userns_fd != -1) {
+        close(userns_fd);
+    }
+    free(lowers);
+
+    if (result != 0) {
+        snapshot_idmap_release(config);
+    }
+    return result;
+}
+
+void snapshot_idmap_release(const container_config_t *config) {
+    int count = config->image_layer_count > 0 ? config->image_layer_count : 1;
+    for (int i = 0; i < count; i++) {
+        char staged[SNAPSHOT_PATH_MAX + 64];
+        idmap_lower_path(config, i, staged, sizeof(staged));
+        umount2(staged, MNT_DETACH);
+        rmdir(staged);
+    }
+    char dir[SNAPSHOT_PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/%s", config->overlay_workdir, SNAPSHOT_IDMAP_DIR);
+    rmdir(dir);
+}
+
+const char* snapshot_writable_dir(const container_config_t *config) {
+    switch (config->snapshotter) {
+        case SNAPSHOT_REFLINK:
+            return config->rootfs;
+        case SNAPSHOT_BIND:
+            return NULL;
+        default:
+            return config->overlay_workdir;
+    }
+}
+
+// سپردن دایرکتوری‌های کانتینر به reaper
+static int discard_container_dirs(container_config_t *config) {
+    disk_usage_forget(config->rootfs);
+    disk_usage_forget(config->overlay_workdir);
+    if (reaper_discard(config->rootfs) != 0 ||
+        reaper_discard(config->overlay_workdir) != 0) {
+        log_error("خطا در حذف دایرکتوری‌های کانتینر");
+        return -1;
+    }
+    return 0;
+}
+
+// ---------- overlay ----------
+
+static int overlay_prepare(container_config_t *config) {
+    return setup_overlayfs(config);
+}
+
+static int overlay_cleanup(container_config_t *config) {
+    if (umount(config->rootfs) != 0) {
+        log_error("خطا در جدا کردن فایل‌سیستم overlayfs");
+        return -1;
+    }
+    return discard_container_dirs(config);
+}
+
+// ---------- tmpfs ----------
+
+// upper و work روی tmpfs: copy-up و نوشتن‌ها به دیسک نمی‌رسند و پاک‌سازی فقط یک umount است
+static int tmpfs_prepare(container_config_t *config) {
+    char options[64] = "mode=0755";
+    if (config->snapshot_size > 0) {
+        snprintf(options, sizeof(options), "mode=0755,size=%lu", config->snapshot_size);
+    }
+    if (mount("tmpfs", config->overlay_workdir, "tmpfs", 0, options) != 0) {
+        log_error("خطا در نصب tmpfs روی %s", config->overlay_workdir);
+        return -1;
+    }
+    if (setup_overlayfs(config) != 0) {
+        umount(config->overlay_workdir);
+        return -1;
+    }
+    return 0;
+}
+
+static int tmpfs_cleanup(container_config_t *config) {
+    if (umount(config->rootfs) != 0) {
+        log_error("خطا در جدا کردن فایل‌سیستم overlayfs");
+        return -1;
+    }
+    if (umount2(config->overlay_workdir, MNT_DETACH) != 0) {
+        log_error("خطا در جدا کردن tmpfs %s", config->overlay_workdir);
+        return -1;
+    }
+    return discard_container_dirs(config);
+}
+
+// ---------- reflink ----------
+
+// ادغام لایه‌ها از پایین به بالا در rootfs؛ روی btrfs/XFS داده با FICLONE مشترک می‌ماند
+// و روی فایل‌سیستم‌های دیگر copy_file_fd به copy_file_range برمی‌گردد
+static int reflink_prepare(container_config_t *config) {
+    char (*lowers)[SNAPSHOT_PATH_MAX] = malloc(MAX_IMAGE_LAYERS * sizeof(*lowers));
+    if (!lowers) {
+        return -1;
+    }
+    int count = snapshot_lower_dirs(config, lowers, MAX_IMAGE_LAYERS);
+    int result = count < 0 ? -1 : 0;
+
+    // rootfs خودش لایه قابل نوشتن است؛ project quota پیش از ادغام تا همه فایل‌ها شناسه را به ارث ببرند
+    if (disk_quota_setup(config->rootfs, config->id, config->disk_limit_bytes, 0) != 0 &&
+        config->disk_limit_bytes > 0) {
+        log_message("هشدار: project quota روی %s فعال نیست، سقف دیسک اعمال نمی‌شود", config->rootfs);
+    }
+
+    copy_stats_t total = { 0 };
+    uint64_t start = monotonic_time_ns();
+    for (int i = count - 1; i >= 0 && result == 0; i--) {
+        copy_stats_t stats;
+        if (copy_tree_overlay(lowers[i], config->rootfs, 0, &stats) != 0) {
+            log_error("خطا در ادغام لایه %s", lowers[i]);
+            result = -1;
+            break;
+        }
+        total.files += stats.files;
+        total.bytes += stats.bytes;
+        total.whiteouts += stats.whiteouts;
+    }
+    free(lowers);
+
+    // نسخه کامل مالکیت‌های تصویر را نگه می‌دارد و با نصب idmapped روی خودش نگاشت می‌شود
+    if (result == 0 && config->idmap.count > 0) {
+        int userns_fd = idmap_userns_fd(&config->idmap, false);
+        result = userns_fd == -1 ? -1 : mount_idmapped(config->rootfs, config->rootfs, userns_fd, 0);
+        if (userns_fd != -1) {
+            close(userns_fd);
+        }
+    }
+
+    if (result == 0) {
+        log_message("rootfs با %lu فایل (%.1f MB، %lu whiteout) در %.2f ثانیه ساخته شد",
+                    total.files, total.bytes / (1024.0 * 1024.0), total.whiteouts,
+                    (monotonic_time_ns() - start) / 1e9);
+    }
+    return result;
+}
+
+static int reflink_cleanup(container_config_t *config) {
+    if (config->idmap.count > 0 && umount2(config->rootfs, MNT_DETACH) != 0) {
+        log_error("خطا در جدا کردن نصب idmapped %s", config->rootfs);
+        return -1;
+    }
+    return discard_container_dirs(config);
+}
+
+// ---------- bind ----------
+
+// وجود همه نقاط نصب ضروری در دایرکتوری
+static bool has_mount_points(const char *path) {
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    bool found = true;
+    for (size_t i = 0; i < sizeof(mount_points) / sizeof(mount_points[0]) && found; i++) {
+        struct stat st;
+        found = fstatat(fd, mount_points[i], &st, 0) == 0 && S_ISDIR(st.st_mode);
+    }
+    close(fd);
+    return found;
+}
+
+// rootfs فقط‌خواندنی بدون هیچ نوشتنی روی دیسک؛ /tmp داخل کانتینر tmpfs است
+// یک لایه دارای نقاط نصب مستقیماً bind می‌شود، در غیر این صورت overlayfs بدون upper
+// با یک لایه اسکلت شامل نقاط نصب بالای لایه‌ها ساخته می‌شود
+static int bind_prepare(container_config_t *config) {
+    char (*lowers)[SNAPSHOT_PATH_MAX] = malloc(sizeof(*lowers));
+    if (!lowers) {
+        return -1;
+    }
+    bool single = config->image_layer_count <= 1 &&
+                  snapshot_lower_dirs(config, lowers, 1) == 1 && has_mount_points(lowers[0]);
+
+    if (single && config->idmap.count > 0) {
+        // نگاشت شناسه و فقط‌خواندنی با یک نصب جداشده
+        int userns_fd = idmap_userns_fd(&config->idmap, false);
+        int result = userns_fd == -1 ? -1
+                                     : mount_idmapped(lowers[0], config->rootfs, userns_fd, MOUNT_ATTR_RDONLY);
+        if (userns_fd != -1) {
+            close(userns_fd);
+        }
+        free(lowers);
+        return result;
+    }
+    if (single) {
+        int result = 0;
+        if (mount(lowers[0], config->rootfs, NULL, MS_BIND, NULL) != 0) {
+            log_error("خطا در bind کردن %s", lowers[0]);
+            result = -1;
+        } else if (mount(NULL, config->rootfs, NULL, MS_REMOUNT | MS_BIND | MS_RDONLY, NULL) != 0) {
+            log_error("خطا در فقط‌خواندنی کردن %s", config->rootfs);
+            umount(config->rootfs);
+            result = -1;
+        }
+        free(lowers);
+        return result;
+    }
+    free(lowers);
+
+    char skeleton[1024];
+    snprintf(skeleton, sizeof(skeleton), "%s/skeleton", config->overlay_workdir);
+    for (size_t i = 0; i < sizeof(mount_points) / sizeof(mount_points[0]); i++) {
+        char path[1100];
+        snprintf(path, sizeof(path), "%s/%s", skeleton, mount_points[i]);
+        if (create_directory(path, 0755) != 0) {
+            log_error("خطا در ایجاد %s", path);
+            return -1;
+        }
+    }
+
+    char mountopts[4096] = "lowerdir=";
+    if (snapshot_lowerdir_option(config, skeleton, mountopts + strlen(mountopts),
+                                 sizeof(mountopts) - strlen(mountopts)) != 0) {
+        return -1;
+    }
+    // اسکلت بالاترین لایه و ریشه overlay است
+    if (config->idmap.count > 0 &&
+        (chown(skeleton, config->idmap.uid_base, config->idmap.gid_base) != 0 ||
+         snapshot_idmap_lowers(config) != 0)) {
+        return -1;
+    }
+    int mounted = mount("overlay", config->rootfs, "overlay", MS_RDONLY, mountopts);
+    if (config->idmap.count > 0) {
+        snapshot_idmap_release(config);
+    }
+    if (mounted != 0) {
+        log_error("خطا در نصب overlayfs فقط‌خواندنی");
+        return -1;
+    }
+    return 0;
+}
+
+static int bind_cleanup(container_config_t *config) {
+    if (umount(config->rootfs) != 0) {
+        log_error("خطا در جدا کردن %s", config->rootfs);
+        return -1;
+    }
+    return discard_container_dirs(config);
+}
+
+// جدول snapshotter ها به ترتیب snapshot_type_t
+static const snapshotter_t snapshotters[] = {
+    [SNAPSHOT_OVERLAY] = { "overlay", overlay_prepare, overlay_cleanup },
+    [SNAPSHOT_TMPFS]   = { "tmpfs",   tmpfs_prepare,   tmpfs_cleanup },
+    [SNAPSHOT_REFLINK] = { "reflink", reflink_prepare, reflink_cleanup },
+    [SNAPSHOT_BIND]    = { "bind",    bind_prepare,    bind_cleanup },
+};
+
+#define SNAPSHOTTER_COUNT (int)(sizeof(snapshotters) / sizeof(snapshotters[0]))
+
+const snapshotter_t* snapshotter_get(snapshot_type_t type) {
+    if ((int)type < 0 || (int)type >= SNAPSHOTTER_COUNT) {
+        return &snapshotters[SNAPSHOT_OVERLAY];
+    }
+    return &snapshotters[type];
+}
+
+int snapshotter_parse(const char *name, snapshot_type_t *type) {
+    for (int i = 0; i < SNAPSHOTTER_COUNT; i++) {
+        if (strcmp(name, snapshotters[i].name) == 0) {
+            *type = (snapshot_type_t)i;
+            return 0;
+        }
+    }
+    log_error("snapshotter ناشناخته: %s", name);
+    return -1;
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "../include/sockmap.h"
+#include "../include/bpfprog.h"
+#include "../include/network.h"
+#include "../include/utils.h"
+
+// پیشوند /16 زیرشبکه bridge به ترتیب میزبان (10.88)
+#define SUBNET_HIGH16 (NETWORK_SUBNET >> 16)
+
+// کلید sockhash از دید سوکت: پورت‌ها به ترتیب میزبان؛ netns فقط برای loopback (تا اتصال‌های
+// 127.0.0.1 کانتینرهای مختلف با هم اشتباه نشوند)، برای bridge صفر چون نشانی‌ها یکتا هستند
+typedef struct {
+    uint64_t netns;
+    uint32_t local_ip;
+    uint32_t remote_ip;
+    uint32_t local_port;
+    uint32_t remote_port;
+} sockmap_key_t;
+
+static struct {
+    pthread_mutex_t lock;
+    int map_fd;
+    int sockops_fd;
+    int msg_fd;
+} sockmap_state = { PTHREAD_MUTEX_INITIALIZER, -1, -1, -1 };
+
+// کلاس‌بندی remote_ip4 (در r7): loopback با cookie در r8، زیرشبکه bridge با r8 = 0
+// و بقیه با پرش skip (فاصله از دستور نهم این 13 دستور) به پایان برنامه
+#define CLASSIFY_REMOTE(ctx_off_remote_ip4, skip)                                       \
+    LDX_W(BPF_REG_7, BPF_REG_6, ctx_off_remote_ip4),                                    \
+    MOV64_IMM(BPF_REG_8, 0),                                                            \
+    MOV64_REG(BPF_REG_2, BPF_REG_7),                                                    \
+    TO_BE(BPF_REG_2, 32),                                                               \
+    MOV64_REG(BPF_REG_3, BPF_REG_2),                                                    \
+    RSH32_IMM(BPF_REG_3, 24),                                                           \
+    JEQ_IMM(BPF_REG_3, 127, 3),                                                         \
+    RSH32_IMM(BPF_REG_2, 16),                                                           \
+    JNE_IMM(BPF_REG_2, SUBNET_HIGH16, skip),                                            \
+    JA(3),                                                                              \
+    MOV64_REG(BPF_REG_1, BPF_REG_6),                                                    \
+    CALL(BPF_FUNC_get_netns_cookie),                                                    \
+    MOV64_REG(BPF_REG_8, BPF_REG_0)
+
+// sockops: ثبت سوکت در sockhash هنگام برقراری اتصال (فعال یا غیرفعال) با کلید دید خودش
+static int load_sockops(int map_fd) {
+    struct bpf_insn program[] = {
+        MOV64_REG(BPF_REG_6, BPF_REG_1),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct bpf_sock_ops, op)),
+        JEQ_IMM(BPF_REG_2, BPF_SOCK_OPS_ACTIVE_ESTABLISHED_CB, 1),
+        JNE_IMM(BPF_REG_2, BPF_SOCK_OPS_PASSIVE_ESTABLISHED_CB, 32),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct bpf_sock_ops, family)),
+        JNE_IMM(BPF_REG_2, AF_INET, 30),
+        CLASSIFY_REMOTE(offsetof(struct bpf_sock_ops, remote_ip4), 21),
+        STX_DW(BPF_REG_10, BPF_REG_8, -24),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct bpf_sock_ops, local_ip4)),
+        STX_W(BPF_REG_10, BPF_REG_2, -16),
+        STX_W(BPF_REG_10, BPF_REG_7, -12),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct bpf_sock_ops, local_port)),
+        STX_W(BPF_REG_10, BPF_REG_2, -8),
+        // remote_port در 16 بیت بالای فیلد به ترتیب شبکه است
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct bpf_sock_ops, remote_port)),
+        RSH32_IMM(BPF_REG_2, 16),
+        TO_BE(BPF_REG_2, 16),
+        STX_W(BPF_REG_10, BPF_REG_2, -4),
+        MOV64_REG(BPF_REG_1, BPF_REG_6),
+        LD_MAP_FD(BPF_REG_2, map_fd),
+        MOV64_REG(BPF_REG_3, BPF_REG_10),
+        ADD64_IMM(BPF_REG_3, -24),
+        MOV64_IMM(BPF_REG_4, BPF_ANY),
+        CALL(BPF_FUNC_sock_hash_update),
+        MOV64_IMM(BPF_REG_0, 1),
+        EXIT(),
+    };
+
+    return bpf_prog_load_insns(BPF_PROG_TYPE_SOCK_OPS, BPF_CGROUP_SOCK_OPS, program, sizeof(program) / sizeof(program[0]));
+}
+
+// sk_msg: ساخت کلید سوکت مقابل (local و remote جابه‌جا) و redirect به صف دریافت آن
+// اگر سوکت مقابل در map نباشد redirect برقرار نمی‌شود و SK_PASS داده را به مسیر عادی TCP می‌فرستد
+static int load_msg(int map_fd) {
+    struct bpf_insn program[] = {
+        MOV64_REG(BPF_REG_6, BPF_REG_1),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct sk_msg_md, family)),
+        JNE_IMM(BPF_REG_2, AF_INET, 30),
+        CLASSIFY_REMOTE(offsetof(struct sk_msg_md, remote_ip4), 21),
+        STX_DW(BPF_REG_10, BPF_REG_8, -24),
+        STX_W(BPF_REG_10, BPF_REG_7, -16),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct sk_msg_md, local_ip4)),
+        STX_W(BPF_REG_10, BPF_REG_2, -12),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct sk_msg_md, remote_port)),
+        RSH32_IMM(BPF_REG_2, 16),
+        TO_BE(BPF_REG_2, 16),
+        STX_W(BPF_REG_10, BPF_REG_2, -8),
+        LDX_W(BPF_REG_2, BPF_REG_6, offsetof(struct sk_msg_md, local_port)),
+        STX_W(BPF_REG_10, BPF_REG_2, -4),
+        MOV64_REG(BPF_REG_1, BPF_REG_6),
+        LD_MAP_FD(BPF_REG_2, map_fd),
+        MOV64_REG(BPF_REG_3, BPF_REG_10),
+        ADD64_IMM(BPF_REG_3, -24),
+        MOV64_IMM(BPF_REG_4, BPF_F_INGRESS),
+        CALL(BPF_FUNC_msg_redirect_hash),
+        MOV64_IMM(BPF_REG_0, SK_PASS),
+        EXIT(),
+    };
+
+    return bpf_prog_load_insns(BPF_PROG_TYPE_SK_MSG, BPF_SK_MSG_VERDICT, program, sizeof(program) / sizeof(program[0]));
+}
+
+static void close_fds() {
+    if (sockmap_state.msg_fd != -1) close(sockmap_state.msg_fd);
+    if (sockmap_state.sockops_fd != -1) close(sockmap_state.sockops_fd);
+    if (sockmap_state.map_fd != -1) close(sockmap_state.map_fd);
+    sockmap_state.map_fd = sockmap_state.sockops_fd = sockmap_state.msg_fd = -1;
+}
+
+static int load_objects() {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_SOCKHASH;
+    attr.key_size = sizeof(sockmap_key_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = SOCKMAP_MAX_ENTRIES;
+    strncpy(attr.map_name, "sc_sockhash", sizeof(attr.map_name) - 1);
+    sockmap_state.map_fd = bpf_call(BPF_MAP_CREATE, &attr);
+    if (sockmap_state.map_fd < 0) {
+        log_error("خطا در ایجاد sockhash: %s", strerror(errno));
+        return -1;
+    }
+
+    sockmap_state.sockops_fd = load_sockops(sockmap_state.map_fd);
+    if (sockmap_state.sockops_fd >= 0) {
+        sockmap_state.msg_fd = load_msg(sockmap_state.map_fd);
+    }
+    if (sockmap_state.sockops_fd < 0 || sockmap_state.msg_fd < 0) {
+        return -1;
+    }
+
+    // sk_msg به خود map متصل می‌شود و روی هر سوکت افزوده‌شده اجرا می‌شود
+    memset(&attr, 0, sizeof(attr));
+    attr.target_fd = sockmap_state.map_fd;
+    attr.attach_bpf_fd = sockmap_state.msg_fd;
+    attr.attach_type = BPF_SK_MSG_VERDICT;
+    if (bpf_call(BPF_PROG_ATTACH, &attr) != 0) {
+        log_error("خطا در اتصال sk_msg به sockhash: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int sockmap_init() {
+    pthread_mutex_lock(&sockmap_state.lock);
+    if (sockmap_state.map_fd != -1) {
+        pthread_mutex_unlock(&sockmap_state.lock);
+        return 0;
+    }
+
+    // نسخه pin‌شده اجرای قبلی: سوکت‌های کانتینرهای آن در همین map هستند
+    bool pinned = bpf_pin_ready();
+    if (pinned) {
+        sockmap_state.map_fd = bpf_object_get("sockhash");
+        sockmap_state.sockops_fd = bpf_object_get("sockops");
+        sockmap_state.msg_fd = bpf_object_get("sk_msg");
+        if (sockmap_state.map_fd >= 0 && sockmap_state.sockops_fd >= 0 && sockmap_state.msg_fd >= 0) {
+            pthread_mutex_unlock(&sockmap_state.lock);
+            return 0;
+        }
+        close_fds();
+    }
+
+    if (load_objects() != 0) {
+        close_fds();
+        pthread_mutex_unlock(&sockmap_state.lock);
+        return -1;
+    }
+    if (pinned && (bpf_object_pin(sockmap_state.map_fd, "sockhash") != 0 ||
+                   bpf_object_pin(sockmap_state.sockops_fd, "sockops") != 0 ||
+                   bpf_object_pin(sockmap_state.msg_fd, "sk_msg") != 0)) {
+        log_debug("pin کردن sockmap در %s ممکن نشد", BPF_PIN_DIR);
+    }
+    pthread_mutex_unlock(&sockmap_state.lock);
+    return 0;
+}
+
+int sockmap_attach_cgroup(const char *cgroup_path) {
+    if (sockmap_init() != 0) {
+        return -1;
+    }
+    if (bpf_cgroup_attach(cgroup_path, sockmap_state.sockops_fd, BPF_CGROUP_SOCK_OPS) != 0) {
+        log_error("خطا در اتصال sockops به cgroup %s: %s", cgroup_path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int sockmap_detach_cgroup(const char *cgroup_path) {
+    if (sockmap_state.sockops_fd == -1) {
+        return -1;
+    }
+    return bpf_cgroup_detach(cgroup_path, sockmap_state.sockops_fd, BPF_CGROUP_SOCK_OPS);
+}
+
+int sockmap_socket_count() {
+    if (sockmap_state.map_fd == -1) {
+        return -1;
+    }
+    sockmap_key_t key, next;
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = sockmap_state.map_fd;
+    attr.key = 0;
+    attr.next_key = (uint64_t)(uintptr_t)&next;
+    int count = 0;
+    while (bpf_call(BPF_MAP_GET_NEXT_KEY, &attr) == 0) {
+        count++;
+        key = next;
+        attr.key = (uint64_t)(uintptr_t)&key;
+    }
+    return count;
+}
+
+void sockmap_cleanup() {
+    pthread_mutex_lock(&sockmap_state.lock);
+    close_fds();
+    pthread_mutex_unlock(&sockmap_state.lock);
+}
@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <asm/ptrace.h>
+#include "../include/syslearn.h"
+#include "../include/seccomp.h"
+#include "../include/bpfprog.h"
+#include "../include/utils.h"
+
+// پرش به برچسب exit برنامه که پس از ساخت آرایه جایگزین می‌شود
+#define EXIT_LABEL 0x7fff
+
+// syscall هایی که یک آرگومان انتخابگر با مقادیر کوچک دارند
+typedef struct {
+    int nr;
+    int arg;
+} class_arg_t;
+
+static const class_arg_t class_args[] = {
+    { SYS_socket, 0 }, { SYS_socketpair, 0 }, { SYS_setsockopt, 1 }, { SYS_getsockopt, 1 },
+    { SYS_prctl, 0 }, { SYS_personality, 0 }, { SYS_fcntl, 1 }, { SYS_mmap, 2 }, { SYS_mprotect, 2 },
+    { SYS_madvise, 2 }, { SYS_rt_sigprocmask, 0 }, { SYS_kill, 1 }, { SYS_clock_gettime, 0 },
+};
+
+// ثبات آرگومان‌های syscall در pt_regs؛ آرگومان چهارم در r10 است نه rcx
+static const uint32_t arg_offsets[] = {
+    offsetof(struct pt_regs, rdi), offsetof(struct pt_regs, rsi), offsetof(struct pt_regs, rdx),
+    offsetof(struct pt_regs, r10), offsetof(struct pt_regs, r8), offsetof(struct pt_regs, r9),
+};
+
+typedef struct syslearn_session {
+    char id[64];
+    char profile_path[1024];
+    int cgroup_map_fd;          // cgroup کانتینر برای current_task_under_cgroup
+    int state_fd;               // پرچم آغاز شمارش با نخستین execve
+    int counts_fd;              // تعداد هر syscall، per-CPU
+    int classes_fd;             // محل آرگومان انتخابگر در pt_regs (0 یعنی بدون دسته؛ r15 آرگومان نیست)
+    int masks_fd;               // بیت‌های مقادیر دیده‌شده آرگومان انتخابگر، per-CPU
+    int prog_fd;
+    int link_fd;                // اتصال raw tracepoint؛ بستن آن برنامه را جدا می‌کند
+    struct syslearn_session *next;
+} syslearn_session_t;
+
+static syslearn_session_t *sessions = NULL;
+static pthread_mutex_t sessions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int create_map(enum bpf_map_type type, uint32_t value_size, uint32_t entries, const char *name) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = type;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = value_size;
+    attr.max_entries = entries;
+    strncpy(attr.map_name, name, sizeof(attr.map_name) - 1);
+    int fd = bpf_call(BPF_MAP_CREATE, &attr);
+    if (fd < 0) {
+        log_error("خطا در ایجاد map %s: %s", name, strerror(errno));
+    }
+    return fd;
+}
+
+static int update_elem(int map_fd, uint32_t key, const void *value) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)value;
+    return bpf_call(BPF_MAP_UPDATE_ELEM, &attr) == 0 ? 0 : -1;
+}
+
+static int lookup_elem(int map_fd, uint32_t key, void *value) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)value;
+    return bpf_call(BPF_MAP_LOOKUP_ELEM, &attr) == 0 ? 0 : -1;
+}
+
+// تعداد CPU های ممکن که اندازه مقدار map های per-CPU در فضای کاربر را تعیین می‌کند
+static int possible_cpus() {
+    char text[64] = "";
+    FILE *file = fopen("/sys/devices/system/cpu/possible", "r");
+    if (file) {
+        if (!fgets(text, sizeof(text), file)) {
+            text[0] = '\0';
+        }
+        fclose(file);
+    }
+    int first = 0, last = 0;
+    int fields = sscanf(text, "%d-%d", &first, &last);
+    return fields == 2 ? last + 1 : fields == 1 ? first + 1 : 1;
+}
+
+static uint64_t sum_percpu(int map_fd, uint32_t key, uint64_t *values, int cpus, bool or_values) {
+    uint64_t total = 0;
+    if (lookup_elem(map_fd, key, values) == 0) {
+        for (int cpu = 0; cpu < cpus; cpu++) {
+            total = or_values ? total | values[cpu] : total + values[cpu];
+        }
+    }
+    return total;
+}
+
+// برنامه sys_enter: ctx->args[0] نشانی pt_regs کاربر و ctx->args[1] شماره syscall است
+static int load_program(const syslearn_session_t *session) {
+    struct bpf_insn program[] = {
+        MOV64_REG(BPF_REG_6, BPF_REG_1),
+        LD_MAP_FD(BPF_REG_1, session->cgroup_map_fd),
+        MOV64_IMM(BPF_REG_2, 0),
+        CALL(BPF_FUNC_current_task_under_cgroup),
+        JNE_IMM(BPF_REG_0, 1, EXIT_LABEL),
+        LDX_DW(BPF_REG_7, BPF_REG_6, 8),
+        MOV64_IMM(BPF_REG_1, SECCOMP_MAX_SYSCALL),
+        JLE_REG(BPF_REG_1, BPF_REG_7, EXIT_LABEL),
+        // شمارش پس از نخستین execve یا execveat درون cgroup
+        MOV64_IMM(BPF_REG_1, 0),
+        STX_W(BPF_REG_10, BPF_REG_1, -4),
+        MOV64_REG(BPF_REG_2, BPF_REG_10),
+        ADD64_IMM(BPF_REG_2, -4),
+        LD_MAP_FD(BPF_REG_1, session->state_fd),
+        CALL(BPF_FUNC_map_lookup_elem),
+        JEQ_IMM(BPF_REG_0, 0, EXIT_LABEL),
+        LDX_W(BPF_REG_1, BPF_REG_0, 0),
+        JNE_IMM(BPF_REG_1, 0, 4),
+        JEQ_IMM(BPF_REG_7, SYS_execve, 1),
+        JNE_IMM(BPF_REG_7, SYS_execveat, EXIT_LABEL),
+        MOV64_IMM(BPF_REG_1, 1),
+        STX_W(BPF_REG_0, BPF_REG_1, 0),
+        // شمارنده per-CPU بدون دستور اتمی
+        STX_W(BPF_REG_10, BPF_REG_7, -4),
+        MOV64_REG(BPF_REG_2, BPF_REG_10),
+        ADD64_IMM(BPF_REG_2, -4),
+        LD_MAP_FD(BPF_REG_1, session->counts_fd),
+        CALL(BPF_FUNC_map_lookup_elem),
+        JEQ_IMM(BPF_REG_0, 0, EXIT_LABEL),
+        LDX_DW(BPF_REG_1, BPF_REG_0, 0),
+        ADD64_IMM(BPF_REG_1, 1),
+        STX_DW(BPF_REG_0, BPF_REG_1, 0),
+        // دسته آرگومان: بیت min(مقدار, SYSLEARN_CLASS_MAX)
+        MOV64_REG(BPF_REG_2, BPF_REG_10),
+        ADD64_IMM(BPF_REG_2, -4),
+        LD_MAP_FD(BPF_REG_1, session->classes_fd),
+        CALL(BPF_FUNC_map_lookup_elem),
+        JEQ_IMM(BPF_REG_0, 0, EXIT_LABEL),
+        LDX_W(BPF_REG_8, BPF_REG_0, 0),
+        JEQ_IMM(BPF_REG_8, 0, EXIT_LABEL),
+        LDX_DW(BPF_REG_3, BPF_REG_6, 0),
+        ALU64_REG(BPF_ADD, BPF_REG_3, BPF_REG_8),
+        MOV64_REG(BPF_REG_1, BPF_REG_10),
+        ADD64_IMM(BPF_REG_1, -16),
+        MOV64_IMM(BPF_REG_2, 8),
+        CALL(BPF_FUNC_probe_read_kernel),
+        JNE_IMM(BPF_REG_0, 0, EXIT_LABEL),
+        LDX_DW(BPF_REG_1, BPF_REG_10, -16),
+        MOV64_IMM(BPF_REG_2, SYSLEARN_CLASS_MAX),
+        JLE_REG(BPF_REG_2, BPF_REG_1, 1),
+        MOV64_REG(BPF_REG_2, BPF_REG_1),
+        MOV64_IMM(BPF_REG_9, 1),
+        ALU64_REG(BPF_LSH, BPF_REG_9, BPF_REG_2),
+        MOV64_REG(BPF_REG_2, BPF_REG_10),
+        ADD64_IMM(BPF_REG_2, -4),
+        LD_MAP_FD(BPF_REG_1, session->masks_fd),
+        CALL(BPF_FUNC_map_lookup_elem),
+        JEQ_IMM(BPF_REG_0, 0, EXIT_LABEL),
+        LDX_DW(BPF_REG_1, BPF_REG_0, 0),
+        ALU64_REG(BPF_OR, BPF_REG_1, BPF_REG_9),
+        STX_DW(BPF_REG_0, BPF_REG_1, 0),
+        // exit
+        MOV64_IMM(BPF_REG_0, 0),
+        EXIT(),
+    };
+    size_t count = sizeof(program) / sizeof(program[0]);
+    for (size_t i = 0; i < count; i++) {
+        if (BPF_CLASS(program[i].code) == BPF_JMP && program[i].off == EXIT_LABEL) {
+            program[i].off = count - 2 - (i + 1);
+        }
+    }
+    return bpf_prog_load_insns(BPF_PROG_TYPE_RAW_TRACEPOINT, 0, program, count);
+}
+
+static void session_free(syslearn_session_t *session) {
+    int *fds[] = { &session->link_fd, &session->prog_fd, &session->masks_fd, &session->classes_fd,
+                   &session->counts_fd, &session->state_fd, &session->cgroup_map_fd };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (*fds[i] >= 0) {
+            close(*fds[i]);
+        }
+    }
+    free(session);
+}
+
+static int setup_session(syslearn_session_t *session, const char *cgroup_path) {
+    session->cgroup_map_fd = create_map(BPF_MAP_TYPE_CGROUP_ARRAY, sizeof(uint32_t), 1, "sc_learn_cg");
+    session->state_fd = create_map(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), 1, "sc_learn_state");
+    session->counts_fd = create_map(BPF_MAP_TYPE_PERCPU_ARRAY, sizeof(uint64_t), SECCOMP_MAX_SYSCALL, "sc_learn_count");
+    session->classes_fd = create_map(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), SECCOMP_MAX_SYSCALL, "sc_learn_class");
+    session->masks_fd = create_map(BPF_MAP_TYPE_PERCPU_ARRAY, sizeof(uint64_t), SECCOMP_MAX_SYSCALL, "sc_learn_mask");
+    if (session->cgroup_map_fd < 0 || session->state_fd < 0 || session->counts_fd < 0 ||
+        session->classes_fd < 0 || session->masks_fd < 0) {
+        return -1;
+    }
+
+    int cgroup_fd = open(cgroup_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (cgroup_fd == -1) {
+        log_error("خطا در باز کردن cgroup %s", cgroup_path);
+        return -1;
+    }
+    uint32_t value = cgroup_fd;
+    int result = update_elem(session->cgroup_map_fd, 0, &value);
+    close(cgroup_fd);
+    for (size_t i = 0; result == 0 && i < sizeof(class_args) / sizeof(class_args[0]); i++) {
+        value = arg_offsets[class_args[i].arg];
+        result = update_elem(session->classes_fd, class_args[i].nr, &value);
+    }
+    if (result != 0) {
+        log_error("خطا در مقداردهی map های یادگیری syscall: %s", strerror(errno));
+        return -1;
+    }
+
+    session->prog_fd = load_program(session);
+    if (session->prog_fd < 0) {
+        return -1;
+    }
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.raw_tracepoint.name = (uintptr_t)"sys_enter";
+    attr.raw_tracepoint.prog_fd = session->prog_fd;
+    session->link_fd = bpf_call(BPF_RAW_TRACEPOINT_OPEN, &attr);
+    if (session->link_fd < 0) {
+        log_error("خطا در اتصال برنامه به sys_enter: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int syslearn_start(const char *id, const char *cgroup_path, const char *profile_path) {
+    syslearn_session_t *session = calloc(1, sizeof(syslearn_session_t));
+    if (!session) {
+        return -1;
+    }
+    strncpy(session->id, id, sizeof(session->id) - 1);
+    strncpy(session->profile_path, profile_path, sizeof(session->profile_path) - 1);
+    session->cgroup_map_fd = session->state_fd = session->counts_fd = -1;
+    session->classes_fd = session->masks_fd = session->prog_fd = session->link_fd = -1;
+
+    if (setup_session(session, cgroup_path) != 0) {
+        log_error("خطا در شروع یادگیری syscall های کانتینر %s", id);
+        session_free(session);
+        return -1;
+    }
+
+    pthread_mutex_lock(&sessions_lock);
+    session->next = sessions;
+    sessions = session;
+    pthread_mutex_unlock(&sessions_lock);
+    return 0;
+}
+
+typedef struct {
+    int nr;
+    uint64_t count;
+    uint64_t mask;
+} learned_t;
+
+static int compare_learned(const void *a, const void *b) {
+    const learned_t *left = a, *right = b;
+    return left->count < right->count ? 1 : left->count > right->count ? -1 : left->nr - right->nr;
+}
+
+static int write_profile(const syslearn_session_t *session) {
+    int cpus = possible_cpus();
+    uint64_t *values = calloc(cpus, sizeof(uint64_t));
+    learned_t *learned = calloc(SECCOMP_MAX_SYSCALL, sizeof(learned_t));
+    if (!values || !learned) {
+        free(values);
+        free(learned);
+        return -1;
+    }
+
+    // execve همیشه لازم است: فیلتر پیش از execv نصب می‌شود
+    int count = 0;
+    uint64_t total = 0;
+    for (int nr = 0; nr < SECCOMP_MAX_SYSCALL; nr++) {
+        uint64_t calls = sum_percpu(session->counts_fd, nr, values, cpus, false);
+        if (calls > 0 || nr == SYS_execve) {
+            learned[count++] = (learned_t){ nr, calls, sum_percpu(session->masks_fd, nr, values, cpus, true) };
+            total += calls;
+        }
+    }
+    free(values);
+    qsort(learned, count, sizeof(learned[0]), compare_learned);
+
+    FILE *file = fopen(session->profile_path, "w");
+    if (!file) {
+        log_error("خطا در ایجاد پروفایل %s", session->profile_path);
+        free(learned);
+        return -1;
+    }
+    fprintf(file, "# پروفایل seccomp ضبط‌شده از کانتینر %s: %d syscall، %llu فراخوانی\n", session->id, count,
+            (unsigned long long)total);
+    fprintf(file, "default errno\n");
+    for (int i = 0; i < count; i++) {
+        const char *name = seccomp_syscall_name(learned[i].nr);
+        if (name) {
+            fprintf(file, "allow %s %llu", name, (unsigned long long)learned[i].count);
+        } else {
+            fprintf(file, "allow %d %llu", learned[i].nr, (unsigned long long)learned[i].count);
+        }
+        for (size_t j = 0; learned[i].mask && j < sizeof(class_args) / sizeof(class_args[0]); j++) {
+            if (class_args[j].nr == learned[i].nr) {
+                fprintf(file, " # arg%d:", class_args[j].arg);
+                for (int bit = 0; bit <= SYSLEARN_CLASS_MAX; bit++) {
+                    if (learned[i].mask & (1ULL << bit)) {
+                        fprintf(file, bit == SYSLEARN_CLASS_MAX ? " >=%d" : " %d", bit);
+                    }
+                }
+            }
+        }
+        fputc('\n', file);
+    }
+    free(learned);
+
+    if (fclose(file) != 0) {
+        log_error("خطا در نوشتن پروفایل %s", session->profile_path);
+        return -1;
+    }
+    log_message("پروفایل seccomp با %d syscall در %s نوشته شد", count, session->profile_path);
+    return 0;
+}
+
+// جدا کردن نشست id از فهرست؛ NULL اگر ضبطی نباشد
+static syslearn_session_t* take_session(const char *id) {
+    pthread_mutex_lock(&sessions_lock);
+    syslearn_session_t **link = &sessions;
+    while (*link && strcmp((*link)->id, id) != 0) {
+        link = &(*link)->next;
+    }
+    syslearn_session_t *session = *link;
+    if (session) {
+        *link = session->next;
+    }
+    pthread_mutex_unlock(&sessions_lock);
+    return session;
+}
+
+int syslearn_finish(const char *id) {
+    syslearn_session_t *session = take_session(id);
+    if (!session) {
+        return 0;
+    }
+    // جدا کردن برنامه پیش از خواندن تا شمارش‌ها ثابت باشند
+    close(session->link_fd);
+    session->link_fd = -1;
+    int result = write_profile(session);
+    session_free(session);
+    return result;
+}
+
+void syslearn_discard(const char *id) {
+    syslearn_session_t *session = take_session(id);
+    if (session) {
+        session_free(session);
+    }
+}
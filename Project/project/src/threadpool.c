@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "../include/threadpool.h"
+#include "../include/utils.h"
+
+// حداکثر تعداد thread ها
+#define THREADPOOL_MAX_THREADS 64
+
+// یک کار در صف حلقوی
+typedef struct {
+    threadpool_task_t task;
+    void *arg;
+} threadpool_job_t;
+
+struct threadpool {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;   // کار جدید برای workers
+    pthread_cond_t not_full;    // جای خالی برای ارسال‌کننده
+    pthread_cond_t idle;        // همه کارها تمام شده‌اند
+
+    threadpool_job_t *jobs;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    size_t active;              // کارهای در حال اجرا
+
+    bool shutdown;
+    int thread_count;
+    pthread_t threads[THREADPOOL_MAX_THREADS];
+};
+
+// حلقه هر worker
+static void* threadpool_worker(void *arg) {
+    threadpool_t *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->count == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+        if (pool->count == 0 && pool->shutdown) {
+            break;
+        }
+
+        threadpool_job_t job = pool->jobs[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pool->active++;
+        pthread_cond_signal(&pool->not_full);
+        pthread_mutex_unlock(&pool->lock);
+
+        job.task(job.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->active--;
+        if (pool->count == 0 && pool->active == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// ایجاد مخزن
+threadpool_t* threadpool_create(int threads, size_t queue_capacity) {
+    if (threads <= 0) {
+        cpu_set_t cpus;
+        threads = sched_getaffinity(0, sizeof(cpus), &cpus) == 0 ? CPU_COUNT(&cpus) : 1;
+    }
+    if (threads > THREADPOOL_MAX_THREADS) {
+        threads = THREADPOOL_MAX_THREADS;
+    }
+    if (queue_capacity == 0) {
+        queue_capacity = (size_t)threads * 4;
+    }
+
+    threadpool_t *pool = calloc(1, sizeof(threadpool_t));
+    if (!pool) {
+        log_error("خطا در تخصیص حافظه برای مخزن thread");
+        return NULL;
+    }
+    pool->jobs = calloc(queue_capacity, sizeof(threadpool_job_t));
+    if (!pool->jobs) {
+        log_error("خطا در تخصیص حافظه برای صف کارها");
+        free(pool);
+        return NULL;
+    }
+    pool->capacity = queue_capacity;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+    pthread_cond_init(&pool->not_full, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, threadpool_worker, pool) != 0) {
+            log_error("خطا در ایجاد thread شماره %d مخزن", i);
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0) {
+        threadpool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// افزودن کار به صف
+int threadpool_submit(threadpool_t *pool, threadpool_task_t task, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count == pool->capacity && !pool->shutdown) {
+        pthread_cond_wait(&pool->not_full, &pool->lock);
+    }
+    if (pool->shutdown) {
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+
+    size_t tail = (pool->head + pool->count) % pool->capacity;
+    pool->jobs[tail].task = task;
+    pool->jobs[tail].arg = arg;
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+// انتظار تا اجرای همه کارهای ارسال‌شده
+void threadpool_wait(threadpool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count > 0 || pool->active > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// تعداد thread های مخزن
+int threadpool_size(const threadpool_t *pool) {
+    return pool->thread_count;
+}
+
+// پایان کارهای باقیمانده و آزادسازی مخزن
+void threadpool_destroy(threadpool_t *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_cond_broadcast(&pool->not_full);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_cond_destroy(&pool->not_full);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->jobs);
+    free(pool);
+}
@@ -0,0 +1,1461 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/xattr.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#include <linux/openat2.h>
+#include "../include/unpack.h"
+#include "../include/threadpool.h"
+#include "../include/digest.h"
+#include "../include/utils.h"
+
+// اندازه بلوک tar
+#define TAR_BLOCK_SIZE 512
+
+// اندازه بافر خواندن جریان
+#define UNPACK_READ_BUFFER (1024 * 1024)
+
+// فایل‌های کوچک‌تر از این مقدار در حافظه خوانده و به workers سپرده می‌شوند
+#define UNPACK_SMALL_FILE_MAX (512 * 1024)
+
+// ظرفیت صف کارها؛ همراه با حجم دسته‌ها حافظه در انتظار را محدود می‌کند
+#define UNPACK_QUEUE_CAPACITY 64
+
+// حداکثر تعداد و حجم فایل‌های یک دسته کار
+#define UNPACK_BATCH_FILES 64
+#define UNPACK_BATCH_BYTES (1024 * 1024)
+
+// اندازه بافر pipe برنامه بازکننده فشرده‌سازی
+#define UNPACK_PIPE_SIZE (1024 * 1024)
+
+// پیشوند whiteout در لایه‌های تصویر
+#define WHITEOUT_PREFIX ".wh."
+#define WHITEOUT_OPAQUE ".wh..wh..opq"
+
+// سرآیند ustar
+typedef struct {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char padding[12];
+} tar_header_t;
+
+// مشخصات یک ورودی آرشیو
+typedef struct {
+    char path[PATH_MAX];
+    char linkname[PATH_MAX];
+    char type;
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    uint64_t size;
+    struct timespec mtime;
+    dev_t device;
+} tar_entry_t;
+
+// مقادیر PAX یا GNU که روی ورودی بعدی اعمال می‌شوند
+typedef struct {
+    char *path;
+    char *linkname;
+    bool has_size, has_uid, has_gid, has_mtime;
+    uint64_t size;
+    uid_t uid;
+    gid_t gid;
+    struct timespec mtime;
+} tar_override_t;
+
+// خواننده جریانی با بافر
+typedef struct {
+    int fd;
+    bool seekable;
+    off_t fd_offset;            // موقعیت fd در جریان
+    char *buffer;
+    size_t start;
+    size_t end;
+} tar_reader_t;
+
+// دایرکتوری که مجوز و زمان آن در پایان اعمال می‌شود
+typedef struct {
+    char *path;
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    struct timespec mtime;
+} deferred_dir_t;
+
+// hardlink که پس از نوشته شدن همه فایل‌ها ساخته می‌شود
+typedef struct {
+    char *path;
+    char *target;
+} deferred_link_t;
+
+// وضعیت مشترک یک عملیات باز کردن
+typedef struct {
+    int root_fd;
+    bool use_openat2;
+    unpack_options_t options;
+    unpack_stats_t stats;
+    int error;                  // با __atomic خوانده و نوشته می‌شود
+    mode_t umask;
+    uid_t owner_uid;            // مالک پیش‌فرض فایل‌های جدید؛ در این صورت chown لازم نیست
+    gid_t owner_gid;
+    void *batch;                // دسته در حال تکمیل (unpack_job_t)
+
+    // هش مسیر فایل‌هایی که به workers سپرده شده‌اند (0 = خانه خالی)؛ برخورد هش فقط یک انتظار اضافه است
+    uint64_t *pending;
+    size_t pending_count, pending_capacity;
+
+    deferred_dir_t *dirs;
+    size_t dir_count, dir_capacity;
+    deferred_link_t *links;
+    size_t link_count, link_capacity;
+
+    char last_parent[PATH_MAX]; // آخرین دایرکتوری والد تضمین‌شده توسط خواننده
+} unpack_context_t;
+
+// یک فایل معمولی در انتظار نوشتن
+typedef struct {
+    char *path;
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    struct timespec mtime;
+    uint64_t size;
+    char *data;                 // محتوای فایل کوچک
+    int source_fd;              // یا کپی مستقیم از آرشیو بدون فشرده‌سازی
+    off_t source_offset;
+} unpack_file_t;
+
+// کار worker: دسته‌ای از فایل‌های یک دایرکتوری تا والد فقط یک بار باز شود
+typedef struct {
+    unpack_context_t *ctx;
+    int count;
+    size_t bytes;
+    size_t parent_length;
+    unpack_file_t files[UNPACK_BATCH_FILES];
+} unpack_job_t;
+
+// گزینه‌های پیش‌فرض
+void unpack_default_options(unpack_options_t *options) {
+    options->threads = 0;
+    options->preserve_owner = true;
+    options->convert_whiteouts = true;
+    options->expected_digest = NULL;
+}
+
+// ثبت خطا در وضعیت مشترک
+static void unpack_fail(unpack_context_t *ctx) {
+    __atomic_store_n(&ctx->error, 1, __ATOMIC_RELAXED);
+}
+
+static bool unpack_failed(unpack_context_t *ctx) {
+    return __atomic_load_n(&ctx->error, __ATOMIC_RELAXED) != 0;
+}
+
+// ---------- خواننده جریان ----------
+
+// پر کردن بافر؛ تعداد بایت‌های در دسترس را برمی‌گرداند
+static ssize_t reader_fill(tar_reader_t *reader) {
+    if (reader->start == reader->end) {
+        reader->start = reader->end = 0;
+    }
+    if (reader->end == UNPACK_READ_BUFFER) {
+        return reader->end - reader->start;
+    }
+
+    ssize_t n;
+    do {
+        n = read(reader->fd, reader->buffer + reader->end, UNPACK_READ_BUFFER - reader->end);
+    } while (n == -1 && errno == EINTR);
+    if (n < 0) {
+        log_error("خطا در خواندن آرشیو");
+        return -1;
+    }
+    reader->end += n;
+    reader->fd_offset += n;
+    return reader->end - reader->start;
+}
+
+// خواندن دقیق size بایت
+static int reader_read(tar_reader_t *reader, void *out, size_t size) {
+    char *dst = out;
+    while (size > 0) {
+        if (reader->start == reader->end) {
+            ssize_t available = reader_fill(reader);
+            if (available <= 0) {
+                if (available == 0) log_error("پایان ناگهانی آرشیو");
+                return -1;
+            }
+        }
+        size_t chunk = reader->end - reader->start;
+        if (chunk > size) chunk = size;
+        memcpy(dst, reader->buffer + reader->start, chunk);
+        reader->start += chunk;
+        dst += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+// رد کردن size بایت؛ در آرشیو قابل seek بدون خواندن داده
+static int reader_skip(tar_reader_t *reader, uint64_t size) {
+    size_t buffered = reader->end - reader->start;
+    if (size <= buffered) {
+        reader->start += size;
+        return 0;
+    }
+
+    size -= buffered;
+    reader->start = reader->end = 0;
+
+    if (reader->seekable) {
+        reader->fd_offset += size;
+        if (lseek(reader->fd, reader->fd_offset, SEEK_SET) == (off_t)-1) {
+            log_error("خطا در جابجایی در آرشیو");
+            return -1;
+        }
+        return 0;
+    }
+
+    while (size > 0) {
+        ssize_t available = reader_fill(reader);
+        if (available <= 0) {
+            if (available == 0) log_error("پایان ناگهانی آرشیو");
+            return -1;
+        }
+        size_t chunk = (size_t)available < size ? (size_t)available : size;
+        reader->start += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+// موقعیت منطقی خواننده در آرشیو
+static off_t reader_position(const tar_reader_t *reader) {
+    return reader->fd_offset - (off_t)(reader->end - reader->start);
+}
+
+// انتقال size بایت از جریان به فایل؛ بخش بافرشده نوشته و باقی با splice منتقل می‌شود
+static int reader_splice(tar_reader_t *reader, int out_fd, uint64_t size) {
+    off_t out_offset = 0;
+
+    size_t buffered = reader->end - reader->start;
+    if (buffered > size) buffered = size;
+    while (buffered > 0) {
+        ssize_t n = pwrite(out_fd, reader->buffer + reader->start, buffered, out_offset);
+        if (n <= 0) {
+            return -1;
+        }
+        reader->start += n;
+        out_offset += n;
+        buffered -= n;
+        size -= n;
+    }
+
+    // splice فقط از pipe ممکن است؛ در غیر این صورت از بافر خواننده استفاده می‌شود
+    while (size > 0) {
+        ssize_t n = splice(reader->fd, NULL, out_fd, &out_offset, size, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EINVAL || errno == ENOSYS)) {
+            ssize_t available = reader_fill(reader);
+            if (available <= 0) {
+                return -1;
+            }
+            size_t chunk = (size_t)available < size ? (size_t)available : size;
+            if (pwrite(out_fd, reader->buffer + reader->start, chunk, out_offset) != (ssize_t)chunk) {
+                return -1;
+            }
+            reader->start += chunk;
+            out_offset += chunk;
+            size -= chunk;
+            continue;
+        }
+        if (n <= 0) {
+            log_error("خطا در انتقال داده فایل از آرشیو");
+            return -1;
+        }
+        reader->fd_offset += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// ---------- تفکیک سرآیند ----------
+
+// خواندن عدد octal یا base-256 (برای مقادیر بزرگ در GNU tar)
+static uint64_t parse_number(const char *field, size_t length) {
+    const unsigned char *p = (const unsigned char *)field;
+    uint64_t value = 0;
+
+    if (p[0] & 0x80) {
+        value = p[0] & 0x3f;
+        for (size_t i = 1; i < length; i++) {
+            value = (value << 8) | p[i];
+        }
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < length && (p[i] == ' ' || p[i] == '\0')) i++;
+    while (i < length && p[i] >= '0' && p[i] <= '7') {
+        value = (value << 3) | (p[i] - '0');
+        i++;
+    }
+    return value;
+}
+
+// بررسی checksum سرآیند
+static bool header_checksum_valid(const tar_header_t *header) {
+    const unsigned char *bytes = (const unsigned char *)header;
+    uint64_t expected = parse_number(header->checksum, sizeof(header->checksum));
+    uint64_t sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        bool in_checksum = i >= offsetof(tar_header_t, checksum) &&
+                           i < offsetof(tar_header_t, checksum) + sizeof(header->checksum);
+        sum += in_checksum ? ' ' : bytes[i];
+    }
+    return sum == expected;
+}
+
+// آیا بلوک کاملاً صفر است (نشانه پایان آرشیو)
+static bool block_is_zero(const char *block) {
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        if (block[i] != 0) return false;
+    }
+    return true;
+}
+
+// کپی فیلد با طول ثابت که ممکن است با NUL تمام نشود
+static void copy_field(char *dst, size_t dst_size, const char *field, size_t field_size) {
+    size_t length = strnlen(field, field_size);
+    if (length >= dst_size) length = dst_size - 1;
+    memcpy(dst, field, length);
+    dst[length] = '\0';
+}
+
+// خواندن زمان با بخش کسری از PAX (مانند 1700000000.123456789)
+static struct timespec parse_pax_time(const char *value) {
+    struct timespec ts = { 0, 0 };
+    char *end;
+    ts.tv_sec = strtoll(value, &end, 10);
+    if (*end == '.') {
+        long scale = 100000000;
+        for (const char *p = end + 1; *p >= '0' && *p <= '9' && scale > 0; p++, scale /= 10) {
+            ts.tv_nsec += (*p - '0') * scale;
+        }
+    }
+    return ts;
+}
+
+// تفکیک رکوردهای PAX ("<طول> <کلید>=<مقدار>\n")
+static void parse_pax(char *data, size_t size, tar_override_t *override) {
+    size_t offset = 0;
+    while (offset < size) {
+        char *record = data + offset;
+        char *end;
+        unsigned long length = strtoul(record, &end, 10);
+        if (length == 0 || offset + length > size || *end != ' ') {
+            break;
+        }
+
+        char *key = end + 1;
+        char *value = strchr(key, '=');
+        record[length - 1] = '\0';  // جایگزینی '\n' پایانی
+        if (value) {
+            *value++ = '\0';
+            if (strcmp(key, "path") == 0) {
+                free(override->path);
+                override->path = strdup(value);
+            } else if (strcmp(key, "linkpath") == 0) {
+                free(override->linkname);
+                override->linkname = strdup(value);
+            } else if (strcmp(key, "size") == 0) {
+                override->size = strtoull(value, NULL, 10);
+                override->has_size = true;
+            } else if (strcmp(key, "uid") == 0) {
+                override->uid = strtoul(value, NULL, 10);
+                override->has_uid = true;
+            } else if (strcmp(key, "gid") == 0) {
+                override->gid = strtoul(value, NULL, 10);
+                override->has_gid = true;
+            } else if (strcmp(key, "mtime") == 0) {
+                override->mtime = parse_pax_time(value);
+                override->has_mtime = true;
+            }
+        }
+        offset += length;
+    }
+}
+
+// آزادسازی مقادیر override پس از استفاده
+static void override_reset(tar_override_t *override) {
+    free(override->path);
+    free(override->linkname);
+    memset(override, 0, sizeof(*override));
+}
+
+// خواندن داده یک ورودی کمکی (PAX یا نام طولانی GNU) در حافظه
+static char* read_meta_data(tar_reader_t *reader, uint64_t size) {
+    if (size > 1024 * 1024) {
+        log_error("سرآیند توسعه‌یافته tar خیلی بزرگ است");
+        return NULL;
+    }
+    char *data = malloc(size + 1);
+    if (!data) {
+        return NULL;
+    }
+    uint64_t padded = (size + TAR_BLOCK_SIZE - 1) & ~(uint64_t)(TAR_BLOCK_SIZE - 1);
+    if (reader_read(reader, data, size) != 0 || reader_skip(reader, padded - size) != 0) {
+        free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    return data;
+}
+
+// نرمال‌سازی مسیر: حذف "/" و "./" ابتدایی و رد کردن اجزای ".."
+static int sanitize_path(char *path) {
+    char *p = path;
+    while (*p == '/' || (p[0] == '.' && p[1] == '/')) {
+        p += (*p == '/') ? 1 : 2;
+    }
+    memmove(path, p, strlen(p) + 1);
+
+    size_t length = strlen(path);
+    while (length > 0 && path[length - 1] == '/') {
+        path[--length] = '\0';
+    }
+    if (length == 0 || strcmp(path, ".") == 0) {
+        return 1;  // خود ریشه
+    }
+
+    for (char *component = path; component; ) {
+        char *slash = strchr(component, '/');
+        size_t component_length = slash ? (size_t)(slash - component) : strlen(component);
+        if (component_length == 2 && component[0] == '.' && component[1] == '.') {
+            log_error("مسیر خارج از ریشه در آرشیو رد شد: %s", path);
+            return -1;
+        }
+        component = slash ? slash + 1 : NULL;
+    }
+    return 0;
+}
+
+// ---------- عملیات فایل‌سیستم درون ریشه ----------
+
+// باز کردن دایرکتوری درون ریشه بدون دنبال کردن symlink های بیرون‌زننده
+static int open_in_root(unpack_context_t *ctx, const char *path) {
+    if (path[0] == '\0') {
+        return dup(ctx->root_fd);
+    }
+
+    if (ctx->use_openat2) {
+        struct open_how how = {
+            .flags = O_PATH | O_DIRECTORY | O_CLOEXEC,
+            .resolve = RESOLVE_IN_ROOT | RESOLVE_NO_MAGICLINKS,
+        };
+        int fd = syscall(SYS_openat2, ctx->root_fd, path, &how, sizeof(how));
+        if (fd != -1 || (errno != ENOSYS && errno != E2BIG)) {
+            return fd;
+        }
+        ctx->use_openat2 = false;
+    }
+
+    // هسته‌های قدیمی: پیمایش جزء به جزء بدون دنبال کردن symlink
+    char buffer[PATH_MAX];
+    strncpy(buffer, path, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    int fd = dup(ctx->root_fd);
+    char *saveptr;
+    for (char *component = strtok_r(buffer, "/", &saveptr); component && fd != -1;
+         component = strtok_r(NULL, "/", &saveptr)) {
+        int next = openat(fd, component, O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        fd = next;
+    }
+    return fd;
+}
+
+// باز کردن دایرکتوری والد path؛ name به جزء آخر اشاره می‌کند
+static int open_parent(unpack_context_t *ctx, char *path, const char **name) {
+    char *slash = strrchr(path, '/');
+    if (!slash) {
+        *name = path;
+        return dup(ctx->root_fd);
+    }
+
+    *slash = '\0';
+    int fd = open_in_root(ctx, path);
+    *slash = '/';
+    *name = slash + 1;
+    return fd;
+}
+
+// ایجاد همه دایرکتوری‌های والد path (مانند mkdir -p)
+static int ensure_parents(unpack_context_t *ctx, char *path) {
+    char *slash = strrchr(path, '/');
+    if (!slash) {
+        return 0;
+    }
+
+    // ورودی‌های آرشیو معمولاً بر اساس دایرکتوری گروه‌بندی شده‌اند
+    size_t parent_length = slash - path;
+    if (strncmp(ctx->last_parent, path, parent_length) == 0 && ctx->last_parent[parent_length] == '\0') {
+        return 0;
+    }
+
+    *slash = '\0';
+    int fd = open_in_root(ctx, path);
+    if (fd == -1 && errno == ENOENT) {
+        for (char *p = strchr(path, '/'); ; p = strchr(p + 1, '/')) {
+            if (p) *p = '\0';
+            const char *name;
+            int parent = open_parent(ctx, path, &name);
+            if (parent != -1) {
+                mkdirat(parent, name, 0755);
+                close(parent);
+            }
+            if (!p) break;
+            *p = '/';
+        }
+        fd = open_in_root(ctx, path);
+    }
+
+    if (fd != -1) {
+        close(fd);
+        strcpy(ctx->last_parent, path);
+    }
+    *slash = '/';
+
+    if (fd == -1) {
+        log_error("خطا در ایجاد دایرکتوری والد %s", path);
+        return -1;
+    }
+    return 0;
+}
+
+// اعمال مالکیت و زمان روی ورودی (بدون دنبال کردن symlink)
+static void apply_entry_metadata(unpack_context_t *ctx, int parent, const char *name,
+                                 uid_t uid, gid_t gid, const struct timespec *mtime) {
+    if (ctx->options.preserve_owner) {
+        fchownat(parent, name, uid, gid, AT_SYMLINK_NOFOLLOW);
+    }
+    struct timespec times[2] = { *mtime, *mtime };
+    utimensat(parent, name, times, AT_SYMLINK_NOFOLLOW);
+}
+
+// ایجاد فایل معمولی
+// فایل‌های بزرگ با O_TMPFILE و fallocate ساخته می‌شوند تا فایل نیمه‌نوشته با نام نهایی دیده نشود
+// و فضا یکجا رزرو شود؛ برای فایل‌های کوچک هزینه این دو از نوشتن بیشتر است
+static int create_regular_file(int parent, const char *name, uint64_t size, mode_t mode, bool *anonymous) {
+    int fd = -1;
+    *anonymous = false;
+
+    if (size > UNPACK_SMALL_FILE_MAX) {
+        fd = openat(parent, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0600);
+        *anonymous = fd != -1;
+    }
+    for (int attempt = 0; fd == -1 && attempt < 2; attempt++) {
+        fd = openat(parent, name, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, mode & 0777);
+        if (fd == -1 && errno == EEXIST) {
+            // ورودی بعدی آرشیو جایگزین ورودی قبلی با همان نام می‌شود
+            unlinkat(parent, name, 0);
+        } else if (fd == -1) {
+            return -1;
+        }
+    }
+
+    if (fd != -1 && size > UNPACK_SMALL_FILE_MAX) {
+        fallocate(fd, 0, 0, size);
+    }
+    return fd;
+}
+
+// اعمال مشخصات و قرار دادن فایل با نام نهایی
+static int finish_regular_file(unpack_context_t *ctx, int fd, int parent, const char *name, bool anonymous,
+                               mode_t mode, uid_t uid, gid_t gid, const struct timespec *mtime) {
+    // chown پیش از chmod چون بیت‌های setuid را پاک می‌کند
+    bool chowned = false;
+    if (ctx->options.preserve_owner && (uid != ctx->owner_uid || gid != ctx->owner_gid)) {
+        fchown(fd, uid, gid);
+        chowned = true;
+    }
+    if (anonymous || chowned || (mode & (07000 | ctx->umask))) {
+        fchmod(fd, mode & 07777);
+    }
+    struct timespec times[2] = { *mtime, *mtime };
+    futimens(fd, times);
+
+    if (!anonymous) {
+        return 0;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (linkat(fd, "", parent, name, AT_EMPTY_PATH) == 0) {
+            return 0;
+        }
+        if (errno == EEXIST) {
+            unlinkat(parent, name, 0);
+            continue;
+        }
+        if (errno == EPERM || errno == ENOENT) {
+            // بدون CAP_DAC_READ_SEARCH از مسیر /proc استفاده می‌شود
+            char proc_path[64];
+            snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd);
+            if (linkat(AT_FDCWD, proc_path, parent, name, AT_SYMLINK_FOLLOW) == 0) {
+                return 0;
+            }
+            if (errno == EEXIST) {
+                unlinkat(parent, name, 0);
+                continue;
+            }
+        }
+        break;
+    }
+    return -1;
+}
+
+// کپی از آرشیو بدون فشرده‌سازی با copy_file_range (بدون عبور داده از فضای کاربر)
+static int copy_from_archive(int source_fd, off_t source_offset, int out_fd, uint64_t size) {
+    off_t out_offset = 0;
+    while (size > 0) {
+        ssize_t n = copy_file_range(source_fd, &source_offset, out_fd, &out_offset, size, 0);
+        if (n > 0) {
+            size -= n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0 || (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP)) {
+            return -1;
+        }
+
+        // بازگشت به pread/pwrite برای فایل‌سیستم‌هایی که copy_file_range ندارند
+        char *buffer = malloc(UNPACK_READ_BUFFER);
+        if (!buffer) {
+            return -1;
+        }
+        while (size > 0) {
+            size_t chunk = size < UNPACK_READ_BUFFER ? size : UNPACK_READ_BUFFER;
+            ssize_t r = pread(source_fd, buffer, chunk, source_offset);
+            if (r <= 0 || pwrite(out_fd, buffer, r, out_offset) != r) {
+                free(buffer);
+                return -1;
+            }
+            source_offset += r;
+            out_offset += r;
+            size -= r;
+        }
+        free(buffer);
+    }
+    return 0;
+}
+
+// نوشتن کامل بافر در فایل
+static int write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// نوشتن یک فایل در دایرکتوری والد باز شده
+static int write_regular_file(unpack_context_t *ctx, int parent, unpack_file_t *file) {
+    const char *name = file->path + (strrchr(file->path, '/') ? strrchr(file->path, '/') - file->path + 1 : 0);
+    bool anonymous;
+    int fd = create_regular_file(parent, name, file->size, file->mode, &anonymous);
+    if (fd == -1) {
+        return -1;
+    }
+
+    int result;
+    if (file->data) {
+        result = write_all(fd, file->data, file->size);
+    } else {
+        result = copy_from_archive(file->source_fd, file->source_offset, fd, file->size);
+    }
+    if (result == 0) {
+        result = finish_regular_file(ctx, fd, parent, name, anonymous,
+                                     file->mode, file->uid, file->gid, &file->mtime);
+    }
+    close(fd);
+    return result;
+}
+
+// کار worker: نوشتن یک دسته فایل
+static void unpack_write_job(void *arg) {
+    unpack_job_t *job = arg;
+    unpack_context_t *ctx = job->ctx;
+
+    if (!unpack_failed(ctx)) {
+        const char *name;
+        int parent = open_parent(ctx, job->files[0].path, &name);
+        for (int i = 0; i < job->count && !unpack_failed(ctx); i++) {
+            if (parent == -1 || write_regular_file(ctx, parent, &job->files[i]) != 0) {
+                log_error("خطا در نوشتن فایل %s", job->files[i].path);
+                unpack_fail(ctx);
+            }
+        }
+        if (parent != -1) {
+            close(parent);
+        }
+    }
+
+    for (int i = 0; i < job->count; i++) {
+        free(job->files[i].data);
+        free(job->files[i].path);
+    }
+    free(job);
+}
+
+// ارسال دسته در حال تکمیل به workers
+static void flush_batch(unpack_context_t *ctx, threadpool_t *pool) {
+    unpack_job_t *job = ctx->batch;
+    ctx->batch = NULL;
+    if (job && threadpool_submit(pool, unpack_write_job, job) != 0) {
+        unpack_write_job(job);
+    }
+}
+
+// هش FNV-1a مسیر برای جدول نوشتن‌های در انتظار
+static uint64_t path_hash(const char *path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash | 1;
+}
+
+// آیا نوشتن فایلی با این مسیر هنوز در دسته یا صف workers است
+static bool pending_contains(unpack_context_t *ctx, const char *path) {
+    if (ctx->pending_count == 0) {
+        return false;
+    }
+    uint64_t hash = path_hash(path);
+    for (size_t i = hash & (ctx->pending_capacity - 1); ctx->pending[i]; i = (i + 1) & (ctx->pending_capacity - 1)) {
+        if (ctx->pending[i] == hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ثبت مسیر فایل سپرده‌شده به workers؛ جدول با ضریب بار 0.5 دو برابر می‌شود
+static int pending_add(unpack_context_t *ctx, const char *path) {
+    if ((ctx->pending_count + 1) * 2 > ctx->pending_capacity) {
+        size_t capacity = ctx->pending_capacity ? ctx->pending_capacity * 2 : 1024;
+        uint64_t *table = calloc(capacity, sizeof(uint64_t));
+        if (!table) {
+            return -1;
+        }
+        for (size_t i = 0; i < ctx->pending_capacity; i++) {
+            if (ctx->pending[i]) {
+                size_t j = ctx->pending[i] & (capacity - 1);
+                while (table[j]) j = (j + 1) & (capacity - 1);
+                table[j] = ctx->pending[i];
+            }
+        }
+        free(ctx->pending);
+        ctx->pending = table;
+        ctx->pending_capacity = capacity;
+    }
+
+    uint64_t hash = path_hash(path);
+    size_t i = hash & (ctx->pending_capacity - 1);
+    while (ctx->pending[i] && ctx->pending[i] != hash) {
+        i = (i + 1) & (ctx->pending_capacity - 1);
+    }
+    if (!ctx->pending[i]) {
+        ctx->pending[i] = hash;
+        ctx->pending_count++;
+    }
+    return 0;
+}
+
+// ورودی بعدی آرشیو با همان مسیر جایگزین ورودی قبلی می‌شود؛ پیش از ساختن آن همه نوشتن‌های در
+// انتظار تمام می‌شوند تا create و unlink تأخیری worker ورودی جدیدتر را پاک نکند
+static void drain_pending(unpack_context_t *ctx, threadpool_t *pool, const char *path) {
+    if (!pending_contains(ctx, path)) {
+        return;
+    }
+    flush_batch(ctx, pool);
+    threadpool_wait(pool);
+    memset(ctx->pending, 0, ctx->pending_capacity * sizeof(uint64_t));
+    ctx->pending_count = 0;
+}
+
+// افزودن فایل به دسته؛ دسته با تغییر دایرکتوری یا پر شدن ارسال می‌شود
+static int queue_file(unpack_context_t *ctx, threadpool_t *pool, const unpack_file_t *file) {
+    const char *slash = strrchr(file->path, '/');
+    size_t parent_length = slash ? (size_t)(slash - file->path) : 0;
+
+    unpack_job_t *job = ctx->batch;
+    if (job && (job->count == UNPACK_BATCH_FILES || job->bytes >= UNPACK_BATCH_BYTES ||
+                job->parent_length != parent_length ||
+                strncmp(job->files[0].path, file->path, parent_length) != 0)) {
+        flush_batch(ctx, pool);
+        job = NULL;
+    }
+
+    if (!job) {
+        job = malloc(sizeof(unpack_job_t));
+        if (!job) {
+            return -1;
+        }
+        job->ctx = ctx;
+        job->count = 0;
+        job->bytes = 0;
+        job->parent_length = parent_length;
+        ctx->batch = job;
+    }
+
+    if (pending_add(ctx, file->path) != 0) {
+        return -1;
+    }
+    job->files[job->count++] = *file;
+    job->bytes += file->data ? file->size : UNPACK_BATCH_BYTES;
+    return 0;
+}
+
+// افزودن عنصر به آرایه پویا
+static void* array_append(void *array, size_t *count, size_t *capacity, size_t element_size) {
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 64;
+        void *grown = realloc(array, new_capacity * element_size);
+        if (!grown) {
+            return NULL;
+        }
+        array = grown;
+        *capacity = new_capacity;
+    }
+    (*count)++;
+    return array;
+}
+
+// ---------- پردازش ورودی‌ها ----------
+
+// ایجاد whiteout معادل overlayfs برای ".wh.<نام>" یا دایرکتوری opaque
+static int unpack_whiteout(unpack_context_t *ctx, tar_entry_t *entry, const char *base) {
+    const char *name;
+    int parent = open_parent(ctx, entry->path, &name);
+    if (parent == -1) {
+        return -1;
+    }
+
+    int result;
+    if (strcmp(base, WHITEOUT_OPAQUE) == 0) {
+        int dir_fd = openat(parent, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        result = dir_fd != -1 ? fsetxattr(dir_fd, "trusted.overlay.opaque", "y", 1, 0) : -1;
+        if (dir_fd != -1) close(dir_fd);
+    } else {
+        const char *target = base + strlen(WHITEOUT_PREFIX);
+        unlinkat(parent, target, 0);
+        result = mknodat(parent, target, S_IFCHR | 0000, makedev(0, 0));
+    }
+    close(parent);
+
+    if (result == 0) {
+        ctx->stats.whiteouts++;
+    }
+    return result;
+}
+
+// پردازش یک ورودی (داده آن هنوز در جریان است)
+static int unpack_entry(unpack_context_t *ctx, tar_reader_t *reader, threadpool_t *pool, tar_entry_t *entry) {
+    uint64_t padded = (entry->size + TAR_BLOCK_SIZE - 1) & ~(uint64_t)(TAR_BLOCK_SIZE - 1);
+    int sanitized = sanitize_path(entry->path);
+    if (sanitized < 0) {
+        return -1;
+    }
+    if (sanitized > 0 && entry->type != '5') {
+        return reader_skip(reader, padded);
+    }
+    if (sanitized > 0) {
+        strcpy(entry->path, ".");  // ورودی خود ریشه فقط مشخصاتش اعمال می‌شود
+    } else if (ensure_parents(ctx, entry->path) != 0) {
+        return -1;
+    }
+
+    const char *base = strrchr(entry->path, '/');
+    base = base ? base + 1 : entry->path;
+    bool whiteout = ctx->options.convert_whiteouts && strncmp(base, WHITEOUT_PREFIX, strlen(WHITEOUT_PREFIX)) == 0;
+    if (whiteout && strcmp(base, WHITEOUT_OPAQUE) != 0) {
+        // whiteout فایل هم‌نام در همین آرشیو را حذف می‌کند
+        char target[PATH_MAX];
+        snprintf(target, sizeof(target), "%.*s%s", (int)(base - entry->path), entry->path,
+                 base + strlen(WHITEOUT_PREFIX));
+        drain_pending(ctx, pool, target);
+    } else if (!whiteout) {
+        drain_pending(ctx, pool, entry->path);
+    }
+
+    if (whiteout) {
+        if (unpack_whiteout(ctx, entry, base) != 0) {
+            log_error("خطا در ایجاد whiteout برای %s", entry->path);
+            return -1;
+        }
+        return reader_skip(reader, padded);
+    }
+
+    switch (entry->type) {
+        case '0':
+        case '\0':
+        case '7': {
+            ctx->stats.files++;
+            ctx->stats.bytes += entry->size;
+
+            unpack_file_t file = {
+                .mode = entry->mode, .uid = entry->uid, .gid = entry->gid,
+                .mtime = entry->mtime, .size = entry->size,
+            };
+
+            if (entry->size <= UNPACK_SMALL_FILE_MAX) {
+                file.data = malloc(entry->size ? entry->size : 1);
+                if (!file.data || reader_read(reader, file.data, entry->size) != 0 ||
+                    reader_skip(reader, padded - entry->size) != 0 ||
+                    !(file.path = strdup(entry->path)) || queue_file(ctx, pool, &file) != 0) {
+                    free(file.data);
+                    free(file.path);
+                    return -1;
+                }
+                return 0;
+            }
+
+            if (reader->seekable) {
+                // worker مستقیماً از آرشیو کپی می‌کند و خواننده فقط از داده رد می‌شود
+                file.source_fd = reader->fd;
+                file.source_offset = reader_position(reader);
+                if (reader_skip(reader, padded) != 0 || !(file.path = strdup(entry->path)) ||
+                    queue_file(ctx, pool, &file) != 0) {
+                    free(file.path);
+                    return -1;
+                }
+                return 0;
+            }
+
+            // فایل بزرگ از جریان فشرده: انتقال با splice در همین thread
+            const char *name;
+            bool anonymous;
+            int result = -1;
+            int parent = open_parent(ctx, entry->path, &name);
+            if (parent != -1) {
+                int fd = create_regular_file(parent, name, entry->size, entry->mode, &anonymous);
+                if (fd != -1) {
+                    result = reader_splice(reader, fd, entry->size);
+                    if (result == 0) {
+                        result = finish_regular_file(ctx, fd, parent, name, anonymous,
+                                                     entry->mode, entry->uid, entry->gid, &entry->mtime);
+                    }
+                    close(fd);
+                }
+                close(parent);
+            }
+            if (result != 0) {
+                log_error("خطا در نوشتن فایل %s", entry->path);
+                return -1;
+            }
+            return reader_skip(reader, padded - entry->size);
+        }
+
+        case '5': {
+            const char *name;
+            int parent = open_parent(ctx, entry->path, &name);
+            if (parent == -1) {
+                return -1;
+            }
+            // تا پایان قابل نوشتن می‌ماند؛ مجوز و زمان نهایی در پایان اعمال می‌شود
+            if (sanitized == 0 && mkdirat(parent, name, 0700) != 0 && errno == EEXIST) {
+                struct stat st;
+                if (fstatat(parent, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && !S_ISDIR(st.st_mode)) {
+                    unlinkat(parent, name, 0);
+                    mkdirat(parent, name, 0700);
+                }
+            }
+            close(parent);
+            if (sanitized == 0) {
+                ctx->stats.directories++;
+            }
+
+            deferred_dir_t *dirs = array_append(ctx->dirs, &ctx->dir_count, &ctx->dir_capacity,
+                                                sizeof(deferred_dir_t));
+            if (!dirs) {
+                return -1;
+            }
+            ctx->dirs = dirs;
+            deferred_dir_t *dir = &dirs[ctx->dir_count - 1];
+            dir->path = strdup(entry->path);
+            dir->mode = entry->mode;
+            dir->uid = entry->uid;
+            dir->gid = entry->gid;
+            dir->mtime = entry->mtime;
+            return reader_skip(reader, padded);
+        }
+
+        case '2': {
+            ctx->stats.symlinks++;
+            const char *name;
+            int parent = open_parent(ctx, entry->path, &name);
+            if (parent == -1) {
+                return -1;
+            }
+            unlinkat(parent, name, 0);
+            int result = symlinkat(entry->linkname, parent, name);
+            if (result == 0) {
+                apply_entry_metadata(ctx, parent, name, entry->uid, entry->gid, &entry->mtime);
+            }
+            close(parent);
+            return result == 0 ? reader_skip(reader, padded) : -1;
+        }
+
+        case '1': {
+            // هدف ممکن است هنوز در صف workers باشد؛ پس از اتمام همه نوشتن‌ها ساخته می‌شود
+            ctx->stats.hardlinks++;
+            char target[PATH_MAX];
+            strcpy(target, entry->linkname);
+            if (sanitize_path(target) != 0) {
+                return -1;
+            }
+            deferred_link_t *links = array_append(ctx->links, &ctx->link_count, &ctx->link_capacity,
+                                                  sizeof(deferred_link_t));
+            if (!links) {
+                return -1;
+            }
+            ctx->links = links;
+            links[ctx->link_count - 1].path = strdup(entry->path);
+            links[ctx->link_count - 1].target = strdup(target);
+            return reader_skip(reader, padded);
+        }
+
+        case '3':
+        case '4':
+        case '6': {
+            const char *name;
+            int parent = open_parent(ctx, entry->path, &name);
+            if (parent == -1) {
+                return -1;
+            }
+            mode_t type = entry->type == '3' ? S_IFCHR : entry->type == '4' ? S_IFBLK : S_IFIFO;
+            unlinkat(parent, name, 0);
+            int result = mknodat(parent, name, type | (entry->mode & 07777), entry->device);
+            if (result == 0) {
+                fchmodat(parent, name, entry->mode & 07777, 0);
+                apply_entry_metadata(ctx, parent, name, entry->uid, entry->gid, &entry->mtime);
+            }
+            close(parent);
+            return result == 0 ? reader_skip(reader, padded) : -1;
+        }
+
+        default:
+            log_debug("ورودی tar با نوع '%c' نادیده گرفته شد: %s", entry->type, entry->path);
+            return reader_skip(reader, padded);
+    }
+}
+
+// ساخت hardlink ها و اعمال مشخصات دایرکتوری‌ها پس از پایان نوشتن فایل‌ها
+static int unpack_finish(unpack_context_t *ctx) {
+    int result = 0;
+
+    for (size_t i = 0; i < ctx->link_count; i++) {
+        const char *name, *target_name;
+        int parent = open_parent(ctx, ctx->links[i].path, &name);
+        int target_parent = open_parent(ctx, ctx->links[i].target, &target_name);
+        if (parent != -1 && target_parent != -1) {
+            unlinkat(parent, name, 0);
+        }
+        if (parent == -1 || target_parent == -1 || linkat(target_parent, target_name, parent, name, 0) != 0) {
+            log_error("خطا در ایجاد hardlink %s", ctx->links[i].path);
+            result = -1;
+        }
+        if (parent != -1) close(parent);
+        if (target_parent != -1) close(target_parent);
+    }
+
+    // ایجاد هر فرزند زمان دایرکتوری را تغییر می‌دهد، پس زمان‌ها در پایان اعمال می‌شوند
+    for (size_t i = 0; i < ctx->dir_count; i++) {
+        deferred_dir_t *dir = &ctx->dirs[i];
+        const char *name;
+        int parent = open_parent(ctx, dir->path, &name);
+        if (parent == -1) {
+            continue;
+        }
+        if (ctx->options.preserve_owner) {
+            fchownat(parent, name, dir->uid, dir->gid, AT_SYMLINK_NOFOLLOW);
+        }
+        fchmodat(parent, name, dir->mode & 07777, 0);
+        struct timespec times[2] = { dir->mtime, dir->mtime };
+        utimensat(parent, name, times, AT_SYMLINK_NOFOLLOW);
+        close(parent);
+    }
+
+    return result;
+}
+
+// حلقه اصلی: خواندن سرآیندها و توزیع ورودی‌ها
+static int unpack_stream(unpack_context_t *ctx, tar_reader_t *reader, threadpool_t *pool) {
+    tar_override_t override;
+    memset(&override, 0, sizeof(override));
+    tar_entry_t *entry = malloc(sizeof(tar_entry_t));
+    if (!entry) {
+        return -1;
+    }
+
+    int result = 0;
+    int zero_blocks = 0;
+    tar_header_t header;
+
+    while (result == 0 && !unpack_failed(ctx)) {
+        ssize_t available = reader->end - reader->start;
+        if (available == 0 && (available = reader_fill(reader)) <= 0) {
+            // برخی ابزارها بلوک‌های صفر پایانی را نمی‌نویسند
+            result = available == 0 ? 0 : -1;
+            break;
+        }
+        if (reader_read(reader, &header, sizeof(header)) != 0) {
+            result = -1;
+            break;
+        }
+
+        if (block_is_zero((const char *)&header)) {
+            if (++zero_blocks == 2) break;
+            continue;
+        }
+        zero_blocks = 0;
+
+        if (!header_checksum_valid(&header)) {
+            log_error("checksum سرآیند tar نامعتبر است");
+            result = -1;
+            break;
+        }
+
+        uint64_t size = parse_number(header.size, sizeof(header.size));
+
+        // سرآیندهای توسعه‌یافته روی ورودی بعدی اعمال می‌شوند
+        if (header.typeflag == 'x' || header.typeflag == 'g' ||
+            header.typeflag == 'L' || header.typeflag == 'K') {
+            char *data = read_meta_data(reader, size);
+            if (!data) {
+                result = -1;
+                break;
+            }
+            if (header.typeflag == 'x') {
+                parse_pax(data, size, &override);
+            } else if (header.typeflag == 'L') {
+                free(override.path);
+                override.path = data;
+                data = NULL;
+            } else if (header.typeflag == 'K') {
+                free(override.linkname);
+                override.linkname = data;
+                data = NULL;
+            }
+            free(data);
+            continue;
+        }
+
+        memset(entry, 0, offsetof(tar_entry_t, type));
+        if (override.path) {
+            copy_field(entry->path, sizeof(entry->path), override.path, strlen(override.path));
+        } else if (header.prefix[0] && memcmp(header.magic, "ustar", 5) == 0) {
+            char prefix[sizeof(header.prefix) + 1], name[sizeof(header.name) + 1];
+            copy_field(prefix, sizeof(prefix), header.prefix, sizeof(header.prefix));
+            copy_field(name, sizeof(name), header.name, sizeof(header.name));
+            snprintf(entry->path, sizeof(entry->path), "%s/%s", prefix, name);
+        } else {
+            copy_field(entry->path, sizeof(entry->path), header.name, sizeof(header.name));
+        }
+        if (override.linkname) {
+            copy_field(entry->linkname, sizeof(entry->linkname), override.linkname, strlen(override.linkname));
+        } else {
+            copy_field(entry->linkname, sizeof(entry->linkname), header.linkname, sizeof(header.linkname));
+        }
+
+        entry->type = header.typeflag;
+        entry->mode = parse_number(header.mode, sizeof(header.mode));
+        entry->uid = override.has_uid ? override.uid : parse_number(header.uid, sizeof(header.uid));
+        entry->gid = override.has_gid ? override.gid : parse_number(header.gid, sizeof(header.gid));
+        entry->size = override.has_size ? override.size : size;
+        if (override.has_mtime) {
+            entry->mtime = override.mtime;
+        } else {
+            entry->mtime.tv_sec = parse_number(header.mtime, sizeof(header.mtime));
+            entry->mtime.tv_nsec = 0;
+        }
+        entry->device = makedev(parse_number(header.devmajor, sizeof(header.devmajor)),
+                                parse_number(header.devminor, sizeof(header.devminor)));
+
+        // ورودی‌های بدون داده صرف نظر از فیلد size
+        if (entry->type == '1' || entry->type == '2' || entry->type == '5' ||
+            entry->type == '3' || entry->type == '4' || entry->type == '6') {
+            entry->size = entry->type == '5' ? entry->size : 0;
+        }
+
+        override_reset(&override);
+        result = unpack_entry(ctx, reader, pool, entry);
+    }
+
+    override_reset(&override);
+    free(entry);
+    flush_batch(ctx, pool);
+    return result;
+}
+
+// ---------- فشرده‌سازی ----------
+
+// تشخیص فرمت فشرده‌سازی از بایت‌های ابتدایی
+static const char* detect_decompressor(int fd) {
+    unsigned char magic[6] = { 0 };
+    if (pread(fd, magic, sizeof(magic), 0) < (ssize_t)sizeof(magic)) {
+        return NULL;
+    }
+    if (magic[0] == 0x1f && magic[1] == 0x8b) return "gzip";
+    if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) return "zstd";
+    if (memcmp(magic, "\xfd" "7zXZ", 5) == 0) return "xz";
+    if (memcmp(magic, "BZh", 3) == 0) return "bzip2";
+    return NULL;
+}
+
+// اجرای بازکننده در فرآیند جدا تا فشرده‌سازی و نوشتن فایل‌ها روی هسته‌های مختلف همزمان انجام شوند
+static pid_t start_decompressor(const char *program, int input_fd, int *output_fd) {
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+        log_error("خطا در ایجاد pipe برای بازکننده");
+        return -1;
+    }
+    fcntl(pipe_fds[1], F_SETPIPE_SZ, UNPACK_PIPE_SIZE);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        log_error("خطا در ایجاد فرآیند بازکننده");
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        lseek(input_fd, 0, SEEK_SET);
+        dup2(input_fd, STDIN_FILENO);
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        // نسخه چندنخی gzip در صورت وجود
+        if (strcmp(program, "gzip") == 0) {
+            execlp("pigz", "pigz", "-dc", (char *)NULL);
+        }
+        execlp(program, program, "-dc", (char *)NULL);
+        _exit(127);
+    }
+
+    close(pipe_fds[1]);
+    *output_fd = pipe_fds[0];
+    return pid;
+}
+
+// ---------- بررسی digest ----------
+
+// هش آرشیو در thread جدا همزمان با باز کردن آن؛ pread موقعیت فایل خواننده را تغییر نمی‌دهد
+typedef struct {
+    pthread_t thread;
+    int fd;
+    int result;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+} archive_hasher_t;
+
+static void* archive_hasher_main(void *arg) {
+    archive_hasher_t *hasher = arg;
+    hasher->result = -1;
+
+    uint8_t *buffer = malloc(UNPACK_READ_BUFFER);
+    if (!buffer) {
+        return NULL;
+    }
+
+    sha256_ctx_t sha;
+    sha256_init(&sha);
+    off_t offset = 0;
+    ssize_t n;
+    while ((n = pread(hasher->fd, buffer, UNPACK_READ_BUFFER, offset)) > 0) {
+        sha256_update(&sha, buffer, n);
+        offset += n;
+    }
+    free(buffer);
+
+    if (n == 0) {
+        sha256_final(&sha, hasher->digest);
+        hasher->result = 0;
+    }
+    return NULL;
+}
+
+// مقایسه digest محاسبه‌شده با مقدار مورد انتظار
+static int archive_hasher_finish(archive_hasher_t *hasher, const char *archive_path, const uint8_t *expected) {
+    pthread_join(hasher->thread, NULL);
+    if (hasher->result != 0) {
+        log_error("خطا در خواندن آرشیو برای محاسبه digest: %s", archive_path);
+        return -1;
+    }
+    if (memcmp(hasher->digest, expected, SHA256_DIGEST_SIZE) != 0) {
+        char actual[DIGEST_STRING_MAX];
+        digest_format(hasher->digest, actual, sizeof(actual));
+        log_error("digest آرشیو %s مطابقت ندارد (%s)", archive_path, actual);
+        return -1;
+    }
+    return 0;
+}
+
+// باز کردن جریانی آرشیو tar در destination
+int unpack_tar(const char *archive_path, const char *destination,
+               const unpack_options_t *options, unpack_stats_t *stats) {
+    int archive_fd = open(archive_path, O_RDONLY | O_CLOEXEC);
+    if (archive_fd == -1) {
+        log_error("آرشیو یافت نشد: %s", archive_path);
+        return -1;
+    }
+
+    unpack_context_t *ctx = calloc(1, sizeof(unpack_context_t));
+    tar_reader_t reader = { .fd = archive_fd };
+    reader.buffer = malloc(UNPACK_READ_BUFFER);
+    if (!ctx || !reader.buffer) {
+        free(ctx);
+        free(reader.buffer);
+        close(archive_fd);
+        return -1;
+    }
+
+    if (options) {
+        ctx->options = *options;
+    } else {
+        unpack_default_options(&ctx->options);
+    }
+    ctx->use_openat2 = true;
+    ctx->umask = umask(022);
+    umask(ctx->umask);
+    ctx->owner_uid = geteuid();
+    ctx->owner_gid = getegid();
+    ctx->root_fd = open(destination, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (ctx->root_fd == -1) {
+        log_error("دایرکتوری مقصد یافت نشد: %s", destination);
+        free(reader.buffer);
+        free(ctx);
+        close(archive_fd);
+        return -1;
+    }
+
+    uint8_t expected_digest[SHA256_DIGEST_SIZE];
+    archive_hasher_t hasher = { .fd = archive_fd };
+    bool verify = ctx->options.expected_digest != NULL;
+    if (verify) {
+        if (digest_parse(ctx->options.expected_digest, expected_digest) != 0) {
+            log_error("digest نامعتبر برای بررسی آرشیو: %s", ctx->options.expected_digest);
+            verify = false;
+            reader.fd = -1;
+        } else if (pthread_create(&hasher.thread, NULL, archive_hasher_main, &hasher) != 0) {
+            log_error("خطا در ایجاد thread محاسبه digest");
+            verify = false;
+            reader.fd = -1;
+        }
+    }
+
+    pid_t decompressor = -1;
+    const char *program = reader.fd != -1 ? detect_decompressor(archive_fd) : NULL;
+    if (program) {
+        decompressor = start_decompressor(program, archive_fd, &reader.fd);
+        if (decompressor == -1) {
+            reader.fd = -1;
+        }
+    } else {
+        struct stat st;
+        reader.seekable = fstat(archive_fd, &st) == 0 && S_ISREG(st.st_mode);
+    }
+
+    int result = -1;
+    threadpool_t *pool = reader.fd != -1 ? threadpool_create(ctx->options.threads, UNPACK_QUEUE_CAPACITY) : NULL;
+    if (pool) {
+        uint64_t start = monotonic_time_ns();
+        result = unpack_stream(ctx, &reader, pool);
+
+        // پیش از ساخت hardlink ها و بستن آرشیو، همه نوشتن‌ها باید تمام شده باشند
+        threadpool_wait(pool);
+        threadpool_destroy(pool);
+        if (unpack_failed(ctx)) {
+            result = -1;
+        }
+        if (result == 0) {
+            result = unpack_finish(ctx);
+        }
+
+        double seconds = (monotonic_time_ns() - start) / 1e9;
+        log_debug("باز کردن %s: %lu فایل، %.1f MB در %.2f ثانیه", archive_path,
+                  ctx->stats.files, ctx->stats.bytes / (1024.0 * 1024.0), seconds);
+    }
+
+    if (decompressor > 0) {
+        close(reader.fd);
+        int status;
+        waitpid(decompressor, &status, 0);
+        if (result == 0 && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+            log_error("بازکننده %s با خطا خاتمه یافت", program);
+            result = -1;
+        }
+    }
+
+    // نتیجه فقط وقتی معتبر است که digest کل آرشیو با مقدار مورد انتظار مطابقت داشته باشد
+    if (verify && archive_hasher_finish(&hasher, archive_path, expected_digest) != 0) {
+        result = -1;
+    }
+
+    if (stats) {
+        *stats = ctx->stats;
+    }
+
+    for (size_t i = 0; i < ctx->dir_count; i++) {
+        free(ctx->dirs[i].path);
+    }
+    for (size_t i = 0; i < ctx->link_count; i++) {
+        free(ctx->links[i].path);
+        free(ctx->links[i].target);
+    }
+    free(ctx->dirs);
+    free(ctx->links);
+    free(ctx->pending);
+    close(ctx->root_fd);
+    free(ctx);
+    free(reader.buffer);
+    close(archive_fd);
+
+    return result;
+}
@@ -8,7 +8,13 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
 #include <dirent.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include "../include/utils.h"
 
 // تولید شناسه منحصر به فرد
@@ -75,39 +81,68 @@ int create_directory(const char *path, int mode) {
     return 0;
 }
 
-// حذف دایرکتوری
-int remove_directory(const char *path) {
-    DIR *dir;
-    struct dirent *entry;
-    char file_path[512];
-    
-    // باز کردن دایرکتوری
-    dir = opendir(path);
+// حذف بازگشتی name زیر dir_fd؛ مسیرها نسبی هستند و طول مسیر محدودیتی ندارد
+int remove_directory_at(int dir_fd, const char *name, void (*on_remove)(void *arg), void *arg) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        // پیوند نمادین یا فایل معمولی به جای دایرکتوری
+        return errno == ENOTDIR || errno == ELOOP ? unlinkat(dir_fd, name, 0) : -1;
+    }
+    DIR *dir = fdopendir(fd);
     if (!dir) {
+        close(fd);
         return -1;
     }
     
-    // حذف همه فایل‌ها و زیر دایرکتوری‌ها
+    // حذف همه فایل‌ها و زیر دایرکتوری‌ها؛ خطای هر ورودی در نتیجه rmdir نهایی دیده می‌شود
+    // (فایل‌های مجازی cgroupfs حذف نمی‌شوند ولی مانع rmdir هم نیستند)
+    struct dirent *entry;
     while ((entry = readdir(dir)) != NULL) {
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
             continue;
         }
         
-        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        bool is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+        }
         
-        if (entry->d_type == DT_DIR) {
+        if (is_dir) {
             // بازگشتی حذف زیر دایرکتوری
-            remove_directory(file_path);
-        } else {
-            // حذف فایل
-            unlink(file_path);
+            remove_directory_at(fd, entry->d_name, on_remove, arg);
+        } else if (unlinkat(fd, entry->d_name, 0) == 0 && on_remove) {
+            on_remove(arg);
         }
     }
     
     closedir(dir);
     
     // حذف دایرکتوری خالی
-    return rmdir(path);
+    if (unlinkat(dir_fd, name, AT_REMOVEDIR) != 0) {
+        return -1;
+    }
+    if (on_remove) {
+        on_remove(arg);
+    }
+    return 0;
+}
+
+// حذف دایرکتوری
+int remove_directory(const char *path) {
+    return remove_directory_at(AT_FDCWD, path, NULL, NULL);
+}
+
+// سطح فعلی لاگ؛ نسخه debug به طور پیش‌فرض پیام‌های مسیر داغ را هم چاپ می‌کند
+#ifdef DEBUG
+int log_level = LOG_LEVEL_DEBUG;
+#else
+int log_level = LOG_LEVEL_INFO;
+#endif
+
+// تنظیم سطح لاگ
+void log_set_level(log_level_t level) {
+    log_level = level;
 }
 
 // ثبت لاگ
@@ -129,6 +164,25 @@ void log_message(const char *format, ...) {
     va_end(args);
 }
 
+// ثبت لاگ جزئیات؛ فقط از طریق ماکرو log_debug و در سطح DEBUG فراخوانی می‌شود
+void log_debug_message(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    
+    // تاریخ و زمان فعلی
+    time_t now = time(NULL);
+    struct tm *tm_info = localtime(&now);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "[%Y-%m-%d %H:%M:%S]", tm_info);
+    
+    // چاپ لاگ با تاریخ و زمان
+    printf("%s DEBUG: ", timestamp);
+    vprintf(format, args);
+    printf("\n");
+    
+    va_end(args);
+}
+
 // ثبت خطا
 void log_error(const char *format, ...) {
     va_list args;
@@ -153,51 +207,175 @@ bool has_root_privileges() {
     return (geteuid() == 0);
 }
 
+// اندازه بافر کپی در روش نهایی
+#define COPY_BUFFER_SIZE (1024 * 1024)
+
+// بیشترین طول یک فراخوانی sendfile
+#define COPY_SENDFILE_MAX 0x7ffff000
+
+// روش‌های کپی داده به ترتیب اولویت؛ در صورت پشتیبانی نشدن به روش بعدی تنزل می‌کند
+enum {
+    COPY_METHOD_RANGE,          // copy_file_range: کپی درون هسته، روی برخی فایل‌سیستم‌ها بدون جابه‌جایی داده
+    COPY_METHOD_SENDFILE,       // sendfile: کپی درون هسته از طریق page cache
+    COPY_METHOD_BUFFER          // pread/pwrite با بافر بزرگ
+};
+
+// کپی یک تکه با pread/pwrite
+static ssize_t copy_buffered(int source_fd, int dest_fd, off_t offset, off_t length) {
+    char stack_buffer[64 * 1024];
+    char *buffer = stack_buffer;
+    size_t buffer_size = sizeof(stack_buffer);
+    if (length > (off_t)sizeof(stack_buffer)) {
+        buffer = malloc(COPY_BUFFER_SIZE);
+        buffer_size = COPY_BUFFER_SIZE;
+        if (!buffer) {
+            buffer = stack_buffer;
+            buffer_size = sizeof(stack_buffer);
+        }
+    }
+
+    ssize_t total = 0;
+    while (total < length) {
+        size_t chunk = (size_t)(length - total) < buffer_size ? (size_t)(length - total) : buffer_size;
+        ssize_t n = pread(source_fd, buffer, chunk, offset + total);
+        if (n <= 0) {
+            if (n < 0 && total == 0) total = -1;
+            break;
+        }
+        for (ssize_t written = 0; written < n; ) {
+            ssize_t w = pwrite(dest_fd, buffer + written, n - written, offset + total + written);
+            if (w <= 0) {
+                if (buffer != stack_buffer) free(buffer);
+                return -1;
+            }
+            written += w;
+        }
+        total += n;
+    }
+
+    if (buffer != stack_buffer) free(buffer);
+    return total;
+}
+
+// کپی بازه [offset, offset + length) با بهترین روش در دسترس
+static int copy_range(int source_fd, int dest_fd, off_t offset, off_t length, int *method) {
+    while (length > 0) {
+        ssize_t n;
+        if (*method == COPY_METHOD_RANGE) {
+            loff_t source_offset = offset, dest_offset = offset;
+            n = copy_file_range(source_fd, &source_offset, dest_fd, &dest_offset, length, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL)) {
+                *method = COPY_METHOD_SENDFILE;
+                continue;
+            }
+        } else if (*method == COPY_METHOD_SENDFILE) {
+            off_t source_offset = offset;
+            if (lseek(dest_fd, offset, SEEK_SET) != offset) {
+                return -1;
+            }
+            n = sendfile(dest_fd, source_fd, &source_offset, length < COPY_SENDFILE_MAX ? length : COPY_SENDFILE_MAX);
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                *method = COPY_METHOD_BUFFER;
+                continue;
+            }
+        } else {
+            n = copy_buffered(source_fd, dest_fd, offset, length);
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            break;  // فایل منبع در حین کپی کوتاه شده است
+        }
+        offset += n;
+        length -= n;
+    }
+    return 0;
+}
+
+// کپی داده و مشخصات یک فایل باز به فایل مقصد خالی
+int copy_file_fd(int source_fd, int dest_fd) {
+    struct stat st;
+    if (fstat(source_fd, &st) != 0) {
+        return -1;
+    }
+
+    // reflink: بلوک‌ها بین دو فایل به اشتراک گذاشته می‌شوند و داده‌ای جابه‌جا نمی‌شود
+    if (st.st_size > 0 && ioctl(dest_fd, FICLONE, source_fd) != 0) {
+        int method = COPY_METHOD_RANGE;
+        int result = 0;
+
+        if ((off_t)st.st_blocks * 512 >= st.st_size) {
+            result = copy_range(source_fd, dest_fd, 0, st.st_size, &method);
+        } else {
+            // فایل حفره‌دار: فقط بخش‌های دارای داده کپی می‌شوند
+            off_t data = 0;
+            while (result == 0 && data < st.st_size) {
+                data = lseek(source_fd, data, SEEK_DATA);
+                if (data < 0) {
+                    if (errno != ENXIO) {
+                        result = copy_range(source_fd, dest_fd, 0, st.st_size, &method);
+                    }
+                    break;
+                }
+                off_t hole = lseek(source_fd, data, SEEK_HOLE);
+                if (hole < 0 || hole > st.st_size) {
+                    hole = st.st_size;
+                }
+                result = copy_range(source_fd, dest_fd, data, hole - data, &method);
+                data = hole;
+            }
+        }
+
+        // حفره انتهایی فایل با تنظیم طول ساخته می‌شود
+        if (result != 0 || ftruncate(dest_fd, st.st_size) != 0) {
+            return -1;
+        }
+    }
+
+    // مالکیت پیش از مجوزها، چون chown بیت‌های setuid را پاک می‌کند
+    if ((st.st_uid != geteuid() || st.st_gid != getegid()) && fchown(dest_fd, st.st_uid, st.st_gid) != 0) {
+        log_debug("خطا در تنظیم مالکیت فایل کپی‌شده");
+    }
+    if (fchmod(dest_fd, st.st_mode & 07777) != 0) {
+        return -1;
+    }
+    struct timespec times[2] = { st.st_atim, st.st_mtim };
+    futimens(dest_fd, times);
+    return 0;
+}
+
 // کپی فایل
 int copy_file(const char *source, const char *destination) {
-    int source_fd, dest_fd;
-    char buffer[4096];
-    ssize_t bytes_read, bytes_written;
-    
     // باز کردن فایل منبع
-    source_fd = open(source, O_RDONLY);
+    int source_fd = open(source, O_RDONLY | O_CLOEXEC);
     if (source_fd == -1) {
         log_error("خطا در باز کردن فایل منبع: %s", source);
         return -1;
     }
     
-    // ایجاد فایل مقصد
-    dest_fd = open(destination, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    // ایجاد فایل مقصد؛ مجوزهای نهایی پس از کپی اعمال می‌شوند
+    int dest_fd = open(destination, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
     if (dest_fd == -1) {
         log_error("خطا در ایجاد فایل مقصد: %s", destination);
         close(source_fd);
         return -1;
     }
     
-    // کپی داده‌ها
-    while ((bytes_read = read(source_fd, buffer, sizeof(buffer))) > 0) {
-        bytes_written = write(dest_fd, buffer, bytes_read);
-        if (bytes_written != bytes_read) {
-            log_error("خطا در نوشتن به فایل مقصد");
-            close(source_fd);
-            close(dest_fd);
-            return -1;
-        }
-    }
-    
-    // بررسی خطای خواندن
-    if (bytes_read == -1) {
-        log_error("خطا در خواندن از فایل منبع");
-        close(source_fd);
-        close(dest_fd);
-        return -1;
+    int result = copy_file_fd(source_fd, dest_fd);
+    if (result != 0) {
+        log_error("خطا در کپی %s به %s", source, destination);
     }
     
     // بستن فایل‌ها
     close(source_fd);
-    close(dest_fd);
+    if (close(dest_fd) != 0) {
+        result = -1;
+    }
     
-    return 0;
+    return result;
 }
 
 // حذف فایل
@@ -208,4 +386,44 @@ int remove_file(const char *path) {
     }
     
     return 0;
-}
\ No newline at end of file
+}
+
+// زمان یکنواخت بر حسب نانوثانیه
+uint64_t monotonic_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// استراحت کوتاه پردازنده در حلقه‌های انتظار
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+// انتظار futex روی کلمه‌ای در حافظه مشترک بین فرآیندها
+int futex_wait_shared(uint32_t *address, uint32_t expected, int64_t timeout_ns) {
+    struct timespec timeout, *timeout_ptr = NULL;
+    if (timeout_ns >= 0) {
+        timeout.tv_sec = timeout_ns / 1000000000LL;
+        timeout.tv_nsec = timeout_ns % 1000000000LL;
+        timeout_ptr = &timeout;
+    }
+
+    if (syscall(SYS_futex, address, FUTEX_WAIT, expected, timeout_ptr, NULL, 0) == -1) {
+        // تغییر مقدار پیش از خوابیدن یا وقفه سیگنال، بیدار شدن عادی محسوب می‌شود
+        if (errno == EAGAIN || errno == EINTR) {
+            return 0;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+// بیدار کردن منتظران futex
+int futex_wake_shared(uint32_t *address, int count) {
+    return syscall(SYS_futex, address, FUTEX_WAKE, count, NULL, NULL, 0) == -1 ? -1 : 0;
+}
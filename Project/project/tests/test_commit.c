@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/xattr.h>
+#include <sys/sysmacros.h>
+#include "../include/commit.h"
+#include "../include/unpack.h"
+#include "../include/digest.h"
+#include "../include/utils.h"
+
+static void write_file(const char *path, const char *content) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd != -1 && write(fd, content, strlen(content)) == (ssize_t)strlen(content));
+    close(fd);
+}
+
+static void read_file(const char *path, char *buffer, size_t size) {
+    int fd = open(path, O_RDONLY);
+    assert(fd != -1);
+    ssize_t n = read(fd, buffer, size - 1);
+    assert(n >= 0);
+    buffer[n] = '\0';
+    close(fd);
+}
+
+// باز کردن لایه commit‌شده در دایرکتوری تازه و بررسی digest آرشیو
+static void unpack_layer(const char *directory, const char *digest, const char *destination) {
+    char archive[512];
+    snprintf(archive, sizeof(archive), "%s/%s.tar", directory, digest + strlen("sha256:"));
+    uint8_t hash[SHA256_DIGEST_SIZE];
+    char actual[DIGEST_STRING_MAX];
+    assert(digest_file(archive, hash) == 0);
+    digest_format(hash, actual, sizeof(actual));
+    assert(strcmp(actual, digest) == 0);
+
+    remove_directory(destination);
+    assert(create_directory(destination, 0755) == 0);
+    assert(unpack_tar(archive, destination, NULL, NULL) == 0);
+}
+
+// تست commit کامل و سپس commit های افزایشی upperdir
+void test_commit_layer() {
+    printf("تست commit لایه قابل نوشتن...\n");
+
+    char directory[] = "/tmp/commit_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char upper[256], cache[256], out[256], path[512], buffer[256];
+    snprintf(upper, sizeof(upper), "%s/upper", directory);
+    snprintf(cache, sizeof(cache), "%s/%s", directory, COMMIT_CACHE_NAME);
+    snprintf(out, sizeof(out), "%s/out", directory);
+
+    // upper شبیه overlayfs: فایل‌ها، پیوند، whiteout و دایرکتوری opaque
+    snprintf(path, sizeof(path), "%s/etc/conf.d", upper);
+    assert(create_directory(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/etc/hostname", upper);
+    write_file(path, "box\n");
+    snprintf(path, sizeof(path), "%s/etc/conf.d/a", upper);
+    write_file(path, "a\n");
+    snprintf(path, sizeof(path), "%s/etc/conf.d/b", upper);
+    write_file(path, "b\n");
+    snprintf(path, sizeof(path), "%s/etc/link", upper);
+    assert(symlink("hostname", path) == 0);
+    snprintf(path, sizeof(path), "%s/etc/removed", upper);
+    assert(mknod(path, S_IFCHR | 0000, makedev(0, 0)) == 0);
+    snprintf(path, sizeof(path), "%s/var", upper);
+    assert(create_directory(path, 0700) == 0);
+    assert(setxattr(path, "trusted.overlay.opaque", "y", 1, 0) == 0);
+    snprintf(path, sizeof(path), "%s/var/data", upper);
+    write_file(path, "data\n");
+
+    char digest[DIGEST_STRING_MAX];
+    commit_stats_t stats;
+    assert(commit_layer(upper, cache, directory, 2, digest, sizeof(digest), &stats) == 0);
+    assert(stats.files == 4 && stats.symlinks == 1 && stats.whiteouts == 1 && stats.opaque == 1);
+    assert(stats.unchanged == 0 && stats.hashed == 4);
+
+    unpack_layer(directory, digest, out);
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/etc/hostname", out);
+    read_file(path, buffer, sizeof(buffer));
+    assert(strcmp(buffer, "box\n") == 0);
+    snprintf(path, sizeof(path), "%s/etc/removed", out);
+    assert(lstat(path, &st) == 0 && S_ISCHR(st.st_mode) && st.st_rdev == makedev(0, 0));
+    snprintf(path, sizeof(path), "%s/var", out);
+    assert(stat(path, &st) == 0 && (st.st_mode & 07777) == 0700);
+    assert(getxattr(path, "trusted.overlay.opaque", buffer, sizeof(buffer)) == 1 && buffer[0] == 'y');
+
+    // بدون تغییر لایه‌ای ساخته نمی‌شود؛ بازنویسی با همان محتوا هم تغییر نیست
+    assert(commit_layer(upper, cache, directory, 2, digest, sizeof(digest), &stats) == 1);
+    assert(stats.unchanged == 4 && stats.hashed == 0);
+    snprintf(path, sizeof(path), "%s/etc/conf.d/a", upper);
+    write_file(path, "a\n");
+    assert(commit_layer(upper, cache, directory, 2, digest, sizeof(digest), &stats) == 1);
+    assert(stats.hashed == 1);
+
+    // تغییر یک فایل و حذف فایلی که فقط در upper بود
+    snprintf(path, sizeof(path), "%s/etc/conf.d/b", upper);
+    write_file(path, "b2\n");
+    snprintf(path, sizeof(path), "%s/etc/hostname", upper);
+    assert(unlink(path) == 0);
+    assert(commit_layer(upper, cache, directory, 2, digest, sizeof(digest), &stats) == 0);
+    assert(stats.files == 1 && stats.whiteouts == 1 && stats.unchanged == 2 && stats.opaque == 0);
+
+    unpack_layer(directory, digest, out);
+    snprintf(path, sizeof(path), "%s/etc/conf.d/b", out);
+    read_file(path, buffer, sizeof(buffer));
+    assert(strcmp(buffer, "b2\n") == 0);
+    snprintf(path, sizeof(path), "%s/etc/conf.d/a", out);
+    assert(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/etc/hostname", out);
+    assert(lstat(path, &st) == 0 && S_ISCHR(st.st_mode));
+    snprintf(path, sizeof(path), "%s/var/data", out);
+    assert(access(path, F_OK) != 0);
+
+    // زنجیره دو لایه در cache ثبت شده است
+    FILE *file = fopen(cache, "r");
+    assert(file != NULL);
+    int layers = 0;
+    while (fgets(path, sizeof(path), file)) {
+        layers += strncmp(path, "layer ", 6) == 0;
+    }
+    fclose(file);
+    assert(layers == 2);
+
+    remove_directory(directory);
+    printf("تست commit لایه قابل نوشتن با موفقیت انجام شد\n");
+}
+
+// تست نام‌های طولانی (سرآیند PAX)
+void test_commit_long_names() {
+    printf("تست commit نام‌های طولانی...\n");
+
+    char directory[] = "/tmp/commit_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char upper[256], cache[256], out[256], name[256], path[1024], buffer[64];
+    snprintf(upper, sizeof(upper), "%s/upper", directory);
+    snprintf(cache, sizeof(cache), "%s/%s", directory, COMMIT_CACHE_NAME);
+    snprintf(out, sizeof(out), "%s/out", directory);
+    memset(name, 'n', 200);
+    name[200] = '\0';
+
+    snprintf(path, sizeof(path), "%s/%s", upper, name);
+    assert(create_directory(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/%s/%s", upper, name, name);
+    write_file(path, "long\n");
+
+    char digest[DIGEST_STRING_MAX];
+    assert(commit_layer(upper, cache, directory, 1, digest, sizeof(digest), NULL) == 0);
+    unpack_layer(directory, digest, out);
+    snprintf(path, sizeof(path), "%s/%s/%s", out, name, name);
+    read_file(path, buffer, sizeof(buffer));
+    assert(strcmp(buffer, "long\n") == 0);
+
+    remove_directory(directory);
+    printf("تست commit نام‌های طولانی با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های commit...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون commit نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_commit_layer();
+    test_commit_long_names();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
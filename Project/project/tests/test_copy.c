@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/sysmacros.h>
+#include <sys/xattr.h>
+#include "../include/copy.h"
+#include "../include/utils.h"
+
+#define SPARSE_SIZE (64 * 1024 * 1024)
+
+// نوشتن یک فایل آزمایشی
+static void write_test_file(const char *path, const char *content, mode_t mode) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    assert(fd != -1);
+    assert(write(fd, content, strlen(content)) == (ssize_t)strlen(content));
+    close(fd);
+    assert(chmod(path, mode) == 0);
+}
+
+// مقایسه محتوای دو فایل
+static void assert_same_content(const char *path1, const char *path2) {
+    char buffer1[4096], buffer2[4096];
+    int fd1 = open(path1, O_RDONLY);
+    int fd2 = open(path2, O_RDONLY);
+    assert(fd1 != -1 && fd2 != -1);
+    for (;;) {
+        ssize_t n1 = read(fd1, buffer1, sizeof(buffer1));
+        ssize_t n2 = read(fd2, buffer2, sizeof(buffer2));
+        assert(n1 == n2 && n1 >= 0);
+        if (n1 == 0) break;
+        assert(memcmp(buffer1, buffer2, n1) == 0);
+    }
+    close(fd1);
+    close(fd2);
+}
+
+// تست کپی یک فایل: محتوا، مجوز، زمان و حفره‌ها
+void test_copy_file() {
+    printf("تست کپی فایل...\n");
+
+    char directory[] = "/tmp/copy_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    char source[256], destination[256];
+    snprintf(source, sizeof(source), "%s/script", directory);
+    snprintf(destination, sizeof(destination), "%s/script.copy", directory);
+    write_test_file(source, "#!/bin/sh\necho hello\n", 0750);
+
+    struct timespec times[2] = { { 1000000000, 0 }, { 1200000000, 500 } };
+    assert(utimensat(AT_FDCWD, source, times, 0) == 0);
+
+    assert(copy_file(source, destination) == 0);
+    assert_same_content(source, destination);
+    struct stat st;
+    assert(stat(destination, &st) == 0);
+    assert((st.st_mode & 07777) == 0750);
+    assert(st.st_mtim.tv_sec == 1200000000 && st.st_mtim.tv_nsec == 500);
+
+    // فایل حفره‌دار: چند بلوک داده در ابتدا، میانه و یک حفره انتهایی
+    snprintf(source, sizeof(source), "%s/sparse", directory);
+    snprintf(destination, sizeof(destination), "%s/sparse.copy", directory);
+    int fd = open(source, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd != -1);
+    assert(pwrite(fd, "head", 4, 0) == 4);
+    assert(pwrite(fd, "middle", 6, SPARSE_SIZE / 2) == 6);
+    assert(ftruncate(fd, SPARSE_SIZE) == 0);
+    close(fd);
+
+    assert(copy_file(source, destination) == 0);
+    assert_same_content(source, destination);
+    assert(stat(destination, &st) == 0);
+    assert(st.st_size == SPARSE_SIZE);
+    assert(st.st_blocks * 512 < SPARSE_SIZE / 4);
+
+    assert(copy_file("/nonexistent/file", destination) == -1);
+
+    remove_directory(directory);
+    printf("تست کپی فایل با موفقیت انجام شد\n");
+}
+
+// تست کپی درخت: ساختار، پیوندها، مجوزها و زمان دایرکتوری‌ها
+void test_copy_tree() {
+    printf("تست کپی درخت...\n");
+
+    char directory[] = "/tmp/copy_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    char path[512], other[512];
+    snprintf(path, sizeof(path), "%s/src", directory);
+    assert(mkdir(path, 0755) == 0);
+    for (int d = 0; d < 5; d++) {
+        snprintf(path, sizeof(path), "%s/src/dir%d", directory, d);
+        assert(mkdir(path, 0755) == 0);
+        for (int f = 0; f < 100; f++) {
+            char content[64];
+            snprintf(content, sizeof(content), "file %d in dir %d\n", f, d);
+            snprintf(path, sizeof(path), "%s/src/dir%d/file%d", directory, d, f);
+            write_test_file(path, content, f % 2 ? 0600 : 0644);
+        }
+    }
+    snprintf(path, sizeof(path), "%s/src/dir0/file0", directory);
+    snprintf(other, sizeof(other), "%s/src/dir1/hardlink", directory);
+    assert(link(path, other) == 0);
+    snprintf(path, sizeof(path), "%s/src/link", directory);
+    assert(symlink("dir0/file0", path) == 0);
+    snprintf(path, sizeof(path), "%s/src/fifo", directory);
+    assert(mkfifo(path, 0640) == 0);
+
+    // دایرکتوری فقط‌خواندنی با زمان مشخص
+    snprintf(path, sizeof(path), "%s/src/dir4", directory);
+    struct timespec times[2] = { { 1100000000, 0 }, { 1100000000, 0 } };
+    assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+    assert(chmod(path, 0555) == 0);
+
+    char source[512], destination[512];
+    snprintf(source, sizeof(source), "%s/src", directory);
+    snprintf(destination, sizeof(destination), "%s/dst", directory);
+    copy_stats_t stats;
+    assert(copy_tree(source, destination, 4, &stats) == 0);
+    assert(stats.files == 500);
+    assert(stats.directories == 5);
+    assert(stats.hardlinks == 1);
+    assert(stats.symlinks == 1);
+    assert(stats.specials == 1);
+
+    struct stat st, st_link;
+    snprintf(path, sizeof(path), "%s/dst/dir3/file7", directory);
+    snprintf(other, sizeof(other), "%s/src/dir3/file7", directory);
+    assert_same_content(path, other);
+    assert(stat(path, &st) == 0 && (st.st_mode & 07777) == 0600);
+
+    snprintf(path, sizeof(path), "%s/dst/dir0/file0", directory);
+    snprintf(other, sizeof(other), "%s/dst/dir1/hardlink", directory);
+    assert(stat(path, &st) == 0 && stat(other, &st_link) == 0);
+    assert(st.st_ino == st_link.st_ino);
+
+    snprintf(path, sizeof(path), "%s/dst/link", directory);
+    char target[64];
+    ssize_t length = readlink(path, target, sizeof(target) - 1);
+    assert(length == 10 && memcmp(target, "dir0/file0", 10) == 0);
+
+    snprintf(path, sizeof(path), "%s/dst/fifo", directory);
+    assert(lstat(path, &st) == 0 && S_ISFIFO(st.st_mode));
+
+    snprintf(path, sizeof(path), "%s/dst/dir4", directory);
+    assert(stat(path, &st) == 0);
+    assert((st.st_mode & 07777) == 0555);
+    assert(st.st_mtim.tv_sec == 1100000000);
+
+    snprintf(path, sizeof(path), "%s/src/dir4", directory);
+    chmod(path, 0755);
+    snprintf(path, sizeof(path), "%s/dst/dir4", directory);
+    chmod(path, 0755);
+    remove_directory(directory);
+    printf("تست کپی درخت با موفقیت انجام شد\n");
+}
+
+// تست ادغام لایه overlay: جایگزینی، whiteout و دایرکتوری opaque
+void test_copy_tree_overlay() {
+    printf("تست ادغام لایه overlay...\n");
+
+    char directory[] = "/tmp/copy_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    char path[512], rootfs[256], lower[256], upper[256];
+    snprintf(lower, sizeof(lower), "%s/lower", directory);
+    snprintf(upper, sizeof(upper), "%s/upper", directory);
+    snprintf(rootfs, sizeof(rootfs), "%s/rootfs", directory);
+    const char *lower_dirs[] = { "", "/keep", "/opaque", "/gone" };
+    for (int i = 0; i < 4; i++) {
+        snprintf(path, sizeof(path), "%s%s", lower, lower_dirs[i]);
+        assert(mkdir(path, 0755) == 0);
+    }
+    const char *lower_files[] = { "/file", "/keep/old", "/opaque/old", "/gone/old", "/whiteout" };
+    for (int i = 0; i < 5; i++) {
+        snprintf(path, sizeof(path), "%s%s", lower, lower_files[i]);
+        write_test_file(path, "lower\n", 0644);
+    }
+
+    // لایه بالایی مانند خروجی unpack با whiteout های overlayfs
+    const char *upper_dirs[] = { "", "/keep", "/opaque" };
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s%s", upper, upper_dirs[i]);
+        assert(mkdir(path, 0755) == 0);
+    }
+    snprintf(path, sizeof(path), "%s/opaque", upper);
+    assert(setxattr(path, "trusted.overlay.opaque", "y", 1, 0) == 0);
+    snprintf(path, sizeof(path), "%s/opaque/new", upper);
+    write_test_file(path, "upper\n", 0644);
+    snprintf(path, sizeof(path), "%s/keep/new", upper);
+    write_test_file(path, "upper\n", 0644);
+    snprintf(path, sizeof(path), "%s/file", upper);
+    write_test_file(path, "upper\n", 0600);
+    snprintf(path, sizeof(path), "%s/gone", upper);
+    assert(mknod(path, S_IFCHR | 0000, makedev(0, 0)) == 0);
+    snprintf(path, sizeof(path), "%s/whiteout", upper);
+    assert(mknod(path, S_IFCHR | 0000, makedev(0, 0)) == 0);
+
+    copy_stats_t stats;
+    assert(copy_tree_overlay(lower, rootfs, 2, &stats) == 0);
+    assert(copy_tree_overlay(upper, rootfs, 2, &stats) == 0);
+    assert(stats.whiteouts == 2);
+
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/file", rootfs);
+    snprintf(upper, sizeof(upper), "%s/upper/file", directory);
+    assert_same_content(path, upper);
+    assert(stat(path, &st) == 0 && (st.st_mode & 07777) == 0600);
+
+    snprintf(path, sizeof(path), "%s/keep/old", rootfs);
+    assert(access(path, F_OK) == 0);
+    snprintf(path, sizeof(path), "%s/keep/new", rootfs);
+    assert(access(path, F_OK) == 0);
+    snprintf(path, sizeof(path), "%s/opaque/old", rootfs);
+    assert(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/opaque/new", rootfs);
+    assert(access(path, F_OK) == 0);
+    snprintf(path, sizeof(path), "%s/gone", rootfs);
+    assert(lstat(path, &st) != 0);
+    snprintf(path, sizeof(path), "%s/whiteout", rootfs);
+    assert(lstat(path, &st) != 0);
+
+    remove_directory(directory);
+    printf("تست ادغام لایه overlay با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های کپی...\n");
+
+    test_copy_file();
+    test_copy_tree();
+
+    // whiteout و xattr های trusted نیاز به دسترسی root دارند
+    if (getuid() == 0) {
+        test_copy_tree_overlay();
+    }
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include "../include/digest.h"
+#include "../include/utils.h"
+
+// بردارهای آزمون NIST برای SHA-256
+static const struct {
+    const char *message;
+    const char *digest;
+} vectors[] = {
+    { "", "sha256:e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc", "sha256:ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "sha256:248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+};
+
+#define MILLION_A_DIGEST "sha256:cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+
+static void check_digest(const uint8_t digest[SHA256_DIGEST_SIZE], const char *expected) {
+    char formatted[DIGEST_STRING_MAX];
+    digest_format(digest, formatted, sizeof(formatted));
+    assert(strcmp(formatted, expected) == 0);
+}
+
+// بردارهای NIST با یک پیاده‌سازی مشخص
+static void test_vectors(const char *implementation) {
+    uint8_t digest[SHA256_DIGEST_SIZE];
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        sha256(vectors[i].message, strlen(vectors[i].message), digest);
+        check_digest(digest, vectors[i].digest);
+    }
+
+    // یک میلیون 'a' با تکه‌های نامنظم تا مرز بلوک‌ها جابه‌جا شود
+    char chunk[997];
+    memset(chunk, 'a', sizeof(chunk));
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    size_t remaining = 1000000;
+    while (remaining > 0) {
+        size_t take = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+        sha256_update(&ctx, chunk, take);
+        remaining -= take;
+    }
+    sha256_final(&ctx, digest);
+    check_digest(digest, MILLION_A_DIGEST);
+
+    printf("  بردارهای NIST با %s درست هستند\n", implementation);
+}
+
+// هش چندبافری باید با هش تکی یکسان باشد
+static void test_many() {
+    enum { COUNT = 37 };
+    uint8_t *data[COUNT];
+    size_t sizes[COUNT];
+    uint8_t digests[COUNT][SHA256_DIGEST_SIZE];
+    uint8_t expected[SHA256_DIGEST_SIZE];
+
+    for (int i = 0; i < COUNT; i++) {
+        sizes[i] = (size_t)i * 251;     // طول‌های متفاوت، شامل صفر و دنباله‌های ناقص
+        data[i] = malloc(sizes[i] + 1);
+        assert(data[i] != NULL);
+        for (size_t j = 0; j < sizes[i]; j++) {
+            data[i][j] = (uint8_t)(i * 31 + j);
+        }
+    }
+
+    sha256_many((const uint8_t *const *)data, sizes, COUNT, digests);
+    for (int i = 0; i < COUNT; i++) {
+        sha256(data[i], sizes[i], expected);
+        assert(memcmp(digests[i], expected, SHA256_DIGEST_SIZE) == 0);
+        free(data[i]);
+    }
+}
+
+// تست پیاده‌سازی‌ها
+void test_sha256() {
+    printf("تست SHA-256 (پیاده‌سازی پیش‌فرض: %s)...\n", digest_implementation());
+
+    const char *implementations[] = { "scalar", "avx2", "shani" };
+    for (int i = 0; i < 3; i++) {
+        if (digest_set_implementation(implementations[i]) != 0) {
+            printf("  %s روی این پردازنده پشتیبانی نمی‌شود\n", implementations[i]);
+            continue;
+        }
+        test_vectors(implementations[i]);
+        test_many();
+    }
+
+    printf("تست SHA-256 با موفقیت انجام شد\n");
+}
+
+// تست هش فایل‌ها و قالب رشته‌ای
+void test_digest_files() {
+    printf("تست هش فایل‌ها...\n");
+
+    char directory[] = "/tmp/digest_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    enum { COUNT = 70 };
+    char paths[COUNT][256];
+    const char *path_list[COUNT];
+    uint8_t digests[COUNT][SHA256_DIGEST_SIZE];
+    uint8_t expected[SHA256_DIGEST_SIZE];
+
+    size_t large_size = 300 * 1024;
+    char *content = malloc(large_size);
+    assert(content != NULL);
+    for (size_t i = 0; i < large_size; i++) {
+        content[i] = (char)(i * 7);
+    }
+
+    for (int i = 0; i < COUNT; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/file%d", directory, i);
+        path_list[i] = paths[i];
+        size_t size = i == 0 ? large_size : (size_t)i * 100;
+        int fd = open(paths[i], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd != -1);
+        assert(write(fd, content, size) == (ssize_t)size);
+        close(fd);
+    }
+
+    assert(digest_files(path_list, COUNT, digests, 4) == 0);
+    for (int i = 0; i < COUNT; i++) {
+        sha256(content, i == 0 ? large_size : (size_t)i * 100, expected);
+        assert(memcmp(digests[i], expected, SHA256_DIGEST_SIZE) == 0);
+    }
+
+    char formatted[DIGEST_STRING_MAX];
+    uint8_t parsed[SHA256_DIGEST_SIZE];
+    digest_format(digests[1], formatted, sizeof(formatted));
+    assert(digest_parse(formatted, parsed) == 0);
+    assert(memcmp(parsed, digests[1], SHA256_DIGEST_SIZE) == 0);
+    assert(digest_parse("sha512:abcd", parsed) == -1);
+    assert(digest_parse("sha256:zz", parsed) == -1);
+
+    snprintf(paths[0], sizeof(paths[0]), "%s/missing", directory);
+    assert(digest_files(path_list, 1, digests, 1) == -1);
+
+    free(content);
+    remove_directory(directory);
+
+    printf("تست هش فایل‌ها با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های digest...\n");
+
+    test_sha256();
+    test_digest_files();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
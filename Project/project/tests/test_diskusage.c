@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "../include/diskusage.h"
+#include "../include/utils.h"
+
+#define TEST_FILE_SIZE (64 * 1024)
+
+static void write_file(const char *path, size_t size) {
+    char *data = malloc(size);
+    assert(data);
+    memset(data, 'x', size);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd != -1 && write(fd, data, size) == (ssize_t)size);
+    fsync(fd);
+    close(fd);
+    free(data);
+}
+
+// پیمایش path در فرایند تازه؛ درستی اگر مصرف گزارش‌شده برابر expected باشد
+static bool scan_in_new_process(const char *path, uint64_t expected) {
+    char expected_text[32];
+    snprintf(expected_text, sizeof(expected_text), "%lu", expected);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        execl("/proc/self/exe", "test_diskusage", "--scan", path, expected_text, NULL);
+        _exit(127);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// تست پیمایش افزایشی: نتیجه درست و به‌روز شدن پس از تغییر دایرکتوری
+void test_scan() {
+    printf("تست پیمایش افزایشی مصرف دیسک...\n");
+
+    char directory[] = "/tmp/diskusage_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/a/b", directory);
+    assert(create_directory(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/a/b/file1", directory);
+    write_file(path, TEST_FILE_SIZE);
+    snprintf(path, sizeof(path), "%s/file2", directory);
+    write_file(path, TEST_FILE_SIZE);
+
+    // سه دایرکتوری و دو فایل
+    disk_usage_t usage;
+    assert(disk_usage_scan(directory, &usage) == 0);
+    assert(!usage.from_quota);
+    assert(usage.inodes == 5);
+    assert(usage.bytes >= 2 * TEST_FILE_SIZE);
+    uint64_t first_bytes = usage.bytes;
+
+    // پیمایش دوباره از حافظه همان نتیجه را می‌دهد
+    assert(disk_usage_scan(directory, &usage) == 0);
+    assert(usage.inodes == 5 && usage.bytes == first_bytes);
+
+    // بزرگ شدن فایل موجود mtime دایرکتوری را تغییر نمی‌دهد، پس اجرای بعدی از نتیجه ذخیره‌شده روی دیسک
+    // استفاده می‌کند تا مهلت DISK_SCAN_MAX_AGE_SECONDS تمام شود
+    snprintf(path, sizeof(path), "%s/file2", directory);
+    write_file(path, 2 * TEST_FILE_SIZE);
+    assert(scan_in_new_process(directory, first_bytes));
+    write_file(path, TEST_FILE_SIZE);
+
+    // فایل تازه در زیردایرکتوری عمیق mtime همان دایرکتوری را تغییر می‌دهد
+    snprintf(path, sizeof(path), "%s/a/b/file3", directory);
+    write_file(path, TEST_FILE_SIZE);
+    assert(disk_usage_scan(directory, &usage) == 0);
+    assert(usage.inodes == 6 && usage.bytes >= first_bytes + TEST_FILE_SIZE);
+
+    // حذف زیردرخت
+    snprintf(path, sizeof(path), "%s/a", directory);
+    assert(remove_directory(path) == 0);
+    assert(disk_usage_scan(directory, &usage) == 0);
+    assert(usage.inodes == 2);
+
+    // بدون project quota از پیمایش استفاده می‌شود
+    assert(disk_usage_get(directory, &usage) == 0);
+    assert(usage.inodes == 2);
+
+    disk_usage_forget(directory);
+    snprintf(path, sizeof(path), "%s/file2", directory);
+    write_file(path, 2 * TEST_FILE_SIZE);
+    assert(!scan_in_new_process(directory, usage.bytes));
+    disk_usage_forget(directory);
+    assert(disk_usage_scan("/tmp/diskusage_missing", &usage) == -1);
+
+    remove_directory(directory);
+    printf("تست پیمایش افزایشی مصرف دیسک با موفقیت انجام شد\n");
+}
+
+// تست project quota؛ روی فایل‌سیستم بدون prjquota فقط بازگشت -1 بررسی می‌شود
+void test_quota() {
+    printf("تست project quota...\n");
+
+    char directory[] = "/tmp/diskusage_quota_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+
+    if (disk_quota_setup(directory, "test", 0, 0) != 0) {
+        printf("project quota روی /tmp فعال نیست، تست رد شد\n");
+        remove_directory(directory);
+        return;
+    }
+
+    // مصرف فایل تازه بدون پیمایش و از شمارنده هسته خوانده می‌شود
+    char path[512];
+    snprintf(path, sizeof(path), "%s/file", directory);
+    write_file(path, TEST_FILE_SIZE);
+    disk_usage_t usage;
+    assert(disk_usage_get(directory, &usage) == 0);
+    assert(usage.from_quota);
+    assert(usage.bytes >= TEST_FILE_SIZE && usage.inodes >= 2);
+
+    remove_directory(directory);
+    printf("تست project quota با موفقیت انجام شد\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "--scan") == 0) {
+        disk_usage_t usage;
+        return disk_usage_scan(argv[2], &usage) == 0 && usage.bytes == strtoull(argv[3], NULL, 10) ? 0 : 1;
+    }
+    printf("شروع آزمون‌های مصرف دیسک...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون مصرف دیسک نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_scan();
+    test_quota();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "../include/forkserver.h"
+#include "../include/utils.h"
+
+static int initialized = 0;
+
+// برنامه کانتینر: مقداردهی یک بار، سپس هر نمونه وضعیت خود را روی کانال گزارش می‌کند
+static int server_main() {
+    initialized = 42;
+    int channel = forkserver_run();
+    if (channel < 0) {
+        return channel == -1 ? 0 : 1;
+    }
+
+    char uts[64] = "", cgroup[256] = "", report[512];
+    ssize_t length = readlink("/proc/self/ns/uts", uts, sizeof(uts) - 1);
+    uts[length > 0 ? length : 0] = '\0';
+    int fd = open("/proc/self/cgroup", O_RDONLY | O_CLOEXEC);
+    length = fd == -1 ? 0 : read(fd, cgroup, sizeof(cgroup) - 1);
+    cgroup[length > 0 ? length : 0] = '\0';
+    close(fd);
+    snprintf(report, sizeof(report), "%d %s %s", initialized, uts, cgroup);
+    if (send(channel, report, strlen(report), 0) <= 0) {
+        return 1;
+    }
+    // تا بسته شدن کانال توسط مدیر
+    char byte;
+    while (recv(channel, &byte, 1, 0) > 0) {
+    }
+    return 0;
+}
+
+static pid_t start_server(int *server_fd) {
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        close(sv[0]);
+        char fd_text[16];
+        snprintf(fd_text, sizeof(fd_text), "%d", sv[1]);
+        setenv(FORKSERVER_ENV, fd_text, 1);
+        execl("/proc/self/exe", "test_forkserver", "--server", NULL);
+        _exit(127);
+    }
+    close(sv[1]);
+    fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+    *server_fd = sv[0];
+    return pid;
+}
+
+static void read_report(forkserver_instance_t *instance, char *report, size_t size) {
+    ssize_t length = recv(instance->channel_fd, report, size - 1, 0);
+    assert(length > 0);
+    report[length] = '\0';
+}
+
+void test_forkserver_instances() {
+    printf("تست نمونه‌های fork-server...\n");
+
+    assert(forkserver_run() == FORKSERVER_STANDALONE);
+
+    const char *root = access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0 ? "/sys/fs/cgroup"
+                                                                               : "/sys/fs/cgroup/unified";
+    char base[256], path[300];
+    snprintf(base, sizeof(base), "%s/forkserver_test", root);
+    assert(create_directory(base, 0755) == 0);
+
+    int server_fd;
+    pid_t server = start_server(&server_fd);
+    assert(forkserver_wait_ready(server_fd, 5000) == 0);
+
+    char host_uts[64];
+    ssize_t length = readlink("/proc/self/ns/uts", host_uts, sizeof(host_uts) - 1);
+    assert(length > 0);
+    host_uts[length] = '\0';
+
+    // هر نمونه وضعیت مقداردهی‌شده را دارد و در cgroup خود است
+    forkserver_instance_t instances[3];
+    char report[512], expected[400];
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/instance-%d", base, i);
+        assert(forkserver_fork(server_fd, i, path, i == 2 ? CLONE_NEWUTS : 0, &instances[i]) == 0);
+        assert(instances[i].pid > 0 && instances[i].pid != server);
+        read_report(&instances[i], report, sizeof(report));
+        assert(strncmp(report, "42 ", 3) == 0);
+        assert((strstr(report, host_uts) != NULL) == (i != 2));
+        snprintf(expected, sizeof(expected), "/forkserver_test/instance-%d\n", i);
+        assert(strstr(report, expected) != NULL);
+    }
+    forkserver_instance_t rejected;
+    assert(forkserver_fork(server_fd, 9, path, CLONE_NEWUSER, &rejected) == -1);
+
+    // بستن کانال نمونه را تمام می‌کند؛ نمونه دیگر با destroy کشته می‌شود
+    close(instances[0].channel_fd);
+    instances[0].channel_fd = -1;
+    assert(forkserver_instance_wait(&instances[0], 5000) == 0);
+    assert(forkserver_instance_wait(&instances[1], 100) == 1);
+    for (int i = 0; i < 3; i++) {
+        assert(forkserver_instance_destroy(&instances[i]) == 0);
+        assert(access(instances[i].cgroup_path, F_OK) != 0);
+    }
+
+    // بستن سوکت سرور را پایان می‌دهد
+    close(server_fd);
+    int status;
+    assert(waitpid(server, &status, 0) == server);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(rmdir(base) == 0);
+
+    printf("تست نمونه‌های fork-server با موفقیت انجام شد\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--server") == 0) {
+        return server_main();
+    }
+    printf("شروع آزمون‌های fork-server...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون fork-server نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_forkserver_instances();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <assert.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../include/idmap.h"
+#include "../include/mounttree.h"
+#include "../include/snapshot.h"
+#include "../include/filesystem.h"
+#include "../include/utils.h"
+
+#define TEST_DIR "/var/lib/simplecontainer/idmap_test"
+#define LAYER_DIR TEST_DIR "/layer"
+
+void test_idmap_parse() {
+    printf("تست پارس نگاشت شناسه...\n");
+
+    id_mapping_t map;
+    assert(idmap_parse("100000", &map) == 0);
+    assert(map.uid_base == 100000 && map.gid_base == 100000 && map.count == IDMAP_DEFAULT_COUNT);
+    assert(idmap_parse("200000:1000", &map) == 0);
+    assert(map.uid_base == 200000 && map.count == 1000);
+    assert(idmap_parse("abc", &map) == -1);
+    assert(idmap_parse("1:0", &map) == -1);
+    assert(idmap_parse("4294967295:2", &map) == -1);
+    assert(idmap_parse("100000:", &map) == -1);
+
+    // نخستین محدوده کاربر، با نام یا uid عددی
+    const char *path = "/tmp/idmap_test_subuid";
+    FILE *file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "other:10:20\nroot:300000:65536\nroot:500000:10\n");
+    fclose(file);
+    uint32_t base, count;
+    assert(idmap_read_subid(path, "root", &base, &count) == 0);
+    assert(base == 300000 && count == 65536);
+    assert(idmap_read_subid(path, "missing", &base, &count) == -1);
+    file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "%u:600000:100\n", getuid());
+    fclose(file);
+    assert(idmap_read_subid(path, "missing", &base, &count) == 0);
+    assert(base == 600000 && count == 100);
+    unlink(path);
+
+    printf("تست پارس نگاشت شناسه با موفقیت انجام شد\n");
+}
+
+static void create_owned(const char *path, uid_t uid, gid_t gid) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    assert(fd != -1);
+    assert(write(fd, "x", 1) == 1);
+    close(fd);
+    assert(chown(path, uid, gid) == 0);
+}
+
+static uid_t owner_of(const char *path) {
+    struct stat st;
+    assert(lstat(path, &st) == 0);
+    return st.st_uid;
+}
+
+// فرآیندی با user namespace و نگاشت map مالک path را از درون می‌بیند
+static uid_t owner_inside(const id_mapping_t *map, const char *path) {
+    int ready[2], result[2];
+    assert(pipe(ready) == 0 && pipe(result) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        close(ready[1]);
+        close(result[0]);
+        char byte;
+        if (unshare(CLONE_NEWUSER) != 0) _exit(1);
+        if (write(result[1], "u", 1) != 1 || read(ready[0], &byte, 1) != 1) _exit(1);
+        struct stat st;
+        uid_t uid = lstat(path, &st) == 0 ? st.st_uid : (uid_t)-1;
+        if (write(result[1], &uid, sizeof(uid)) != sizeof(uid)) _exit(1);
+        _exit(0);
+    }
+    close(ready[0]);
+    close(result[1]);
+    char byte;
+    assert(read(result[0], &byte, 1) == 1);
+    assert(idmap_write(pid, map, false) == 0);
+    assert(write(ready[1], "1", 1) == 1);
+    uid_t uid;
+    assert(read(result[0], &uid, sizeof(uid)) == sizeof(uid));
+    close(ready[1]);
+    close(result[0]);
+    assert(waitpid(pid, NULL, 0) == pid);
+    return uid;
+}
+
+void test_idmap_mount() {
+    printf("تست نصب idmapped...\n");
+
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        // mount namespace خصوصی تا نصب‌ها با خروج آزاد شوند
+        assert(unshare(CLONE_NEWNS) == 0);
+        assert(mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0);
+        assert(create_directory(LAYER_DIR "/etc", 0755) == 0);
+        create_owned(LAYER_DIR "/etc/owned", 5, 6);
+        create_owned(LAYER_DIR "/etc/shifted", 100007, 100007);
+
+        // نگاشت روی نصب؛ مالکیت روی دیسک دست نمی‌خورد
+        id_mapping_t map = { 100000, 100000, 65536 };
+        int userns_fd = idmap_userns_fd(&map, false);
+        assert(userns_fd != -1);
+        assert(create_directory(TEST_DIR "/mapped", 0755) == 0);
+        assert(mount_idmapped(LAYER_DIR, TEST_DIR "/mapped", userns_fd, MOUNT_ATTR_RDONLY) == 0);
+        close(userns_fd);
+        assert(owner_of(TEST_DIR "/mapped/etc/owned") == 100005);
+        assert(owner_of(LAYER_DIR "/etc/owned") == 5);
+        assert(owner_inside(&map, TEST_DIR "/mapped/etc/owned") == 5);
+        assert(mkdir(TEST_DIR "/mapped/new", 0755) == -1);
+
+        // نگاشت معکوس شناسه‌های میزبان را به شناسه‌های کانتینر برمی‌گرداند
+        userns_fd = idmap_userns_fd(&map, true);
+        assert(userns_fd != -1);
+        assert(create_directory(TEST_DIR "/inverse", 0755) == 0);
+        assert(mount_idmapped(LAYER_DIR, TEST_DIR "/inverse", userns_fd, 0) == 0);
+        close(userns_fd);
+        assert(owner_of(TEST_DIR "/inverse/etc/shifted") == 7);
+        assert(owner_of(TEST_DIR "/inverse/etc/owned") == 65534);
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    printf("تست نصب idmapped با موفقیت انجام شد\n");
+}
+
+static void init_config(container_config_t *config, const char *id, uint32_t base) {
+    memset(config, 0, sizeof(*config));
+    snprintf(config->id, sizeof(config->id), "%s", id);
+    snprintf(config->rootfs, sizeof(config->rootfs), TEST_DIR "/%s/rootfs", id);
+    snprintf(config->overlay_workdir, sizeof(config->overlay_workdir), TEST_DIR "/%s/overlay", id);
+    config->idmap = (id_mapping_t){ base, base, 65536 };
+    assert(create_directory(config->rootfs, 0755) == 0);
+    assert(create_directory(config->overlay_workdir, 0755) == 0);
+}
+
+void test_idmap_overlay() {
+    printf("تست اشتراک یک لایه با نگاشت‌های متفاوت...\n");
+
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        assert(unshare(CLONE_NEWNS) == 0);
+        assert(mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0);
+        assert(create_directory(SNAPSHOT_BASE_ROOTFS "/etc", 0755) == 0);
+        create_owned(SNAPSHOT_BASE_ROOTFS "/etc/idmap_owned", 5, 6);
+
+        container_config_t first, second;
+        init_config(&first, "first", 100000);
+        init_config(&second, "second", 200000);
+        assert(setup_overlayfs(&first) == 0);
+        assert(setup_overlayfs(&second) == 0);
+
+        // لایه روی دیسک یکی است و هر کانتینر آن را با شناسه‌های خود می‌بیند
+        assert(owner_of(first.rootfs) == 100000);
+        assert(owner_of(SNAPSHOT_BASE_ROOTFS "/etc/idmap_owned") == 5);
+        char path[1100];
+        snprintf(path, sizeof(path), "%s/etc/idmap_owned", first.rootfs);
+        assert(owner_of(path) == 100005);
+        assert(owner_inside(&first.idmap, path) == 5);
+        snprintf(path, sizeof(path), "%s/etc/idmap_owned", second.rootfs);
+        assert(owner_of(path) == 200005);
+        assert(owner_inside(&second.idmap, path) == 5);
+
+        // نسخه‌های idmapped پس از نصب جدا شده‌اند
+        snprintf(path, sizeof(path), "%s/%s", first.overlay_workdir, SNAPSHOT_IDMAP_DIR);
+        assert(access(path, F_OK) != 0);
+
+        // copy-up مالکیت نگاشت‌شده را در upper نگه می‌دارد
+        snprintf(path, sizeof(path), "%s/etc/idmap_owned", first.rootfs);
+        assert(chown(path, 100009, 100009) == 0);
+        snprintf(path, sizeof(path), "%s/upper/etc/idmap_owned", first.overlay_workdir);
+        assert(owner_of(path) == 100009);
+        assert(owner_of(SNAPSHOT_BASE_ROOTFS "/etc/idmap_owned") == 5);
+
+        assert(umount(first.rootfs) == 0);
+        assert(umount(second.rootfs) == 0);
+        unlink(SNAPSHOT_BASE_ROOTFS "/etc/idmap_owned");
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    remove_directory(TEST_DIR);
+
+    printf("تست اشتراک یک لایه با نگاشت‌های متفاوت با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های نگاشت شناسه...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون نگاشت شناسه نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_idmap_parse();
+    test_idmap_mount();
+    test_idmap_overlay();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
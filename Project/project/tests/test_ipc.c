@@ -0,0 +1,484 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+#include "../include/container.h"
+#include "../include/cgroup.h"
+#include "../include/ipc.h"
+#include "../include/ipc_layout.h"
+#include "../include/rpc.h"
+#include "../include/utils.h"
+
+// تست ایجاد تعداد زیادی کانال و جستجوی هش
+void test_ipc_registry() {
+    printf("تست جدول کانال‌های IPC...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    assert(ipc_setup() == 0);
+
+    // بیش از ظرفیت اولیه جدول تا تغییر اندازه هم آزموده شود
+    char name[64];
+    for (int i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "test_channel_%d", i);
+        assert(ipc_create_channel(&config, name) == 0);
+    }
+    assert(ipc_channel_count() == 500);
+
+    // نام تکراری پذیرفته نمی‌شود
+    assert(ipc_create_channel(&config, "test_channel_7") == -1);
+
+    ipc_cleanup();
+    assert(ipc_channel_count() == 0);
+
+    printf("تست جدول کانال‌های IPC با موفقیت انجام شد\n");
+}
+
+// کلید سگمنت همان‌طور که ipc.c از نام می‌سازد
+static key_t channel_key(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return (key_t)(hash & 0x7fffffff);
+}
+
+// تست سگمنت مانده از فرآیند قبلی و برخورد کلید با سگمنت نام دیگر
+void test_ipc_segment_key() {
+    printf("تست کلید سگمنت کانال IPC...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    // فرآیندی که بدون پاک‌سازی خارج می‌شود سگمنتی بدون اتصال به جا می‌گذارد
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(ipc_create_channel(&config, "stale_channel") == 0 ? 0 : 1);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(ipc_create_channel(&config, "stale_channel") == 0);
+
+    // سگمنت بیگانه روی کلید نام دست نمی‌خورد و کانال کلید بعدی را می‌گیرد
+    int foreign = shmget(channel_key("collide_channel"), 4096, IPC_CREAT | IPC_EXCL | 0600);
+    assert(foreign != -1);
+    char *foreign_data = shmat(foreign, NULL, 0);
+    assert(foreign_data != (void *) -1);
+    strcpy(foreign_data, "foreign");
+    assert(ipc_create_channel(&config, "collide_channel") == 0);
+    assert(ipc_send_message("collide_channel", "x", 1) == 0);
+    assert(strcmp(foreign_data, "foreign") == 0);
+    shmdt(foreign_data);
+    shmctl(foreign, IPC_RMID, NULL);
+
+    ipc_cleanup();
+
+    printf("تست کلید سگمنت کانال IPC با موفقیت انجام شد\n");
+}
+
+// تست handle، آمار و حذف تکی کانال
+void test_ipc_handle() {
+    printf("تست handle کانال IPC...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    assert(ipc_create_channel(&config, "handle_channel") == 0);
+
+    ipc_channel_t *channel = ipc_channel_open("handle_channel");
+    assert(channel != NULL);
+
+    char buffer[16];
+    assert(ipc_channel_send(channel, "hello", 5) == 0);
+    assert(ipc_channel_send(channel, "world", 5) == 0);
+    assert(ipc_channel_receive(channel, buffer, sizeof(buffer)) == 5);
+    assert(memcmp(buffer, "hello", 5) == 0);
+
+    // پس از حذف، handle باز همچنان معتبر است
+    assert(ipc_destroy_channel("handle_channel") == 0);
+    assert(ipc_channel_open("handle_channel") == NULL);
+    assert(ipc_channel_receive(channel, buffer, sizeof(buffer)) == 5);
+    assert(memcmp(buffer, "world", 5) == 0);
+
+    // صف خالی
+    assert(ipc_channel_receive(channel, buffer, sizeof(buffer)) == 0);
+
+    ipc_channel_stats_t stats;
+    assert(ipc_channel_get_stats(channel, &stats) == 0);
+    assert(stats.messages_sent == 2);
+    assert(stats.messages_received == 2);
+    assert(stats.bytes_sent == 10);
+
+    ipc_channel_close(channel);
+    ipc_cleanup();
+
+    printf("تست handle کانال IPC با موفقیت انجام شد\n");
+}
+
+// مقدار یک کلید از memory.stat؛ -1 اگر فایل یا کلید نباشد
+static long long memory_stat_value(const char *cgroup_path, const char *key) {
+    char buffer[8192];
+    if (read_cgroup_file(cgroup_path, "memory.stat", buffer, sizeof(buffer)) != 0) {
+        return -1;
+    }
+    size_t key_length = strlen(key);
+    for (char *line = buffer; line != NULL; ) {
+        if (strncmp(line, key, key_length) == 0 && line[key_length] == ' ') {
+            return atoll(line + key_length + 1);
+        }
+        line = strchr(line, '\n');
+        if (line != NULL) {
+            line++;
+        }
+    }
+    return -1;
+}
+
+// تست نسبت دادن همه صفحات سگمنت، از جمله صفحه سرآیند، به cgroup کانتینر
+void test_ipc_cgroup_charge() {
+    printf("تست شارژ حافظه کانال IPC به cgroup...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    // cgroup v2 یا سلسله‌مراتب memory در v1
+    const char *root = access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0 ? "/sys/fs/cgroup"
+                                                                            : "/sys/fs/cgroup/memory";
+    snprintf(config.cgroup_path, sizeof(config.cgroup_path), "%s/ipc_charge_test", root);
+    rmdir(config.cgroup_path);
+    if (mkdir(config.cgroup_path, 0755) != 0 || memory_stat_value(config.cgroup_path, "shmem") < 0) {
+        rmdir(config.cgroup_path);
+        printf("کنترلر memory در دسترس نیست، تست رد شد\n");
+        return;
+    }
+
+    ipc_channel_options_t options = { .size = 1 << 20, .huge_pages = false };
+    assert(ipc_create_channel_ex(&config, "charge_channel", &options) == 0);
+    ipc_channel_t *channel = ipc_channel_open("charge_channel");
+    assert(channel != NULL);
+    size_t size;
+    assert(ipc_channel_map(channel, &size) != NULL);
+
+    // سرآیندها در همان صفحه اول نوشته می‌شوند؛ اگر مدیر زودتر لمسش کند یک صفحه کم می‌آید
+    long page = sysconf(_SC_PAGESIZE);
+    long long expected = (long long)((size + sizeof(ipc_segment_header_t) + page - 1) / page * page);
+    assert(memory_stat_value(config.cgroup_path, "shmem") == expected);
+
+    ipc_channel_close(channel);
+    ipc_cleanup();
+    assert(rmdir(config.cgroup_path) == 0);
+
+    printf("تست شارژ حافظه کانال IPC به cgroup با موفقیت انجام شد\n");
+}
+
+// تست ارسال و دریافت دسته‌ای و چرخش صف
+void test_ipc_batch() {
+    printf("تست ارسال دسته‌ای IPC...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    ipc_channel_options_t options = { .size = 100, .huge_pages = false };
+    assert(ipc_create_channel_ex(&config, "batch_channel", &options) == 0);
+    ipc_channel_t *channel = ipc_channel_open("batch_channel");
+    assert(channel != NULL);
+
+    // چندین دور تا آفست‌ها از انتهای ناحیه داده عبور کنند
+    char out[8][32], in[8][32];
+    for (int round = 0; round < 1000; round++) {
+        struct iovec send_records[8], recv_records[8];
+        for (int i = 0; i < 8; i++) {
+            snprintf(out[i], sizeof(out[i]), "r%d-%d", round, i);
+            send_records[i].iov_base = out[i];
+            send_records[i].iov_len = strlen(out[i]) + 1;
+            recv_records[i].iov_base = in[i];
+            recv_records[i].iov_len = sizeof(in[i]);
+        }
+
+        int sent = ipc_send_batch(channel, send_records, 8);
+        assert(sent > 0);
+        assert(ipc_recv_batch(channel, recv_records, 8, 0) == sent);
+        for (int i = 0; i < sent; i++) {
+            assert(strcmp(in[i], out[i]) == 0);
+            assert(recv_records[i].iov_len == strlen(out[i]) + 1);
+        }
+    }
+
+    // صف خالی با مهلت کوتاه
+    struct iovec record = { in[0], sizeof(in[0]) };
+    assert(ipc_recv_batch(channel, &record, 1, 10) == 0);
+
+    // طول رکورد و اندیس‌هایی که طرف مقابل خراب کرده در دریافت و ارسال رد می‌شوند
+    ipc_channel_stats_t stats;
+    ipc_ring_header_t *ring = ipc_channel_map(channel, NULL);
+    assert(ring != NULL);
+    char *data = (char *)ring + sizeof(ipc_ring_header_t);
+    assert(ipc_channel_send(channel, "abc", 3) == 0);
+    uint32_t *length = (uint32_t *)(data + ring->head);
+    *length = 1u << 30;
+    record.iov_len = sizeof(in[0]);
+    assert(ipc_recv_batch(channel, &record, 1, 0) == -1);
+    *length = 3;
+    uint32_t tail = ring->tail;
+    ring->tail = tail + 4;
+    assert(ipc_recv_batch(channel, &record, 1, 0) == -1);
+    ring->tail = ring->capacity + 64;
+    assert(ipc_send_batch(channel, &record, 1) == -1);
+    ring->tail = tail;
+    uint32_t head = ring->head;
+    ring->head = 1u << 31;
+    assert(ipc_send_batch(channel, &record, 1) == -1);
+    ring->head = head;
+    assert(ipc_recv_batch(channel, &record, 1, 0) == 1 && record.iov_len == 3);
+    assert(ipc_channel_get_stats(channel, &stats) == 0 && stats.errors == 4);
+
+    ipc_channel_close(channel);
+    ipc_cleanup();
+
+    printf("تست ارسال دسته‌ای IPC با موفقیت انجام شد\n");
+}
+
+// تست کانال broadcast و نسخه‌گذاری snapshot
+void test_ipc_broadcast() {
+    printf("تست کانال broadcast...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    assert(ipc_create_broadcast_channel(&config, "broadcast_channel", 128) == 0);
+    ipc_channel_t *channel = ipc_channel_open("broadcast_channel");
+    assert(channel != NULL);
+
+    // بدون انتشار، انتظار با پایان مهلت برمی‌گردد
+    assert(ipc_broadcast_wait(channel, 0, 10) == 1);
+
+    char buffer[128];
+    uint64_t version = 0;
+    assert(ipc_broadcast_publish(channel, "flag=on", 7) == 0);
+    assert(ipc_broadcast_wait(channel, 0, 10) == 0);
+    assert(ipc_broadcast_read(channel, buffer, sizeof(buffer), &version) == 7);
+    assert(version == 1);
+    assert(memcmp(buffer, "flag=on", 7) == 0);
+
+    // داده بزرگتر از ظرفیت رد می‌شود
+    char large[256] = {0};
+    assert(ipc_broadcast_publish(channel, large, sizeof(large)) == -1);
+
+    // ارسال معمولی روی کانال broadcast پذیرفته نمی‌شود
+    assert(ipc_channel_send(channel, "x", 1) == -1);
+
+    // نویسنده‌ای که وسط انتشار مرده: خواننده دقیقاً -1 می‌گیرد و نویسنده بعدی ادامه می‌دهد
+    ipc_broadcast_header_t *header = ipc_channel_map(channel, NULL);
+    assert(header != NULL);
+    pid_t writer = fork();
+    assert(writer != -1);
+    if (writer == 0) {
+        pthread_mutex_lock(&header->writer_lock);
+        __atomic_store_n(&header->seq, header->seq + 1, __ATOMIC_RELEASE);
+        memset(header->data, 'x', header->capacity);
+        _exit(0);
+    }
+    assert(waitpid(writer, NULL, 0) == writer);
+    assert(ipc_broadcast_read(channel, buffer, sizeof(buffer), &version) == -1);
+    assert(ipc_broadcast_publish(channel, "flag=off", 8) == 0);
+    assert(ipc_broadcast_read(channel, buffer, sizeof(buffer), &version) == 8);
+    assert(memcmp(buffer, "flag=off", 8) == 0);
+
+    // انتشار طولانی نویسنده زنده در namespace PID دیگر مرگ نویسنده به حساب نمی‌آید
+    int ready[2];
+    assert(pipe(ready) == 0);
+    writer = fork();
+    assert(writer != -1);
+    if (writer == 0) {
+        assert(unshare(CLONE_NEWPID) == 0);
+        pid_t inner = fork();
+        if (inner == 0) {
+            pthread_mutex_lock(&header->writer_lock);
+            __atomic_store_n(&header->seq, header->seq + 1, __ATOMIC_RELEASE);
+            assert(write(ready[1], "1", 1) == 1);
+            usleep(300000);
+            memcpy(header->data, "slow", 4);
+            header->size = 4;
+            header->version++;
+            __atomic_store_n(&header->seq, header->seq + 1, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&header->writer_lock);
+            _exit(0);
+        }
+        _exit(inner > 0 && waitpid(inner, NULL, 0) == inner ? 0 : 1);
+    }
+    char byte;
+    assert(read(ready[0], &byte, 1) == 1);
+    assert(ipc_broadcast_read(channel, buffer, sizeof(buffer), &version) == 4);
+    assert(memcmp(buffer, "slow", 4) == 0);
+    int status;
+    assert(waitpid(writer, &status, 0) == writer && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(ready[0]);
+    close(ready[1]);
+
+    ipc_channel_close(channel);
+    ipc_cleanup();
+
+    printf("تست کانال broadcast با موفقیت انجام شد\n");
+}
+
+// پردازش‌گر آزمایشی: برگرداندن درخواست با method به عنوان پیشوند
+static int test_rpc_handler(uint32_t method, const void *request, size_t request_size,
+                            void *response, size_t response_capacity, void *user_data) {
+    (void)user_data;
+    if (method == 0 || request_size + 1 > response_capacity) {
+        return -1;
+    }
+    ((char *)response)[0] = (char)method;
+    memcpy((char *)response + 1, request, request_size);
+    return (int)request_size + 1;
+}
+
+// تست دسته‌ای ارسال، شناسه درخواست‌ها و پایان مهلت RPC
+void test_rpc() {
+    printf("تست RPC...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    rpc_server_t *server = rpc_server_create(&config, "test_rpc", test_rpc_handler, NULL);
+    assert(server != NULL);
+    rpc_client_t *client = rpc_client_create(server, &config, "client", 4, 64);
+    assert(client != NULL);
+    rpc_client_set_spin(client, 0);
+
+    // بدون سرور فعال، انتظار با پایان مهلت برمی‌گردد
+    char response[64];
+    assert(rpc_wait_completion(client, NULL, NULL, response, sizeof(response), 10) == RPC_TIMEOUT);
+
+    // چهار درخواست با یک doorbell؛ درخواست پنجم از عمق صف بیشتر است
+    uint64_t ids[4];
+    for (int i = 0; i < 4; i++) {
+        assert(rpc_submit(client, i + 1, "abc", 3, &ids[i]) == 0);
+    }
+    assert(rpc_submit(client, 1, "abc", 3, NULL) == -1);
+    assert(rpc_flush(client) == 0);
+    assert(rpc_server_poll(server) == 4);
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t id;
+        int status;
+        assert(rpc_wait_completion(client, &id, &status, response, sizeof(response), 10) == 4);
+        assert(id == ids[i]);
+        assert(status == 0);
+        assert(response[0] == i + 1);
+        assert(memcmp(response + 1, "abc", 3) == 0);
+    }
+
+    // خطای پردازش‌گر به صورت وضعیت منفی برمی‌گردد
+    uint64_t id;
+    int status;
+    assert(rpc_submit(client, 0, "x", 1, &id) == 0);
+    rpc_flush(client);
+    assert(rpc_server_poll(server) == 1);
+    assert(rpc_wait_completion(client, NULL, &status, response, sizeof(response), 10) == 0);
+    assert(status < 0);
+
+    rpc_server_destroy(server);
+    ipc_cleanup();
+
+    printf("تست RPC با موفقیت انجام شد\n");
+}
+
+// اجرای همه تست‌ها
+static void* rpc_server_thread(void *arg) {
+    return (void *)(intptr_t)rpc_server_run(arg);
+}
+
+// تست کلاینت RPC در فرآیند دیگر و ثبت کلاینت هم‌زمان با حلقه سرور
+void test_rpc_attach() {
+    printf("تست اتصال کلاینت RPC از فرآیند دیگر...\n");
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "test");
+
+    rpc_server_t *server = rpc_server_create(&config, "attach_rpc", test_rpc_handler, NULL);
+    assert(server != NULL);
+    assert(rpc_server_add_client(server, &config, "remote", 4, 64) == 0);
+
+    // نام ثبت‌نشده و سگمنتی که سرآیند RPC ندارد پذیرفته نمی‌شوند
+    assert(rpc_client_attach("attach_rpc", "missing") == NULL);
+    assert(ipc_create_channel(&config, "attach_rpc.plain") == 0);
+    assert(rpc_client_attach("attach_rpc", "plain") == NULL);
+
+    // فرزند فقط با نام و از طریق ipc_channel_attach به سگمنت‌ها وصل می‌شود، نه از جدول کانال‌ها
+    pid_t pid = fork();
+    if (pid == 0) {
+        rpc_client_t *remote = rpc_client_attach("attach_rpc", "remote");
+        if (remote == NULL) {
+            _exit(1);
+        }
+        char response[64];
+        int result = rpc_call(remote, 7, "abc", 3, response, sizeof(response), 5000);
+        rpc_client_destroy(remote);
+        _exit(result == 4 && response[0] == 7 && memcmp(response + 1, "abc", 3) == 0 ? 0 : 2);
+    }
+    assert(pid > 0);
+
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, rpc_server_thread, server) == 0);
+
+    // ساخت کلاینت از نخ دیگر در حالی که حلقه سرور فهرست کلاینت‌ها را پیمایش می‌کند
+    char name[32];
+    char response[64];
+    for (int i = 0; i < 32; i++) {
+        snprintf(name, sizeof(name), "local_%d", i);
+        rpc_client_t *client = rpc_client_create(server, &config, name, 2, 16);
+        assert(client != NULL);
+        assert(rpc_call(client, 1, "x", 1, response, sizeof(response), 5000) == 2);
+        if (i % 2 == 0) {
+            rpc_client_destroy(client);
+        }
+    }
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    rpc_server_stop(server);
+    void *result;
+    assert(pthread_join(thread, &result) == 0 && result == NULL);
+    rpc_server_destroy(server);
+    ipc_cleanup();
+
+    printf("تست اتصال کلاینت RPC از فرآیند دیگر با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های IPC...\n");
+
+    test_ipc_registry();
+    test_ipc_segment_key();
+    test_ipc_handle();
+    test_ipc_cgroup_charge();
+    test_ipc_batch();
+    test_ipc_broadcast();
+    test_rpc();
+    test_rpc_attach();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
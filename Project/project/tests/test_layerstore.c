@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include "../include/layerstore.h"
+#include "../include/digest.h"
+#include "../include/utils.h"
+
+#define LAYER_A "sha256:aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+#define LAYER_C "sha256:cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc"
+
+// نوشتن یک فایل آزمایشی
+static void write_test_file(const char *path, const char *content) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd != -1);
+    assert(write(fd, content, strlen(content)) == (ssize_t)strlen(content));
+    close(fd);
+}
+
+// عقب بردن زمان آخرین استفاده لایه تا از مهلت نگهداری GC بگذرد
+static void expire_layer(const char *digest) {
+    char path[1024];
+    assert(layer_store_path(digest, path, sizeof(path)) == 0);
+    strcpy(strrchr(path, '/'), "/refs");
+
+    struct timespec times[2];
+    clock_gettime(CLOCK_REALTIME, &times[0]);
+    times[0].tv_sec -= LAYER_GC_GRACE_SECONDS + 1;
+    times[1] = times[0];
+    assert(utimensat(AT_FDCWD, path, times, 0) == 0);
+}
+
+// تست اعتبارسنجی digest
+void test_layer_digest() {
+    printf("تست اعتبارسنجی digest...\n");
+
+    assert(layer_digest_valid(LAYER_A));
+    assert(!layer_digest_valid("sha256:../../etc"));
+    assert(!layer_digest_valid("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"));
+    assert(!layer_digest_valid("SHA256:aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"));
+
+    printf("تست اعتبارسنجی digest با موفقیت انجام شد\n");
+}
+
+// تست واردسازی از دایرکتوری و tar، اشتراک فایل‌های یکسان و GC
+void test_layer_store() {
+    printf("تست انبار لایه...\n");
+
+    char source[] = "/tmp/layer_test_XXXXXX";
+    assert(mkdtemp(source) != NULL);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/a", source);
+    assert(mkdir(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/a/etc", source);
+    assert(mkdir(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/a/etc/shared", source);
+    write_test_file(path, "shared content\n");
+    snprintf(path, sizeof(path), "%s/a/link", source);
+    assert(symlink("etc/shared", path) == 0);
+
+    snprintf(path, sizeof(path), "%s/b", source);
+    assert(mkdir(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/b/shared", source);
+    write_test_file(path, "shared content\n");
+    snprintf(path, sizeof(path), "%s/b/own", source);
+    write_test_file(path, "layer b only\n");
+
+    char layer_dir[1024];
+    snprintf(layer_dir, sizeof(layer_dir), "%s/a", source);
+    assert(layer_store_import_dir(LAYER_A, layer_dir) == 0);
+    // لایه دوم از آرشیو tar باز می‌شود و همچنان با لایه اول اشتراک دارد
+    char command[2048];
+    snprintf(command, sizeof(command), "tar -czf %s/b.tar.gz -C %s/b .", source, source);
+    assert(system(command) == 0);
+    snprintf(layer_dir, sizeof(layer_dir), "%s/b.tar.gz", source);
+
+    // digest آرشیو باید با محتوای آن مطابقت داشته باشد
+    uint8_t hash[SHA256_DIGEST_SIZE];
+    char LAYER_B[DIGEST_STRING_MAX];
+    assert(digest_file(layer_dir, hash) == 0);
+    digest_format(hash, LAYER_B, sizeof(LAYER_B));
+    assert(layer_store_import_tar(LAYER_C, layer_dir) == -1);
+    assert(!layer_store_has(LAYER_C));
+    assert(layer_store_import_tar(LAYER_B, layer_dir) == 0);
+    assert(layer_store_has(LAYER_A) && layer_store_has(LAYER_B));
+
+    // فایل یکسان در دو لایه یک inode است (دو لایه + شیء مشترک)
+    struct stat st_a, st_b;
+    assert(layer_store_path(LAYER_A, path, sizeof(path)) == 0);
+    strcat(path, "/etc/shared");
+    assert(stat(path, &st_a) == 0);
+    assert(layer_store_path(LAYER_B, path, sizeof(path)) == 0);
+    strcat(path, "/shared");
+    assert(stat(path, &st_b) == 0);
+    assert(st_a.st_ino == st_b.st_ino);
+    assert(layer_store_path(LAYER_B, path, sizeof(path)) == 0);
+    strcat(path, "/own");
+    assert(access(path, F_OK) == 0);
+    assert(st_a.st_nlink == 3);
+
+    // بررسی محتوای لایه و تشخیص تغییر آن
+    assert(layer_store_verify(LAYER_A) == 0);
+    assert(layer_store_verify(LAYER_B) == 0);
+    assert(layer_store_path(LAYER_B, path, sizeof(path)) == 0);
+    strcat(path, "/own");
+    write_test_file(path, "tampered\n");
+    assert(layer_store_verify(LAYER_B) == -1);
+
+    // شمارنده ارجاع
+    assert(layer_store_refcount(LAYER_A) == 0);
+    assert(layer_store_ref(LAYER_A) == 0);
+    assert(layer_store_ref(LAYER_A) == 0);
+    assert(layer_store_refcount(LAYER_A) == 2);
+
+    // ارجاعی که پیش از انتقال لایه به trash فایل refs را باز کرده و منتظر قفل است نباید روی فایل قدیمی بنشیند
+    char layer_path[1024], moved_path[1024];
+    assert(layer_store_path(LAYER_A, layer_path, sizeof(layer_path)) == 0);
+    *strrchr(layer_path, '/') = '\0';
+    snprintf(moved_path, sizeof(moved_path), "%s.moved", source);
+    strcpy(path, layer_path);
+    strcat(path, "/refs");
+    int refs_fd = open(path, O_RDWR);
+    assert(refs_fd != -1);
+    assert(flock(refs_fd, LOCK_EX) == 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(layer_store_ref(LAYER_A) == -1 ? 0 : 1);
+    }
+    assert(pid > 0);
+    usleep(200000);
+    assert(rename(layer_path, moved_path) == 0);
+    flock(refs_fd, LOCK_UN);
+    close(refs_fd);
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(rename(moved_path, layer_path) == 0);
+    assert(layer_store_refcount(LAYER_A) == 2);
+
+    // لایه دارای ارجاع و لایه تازه رهاشده حذف نمی‌شوند
+    layer_store_gc();
+    assert(layer_store_has(LAYER_A) && layer_store_has(LAYER_B));
+
+    // پس از گذشت مهلت، فقط لایه بدون ارجاع حذف می‌شود
+    expire_layer(LAYER_A);
+    expire_layer(LAYER_B);
+    layer_store_gc();
+    assert(layer_store_has(LAYER_A));
+    assert(!layer_store_has(LAYER_B));
+
+    assert(layer_store_path(LAYER_A, path, sizeof(path)) == 0);
+    strcat(path, "/etc/shared");
+    assert(stat(path, &st_a) == 0);
+    assert(st_a.st_nlink == 2);
+
+    assert(layer_store_unref(LAYER_A) == 0);
+    assert(layer_store_unref(LAYER_A) == 0);
+    expire_layer(LAYER_A);
+
+    // GC پس‌زمینه که بلافاصله پس از توقف دوباره شروع شده باید همچنان کار کند
+    assert(layer_store_gc_start(1) == 0);
+    layer_store_gc_stop();
+    assert(layer_store_gc_start(1) == 0);
+    for (int i = 0; i < 50 && layer_store_has(LAYER_A); i++) {
+        usleep(100000);
+    }
+    layer_store_gc_stop();
+    assert(!layer_store_has(LAYER_A));
+
+    remove_directory(source);
+
+    printf("تست انبار لایه با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های انبار لایه...\n");
+
+    if (getuid() != 0) {
+        printf("این آزمون‌ها نیاز به دسترسی root دارند\n");
+        return 1;
+    }
+
+    assert(layer_store_init() == 0);
+
+    test_layer_digest();
+    test_layer_store();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
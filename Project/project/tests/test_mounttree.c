@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/mount.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "../include/mounttree.h"
+#include "../include/utils.h"
+
+// تست نصب فایل‌سیستم تازه و clone قالب /dev در یک mount namespace جدا
+static void run_in_namespace(const char *root) {
+    assert(unshare(CLONE_NEWNS) == 0);
+    assert(mount_make_private("/") == 0);
+
+    char tmp_dir[512], dev_dir[512], path[600];
+    snprintf(tmp_dir, sizeof(tmp_dir), "%s/tmp", root);
+    snprintf(dev_dir, sizeof(dev_dir), "%s/dev", root);
+
+    // گزینه‌ها با fsconfig اعمال می‌شوند
+    assert(mount_new_fs("tmpfs", "mode=1777,size=1m", MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV, tmp_dir) == 0);
+    struct statfs fs;
+    assert(statfs(tmp_dir, &fs) == 0);
+    assert(fs.f_blocks * fs.f_bsize == 1024 * 1024);
+    struct stat st;
+    assert(stat(tmp_dir, &st) == 0 && (st.st_mode & 07777) == 01777);
+    assert(mount_new_fs("tmpfs", "no_such_option=1", 0, tmp_dir) == -1);
+
+    // گره‌های قالب قابل استفاده و خود قالب فقط‌خواندنی است
+    assert(mount_clone_tree(MOUNT_TEMPLATE_DEV, dev_dir) == 0);
+    snprintf(path, sizeof(path), "%s/null", dev_dir);
+    int fd = open(path, O_WRONLY);
+    assert(fd != -1 && write(fd, "x", 1) == 1);
+    close(fd);
+    snprintf(path, sizeof(path), "%s/urandom", dev_dir);
+    assert(stat(path, &st) == 0 && S_ISCHR(st.st_mode));
+    snprintf(path, sizeof(path), "%s/sda", dev_dir);
+    assert(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/new", dev_dir);
+    assert(open(path, O_WRONLY | O_CREAT, 0644) == -1 && errno == EROFS);
+
+    // ptmx قالب پس از نصب devpts مستقل به pts/ptmx همین نمونه می‌رسد
+    snprintf(path, sizeof(path), "%s/pts", dev_dir);
+    assert(mount_new_fs("devpts", "ptmxmode=0666,mode=0620",
+                        MOUNT_ATTR_NOSUID | MOUNT_ATTR_NOEXEC, path) == 0);
+    snprintf(path, sizeof(path), "%s/ptmx", dev_dir);
+    fd = open(path, O_RDWR | O_NOCTTY);
+    assert(fd != -1);
+    close(fd);
+    snprintf(path, sizeof(path), "%s/shm", dev_dir);
+    assert(mount_new_fs("tmpfs", NULL, MOUNT_ATTR_NOSUID | MOUNT_ATTR_NODEV, path) == 0);
+    assert(stat(path, &st) == 0 && (st.st_mode & 07777) == 01777);
+
+    _exit(0);
+}
+
+void test_mount_tree() {
+    printf("تست نصب با API جدید...\n");
+
+    assert(mount_template_init() == 0);
+    // فراخوانی دوباره از قالب موجود استفاده می‌کند
+    assert(mount_template_init() == 0);
+
+    char root[] = "/tmp/mounttree_test_XXXXXX";
+    assert(mkdtemp(root) != NULL);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/tmp", root);
+    assert(mkdir(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/dev", root);
+    assert(mkdir(path, 0755) == 0);
+
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        run_in_namespace(root);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // نصب‌های namespace فرزند در میزبان دیده نمی‌شوند
+    snprintf(path, sizeof(path), "%s/dev/null", root);
+    assert(access(path, F_OK) != 0);
+
+    remove_directory(root);
+    printf("تست نصب با API جدید با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های نصب...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون نصب نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_mount_tree();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
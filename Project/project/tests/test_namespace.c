@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <assert.h>
+#include <sys/wait.h>
+#include "../include/namespace.h"
+#include "../include/utils.h"
+
+static char cgroup_root[256];
+static char test_cgroup[512];
+
+// ریشه cgroup v2 (در میزبان‌های hybrid زیر unified)
+static void find_cgroup_root() {
+    if (access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0) {
+        strcpy(cgroup_root, "/sys/fs/cgroup");
+    } else {
+        strcpy(cgroup_root, "/sys/fs/cgroup/unified");
+    }
+    snprintf(test_cgroup, sizeof(test_cgroup), "%s/namespace_exec_test", cgroup_root);
+}
+
+typedef struct {
+    int ready[2];
+    int hold[2];
+} target_args_t;
+
+// فرآیند مقصد مانند کانتینر: namespace های تازه و hostname پس از نگاشت root توسط والد؛ تا بسته شدن
+// hold منتظر می‌ماند
+static int target_main(void *arg) {
+    target_args_t *args = arg;
+    close(args->ready[0]);
+    close(args->hold[1]);
+    char byte;
+    if (read(args->hold[0], &byte, 1) != 1 || sethostname("nstest", 6) != 0) {
+        _exit(1);
+    }
+    if (write(args->ready[1], "1", 1) != 1) {
+        _exit(1);
+    }
+    while (read(args->hold[0], &byte, 1) > 0) {
+    }
+    _exit(0);
+}
+
+// نگاشت root درون user namespace به root میزبان؛ نوشتن نگاشت uid 0 نیازمند CAP_SETFCAP در namespace والد است
+static void write_proc(pid_t pid, const char *file, const char *text) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", pid, file);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    assert(fd != -1);
+    assert(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+    close(fd);
+}
+
+static void read_link(pid_t pid, const char *name, char *buffer, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/ns/%s", pid, name);
+    ssize_t n = readlink(path, buffer, size - 1);
+    assert(n > 0);
+    buffer[n] = '\0';
+}
+
+static int wait_exit(pid_t pid) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+void test_namespace_exec() {
+    printf("تست اجرای فرمان در namespace های فرآیند موجود...\n");
+
+    find_cgroup_root();
+    assert(create_directory(test_cgroup, 0755) == 0);
+    int cgroup_fd = open(test_cgroup, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    assert(cgroup_fd != -1);
+
+    target_args_t args;
+    assert(pipe(args.ready) == 0 && pipe(args.hold) == 0);
+    const int stack_size = 256 * 1024;
+    char *stack = malloc(stack_size);
+    assert(stack != NULL);
+    int pidfd = -1;
+    pid_t target = clone(target_main, stack + stack_size, NAMESPACE_EXEC_TYPES | CLONE_PIDFD | SIGCHLD, &args,
+                         &pidfd);
+    assert(target != -1 && pidfd != -1);
+    close(args.ready[1]);
+    close(args.hold[0]);
+    write_proc(target, "uid_map", "0 0 1");
+    write_proc(target, "setgroups", "deny");
+    write_proc(target, "gid_map", "0 0 1");
+    char byte = 1;
+    assert(write(args.hold[1], &byte, 1) == 1);
+    assert(read(args.ready[0], &byte, 1) == 1);
+    close(args.ready[0]);
+
+    // همه namespace ها و cgroup با یک فراخوانی؛ فرمان فرزند مستقیم این فرآیند است
+    char *sleeper[] = { "sleep", "30", NULL };
+    pid_t pid = namespace_exec(pidfd, NAMESPACE_EXEC_TYPES, cgroup_fd, NULL, sleeper);
+    assert(pid > 0);
+    const char *names[] = { "user", "mnt", "pid", "uts", "ipc", "net" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char expected[64], actual[64];
+        read_link(target, names[i], expected, sizeof(expected));
+        read_link(pid, names[i], actual, sizeof(actual));
+        assert(strcmp(expected, actual) == 0);
+    }
+    char path[64], buffer[1024];
+    snprintf(path, sizeof(path), "/proc/%d/cgroup", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    assert(fd != -1);
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    assert(n > 0);
+    buffer[n] = '\0';
+    close(fd);
+    assert(strstr(buffer, "0::/namespace_exec_test\n") != NULL);
+    kill(pid, SIGKILL);
+    assert(waitpid(pid, NULL, 0) == pid);
+
+    // دید فرمان از درون: hostname کانتینر، PID داخلی کوچک و uid نگاشت‌شده به root
+    char *check[] = { "/bin/sh", "-c", "[ \"$(hostname)\" = nstest ] && [ $$ -lt 10 ] && [ \"$(id -u)\" = 0 ]", NULL };
+    pid = namespace_exec(pidfd, NAMESPACE_EXEC_TYPES, cgroup_fd, "/", check);
+    assert(pid > 0 && wait_exit(pid) == 0);
+
+    // بدون cgroup مقصد فرمان در cgroup فراخواننده می‌ماند
+    char *status_check[] = { "true", NULL };
+    pid = namespace_exec(pidfd, NAMESPACE_EXEC_TYPES, -1, NULL, status_check);
+    assert(pid > 0 && wait_exit(pid) == 0);
+
+    // خطای exec و مقصد خاتمه‌یافته به فراخواننده برمی‌گردد
+    char *missing[] = { "/nonexistent/command", NULL };
+    assert(namespace_exec(pidfd, NAMESPACE_EXEC_TYPES, cgroup_fd, NULL, missing) == -1);
+    close(args.hold[1]);
+    assert(wait_exit(target) == 0);
+    assert(namespace_exec(pidfd, NAMESPACE_EXEC_TYPES, cgroup_fd, NULL, status_check) == -1);
+
+    close(pidfd);
+    close(cgroup_fd);
+    free(stack);
+    assert(rmdir(test_cgroup) == 0);
+
+    printf("تست اجرای فرمان در namespace های فرآیند موجود با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های namespace...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون namespace نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_namespace_exec();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
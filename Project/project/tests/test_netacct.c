@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <assert.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../include/netacct.h"
+#include "../include/bpfprog.h"
+#include "../include/utils.h"
+
+#define PAYLOAD_SIZE (4 * 1024 * 1024)
+#define RATE_LIMIT (4 * 1024 * 1024)
+
+static char cgroup_root[256];
+static char test_cgroup[512];
+
+// ریشه cgroup v2 (در میزبان‌های hybrid زیر unified)
+static void find_cgroup_root() {
+    if (access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0) {
+        strcpy(cgroup_root, "/sys/fs/cgroup");
+    } else {
+        strcpy(cgroup_root, "/sys/fs/cgroup/unified");
+    }
+    snprintf(test_cgroup, sizeof(test_cgroup), "%s/netacct_test", cgroup_root);
+}
+
+static void move_self(const char *cgroup) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", cgroup);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    assert(fd != -1);
+    assert(write(fd, "0", 1) == 1);
+    close(fd);
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ارسال PAYLOAD_SIZE بایت روی 127.0.0.1 و بررسی سالم رسیدن آن؛ مدت انتقال برگردانده می‌شود
+static double transfer() {
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(listener != -1);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof(address);
+    assert(bind(listener, (struct sockaddr *)&address, sizeof(address)) == 0);
+    assert(listen(listener, 1) == 0);
+    assert(getsockname(listener, (struct sockaddr *)&address, &length) == 0);
+    int client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(connect(client, (struct sockaddr *)&address, sizeof(address)) == 0);
+    int server = accept(listener, NULL, NULL);
+    assert(server != -1);
+    close(listener);
+
+    char *buffer = malloc(65536);
+    assert(buffer != NULL);
+    double start = now_seconds();
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        for (size_t sent = 0; sent < PAYLOAD_SIZE; sent += 65536) {
+            for (size_t i = 0; i < 65536; i++) buffer[i] = (char)((sent + i) * 13);
+            size_t done = 0;
+            while (done < 65536) {
+                ssize_t n = write(client, buffer + done, 65536 - done);
+                if (n <= 0) _exit(1);
+                done += n;
+            }
+        }
+        _exit(0);
+    }
+    size_t received = 0;
+    while (received < PAYLOAD_SIZE) {
+        ssize_t n = read(server, buffer, 65536);
+        assert(n > 0);
+        for (ssize_t i = 0; i < n; i++) {
+            assert(buffer[i] == (char)((received + i) * 13));
+        }
+        received += n;
+    }
+    double elapsed = now_seconds() - start;
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    free(buffer);
+    close(client);
+    close(server);
+    return elapsed;
+}
+
+void test_netacct() {
+    printf("تست شمارش ترافیک شبکه...\n");
+
+    // bpffs تازه تا نسخه pin‌شده میزبان دست نخورد
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        assert(unshare(CLONE_NEWNS) == 0);
+        assert(mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0);
+        assert(mount("bpf", BPF_FS_PATH, "bpf", 0, "mode=0700") == 0);
+
+        find_cgroup_root();
+        assert(create_directory(test_cgroup, 0755) == 0);
+        move_self(test_cgroup);
+
+        netacct_stats_t stats;
+        assert(netacct_read(test_cgroup, &stats) == -1);
+        assert(netacct_attach_cgroup(test_cgroup, 0) == 0);
+        assert(netacct_read(test_cgroup, &stats) == 0);
+        assert(stats.rx_bytes == 0 && stats.tx_bytes == 0);
+
+        // هر دو سر اتصال در cgroup هستند: داده یک بار خروجی و یک بار ورودی شمرده می‌شود
+        transfer();
+        assert(netacct_read(test_cgroup, &stats) == 0);
+        assert(stats.tx_bytes >= PAYLOAD_SIZE && stats.rx_bytes >= PAYLOAD_SIZE);
+        assert(stats.tx_packets > 0 && stats.rx_packets > 0);
+        assert(stats.tx_dropped == 0 && stats.rx_dropped == 0);
+
+        // با سقف، انتقال دست‌کم به اندازه داده منهای سطل اولیه طول می‌کشد و داده سالم می‌رسد
+        assert(netacct_set_rate(test_cgroup, RATE_LIMIT) == 0);
+        double elapsed = transfer();
+        assert(elapsed > 0.8 * (PAYLOAD_SIZE - NETACCT_MIN_BURST) / RATE_LIMIT);
+        assert(netacct_read(test_cgroup, &stats) == 0);
+        assert(stats.tx_dropped + stats.rx_dropped > 0);
+
+        // بدون سقف شمارش ادامه دارد و چیزی دور ریخته نمی‌شود
+        assert(netacct_set_rate(test_cgroup, 0) == 0);
+        netacct_stats_t before = stats;
+        transfer();
+        assert(netacct_read(test_cgroup, &stats) == 0);
+        assert(stats.tx_bytes >= before.tx_bytes + PAYLOAD_SIZE);
+        assert(stats.tx_dropped == before.tx_dropped && stats.rx_dropped == before.rx_dropped);
+
+        // نسخه pin‌شده دوباره استفاده می‌شود و شمارنده‌ها باقی‌اند
+        netacct_cleanup();
+        assert(netacct_init() == 0);
+        assert(netacct_read(test_cgroup, &before) == 0);
+        assert(before.tx_bytes == stats.tx_bytes);
+
+        // پس از جدا شدن شمارش متوقف می‌شود (storage تا حذف cgroup باقی است)
+        assert(netacct_detach_cgroup(test_cgroup) == 0);
+        transfer();
+        if (netacct_read(test_cgroup, &stats) == 0) {
+            assert(stats.tx_bytes == before.tx_bytes);
+        }
+        netacct_cleanup();
+
+        move_self(cgroup_root);
+        assert(rmdir(test_cgroup) == 0);
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    printf("تست شمارش ترافیک شبکه با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های شمارش ترافیک شبکه...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون شمارش ترافیک شبکه نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_netacct();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <assert.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/mount.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include "../include/netlink.h"
+#include "../include/network.h"
+#include "../include/utils.h"
+
+static bool link_is_up(const char *ifname) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    assert(fd != -1);
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.ifr_name, ifname, IFNAMSIZ - 1);
+    int result = ioctl(fd, SIOCGIFFLAGS, &request);
+    close(fd);
+    return result == 0 && (request.ifr_flags & IFF_UP);
+}
+
+static uint32_t link_address(const char *ifname) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    assert(fd != -1);
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.ifr_name, ifname, IFNAMSIZ - 1);
+    request.ifr_addr.sa_family = AF_INET;
+    int result = ioctl(fd, SIOCGIFADDR, &request);
+    close(fd);
+    return result == 0 ? ((struct sockaddr_in *)&request.ifr_addr)->sin_addr.s_addr : 0;
+}
+
+// وجود مسیر با مقصد و gateway مشخص در /proc/net/route (netns فعلی)
+static bool route_exists(const char *ifname, uint32_t destination, uint32_t gateway) {
+    FILE *file = fopen("/proc/net/route", "r");
+    assert(file != NULL);
+    char line[256], name[IFNAMSIZ];
+    unsigned int dst, gw;
+    bool found = false;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%15s %x %x", name, &dst, &gw) == 3 && strcmp(name, ifname) == 0 &&
+            dst == destination && gw == gateway) {
+            found = true;
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+// اجرای تست در فرآیند فرزند با network namespace جدا تا رابط‌های میزبان دست نخورند؛
+// sysfs تازه رابط‌های همان namespace را نشان می‌دهد
+static void run_isolated(void (*test)(void)) {
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        assert(unshare(CLONE_NEWNET | CLONE_NEWNS) == 0);
+        assert(mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0);
+        assert(mount("sysfs", "/sys", "sysfs", 0, NULL) == 0);
+        test();
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+// loopback، veth، bridge، نشانی و مسیر در یک دسته
+static void batch_operations(void) {
+    netlink_t nl;
+    assert(netlink_open(&nl) == 0);
+    assert(!link_is_up("lo"));
+
+    netlink_link_up(&nl, "lo");
+    netlink_bridge_create(&nl, "br-test");
+    assert(netlink_commit(&nl) == 0);
+    assert(link_is_up("lo") && link_is_up("br-test"));
+
+    int bridge = if_nametoindex("br-test");
+    assert(bridge > 0);
+    netlink_veth_create(&nl, "vt-host", "vt-peer", 0, bridge);
+    assert(netlink_commit(&nl) == 0);
+    int peer = if_nametoindex("vt-peer");
+    assert(peer > 0 && link_is_up("vt-host") && !link_is_up("vt-peer"));
+
+    // سر میزبان عضو bridge است
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/class/net/vt-host/master");
+    char master[64];
+    ssize_t length = readlink(path, master, sizeof(master) - 1);
+    assert(length > 0);
+    master[length] = '\0';
+    assert(strstr(master, "br-test") != NULL);
+
+    netlink_link_up(&nl, "vt-peer");
+    netlink_addr_add(&nl, peer, inet_addr("10.99.0.2"), 24);
+    netlink_route_add(&nl, inet_addr("10.100.0.0"), 16, inet_addr("10.99.0.1"), peer);
+    netlink_route_add(&nl, 0, 0, inet_addr("10.99.0.1"), peer);
+    assert(netlink_commit(&nl) == 0);
+    assert(link_is_up("vt-peer"));
+    assert(link_address("vt-peer") == inet_addr("10.99.0.2"));
+    assert(route_exists("vt-peer", inet_addr("10.100.0.0"), inet_addr("10.99.0.1")));
+    assert(route_exists("vt-peer", 0, inet_addr("10.99.0.1")));
+
+    // خطای یک درخواست گزارش می‌شود ولی بقیه دسته اجرا می‌شود
+    netlink_veth_create(&nl, "vt-host", "vt-other", 0, 0);
+    netlink_link_up(&nl, "no-such-link");
+    netlink_bridge_create(&nl, "br-after");
+    assert(netlink_commit(&nl) == -1);
+    assert(if_nametoindex("vt-other") == 0 && if_nametoindex("br-after") > 0);
+
+    // نام بیش از حد طولانی پیش از ارسال رد می‌شود و دسته خالی می‌شود
+    assert(netlink_link_up(&nl, "a-very-long-interface-name") == -1);
+    assert(netlink_commit(&nl) == -1);
+    assert(netlink_commit(&nl) == 0);
+
+    netlink_close(&nl);
+}
+
+// سمت میزبان و کانتینر شبکه bridge: veth در netns فرآیند دیگر و پیکربندی آن از درون
+static void container_network(void) {
+    int ready[2], attached[2];
+    assert(pipe(ready) == 0 && pipe(attached) == 0);
+
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.id, "nettest0123456789");
+    config.network = NETWORK_BRIDGE;
+    config.ipv4_address = network_container_address(5);
+
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        char byte;
+        assert(unshare(CLONE_NEWNET) == 0);
+        assert(write(ready[1], "1", 1) == 1);
+        assert(read(attached[0], &byte, 1) == 1);
+        assert(if_nametoindex(NETWORK_CONTAINER_IFNAME) > 0);
+        assert(network_configure_container(&config) == 0);
+        assert(link_is_up("lo") && link_is_up(NETWORK_CONTAINER_IFNAME));
+        assert(link_address(NETWORK_CONTAINER_IFNAME) == inet_addr("10.88.0.7"));
+        assert(route_exists(NETWORK_CONTAINER_IFNAME, 0, inet_addr("10.88.0.1")));
+        _exit(0);
+    }
+
+    char byte;
+    assert(read(ready[0], &byte, 1) == 1);
+    assert(network_attach_container(&config, pid) == 0);
+    assert(write(attached[1], "1", 1) == 1);
+
+    char host_ifname[IFNAMSIZ];
+    network_host_ifname(&config, host_ifname, sizeof(host_ifname));
+    assert(strcmp(host_ifname, "scnettest01234") == 0);
+    assert(if_nametoindex(host_ifname) > 0 && if_nametoindex(NETWORK_CONTAINER_IFNAME) == 0);
+    assert(link_is_up(NETWORK_BRIDGE_NAME));
+    assert(link_address(NETWORK_BRIDGE_NAME) == inet_addr("10.88.0.1"));
+
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+void test_netlink_batch() {
+    printf("تست دسته درخواست‌های rtnetlink...\n");
+    run_isolated(batch_operations);
+    printf("تست دسته درخواست‌های rtnetlink با موفقیت انجام شد\n");
+}
+
+void test_network_bridge() {
+    printf("تست شبکه bridge کانتینر...\n");
+    run_isolated(container_network);
+    printf("تست شبکه bridge کانتینر با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های netlink...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون netlink نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_netlink_batch();
+    test_network_bridge();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <dirent.h>
+#include <assert.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include "../include/netpool.h"
+#include "../include/network.h"
+#include "../include/netlink.h"
+#include "../include/mounttree.h"
+#include "../include/utils.h"
+
+#define SYSFS_TARGET "/tmp/netpool_test_sys"
+
+static uint32_t link_address(const char *ifname) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    assert(fd != -1);
+    struct ifreq request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.ifr_name, ifname, IFNAMSIZ - 1);
+    request.ifr_addr.sa_family = AF_INET;
+    int result = ioctl(fd, SIOCGIFADDR, &request);
+    close(fd);
+    return result == 0 ? ((struct sockaddr_in *)&request.ifr_addr)->sin_addr.s_addr : 0;
+}
+
+static int count_links() {
+    struct if_nameindex *links = if_nameindex();
+    assert(links != NULL);
+    int count = 0;
+    while (links[count].if_index != 0) count++;
+    if_freenameindex(links);
+    return count;
+}
+
+// برداشتن ورودی؛ thread پس‌زمینه و پر کردن همزمان با هم کار می‌کنند
+static void acquire_wait(container_config_t *config) {
+    for (int i = 0; i < 500; i++) {
+        netpool_fill();
+        if (netpool_acquire(config) == 0) {
+            return;
+        }
+        usleep(10000);
+    }
+    assert(!"استخر پر نشد");
+}
+
+static container_config_t expected;
+
+// فرزند با user namespace تازه و بدون CLONE_NEWNET، مانند کانتینر
+static int child_main(void *arg) {
+    (void)arg;
+    if (if_nametoindex(NETWORK_CONTAINER_IFNAME) == 0 ||
+        link_address(NETWORK_CONTAINER_IFNAME) != expected.ipv4_address || count_links() != 2) {
+        return 1;
+    }
+    // namespace متعلق به user namespace میزبان است و کانتینر نمی‌تواند آن را تغییر دهد
+    netlink_t nl;
+    if (netlink_open(&nl) != 0) return 2;
+    netlink_addr_add(&nl, if_nametoindex(NETWORK_CONTAINER_IFNAME), inet_addr("10.88.200.1"), 16);
+    int changed = netlink_commit(&nl) == 0;
+    netlink_close(&nl);
+    if (changed) return 3;
+
+    // قالب sysfs رابط‌های همین namespace را نشان می‌دهد
+    char sysfs_template[256], path[512];
+    snprintf(sysfs_template, sizeof(sysfs_template), "%s/%s%s", NETPOOL_DIR, expected.netns_name,
+             NETPOOL_SYSFS_SUFFIX);
+    if (mount_clone_tree(sysfs_template, SYSFS_TARGET) != 0) return 4;
+    snprintf(path, sizeof(path), "%s/class/net/%s", SYSFS_TARGET, NETWORK_CONTAINER_IFNAME);
+    return access(path, F_OK) == 0 ? 0 : 5;
+}
+
+static void run_in_pooled(container_config_t *config) {
+    static char stack[256 * 1024];
+    expected = *config;
+    int saved;
+    assert(netpool_enter(config, &saved) == 0);
+    pid_t pid = clone(child_main, stack + sizeof(stack), CLONE_NEWUSER | CLONE_NEWNS | SIGCHLD, NULL);
+    assert(netpool_leave(saved) == 0);
+    assert(pid != -1);
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+// اجرای اول: ساخت استخر، استفاده و بازگرداندن
+static void first_run() {
+    assert(netpool_start(2) == 0);
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.network = NETWORK_BRIDGE;
+
+    assert(netpool_acquire(&config) == -1);
+    acquire_wait(&config);
+    assert(strncmp(config.netns_name, "bridge-", 7) == 0);
+    int number = atoi(config.netns_name + 7);
+    assert(config.ipv4_address == network_container_address(NETPOOL_ADDRESS_BASE + number));
+
+    char host_ifname[IFNAMSIZ], busy[256];
+    snprintf(host_ifname, sizeof(host_ifname), "scp%d", number);
+    assert(if_nametoindex(host_ifname) > 0 && if_nametoindex(NETWORK_BRIDGE_NAME) > 0);
+    snprintf(busy, sizeof(busy), "%s/%s%s", NETPOOL_DIR, config.netns_name, NETPOOL_BUSY_SUFFIX);
+    assert(access(busy, F_OK) == 0);
+
+    run_in_pooled(&config);
+
+    // پس از بازگشت، پاک‌سازی فایل مالک را برمی‌دارد و ورودی دوباره قابل برداشت است
+    char name[32];
+    strcpy(name, config.netns_name);
+    netpool_release(&config);
+    assert(config.netns_name[0] == '\0');
+    for (int i = 0; i < 500 && access(busy, F_OK) == 0; i++) {
+        netpool_fill();
+        usleep(10000);
+    }
+    assert(access(busy, F_OK) != 0);
+    _exit(0);
+}
+
+// اجرای دوم (فرآیند تازه): ورودی‌های زیر /run پذیرفته و بدون ساخت netns برداشته می‌شوند
+static void second_run() {
+    assert(netpool_start(2) == 0);
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.network = NETWORK_BRIDGE;
+    acquire_wait(&config);
+    run_in_pooled(&config);
+    netpool_release(&config);
+
+    // حالت none فقط loopback دارد
+    memset(&config, 0, sizeof(config));
+    config.network = NETWORK_NONE;
+    acquire_wait(&config);
+    assert(strncmp(config.netns_name, "none-", 5) == 0);
+    int saved;
+    assert(netpool_enter(&config, &saved) == 0);
+    assert(count_links() == 1 && if_nametoindex(NETWORK_CONTAINER_IFNAME) == 0);
+    assert(netpool_leave(saved) == 0);
+    assert(if_nametoindex(NETWORK_BRIDGE_NAME) > 0);
+
+    // ورودی در استفاده کانتینر زنده حذف نمی‌شود؛ thread پس‌زمینه ممکن است هنوز در حال ساخت باشد
+    netpool_stop();
+    assert(netpool_set_owner(&config, getppid()) == 0);
+    int remaining = 0, owned = 0;
+    for (int i = 0; i < 500 && (remaining != 3 || owned != 3); i++) {
+        usleep(10000);
+        netpool_purge();
+        DIR *dir = opendir(NETPOOL_DIR);
+        assert(dir != NULL);
+        struct dirent *entry;
+        remaining = owned = 0;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] != '.') {
+                owned += strncmp(entry->d_name, config.netns_name, strlen(config.netns_name)) == 0;
+                remaining++;
+            }
+        }
+        closedir(dir);
+    }
+    // فایل namespace، قالب sysfs و فایل مالک
+    assert(remaining == 3 && owned == 3);
+    _exit(0);
+}
+
+static void run_process(void (*run)(void)) {
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        run();
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+// برداشت همزمان از استخر یکسان در دو فرآیند run؛ هر دو وضعیت درون فرآیند را از والد به ارث می‌برند
+// با hold_fd فرآیند تا بسته شدن سر دیگر pipe (یا مرگ والد) ورودی را نگه می‌دارد
+static void acquire_and_report(int fd, int hold_fd) {
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.network = NETWORK_BRIDGE;
+    acquire_wait(&config);
+    assert(write(fd, config.netns_name, sizeof(config.netns_name)) == sizeof(config.netns_name));
+    char byte;
+    while (hold_fd != -1 && read(hold_fd, &byte, 1) > 0) {
+    }
+    _exit(0);
+}
+
+static void concurrent_run() {
+    assert(netpool_start(2) == 0);
+    container_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.network = NETWORK_BRIDGE;
+    acquire_wait(&config);
+    netpool_release(&config);
+    netpool_fill();
+    netpool_stop();
+
+    int fds[2], hold[2];
+    assert(pipe(fds) == 0 && pipe2(hold, O_CLOEXEC) == 0);
+    char first[32], second[32];
+    pid_t holder = fork();
+    assert(holder != -1);
+    if (holder == 0) {
+        close(hold[1]);
+        acquire_and_report(fds[1], hold[0]);
+    }
+    assert(read(fds[0], first, sizeof(first)) == sizeof(first));
+    pid_t other = fork();
+    assert(other != -1);
+    if (other == 0) {
+        close(hold[1]);
+        acquire_and_report(fds[1], -1);
+    }
+    assert(read(fds[0], second, sizeof(second)) == sizeof(second));
+    assert(waitpid(other, NULL, 0) == other);
+    assert(strcmp(first, second) != 0);
+
+    // پاک‌سازی فرآیند سوم ورودی در اختیار کانتینر زنده را حذف نمی‌کند
+    netpool_purge();
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", NETPOOL_DIR, first);
+    assert(access(path, F_OK) == 0);
+
+    close(hold[1]);
+    assert(waitpid(holder, NULL, 0) == holder);
+    close(hold[0]);
+    close(fds[0]);
+    close(fds[1]);
+    _exit(0);
+}
+
+static void lease_acquire(container_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->address_lease = -1;
+    assert(network_address_acquire(config) == 0);
+}
+
+static container_config_t first_lease;
+
+// فرآیند run دیگر: نشانی در استفاده فرآیند زنده را نمی‌گیرد و بدون آزاد کردن اجاره خارج می‌شود
+static void lease_other_process() {
+    container_config_t config;
+    lease_acquire(&config);
+    assert(config.address_lease != first_lease.address_lease);
+    assert(config.ipv4_address != first_lease.ipv4_address);
+    _exit(0);
+}
+
+// اجاره نشانی‌های تخصیص مستقیم بین فرآیندها
+static void lease_run() {
+    lease_acquire(&first_lease);
+    assert(first_lease.ipv4_address == network_container_address(first_lease.address_lease));
+    run_process(lease_other_process);
+
+    // اجاره فرآیند مرده دوباره تخصیص می‌یابد و اجاره آزادشده دوباره قابل برداشت است
+    container_config_t config;
+    lease_acquire(&config);
+    assert(config.address_lease == first_lease.address_lease + 1);
+    int index = first_lease.address_lease;
+    network_address_release(&first_lease);
+    assert(first_lease.address_lease == -1);
+    lease_acquire(&first_lease);
+    assert(first_lease.address_lease == index);
+
+    // پس از ثبت PID کانتینر اجاره متعلق به آن است، نه فرآیند فعلی
+    assert(network_address_set_owner(&config, getppid()) == 0);
+    network_address_release(&first_lease);
+    container_config_t other;
+    lease_acquire(&other);
+    assert(other.address_lease == index);
+    _exit(0);
+}
+
+void test_netpool() {
+    printf("تست استخر network namespace...\n");
+
+    // /run و شبکه جدا تا namespace ها و رابط‌های میزبان دست نخورند
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        assert(unshare(CLONE_NEWNET | CLONE_NEWNS) == 0);
+        assert(mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0);
+        assert(mount("tmpfs", "/run", "tmpfs", 0, NULL) == 0);
+        assert(mount("sysfs", "/sys", "sysfs", 0, NULL) == 0);
+        assert(create_directory(SYSFS_TARGET, 0755) == 0);
+        run_process(first_run);
+        run_process(second_run);
+        run_process(concurrent_run);
+        run_process(lease_run);
+        rmdir(SYSFS_TARGET);
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    printf("تست استخر network namespace با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های استخر network namespace...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون استخر network namespace نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_netpool();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
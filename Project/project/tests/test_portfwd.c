@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <errno.h>
+#include <signal.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../include/portfwd.h"
+#include "../include/netlink.h"
+#include "../include/utils.h"
+
+#define PAYLOAD_SIZE (8 * 1024 * 1024)
+#define PARALLEL_CONNECTIONS 32
+
+static int listen_loopback(uint16_t *port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(fd != -1);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof(address);
+    assert(bind(fd, (struct sockaddr *)&address, sizeof(address)) == 0);
+    assert(listen(fd, 128) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&address, &length) == 0);
+    *port = ntohs(address.sin_port);
+    return fd;
+}
+
+static void* echo_connection(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char buffer[65536];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        ssize_t done = 0;
+        while (done < n) {
+            ssize_t written = write(fd, buffer + done, n - done);
+            if (written <= 0) break;
+            done += written;
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+// سرویس echo با یک thread برای هر اتصال تا بسته شدن listener
+static void* echo_server(void *arg) {
+    int listener = (int)(intptr_t)arg;
+    int fd;
+    while ((fd = accept(listener, NULL, NULL)) != -1) {
+        pthread_t thread;
+        assert(pthread_create(&thread, NULL, echo_connection, (void *)(intptr_t)fd) == 0);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+static int connect_port(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(fd != -1);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port),
+                                   .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+typedef struct {
+    uint16_t port;
+    size_t size;
+    unsigned seed;
+} echo_check_t;
+
+// ارسال داده با الگو، نیمه‌بستن و بررسی بازگشت کامل آن
+static void* echo_check(void *arg) {
+    echo_check_t *check = arg;
+    int fd = connect_port(check->port);
+    assert(fd != -1);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        char buffer[65536];
+        for (size_t sent = 0; sent < check->size; sent += sizeof(buffer)) {
+            size_t chunk = check->size - sent < sizeof(buffer) ? check->size - sent : sizeof(buffer);
+            for (size_t i = 0; i < chunk; i++) buffer[i] = (char)((sent + i) * check->seed);
+            size_t done = 0;
+            while (done < chunk) {
+                ssize_t n = write(fd, buffer + done, chunk - done);
+                if (n <= 0) _exit(1);
+                done += n;
+            }
+        }
+        shutdown(fd, SHUT_WR);
+        _exit(0);
+    }
+    char buffer[65536];
+    size_t received = 0;
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            assert(buffer[i] == (char)((received + i) * check->seed));
+        }
+        received += n;
+    }
+    assert(n == 0 && received == check->size);
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(fd);
+    return NULL;
+}
+
+static void wait_connections(int expected) {
+    for (int i = 0; i < 500 && portfwd_connection_count() != expected; i++) {
+        usleep(10000);
+    }
+    assert(portfwd_connection_count() == expected);
+}
+
+void test_portfwd_basic() {
+    printf("تست انتقال پورت...\n");
+
+    uint16_t backend_port;
+    int listener = listen_loopback(&backend_port);
+    pthread_t server;
+    assert(pthread_create(&server, NULL, echo_server, (void *)(intptr_t)listener) == 0);
+
+    int id = portfwd_add(0, -1, htonl(INADDR_LOOPBACK), backend_port);
+    assert(id >= 0);
+    int port = portfwd_port(id);
+    assert(port > 0 && port != backend_port);
+
+    // داده حجیم در هر دو جهت و نیمه‌بسته شدن
+    echo_check_t check = { port, PAYLOAD_SIZE, 7 };
+    echo_check(&check);
+    wait_connections(0);
+
+    // اتصال‌های همزمان روی یک forward و forward دوم در همان thread
+    int second = portfwd_add(0, -1, htonl(INADDR_LOOPBACK), backend_port);
+    assert(second >= 0 && second != id);
+    pthread_t threads[PARALLEL_CONNECTIONS];
+    echo_check_t checks[PARALLEL_CONNECTIONS];
+    for (int i = 0; i < PARALLEL_CONNECTIONS; i++) {
+        checks[i] = (echo_check_t){ portfwd_port(i % 2 ? second : id), 256 * 1024 + i * 4099, 3 + 2 * i };
+        assert(pthread_create(&threads[i], NULL, echo_check, &checks[i]) == 0);
+    }
+    for (int i = 0; i < PARALLEL_CONNECTIONS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    wait_connections(0);
+
+    // مقصد بسته: اتصال مشتری بدون داده بسته می‌شود
+    uint16_t closed_port;
+    int closed_listener = listen_loopback(&closed_port);
+    close(closed_listener);
+    int refused = portfwd_add(0, -1, htonl(INADDR_LOOPBACK), closed_port);
+    assert(refused >= 0);
+    int fd = connect_port(portfwd_port(refused));
+    assert(fd != -1);
+    char byte;
+    assert(read(fd, &byte, 1) <= 0);
+    close(fd);
+    wait_connections(0);
+    assert(portfwd_remove(refused) == 0);
+
+    // حذف forward اتصال‌های باز را می‌بندد و پورت را آزاد می‌کند
+    fd = connect_port(port);
+    assert(fd != -1);
+    wait_connections(1);
+    assert(portfwd_remove(id) == 0);
+    assert(portfwd_port(id) == -1 && portfwd_remove(id) == -1);
+    assert(read(fd, &byte, 1) <= 0);
+    close(fd);
+    assert(connect_port(port) == -1);
+    wait_connections(0);
+    id = portfwd_add(port, -1, htonl(INADDR_LOOPBACK), backend_port);
+    assert(id >= 0 && portfwd_port(id) == port);
+
+    portfwd_stop();
+    assert(connect_port(port) == -1);
+    shutdown(listener, SHUT_RDWR);
+    pthread_join(server, NULL);
+    close(listener);
+
+    printf("تست انتقال پورت با موفقیت انجام شد\n");
+}
+
+// مقصد در network namespace جدا روی loopback آن، مانند کانتینر بدون شبکه bridge
+void test_portfwd_netns() {
+    printf("تست انتقال پورت به network namespace...\n");
+
+    int ready[2];
+    assert(pipe(ready) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        close(ready[0]);
+        netlink_t nl;
+        if (unshare(CLONE_NEWNET) != 0 || netlink_open(&nl) != 0) _exit(1);
+        netlink_link_up(&nl, "lo");
+        if (netlink_commit(&nl) != 0) _exit(1);
+        netlink_close(&nl);
+        uint16_t port;
+        int listener = listen_loopback(&port);
+        if (write(ready[1], &port, sizeof(port)) != sizeof(port)) _exit(1);
+        echo_server((void *)(intptr_t)listener);
+        _exit(0);
+    }
+    close(ready[1]);
+    uint16_t backend_port;
+    assert(read(ready[0], &backend_port, sizeof(backend_port)) == sizeof(backend_port));
+    close(ready[0]);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/ns/net", pid);
+    int netns_fd = open(path, O_RDONLY | O_CLOEXEC);
+    assert(netns_fd != -1);
+    int id = portfwd_add(0, netns_fd, htonl(INADDR_LOOPBACK), backend_port);
+    close(netns_fd);
+    assert(id >= 0);
+
+    echo_check_t check = { portfwd_port(id), PAYLOAD_SIZE, 11 };
+    echo_check(&check);
+
+    // thread پس از ساخت سوکت مقصد به namespace میزبان برمی‌گردد
+    uint16_t host_port;
+    int host_listener = listen_loopback(&host_port);
+    pthread_t server;
+    assert(pthread_create(&server, NULL, echo_server, (void *)(intptr_t)host_listener) == 0);
+    int host_id = portfwd_add(0, -1, htonl(INADDR_LOOPBACK), host_port);
+    assert(host_id >= 0);
+    check = (echo_check_t){ portfwd_port(host_id), 1024 * 1024, 5 };
+    echo_check(&check);
+    check = (echo_check_t){ portfwd_port(id), 1024 * 1024, 9 };
+    echo_check(&check);
+    shutdown(host_listener, SHUT_RDWR);
+    pthread_join(server, NULL);
+    close(host_listener);
+
+    portfwd_stop();
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+
+    printf("تست انتقال پورت به network namespace با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های انتقال پورت...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون انتقال پورت نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    test_portfwd_basic();
+    test_portfwd_netns();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "../include/prewarm.h"
+#include "../include/utils.h"
+
+#define TEST_FILES 8
+#define TEST_FILE_SIZE (1024 * 1024)
+
+// خواندن کامل یا بخشی از فایل؛ پیش‌خوانی هسته برای خواندن جزئی خاموش می‌شود
+static void read_file_range(const char *path, off_t offset, size_t length) {
+    char *buffer = malloc(length);
+    int fd = open(path, O_RDONLY);
+    assert(buffer && fd != -1);
+    if (length < TEST_FILE_SIZE) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+    }
+    assert(pread(fd, buffer, length, offset) == (ssize_t)length);
+    close(fd);
+    free(buffer);
+}
+
+// تست ضبط ترتیب باز شدن فایل‌ها و پیش‌خوانی trace
+void test_record_replay() {
+    printf("تست ضبط و پیش‌خوانی trace...\n");
+
+    char directory[] = "/tmp/prewarm_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char root[256], path[512], trace_path[512];
+    snprintf(root, sizeof(root), "%s/root", directory);
+    snprintf(trace_path, sizeof(trace_path), "%s/%s", directory, PREWARM_TRACE_NAME);
+    snprintf(path, sizeof(path), "%s/lib", root);
+    assert(create_directory(path, 0755) == 0);
+
+    char *data = calloc(1, TEST_FILE_SIZE);
+    assert(data);
+    for (int i = 0; i < TEST_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/lib/file%d", root, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd != -1 && write(fd, data, TEST_FILE_SIZE) == TEST_FILE_SIZE);
+        fsync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    free(data);
+
+    // فایل‌ها به ترتیب معکوس و از فایل 0 فقط یک صفحه در میانه خوانده می‌شود
+    long page_size = sysconf(_SC_PAGESIZE);
+    assert(prewarm_record_start("test", root, trace_path, 30) == 0);
+    for (int i = TEST_FILES - 1; i >= 0; i--) {
+        snprintf(path, sizeof(path), "%s/lib/file%d", root, i);
+        if (i == 0) {
+            read_file_range(path, TEST_FILE_SIZE / 2, page_size);
+        } else {
+            read_file_range(path, 0, TEST_FILE_SIZE);
+        }
+    }
+    // فایل بیرون از root ثبت نمی‌شود
+    snprintf(path, sizeof(path), "%s/outside", directory);
+    close(open(path, O_WRONLY | O_CREAT, 0644));
+    assert(prewarm_record_finish("test") == 0);
+    assert(prewarm_record_finish("test") == 0);
+
+    FILE *trace = fopen(trace_path, "r");
+    assert(trace != NULL);
+    char line[1024];
+    int lines = 0;
+    unsigned long long offset, length;
+    char name[512];
+    while (fgets(line, sizeof(line), trace)) {
+        if (line[0] == '#') continue;
+        assert(sscanf(line, "%llu %llu %511s", &offset, &length, name) == 3);
+        snprintf(path, sizeof(path), "lib/file%d", TEST_FILES - 1 - lines);
+        assert(strcmp(name, path) == 0);
+        if (lines == TEST_FILES - 1) {
+            assert(offset == TEST_FILE_SIZE / 2 && length == (unsigned long long)page_size);
+        } else {
+            assert(offset == 0 && length == TEST_FILE_SIZE);
+        }
+        lines++;
+    }
+    fclose(trace);
+    assert(lines == TEST_FILES);
+
+    prewarm_stats_t stats;
+    assert(prewarm_replay(root, trace_path, 2, &stats) == 0);
+    assert(stats.files == TEST_FILES);
+    assert(stats.bytes == (uint64_t)(TEST_FILES - 1) * TEST_FILE_SIZE + page_size);
+
+    // trace ناموجود خطا نیست
+    snprintf(path, sizeof(path), "%s/missing.trace", directory);
+    assert(prewarm_replay(root, path, 2, &stats) == 0 && stats.files == 0);
+
+    remove_directory(directory);
+    printf("تست ضبط و پیش‌خوانی trace با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های پیش‌خوانی...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون پیش‌خوانی نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_record_replay();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
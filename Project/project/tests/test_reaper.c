@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "../include/reaper.h"
+#include "../include/utils.h"
+
+#define DEEP_LEVELS 200
+#define WIDE_DIRS 8
+#define WIDE_FILES 500
+
+// ساخت درخت عمیق با مسیر بسیار بلندتر از PATH_MAX و درخت پهن با فایل‌های زیاد
+static void build_tree(const char *root) {
+    assert(mkdir(root, 0755) == 0);
+    int fd = open(root, O_RDONLY | O_DIRECTORY);
+    assert(fd != -1);
+
+    int deep = fd;
+    for (int i = 0; i < DEEP_LEVELS; i++) {
+        const char *name = "a_rather_long_directory_name_for_depth";
+        assert(mkdirat(deep, name, 0755) == 0);
+        int next = openat(deep, name, O_RDONLY | O_DIRECTORY);
+        assert(next != -1);
+        int file = openat(next, "file", O_WRONLY | O_CREAT, 0644);
+        assert(file != -1);
+        close(file);
+        if (deep != fd) close(deep);
+        deep = next;
+    }
+    close(deep);
+
+    char path[512];
+    for (int d = 0; d < WIDE_DIRS; d++) {
+        snprintf(path, sizeof(path), "%s/wide%d", root, d);
+        assert(mkdir(path, 0755) == 0);
+        for (int f = 0; f < WIDE_FILES; f++) {
+            snprintf(path, sizeof(path), "%s/wide%d/file%d", root, d, f);
+            int file = open(path, O_WRONLY | O_CREAT, 0644);
+            assert(file != -1);
+            close(file);
+        }
+    }
+    snprintf(path, sizeof(path), "%s/link", root);
+    assert(symlink("/etc", path) == 0);
+    close(fd);
+}
+
+// تعداد موارد باقیمانده در trash
+static int trash_entries() {
+    DIR *dir = opendir(REAPER_TRASH_PATH);
+    assert(dir != NULL);
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// تست حذف درخت با مسیرهای بلند
+void test_remove_directory() {
+    printf("تست حذف دایرکتوری عمیق...\n");
+
+    char directory[] = "/tmp/reaper_test_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char root[256], path[512];
+    snprintf(root, sizeof(root), "%s/tree", directory);
+    build_tree(root);
+
+    // پیوند نمادین به بیرون درخت دنبال نمی‌شود
+    snprintf(path, sizeof(path), "%s/outside", directory);
+    assert(mkdir(path, 0755) == 0);
+    snprintf(path, sizeof(path), "%s/outside/keep", directory);
+    close(open(path, O_WRONLY | O_CREAT, 0644));
+    snprintf(path, sizeof(path), "%s/escape", root);
+    assert(symlink("../outside", path) == 0);
+
+    assert(remove_directory(root) == 0);
+    assert(access(root, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/outside/keep", directory);
+    assert(access(path, F_OK) == 0);
+    assert(remove_directory(root) == -1);
+
+    assert(remove_directory(directory) == 0);
+    printf("تست حذف دایرکتوری عمیق با موفقیت انجام شد\n");
+}
+
+// تست انتقال به trash و حذف پس‌زمینه
+void test_reaper() {
+    printf("تست حذف پس‌زمینه...\n");
+
+    assert(reaper_init() == 0);
+    reaper_collect();
+
+    char root[] = "/var/lib/simplecontainer/reaper_test";
+    build_tree(root);
+
+    // بدون reaper فعال حذف همزمان انجام می‌شود
+    assert(reaper_discard(root) == 0);
+    assert(access(root, F_OK) != 0);
+    assert(trash_entries() == 0);
+
+    build_tree(root);
+    assert(reaper_start(4, 0) == 0);
+    uint64_t start = monotonic_time_ns();
+    assert(reaper_discard(root) == 0);
+    uint64_t elapsed = monotonic_time_ns() - start;
+    assert(access(root, F_OK) != 0);
+    printf("  بازگشت reaper_discard پس از %.3f ms\n", elapsed / 1e6);
+
+    for (int i = 0; i < 500 && trash_entries() > 0; i++) {
+        usleep(10000);
+    }
+    assert(trash_entries() == 0);
+    assert(reaper_discard("/var/lib/simplecontainer/nonexistent") == 0);
+
+    // توقف بلافاصله پس از discard موارد باقیمانده را پیش از بازگشت حذف می‌کند
+    build_tree(root);
+    assert(reaper_discard(root) == 0);
+    reaper_stop();
+    assert(trash_entries() == 0);
+
+    // شروع دوباره بلافاصله پس از توقف reaper فعال می‌سازد
+    assert(reaper_start(4, 0) == 0);
+    reaper_stop();
+    assert(reaper_start(4, 0) == 0);
+    build_tree(root);
+    assert(reaper_discard(root) == 0);
+    for (int i = 0; i < 500 && trash_entries() > 0; i++) {
+        usleep(10000);
+    }
+    assert(trash_entries() == 0);
+
+    reaper_stop();
+    printf("تست حذف پس‌زمینه با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های حذف...\n");
+
+    test_remove_directory();
+
+    if (getuid() != 0) {
+        printf("آزمون reaper نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_reaper();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <assert.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "../include/seccomp.h"
+#include "../include/utils.h"
+
+static struct sock_filter prog[SECCOMP_MAX_INSNS];
+
+void test_seccomp_profile() {
+    printf("تست پارس پروفایل seccomp...\n");
+
+    assert(seccomp_syscall_number("read") == SYS_read);
+    assert(seccomp_syscall_number("getpid") == SYS_getpid);
+    assert(seccomp_syscall_number("451") == 451);
+    assert(seccomp_syscall_number("nosuchcall") == -1);
+    assert(strcmp(seccomp_syscall_name(SYS_openat), "openat") == 0);
+
+    const char *path = "/tmp/seccomp_test_profile";
+    FILE *file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "# پروفایل آزمایشی\ndefault kill\nallow read 500\nallow getpid 9000\nerrno ptrace\n\n"
+                  "log 110\nallow read 700\n");
+    fclose(file);
+    static seccomp_profile_t profile;
+    assert(seccomp_profile_load(path, &profile) == 0);
+    assert(profile.default_action == SECCOMP_ACTION_KILL);
+    assert(profile.rule_count == 4);
+    assert(profile.rules[0].nr == SYS_read && profile.rules[0].count == 700);
+    assert(profile.rules[2].action == SECCOMP_ACTION_ERRNO);
+    assert(profile.rules[3].nr == 110 && profile.rules[3].action == SECCOMP_ACTION_LOG);
+
+    file = fopen(path, "w");
+    assert(file != NULL);
+    fprintf(file, "allow read\ndeny write\n");
+    fclose(file);
+    assert(seccomp_profile_load(path, &profile) == -1);
+    unlink(path);
+
+    printf("تست پارس پروفایل seccomp با موفقیت انجام شد\n");
+}
+
+// اجرای check در فرزندی با فیلتر نصب‌شده؛ وضعیت خروج یا 128+سیگنال
+static int run_filtered(int len, int (*check)(void)) {
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        if (seccomp_install(prog, len) != 0) _exit(100);
+        _exit(check());
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+}
+
+static int denied(long nr) {
+    errno = 0;
+    return syscall(nr) == -1 && errno == EPERM;
+}
+
+static int check_basic(void) {
+    if (syscall(SYS_getpid) <= 0 || !denied(SYS_getppid) || syscall(SYS_getuid) == -1) return 1;
+    syscall(SYS_gettid);
+    return 2;
+}
+
+void test_seccomp_compile() {
+    printf("تست ترجمه و نصب فیلتر seccomp...\n");
+
+    // getpid داغ پیش از درخت بررسی می‌شود
+    static seccomp_profile_t profile;
+    profile.default_action = SECCOMP_ACTION_ALLOW;
+    profile.rule_count = 0;
+    assert(seccomp_profile_add(&profile, SYS_getpid, SECCOMP_ACTION_ALLOW, 1000000) == 0);
+    assert(seccomp_profile_add(&profile, SYS_getppid, SECCOMP_ACTION_ERRNO, 0) == 0);
+    assert(seccomp_profile_add(&profile, SYS_gettid, SECCOMP_ACTION_KILL, 0) == 0);
+    assert(seccomp_profile_add(&profile, SECCOMP_MAX_SYSCALL, SECCOMP_ACTION_ALLOW, 0) == -1);
+    int len = seccomp_compile(&profile, prog, SECCOMP_MAX_INSNS);
+    assert(len > 0);
+    assert(prog[4].code == (BPF_JMP | BPF_JEQ | BPF_K) && prog[4].k == SYS_getpid);
+
+    // gettid با SIGSYS فرآیند را می‌کشد
+    assert(run_filtered(len, check_basic) == 128 + SIGSYS);
+    assert(seccomp_compile(&profile, prog, 8) == -1);
+
+    printf("تست ترجمه و نصب فیلتر seccomp با موفقیت انجام شد\n");
+}
+
+static int check_alternating(void) {
+    // شماره‌های فرد رد می‌شوند: getpid=39، geteuid=107، getpgrp=111
+    if (!denied(SYS_getpid) || !denied(SYS_geteuid) || !denied(SYS_getpgrp)) return 1;
+    // شماره‌های زوج مجازند: sched_yield=24، getuid=102، getppid=110، gettid=186
+    if (syscall(SYS_sched_yield) != 0 || syscall(SYS_getuid) == -1 || syscall(SYS_getppid) <= 0 ||
+        syscall(SYS_gettid) <= 0) return 2;
+    return 0;
+}
+
+void test_seccomp_long_jumps() {
+    printf("تست درخت بزرگ با پرش‌های بلند...\n");
+
+    // تصمیم متناوب صدها بازه می‌سازد و زیردرخت‌های چپ از بُرد jt بزرگ‌تر می‌شوند
+    static seccomp_profile_t profile;
+    profile.default_action = SECCOMP_ACTION_ALLOW;
+    profile.rule_count = 0;
+    for (int nr = 1; nr < 700; nr += 2) {
+        assert(seccomp_profile_add(&profile, nr, SECCOMP_ACTION_ERRNO, 0) == 0);
+    }
+    assert(seccomp_profile_add(&profile, SYS_write, SECCOMP_ACTION_ALLOW, 0) == 0);
+    assert(seccomp_profile_add(&profile, SYS_exit_group, SECCOMP_ACTION_ALLOW, 0) == 0);
+    int len = seccomp_compile(&profile, prog, SECCOMP_MAX_INSNS);
+    assert(len > 0);
+    int long_jumps = 0;
+    for (int i = 0; i < len; i++) {
+        long_jumps += prog[i].code == (BPF_JMP | BPF_JA | BPF_K);
+    }
+    assert(long_jumps > 0);
+    assert(run_filtered(len, check_alternating) == 0);
+
+    printf("تست درخت بزرگ با پرش‌های بلند با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های seccomp...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون seccomp نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_seccomp_profile();
+    test_seccomp_compile();
+    test_seccomp_long_jumps();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <assert.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+#include <arpa/inet.h>
+#include "../include/sockmap.h"
+#include "../include/bpfprog.h"
+#include "../include/utils.h"
+
+#define PAYLOAD_SIZE (4 * 1024 * 1024)
+
+static char cgroup_root[256];
+static char test_cgroup[512];
+
+// ریشه cgroup v2 (در میزبان‌های hybrid زیر unified)
+static void find_cgroup_root() {
+    if (access("/sys/fs/cgroup/cgroup.controllers", F_OK) == 0) {
+        strcpy(cgroup_root, "/sys/fs/cgroup");
+    } else {
+        strcpy(cgroup_root, "/sys/fs/cgroup/unified");
+    }
+    snprintf(test_cgroup, sizeof(test_cgroup), "%s/sockmap_test", cgroup_root);
+}
+
+static void move_self(const char *cgroup) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", cgroup);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    assert(fd != -1);
+    assert(write(fd, "0", 1) == 1);
+    close(fd);
+}
+
+static void connected_pair(int *client, int *server) {
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(listener != -1);
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t length = sizeof(address);
+    assert(bind(listener, (struct sockaddr *)&address, sizeof(address)) == 0);
+    assert(listen(listener, 1) == 0);
+    assert(getsockname(listener, (struct sockaddr *)&address, &length) == 0);
+    *client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    assert(connect(*client, (struct sockaddr *)&address, sizeof(address)) == 0);
+    *server = accept(listener, NULL, NULL);
+    assert(*server != -1);
+    close(listener);
+}
+
+// ارسال داده با الگوی مشخص و بررسی سالم رسیدن آن؛ بایت‌های تأییدشده TCP فرستنده برگردانده می‌شود
+static uint64_t transfer(int client, int server) {
+    char *buffer = malloc(65536);
+    assert(buffer != NULL);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        for (size_t sent = 0; sent < PAYLOAD_SIZE; sent += 65536) {
+            for (size_t i = 0; i < 65536; i++) buffer[i] = (char)((sent + i) * 7);
+            size_t done = 0;
+            while (done < 65536) {
+                ssize_t n = write(client, buffer + done, 65536 - done);
+                if (n <= 0) _exit(1);
+                done += n;
+            }
+        }
+        _exit(0);
+    }
+    size_t received = 0;
+    while (received < PAYLOAD_SIZE) {
+        ssize_t n = read(server, buffer, 65536);
+        assert(n > 0);
+        for (ssize_t i = 0; i < n; i++) {
+            assert(buffer[i] == (char)((received + i) * 7));
+        }
+        received += n;
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    free(buffer);
+
+    struct tcp_info info;
+    socklen_t length = sizeof(info);
+    assert(getsockopt(client, IPPROTO_TCP, TCP_INFO, &info, &length) == 0);
+    return info.tcpi_bytes_acked;
+}
+
+void test_sockmap() {
+    printf("تست شتاب‌دهنده sockmap...\n");
+
+    // bpffs تازه تا نسخه pin‌شده میزبان دست نخورد
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        assert(unshare(CLONE_NEWNS) == 0);
+        assert(mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) == 0);
+        assert(mount("bpf", BPF_FS_PATH, "bpf", 0, "mode=0700") == 0);
+
+        find_cgroup_root();
+        assert(create_directory(test_cgroup, 0755) == 0);
+        move_self(test_cgroup);
+
+        // بدون اتصال به cgroup داده از پشته TCP می‌گذرد
+        int client, server;
+        connected_pair(&client, &server);
+        assert(transfer(client, server) >= PAYLOAD_SIZE);
+        close(client);
+        close(server);
+
+        assert(sockmap_init() == 0);
+        assert(sockmap_attach_cgroup(test_cgroup) == 0);
+        assert(sockmap_socket_count() == 0);
+
+        // هر دو سر اتصال ثبت می‌شوند و داده بدون عبور از TCP و سالم می‌رسد
+        connected_pair(&client, &server);
+        assert(sockmap_socket_count() == 2);
+        assert(transfer(client, server) < PAYLOAD_SIZE / 4);
+
+        // بسته شدن سوکت آن را از map حذف می‌کند
+        close(client);
+        close(server);
+        assert(sockmap_socket_count() == 0);
+
+        // نسخه pin‌شده دوباره استفاده می‌شود
+        sockmap_cleanup();
+        assert(sockmap_init() == 0);
+        connected_pair(&client, &server);
+        assert(sockmap_socket_count() == 2);
+        close(client);
+        close(server);
+
+        assert(sockmap_detach_cgroup(test_cgroup) == 0);
+        connected_pair(&client, &server);
+        assert(sockmap_socket_count() == 0);
+        close(client);
+        close(server);
+        sockmap_cleanup();
+
+        move_self(cgroup_root);
+        assert(rmdir(test_cgroup) == 0);
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    printf("تست شتاب‌دهنده sockmap با موفقیت انجام شد\n");
+}
+
+int main() {
+    printf("شروع آزمون‌های شتاب‌دهنده sockmap...\n");
+
+    if (getuid() != 0) {
+        printf("آزمون شتاب‌دهنده sockmap نیاز به دسترسی root دارد\n");
+        return 1;
+    }
+    test_sockmap();
+
+    printf("تمام آزمون‌ها با موفقیت انجام شدند\n");
+    return 0;
+}